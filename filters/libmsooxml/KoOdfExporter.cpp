@@ -82,6 +82,11 @@ KoFilter::ConversionStatus KoOdfExporter::convert(const QByteArray& from, const
         return KoFilter::FileNotFound;
     }
     debugMsooXml << "created outputStore.";
+    return exportDocument(outputStore, to);
+}
+
+KoFilter::ConversionStatus KoOdfExporter::exportDocument(KoStore *outputStore, const QByteArray& to)
+{
     KoOdfWriteStore oasisStore(outputStore);
 
     debugMsooXml << "created oasisStore.";
@@ -117,7 +122,11 @@ KoFilter::ConversionStatus KoOdfExporter::convert(const QByteArray& from, const
     bodyWriter.startElement("office:body");
     bodyWriter.startElement(d->bodyContentElement.constData());
 
-    RETURN_IF_ERROR( createDocument(outputStore, &writers) )
+    const KoFilter::ConversionStatus status = createDocument(outputStore, &writers);
+    if (status != KoFilter::OK) {
+        delete outputStore;
+        return status;
+    }
 
     //save the office:automatic-styles & and fonts in content.xml
     mainStyles.saveOdfStyles(KoGenStyles::FontFaceDecls, &contentWriter);
@@ -69,6 +69,13 @@ protected:
      */
     KoOdfExporter(const QString& bodyContentElement, QObject* parent = 0);
 
+    /**
+     * Writes the ODF document of the mime type @a to into @a outputStore
+     * using createDocument(); convert() calls it with a store for the output
+     * file of the filter chain. Takes the ownership of @a outputStore.
+     */
+    KoFilter::ConversionStatus exportDocument(KoStore *outputStore, const QByteArray& to);
+
     /**
      * @return true if @a mime is accepted source mime type.
      * Implement it for your filter.
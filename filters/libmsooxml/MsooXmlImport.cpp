@@ -41,6 +41,10 @@
 #include <QInputDialog>
 #include <QImageReader>
 #include <QFileInfo>
+#include <QBuffer>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
 
 #include "MsooXmlDebug.h"
 #include <kzip.h>
@@ -66,6 +70,56 @@
 
 using namespace MSOOXML;
 
+//! The number of prefetched parts held at once: the one being parsed and the next ones.
+static const int s_prefetchWindow = 3;
+
+//! Reads the part @a path of the archive @a archiveName, which gets opened on its own.
+static bool readArchivePart(const QString& archiveName, const QString& path, QByteArray* data)
+{
+    KZip zip(archiveName);
+    if (!zip.open(QIODevice::ReadOnly) || !zip.directory())
+        return false;
+    const KArchiveEntry* entry = zip.directory()->entry(path);
+    if (!entry || !entry->isFile())
+        return false;
+    *data = static_cast<const KZipFileEntry*>(entry)->data();
+    return true;
+}
+
+//! Decompresses a part of the input archive, which it opens on its own,
+//! so that multiple parts can be decompressed in parallel.
+class MsooXmlImport::PrefetchJob : public QRunnable
+{
+public:
+    PrefetchJob(const QString& archiveName, const QString& path)
+            : m_archiveName(archiveName), m_path(path), m_found(false) {
+        setAutoDelete(false);
+    }
+
+    void run() Q_DECL_OVERRIDE {
+        m_found = readArchivePart(m_archiveName, m_path, &m_data);
+        m_done.release();
+    }
+
+    //! Waits for the job to finish. @return false if the part could not be read.
+    bool wait() {
+        m_done.acquire();
+        m_done.release();
+        return m_found;
+    }
+
+    const QByteArray& data() const {
+        return m_data;
+    }
+
+private:
+    const QString m_archiveName;
+    const QString m_path;
+    QByteArray m_data;
+    bool m_found;
+    QSemaphore m_done;
+};
+
 MsooXmlImport::MsooXmlImport(const QString& bodyContentElement, QObject* parent)
         : KoOdfExporter(bodyContentElement, parent),
         m_zip(0),
@@ -75,6 +129,7 @@ MsooXmlImport::MsooXmlImport(const QString& bodyContentElement, QObject* parent)
 
 MsooXmlImport::~MsooXmlImport()
 {
+    releaseParts();
 }
 
 void MsooXmlImport::reportProgress(unsigned progress)
@@ -146,6 +201,7 @@ KoFilter::ConversionStatus MsooXmlImport::createDocument(KoStore *outputStore,
 
     status = openFile(writers, errorMessage);
 
+    releaseParts();
     m_zip = 0; // clear context
     m_outputStore = 0; // clear context
 
@@ -719,8 +775,7 @@ KoFilter::ConversionStatus MsooXmlImport::loadAndParseDocument(
         return KoFilter::UsageError;
     }
     QString errorMessage;
-    KoFilter::ConversionStatus status = Utils::loadAndParseDocument(
-                                            reader, m_zip, reader, errorMessage, path, context);
+    KoFilter::ConversionStatus status = loadAndParseDocument(reader, path, errorMessage, context);
     if (status != KoFilter::OK)
         reader->raiseError(errorMessage);
     return status;
@@ -733,9 +788,80 @@ KoFilter::ConversionStatus MsooXmlImport::loadAndParseDocument(
     if (!m_zip) {
         return KoFilter::UsageError;
     }
-    KoFilter::ConversionStatus status = Utils::loadAndParseDocument(
-                                            reader, m_zip, reader, errorMessage, path, context);
-    return status;
+    PrefetchJob* job = m_prefetchedParts.value(path);
+    if (!job || !job->wait()) {
+        // read out of order; not worth decompressing again
+        m_partsToPrefetch.removeAll(path);
+        return Utils::loadAndParseDocument(reader, m_zip, reader, errorMessage, path, context);
+    }
+    // like Utils::loadAndParseDocument() but without copying the data
+    errorMessage.clear();
+    QBuffer device;
+    device.setData(job->data());
+    device.open(QIODevice::ReadOnly);
+    reader->setDevice(&device);
+    reader->setFileName(path); // for error reporting
+    const KoFilter::ConversionStatus status = reader->read(context);
+    if (status != KoFilter::OK) {
+        errorMessage = reader->errorString();
+        return status;
+    }
+    debugMsooXml << "File" << path << "loaded and parsed.";
+    return KoFilter::OK;
+}
+
+void MsooXmlImport::prefetchParts(const QStringList& paths)
+{
+    if (!m_zip) {
+        return;
+    }
+    foreach (const QString& path, paths) {
+        if (!m_prefetchedParts.contains(path) && !m_partsToPrefetch.contains(path)) {
+            m_partsToPrefetch.append(path);
+        }
+    }
+    startPrefetching();
+}
+
+void MsooXmlImport::startPrefetching()
+{
+    while (m_prefetchedParts.count() < s_prefetchWindow && !m_partsToPrefetch.isEmpty()) {
+        const QString path = m_partsToPrefetch.takeFirst();
+        PrefetchJob* job = new PrefetchJob(m_zip->fileName(), path);
+        m_prefetchedParts.insert(path, job);
+        QThreadPool::globalInstance()->start(job);
+    }
+}
+
+bool MsooXmlImport::readPart(const QString& path, QByteArray* data) const
+{
+    if (!m_zip) {
+        return false;
+    }
+    return readArchivePart(m_zip->fileName(), path, data);
+}
+
+void MsooXmlImport::releasePart(const QString& path)
+{
+    m_partsToPrefetch.removeAll(path);
+    PrefetchJob* job = m_prefetchedParts.take(path);
+    if (job) {
+        job->wait();
+        delete job;
+    }
+    if (m_zip) {
+        startPrefetching();
+    }
+}
+
+void MsooXmlImport::releaseParts()
+{
+    m_partsToPrefetch.clear();
+    foreach (PrefetchJob* job, m_prefetchedParts) {
+        job->wait();
+        delete job;
+    }
+    m_prefetchedParts.clear();
 }
 
 KoFilter::ConversionStatus MsooXmlImport::loadAndParseFromDevice(MsooXmlReader* reader, QIODevice* device,
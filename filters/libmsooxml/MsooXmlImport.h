@@ -30,6 +30,7 @@
 
 #include <QByteArray>
 #include <QHash>
+#include <QStringList>
 #include <QVariant>
 
 #include <KoBorder.h>
@@ -72,6 +73,24 @@ public:
             QString& errorMessage,
             MsooXmlReaderContext* context = 0);
 
+    /*! Decompresses the parts @a paths of the input archive in the background,
+    each part by its own job on the global thread pool. loadAndParseDocument()
+    then reads them from memory, waiting for the job if it is still running.
+    The parts are expected to be read in the order of @a paths; only a few of
+    them are held in memory at once, the next one is decompressed when
+    releasePart() drops one. The parts are kept until they get released by
+    releasePart() or until the importing process ends.
+    Nothing happens, if this method is called outside of the importing process. */
+    void prefetchParts(const QStringList& paths);
+
+    //! Drops the prefetched part @a path, if any, and starts decompressing the next one.
+    void releasePart(const QString& path);
+
+    /*! Decompresses the part @a path of the input archive into @a data.
+    The archive gets opened on its own, so this method may be called from any
+    thread during the importing process. @return false if the part could not be read. */
+    bool readPart(const QString& path, QByteArray* data) const;
+
     //! Loads a file from a device
     KoFilter::ConversionStatus loadAndParseFromDevice(MsooXmlReader* reader, QIODevice* device,
             MsooXmlReaderContext* context);
@@ -165,8 +184,18 @@ private:
         const QString& fileName, MsooXmlReader *reader, KoOdfWriters *writers,
         QString& errorMessage, MsooXmlReaderContext* context, bool *pathFound);
 
+    //! Waits for the prefetch jobs to finish and drops the prefetched parts.
+    void releaseParts();
+
+    //! Starts decompressing the next parts to prefetch, as long as the window is not full.
+    void startPrefetching();
+
     KZip* m_zip; //!< Input zip file
 
+    class PrefetchJob;
+    QHash<QString, PrefetchJob*> m_prefetchedParts; //!< prefetched parts by path
+    QStringList m_partsToPrefetch; //!< the parts to prefetch next in order
+
     KoStore* m_outputStore; //!< output store used for copying files
 
     //! XML from "[Content_Types].xml" file.
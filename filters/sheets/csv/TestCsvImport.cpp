@@ -0,0 +1,123 @@
+/* This file is part of the KDE project
+   Copyright (C) 2016 The Calligra developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#include "TestCsvImport.h"
+
+#include <QBuffer>
+#include <QTableWidget>
+#include <QTest>
+
+#include <KoCsvImportDialog.h>
+
+#include <sheets/CellStorage.h>
+#include <sheets/Map.h>
+#include <sheets/Sheet.h>
+
+#include "csvreader.h"
+
+using namespace Calligra::Sheets;
+
+void TestCsvImport::testImport_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<QString>("delimiter");
+    QTest::addColumn<QChar>("textQuote");
+    QTest::addColumn<bool>("ignoreDuplicates");
+    // the range chosen in the dialog
+    QTest::addColumn<QRect>("range");
+
+    const QRect all(QPoint(1, 1), QPoint(-1, -1));
+
+    QTest::newRow("line feeds")
+        << QByteArray("a,b,c\n1,2,3\n4,5,6\n")
+        << "," << QChar('"') << false << all;
+    QTest::newRow("carriage return line feeds")
+        << QByteArray("a,b,c\r\n1,2,3\r\n4,5,6\r\n7,8,9")
+        << "," << QChar('"') << false << all;
+    QTest::newRow("carriage returns")
+        << QByteArray("a,b\r1,2\r\r3,4")
+        << "," << QChar('"') << false << all;
+    QTest::newRow("quotes")
+        << QByteArray("\"a,b\",\"say \"\"hi\"\"\",c\r\n\"\",x\"y\",\"z\"z\r\n")
+        << "," << QChar('"') << false << all;
+    QTest::newRow("no quotes")
+        << QByteArray("\"a,b\",c\n'd',e\n")
+        << "," << QChar() << false << all;
+    QTest::newRow("multi-character delimiter")
+        << QByteArray("a::b::c\n1::::2\n::3::\n")
+        << "::" << QChar('"') << false << all;
+    QTest::newRow("ignore duplicates")
+        << QByteArray("a,,,b,c\n1,2,,3\n,,4\n")
+        << "," << QChar('"') << true << all;
+    QTest::newRow("ignore duplicate multi-character delimiters")
+        << QByteArray("a::::b::c\n1::2::::3\n")
+        << "::" << QChar('"') << true << all;
+    QTest::newRow("start row and column")
+        << QByteArray("a,b,c,d\r\n1,2,3,4\r\n5,6,7,8\r\n9,10,11,12\r\n")
+        << "," << QChar('"') << false << QRect(QPoint(2, 3), QPoint(-1, -1));
+    QTest::newRow("end row and column")
+        << QByteArray("a,b,c,d\r\n1,2,3,4\r\n5,6,7,8\r\n9,10,11,12\r\n")
+        << "," << QChar('"') << false << QRect(QPoint(1, 1), QPoint(2, 3));
+    QTest::newRow("row and column range")
+        << QByteArray("a,b,c,d\r\n1,2,3,4\r\n5,6,7,8\r\n9,10,11,12\r\n")
+        << "," << QChar('"') << false << QRect(QPoint(2, 2), QPoint(3, 3));
+}
+
+void TestCsvImport::testImport()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(QString, delimiter);
+    QFETCH(QChar, textQuote);
+    QFETCH(bool, ignoreDuplicates);
+    QFETCH(QRect, range);
+
+    KoCsvImportDialog dialog(0);
+    dialog.setData(data);
+    dialog.setDelimiter(delimiter);
+    dialog.setTextQuote(textQuote);
+    dialog.setIgnoreDuplicates(ignoreDuplicates);
+    dialog.setRange(range.top(), range.left(), range.bottom(), range.right());
+    const QTableWidget* table = dialog.findChild<QTableWidget*>();
+    QVERIFY(table);
+
+    // Tiny chunks split the data everywhere, also between CR and LF.
+    for (qint64 chunkSize = 1; chunkSize <= data.size() + 1; chunkSize += chunkSize < 8 ? 1 : 8) {
+        Map map;
+        Sheet* sheet = map.addNewSheet();
+        CellStorage* storage = sheet->cellStorage();
+
+        QBuffer buffer(&data);
+        QVERIFY(buffer.open(QIODevice::ReadOnly));
+        CSVReader reader(&dialog);
+        reader.setChunkSize(chunkSize);
+        reader.read(&buffer, sheet);
+
+        const int rows = qMax(table->rowCount(), storage->rows(false));
+        const int columns = qMax(table->columnCount(), storage->columns(false));
+        for (int row = 1; row <= rows; ++row) {
+            for (int col = 1; col <= columns; ++col) {
+                const QTableWidgetItem* item = table->item(row - 1, col - 1);
+                const QString expected = item ? item->text() : QString();
+                QCOMPARE(storage->userInput(col, row), expected);
+            }
+        }
+    }
+}
+
+QTEST_MAIN(TestCsvImport)
@@ -19,11 +19,10 @@
 */
 
 #include "csvimport.h"
+#include "csvreader.h"
 
 #include <QByteArray>
 #include <QFile>
-#include <QRegExp>
-#include <QVector>
 #include <QApplication>
 
 #include <kmessagebox.h>
@@ -37,15 +36,10 @@
 
 #include <sheets/ElapsedTime_p.h>
 #include <sheets/CalculationSettings.h>
-#include <sheets/Cell.h>
 #include <sheets/part/Doc.h>
 #include <sheets/Global.h>
 #include <sheets/Map.h>
-#include <sheets/RowColumnFormat.h>
 #include <sheets/Sheet.h>
-#include <sheets/Style.h>
-#include <sheets/Value.h>
-#include <sheets/ValueConverter.h>
 
 using namespace Calligra::Sheets;
 
@@ -57,6 +51,9 @@ using namespace Calligra::Sheets;
  perl -e '$i=0;while($i<30000) { print rand().",".rand()."\n"; $i++ }' > file.csv
 */
 
+// The amount of data shown in the import dialog.
+static const qint64 s_previewSize = 1 << 20;
+
 K_PLUGIN_FACTORY_WITH_JSON(CSVImportFactory, "calligra_filter_csv2sheets.json", registerPlugin<CSVFilter>();)
 
 CSVFilter::CSVFilter(QObject* parent, const QVariantList&) :
@@ -100,107 +97,51 @@ KoFilter::ConversionStatus CSVFilter::convert(const QByteArray& from, const QByt
     //if (!config.isNull())
     //    csv_delimiter = config[0];
 
-    QByteArray inputFile(in.readAll());
-    in.close();
+    // The dialog only gets the leading lines; the file is read chunk by chunk later on.
+    QByteArray preview(in.read(s_previewSize));
+    const bool complete = in.atEnd();
+    if (!complete && preview.lastIndexOf('\n') != -1)
+        preview.truncate(preview.lastIndexOf('\n') + 1);
 
     KoCsvImportDialog* dialog = new KoCsvImportDialog(0);
-    dialog->setData(inputFile);
+    dialog->setData(preview);
     dialog->setDecimalSymbol(ksdoc->map()->calculationSettings()->locale()->decimalSymbol());
     dialog->setThousandsSeparator(ksdoc->map()->calculationSettings()->locale()->thousandsSeparator());
-    if (!m_chain->manager()->getBatchMode() && !dialog->exec())
+    if (!m_chain->manager()->getBatchMode() && !dialog->exec()) {
+        delete dialog;
         return KoFilter::UserCancelled;
-    inputFile.resize(0);   // Release memory (input file content)
+    }
 
     ElapsedTime t("Filling data into document");
 
-    Sheet *sheet = ksdoc->map()->addNewSheet();
-
-    int numRows = dialog->rows();
-    int numCols = dialog->cols();
-
-    if (numRows == 0)
-        ++numRows;
+    Map *const map = ksdoc->map();
+    Sheet *sheet = map->addNewSheet();
 
     // Initialize the decimal symbol and thousands separator to use for parsing.
-    const QString documentDecimalSymbol = ksdoc->map()->calculationSettings()->locale()->decimalSymbol();
-    const QString documentThousandsSeparator = ksdoc->map()->calculationSettings()->locale()->thousandsSeparator();
-    ksdoc->map()->calculationSettings()->locale()->setDecimalSymbol(dialog->decimalSymbol());
-    ksdoc->map()->calculationSettings()->locale()->setThousandsSeparator(dialog->thousandsSeparator());
+    const QString documentDecimalSymbol = map->calculationSettings()->locale()->decimalSymbol();
+    const QString documentThousandsSeparator = map->calculationSettings()->locale()->thousandsSeparator();
+    map->calculationSettings()->locale()->setDecimalSymbol(dialog->decimalSymbol());
+    map->calculationSettings()->locale()->setThousandsSeparator(dialog->thousandsSeparator());
 
-    int step = 100 / numRows * numCols;
-    int value = 0;
+    CSVReader reader(dialog);
+    delete dialog;
+    connect(&reader, SIGNAL(progress(int)), this, SIGNAL(sigProgress(int)));
 
-    emit sigProgress(value);
+    emit sigProgress(0);
     QApplication::setOverrideCursor(Qt::WaitCursor);
 
-    const double defaultWidth = ksdoc->map()->defaultColumnFormat()->width();
-    QVector<double> widths(numCols);
-    for (int i = 0; i < numCols; ++i)
-        widths[i] = defaultWidth;
-
-    Cell cell(sheet, 1, 1);
-    QFontMetrics fm(cell.style().font());
-
-    for (int row = 0; row < numRows; ++row) {
-        for (int col = 0; col < numCols; ++col) {
-            value += step;
-            emit sigProgress(value);
-            const QString text(dialog->text(row, col));
-
-            // ### FIXME: how to calculate the width of numbers (as they might not be in the right format)
-            const double len = fm.width(text);
-            if (len > widths[col])
-                widths[col] = len;
-
-            cell = Cell(sheet, col + 1, row + 1);
-
-            switch (dialog->dataType(col)) {
-            case KoCsvImportDialog::Generic:
-            default: {
-                cell.parseUserInput(text);
-                break;
-            }
-            case KoCsvImportDialog::Text: {
-                Value value(text);
-                cell.setValue(value);
-                cell.setUserInput(ksdoc->map()->converter()->asString(value).asString());
-                break;
-            }
-            case KoCsvImportDialog::Date: {
-                Value value(text);
-                cell.setValue(ksdoc->map()->converter()->asDate(value));
-                cell.setUserInput(ksdoc->map()->converter()->asString(value).asString());
-                break;
-            }
-            case KoCsvImportDialog::Currency: {
-                Value value(text);
-                value.setFormat(Value::fmt_Money);
-                cell.setValue(value);
-                cell.setUserInput(ksdoc->map()->converter()->asString(value).asString());
-                break;
-            }
-            case KoCsvImportDialog::None: {
-                // just skip the content
-                break;
-            }
-            }
-        }
-    }
+    in.seek(0);
+    reader.read(&in, sheet);
+    in.close();
 
     emit sigProgress(98);
 
-    for (int i = 0; i < numCols; ++i) {
-        if (widths[i] > defaultWidth)
-            sheet->nonDefaultColumnFormat(i + 1)->setWidth(widths[i]);
-    }
-
     // Restore the document's decimal symbol and thousands separator.
-    ksdoc->map()->calculationSettings()->locale()->setDecimalSymbol(documentDecimalSymbol);
-    ksdoc->map()->calculationSettings()->locale()->setThousandsSeparator(documentThousandsSeparator);
+    map->calculationSettings()->locale()->setDecimalSymbol(documentDecimalSymbol);
+    map->calculationSettings()->locale()->setThousandsSeparator(documentThousandsSeparator);
 
     emit sigProgress(100);
     QApplication::restoreOverrideCursor();
-    delete dialog;
 
     return KoFilter::OK;
 }
@@ -0,0 +1,355 @@
+/* This file is part of the KDE project
+   Copyright (C) 2016 The Calligra developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#include "csvreader.h"
+
+#include <QFontMetrics>
+#include <QIODevice>
+#include <QQueue>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QSemaphore>
+#include <QTextCodec>
+
+#ifdef CALLIGRA_SHEETS_MT
+#include <QThreadPool>
+#endif
+
+#include <KoCsvParser.h>
+
+#include <sheets/Cell.h>
+#include <sheets/CellStorage.h>
+#include <sheets/Damages.h>
+#include <sheets/Formula.h>
+#include <sheets/Map.h>
+#include <sheets/Region.h>
+#include <sheets/RowColumnFormat.h>
+#include <sheets/Sheet.h>
+#include <sheets/Style.h>
+#include <sheets/Value.h>
+#include <sheets/ValueConverter.h>
+#include <sheets/ValueParser.h>
+
+using namespace Calligra::Sheets;
+
+// The amount of data read and parsed at once.
+static const qint64 s_chunkSize = 4 << 20;
+
+namespace
+{
+// The options of the conversion.
+struct Settings {
+    QString delimiter;
+    QChar textQuote;
+    bool ignoreDuplicates;
+    int startCol;
+    int endCol;
+    QVector<KoCsvImportDialog::DataType> dataTypes;
+    bool firstLetterUpper;
+    const ValueParser* parser;
+    const ValueConverter* converter;
+};
+
+struct Field {
+    // the row relative to the chunk counted from 1
+    int row;
+    int column;
+    QString userInput;
+    Value value;
+    bool formula;
+};
+
+/**
+ * Parses a chunk of complete lines and converts the fields to values.
+ * Each line is a row; like in the import dialog quoted fields do not
+ * span lines, so a chunk can be parsed independently of the others.
+ */
+class ChunkJob : public QRunnable
+{
+public:
+    ChunkJob(const QString& text, bool last, const Settings& settings)
+            : rows(0)
+            , m_text(text)
+            , m_last(last)
+            , m_settings(settings) {
+        setAutoDelete(false);
+    }
+
+    void run() Q_DECL_OVERRIDE;
+
+    // Blocks until the chunk is parsed.
+    void wait() {
+        m_done.acquire();
+    }
+
+    void addField(int row, int column, const QString& text);
+
+    // the number of lines
+    int rows;
+    // the converted fields in row order
+    QVector<Field> fields;
+    // the longest text per column, which determines the column width
+    QVector<QString> longest;
+
+private:
+    QString m_text;
+    const bool m_last;
+    const Settings m_settings;
+    QSemaphore m_done;
+};
+
+class ChunkParser : public KoCsvParser
+{
+public:
+    ChunkParser(ChunkJob* job, const Settings& settings)
+            : KoCsvParser(settings.delimiter, settings.textQuote, settings.ignoreDuplicates)
+            , m_job(job) {}
+
+protected:
+    void addField(int row, int column, const QString& text) Q_DECL_OVERRIDE {
+        m_job->addField(row, column, text);
+    }
+
+private:
+    ChunkJob* const m_job;
+};
+
+void ChunkJob::run()
+{
+    ChunkParser parser(this, m_settings);
+    parser.parse(m_text);
+    if (m_last)
+        parser.finish();
+    rows = parser.rows();
+    m_text.clear();
+    m_done.release();
+}
+
+void ChunkJob::addField(int row, int column, const QString& text)
+{
+    // the column of the dialog's table
+    const int col = column - m_settings.startCol;
+    if (text.isEmpty() || col < 1 || (m_settings.endCol >= 0 && col > m_settings.endCol - m_settings.startCol))
+        return;
+    const KoCsvImportDialog::DataType dataType = m_settings.dataTypes.value(col - 1, KoCsvImportDialog::Generic);
+    if (dataType == KoCsvImportDialog::None)
+        return; // just skip the content
+
+    Field field;
+    field.row = row;
+    field.column = col;
+    field.formula = false;
+    switch (dataType) {
+    case KoCsvImportDialog::Generic:
+    default:
+        // the semantics of Cell::parseUserInput()
+        field.userInput = text;
+        if (text[0] == '=') {
+            field.formula = true;
+            break;
+        }
+        field.value = m_settings.parser->parse(text);
+        if (m_settings.firstLetterUpper && field.value.isString()) {
+            const QString string = field.value.asString();
+            field.value = Value(string[0].toUpper() + string.right(string.length() - 1));
+        }
+        break;
+    case KoCsvImportDialog::Text:
+        field.value = Value(text);
+        field.userInput = m_settings.converter->asString(field.value).asString();
+        break;
+    case KoCsvImportDialog::Date:
+        field.value = m_settings.converter->asDate(Value(text));
+        field.userInput = m_settings.converter->asString(Value(text)).asString();
+        break;
+    case KoCsvImportDialog::Currency:
+        field.value = Value(text);
+        field.value.setFormat(Value::fmt_Money);
+        field.userInput = m_settings.converter->asString(field.value).asString();
+        break;
+    }
+    // like Cell::setUserInput() the forced types become formulas, too
+    if (!field.userInput.isEmpty() && field.userInput[0] == '=')
+        field.formula = true;
+
+    fields.append(field);
+    if (longest.count() < col)
+        longest.resize(col);
+    if (text.length() > longest[col - 1].length())
+        longest[col - 1] = text;
+}
+}
+
+CSVReader::CSVReader(const KoCsvImportDialog* dialog)
+        : m_delimiter(dialog->delimiter())
+        , m_textQuote(dialog->textQuote())
+        , m_ignoreDuplicates(dialog->ignoreDuplicates())
+        , m_codec(dialog->codec())
+        , m_startRow(dialog->startRow())
+        , m_startCol(dialog->startCol())
+        , m_endRow(dialog->endRow())
+        , m_endCol(dialog->endCol())
+        , m_chunkSize(s_chunkSize)
+{
+    for (int col = 0; col < dialog->cols(); ++col)
+        m_dataTypes.append(dialog->dataType(col));
+}
+
+CSVReader::~CSVReader()
+{
+}
+
+void CSVReader::setChunkSize(qint64 size)
+{
+    m_chunkSize = size;
+}
+
+void CSVReader::read(QIODevice* device, Sheet* sheet)
+{
+    Map *const map = sheet->map();
+    CellStorage *const storage = sheet->cellStorage();
+
+    Settings settings;
+    settings.delimiter = m_delimiter;
+    settings.textQuote = m_textQuote;
+    settings.ignoreDuplicates = m_ignoreDuplicates;
+    settings.startCol = m_startCol;
+    settings.endCol = m_endCol;
+    settings.dataTypes = m_dataTypes;
+    settings.firstLetterUpper = sheet->getFirstLetterUpper();
+    settings.parser = map->parser();
+    settings.converter = map->converter();
+
+    const double defaultWidth = map->defaultColumnFormat()->width();
+    QVector<double> widths;
+    QFontMetrics fm(Cell(sheet, 1, 1).style().font());
+
+    // Suppress the damages and recalculations of the single cells.
+    const bool loading = map->isLoading();
+    map->setLoading(true);
+
+    // Chunks get parsed in parallel, but the memory usage is bounded by
+    // committing the oldest ones, if there are too many in flight.
+#ifdef CALLIGRA_SHEETS_MT
+    const int maximumJobs = 2 * QThreadPool::globalInstance()->maxThreadCount();
+#else
+    const int maximumJobs = 0;
+#endif
+    QQueue<ChunkJob*> jobs;
+    QScopedPointer<QTextDecoder> decoder(m_codec->makeDecoder());
+    QString pending;
+    bool skipLineFeed = false;
+    bool finished = false;
+    // the lines of the committed chunks
+    int lines = 0;
+    QRect formulaRange;
+
+    const qint64 size = qMax<qint64>(device->size(), 1);
+    while (!finished) {
+        const QByteArray data(device->read(m_chunkSize));
+        const bool atEnd = data.isEmpty() || device->atEnd();
+        pending += decoder->toUnicode(data);
+        if (skipLineFeed && !pending.isEmpty()) {
+            if (pending[0] == '\n')
+                pending.remove(0, 1);
+            skipLineFeed = false;
+        }
+
+        // Split after the last line end.
+        int cut = pending.length();
+        if (!atEnd) {
+            while (cut > 0 && pending[cut - 1] != '\n' && pending[cut - 1] != '\r')
+                --cut;
+            // The line feed of a CR LF line end may be in the next chunk.
+            skipLineFeed = cut > 0 && cut == pending.length() && pending[cut - 1] == '\r';
+        }
+        if (cut > 0) {
+            ChunkJob *job = new ChunkJob(pending.left(cut), atEnd, settings);
+            pending.remove(0, cut);
+            jobs.enqueue(job);
+#ifdef CALLIGRA_SHEETS_MT
+            QThreadPool::globalInstance()->start(job);
+#else
+            job->run();
+#endif
+        }
+
+        while (!jobs.isEmpty() && (atEnd || jobs.count() > maximumJobs)) {
+            ChunkJob *job = jobs.dequeue();
+            job->wait();
+            // In row order every cell gets appended to the storage.
+            for (int i = 0; i < job->fields.count(); ++i) {
+                const Field& field = job->fields[i];
+                const int row = lines + field.row - m_startRow;
+                if (row < 1)
+                    continue;
+                if (m_endRow >= 0 && row > m_endRow - m_startRow)
+                    break;
+                const int col = field.column;
+                if (field.formula) {
+                    Formula formula(sheet, Cell(sheet, col, row));
+                    formula.setExpression(field.userInput);
+                    storage->setFormula(col, row, formula);
+                    if (!formula.isValid())
+                        storage->setValue(col, row, Value::errorPARSE());
+                    else if (!field.value.isEmpty())
+                        storage->setValue(col, row, field.value);
+                    formulaRange |= QRect(col, row, 1, 1);
+                } else {
+                    storage->setUserInput(col, row, field.userInput);
+                    storage->setValue(col, row, field.value);
+                }
+            }
+
+            // ### FIXME: how to calculate the width of numbers (as they might not be in the right format)
+            for (int index = 0; index < job->longest.count(); ++index) {
+                if (job->longest[index].isEmpty())
+                    continue;
+                while (widths.count() <= index)
+                    widths.append(defaultWidth);
+                const double len = fm.width(job->longest[index]);
+                if (len > widths[index])
+                    widths[index] = len;
+            }
+            lines += job->rows;
+            delete job;
+            if (m_endRow >= 0 && lines >= m_endRow)
+                finished = true;
+        }
+
+        emit progress(int(98 * device->pos() / size));
+        if (atEnd)
+            finished = true;
+    }
+    // Wait for the chunks, that are not needed anymore.
+    while (!jobs.isEmpty()) {
+        ChunkJob *job = jobs.dequeue();
+        job->wait();
+        delete job;
+    }
+
+    map->setLoading(loading);
+    if (!formulaRange.isNull())
+        map->addDamage(new CellDamage(sheet, Region(formulaRange, sheet), CellDamage::Formula | CellDamage::Value));
+
+    for (int i = 0; i < widths.count(); ++i) {
+        if (widths[i] > defaultWidth)
+            sheet->nonDefaultColumnFormat(i + 1)->setWidth(widths[i]);
+    }
+}
@@ -0,0 +1,81 @@
+/* This file is part of the KDE project
+   Copyright (C) 2016 The Calligra developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CSVREADER_H
+#define CSVREADER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include <KoCsvImportDialog.h>
+
+class QIODevice;
+class QTextCodec;
+
+namespace Calligra
+{
+namespace Sheets
+{
+class Sheet;
+}
+}
+
+/**
+ * Reads CSV data chunk by chunk into a sheet with the options chosen in a
+ * KoCsvImportDialog, so that the sheet shows the fields of the dialog's
+ * table at the same positions.
+ */
+class CSVReader : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Takes the options from \p dialog , which may be deleted afterwards.
+     */
+    explicit CSVReader(const KoCsvImportDialog* dialog);
+    virtual ~CSVReader();
+
+    /**
+     * Sets the amount of data read and parsed at once.
+     */
+    void setChunkSize(qint64 size);
+
+    /**
+     * Reads the data from \p device into \p sheet .
+     */
+    void read(QIODevice* device, Calligra::Sheets::Sheet* sheet);
+
+Q_SIGNALS:
+    void progress(int percent);
+
+private:
+    QString m_delimiter;
+    QChar m_textQuote;
+    bool m_ignoreDuplicates;
+    QTextCodec* m_codec;
+    int m_startRow;
+    int m_startCol;
+    int m_endRow;
+    int m_endCol;
+    QVector<KoCsvImportDialog::DataType> m_dataTypes;
+    qint64 m_chunkSize;
+};
+
+#endif // CSVREADER_H
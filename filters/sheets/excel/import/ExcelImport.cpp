@@ -64,6 +64,7 @@
 #include <Style.h>
 #include <StyleManager.h>
 #include <StyleStorage.h>
+#include <StringPool.h>
 #include <ValueConverter.h>
 #include <ShapeApplicationData.h>
 #include <Util.h>
@@ -162,6 +163,8 @@ public:
     QHash<int, QRegion> rowStyles;
     QHash<int, QRegion> columnStyles;
     QList<QPair<QRegion, Calligra::Sheets::Conditions> > cellConditions;
+    // cells repeating a text share its value
+    Calligra::Sheets::StringPool stringPool;
 
     QList<KoOdfChartWriter*> charts;
     void processCharts(KoXmlWriter* manifestWriter);
@@ -276,6 +279,8 @@ KoFilter::ConversionStatus ExcelImport::convert(const QByteArray& from, const QB
         d->processSheet(sheet, ksheet);
         d->shapesXml->endElement();
     }
+    // the cells keep the shared values
+    d->stringPool.clear();
 
     // named expressions
     const std::map<std::pair<unsigned, QString>, QString>& namedAreas = d->workbook->namedAreas();
@@ -945,12 +950,13 @@ void ExcelImport::Private::processCell(Cell* ic, Calligra::Sheets::Cell oc)
             }
         }
 
-        oc.setValue(Calligra::Sheets::Value(txt));
+        const Calligra::Sheets::Value pooled = stringPool.value(txt);
+        oc.setValue(pooled);
         if (!isFormula) {
             if (txt.startsWith('='))
                 oc.setRawUserInput('\'' + txt);
             else
-                oc.setRawUserInput(txt);
+                oc.setRawUserInput(pooled.asString());
         }
         if (value.isRichText() || ic->format().font().subscript() || ic->format().font().superscript()) {
             std::map<unsigned, FormatFont> formatRuns = value.formatRuns();
@@ -66,8 +66,7 @@ public:
     std::map<unsigned, int> formatCache;
 
     // shared-string table
-    std::vector<QString> stringTable;
-    std::vector<std::map<unsigned, FormatFont> > formatRunsTable;
+    std::vector<Value> stringTable;
 
     // table of Xformat
     std::vector<XFRecord> xfTable;
@@ -148,15 +147,23 @@ Sheet* GlobalsSubStreamHandler::sheetFromPosition(unsigned position) const
 QString GlobalsSubStreamHandler::stringFromSST(unsigned index) const
 {
     if (index < d->stringTable.size())
-        return d->stringTable[index];
+        return d->stringTable[index].asString();
     else
         return QString();
 }
 
+Value GlobalsSubStreamHandler::valueFromSST(unsigned index) const
+{
+    if (index < d->stringTable.size())
+        return d->stringTable[index];
+    else
+        return Value(QString());
+}
+
 std::map<unsigned, FormatFont> GlobalsSubStreamHandler::formatRunsFromSST(unsigned index) const
 {
-    if (index < d->formatRunsTable.size())
-        return d->formatRunsTable[index];
+    if (index < d->stringTable.size())
+        return d->stringTable[index].formatRuns();
     else
         return std::map<unsigned, FormatFont>();
 }
@@ -719,16 +726,18 @@ void GlobalsSubStreamHandler::handleSST(SSTRecord* record)
     if (!record) return;
 
     d->stringTable.clear();
-    d->formatRunsTable.clear();
+    d->stringTable.reserve(record->count());
     for (unsigned i = 0; i < record->count(); ++i) {
         QString str = record->stringAt(i);
-        d->stringTable.push_back(str);
         std::map<unsigned, unsigned> formatRunsRaw = record->formatRunsAt(i);
         std::map<unsigned, FormatFont> formatRuns;
         for (std::map<unsigned, unsigned>::iterator it = formatRunsRaw.begin(); it != formatRunsRaw.end(); ++it) {
             formatRuns[it->first] = d->workbook->font(it->second);
         }
-        d->formatRunsTable.push_back(formatRuns);
+        if (!formatRuns.empty())
+            d->stringTable.push_back(Value(str, formatRuns));
+        else
+            d->stringTable.push_back(Value(str));
     }
 }
 
@@ -72,6 +72,8 @@ public:
     Sheet* sheetFromPosition(unsigned position) const;
     QString stringFromSST(unsigned index) const;
     std::map<unsigned, FormatFont> formatRunsFromSST(unsigned index) const;
+    // the value of the shared string, shared by all cells referring to it
+    Value valueFromSST(unsigned index) const;
 
     unsigned fontCount() const;//
     FontRecord fontRecord(unsigned index) const;  //
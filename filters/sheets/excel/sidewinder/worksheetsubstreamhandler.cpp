@@ -503,15 +503,10 @@ void WorksheetSubStreamHandler::handleLabelSST(LabelSSTRecord* record)
     unsigned index = record->sstIndex();
     unsigned xfIndex = record->xfIndex();
 
-    QString str = d->globals->stringFromSST(index);
-    std::map<unsigned, FormatFont> formatRuns = d->globals->formatRunsFromSST(index);
-
     Cell* cell = d->sheet->cell(column, row, true);
     if (cell) {
-        if (!formatRuns.empty())
-            cell->setValue(Value(str, formatRuns));
-        else
-            cell->setValue(Value(str));
+        // all cells referring to the string share its value
+        cell->setValue(d->globals->valueFromSST(index));
         cell->setFormat(d->globals->convertedFormat(xfIndex));
     }
 }
@@ -0,0 +1,179 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "BenchmarkXlsxImport.h"
+
+#include <sheets/CellStorage.h>
+#include <sheets/Map.h>
+#include <sheets/Sheet.h>
+#include <sheets/part/Doc.h>
+#include <sheets/tests/MockPart.h>
+
+#include <KoFilterManager.h>
+#include <KoStore.h>
+
+#include <QFile>
+#include <QTest>
+
+// 10 columns of numbers and a column of formulas summing them up in 100000 rows
+static const int s_columns = 10;
+static const int s_rows = 100000;
+
+static const char s_xlsxMimeType[] = "application/vnd.openxmlformats-officedocument.spreadsheetml.sheet";
+static const char s_odsMimeType[] = "application/vnd.oasis.opendocument.spreadsheet";
+
+//! @return the peak resident memory in bytes since the last resetPeakMemory()
+static qint64 peakMemory()
+{
+#ifdef Q_OS_LINUX
+    QFile file("/proc/self/status");
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+    foreach (const QByteArray& line, file.readAll().split('\n')) {
+        if (line.startsWith("VmHWM:"))
+            return line.mid(6).trimmed().split(' ').first().toLongLong() * 1024;
+    }
+#endif
+    return -1;
+}
+
+//! Resets the peak resident memory to the current one.
+static bool resetPeakMemory()
+{
+#ifdef Q_OS_LINUX
+    QFile file("/proc/self/clear_refs");
+    return file.open(QIODevice::WriteOnly) && file.write("5") == 1;
+#else
+    return false;
+#endif
+}
+
+static bool writeEntry(KoStore* store, const QString& name, const QByteArray& data)
+{
+    return store->open(name) && store->write(data) == data.size() && store->close();
+}
+
+void BenchmarkXlsxImport::initTestCase()
+{
+    const QStringList importers = KoFilterManager::mimeFilter(s_odsMimeType, KoFilterManager::Import);
+    if (!importers.contains(QLatin1String(s_xlsxMimeType)))
+        QSKIP("The XLSX import filter is not installed.");
+    QVERIFY(m_dir.isValid());
+
+    QByteArray sheet("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                     "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\"><sheetData>");
+    for (int row = 1; row <= s_rows; ++row) {
+        const QByteArray r = QByteArray::number(row);
+        sheet += "<row r=\"" + r + "\">";
+        for (int col = 0; col < s_columns; ++col) {
+            sheet += "<c r=\"" + QByteArray(1, 'A' + col) + r + "\"><v>"
+                     + QByteArray::number((row * s_columns + col) % 1000) + "</v></c>";
+        }
+        sheet += "<c r=\"K" + r + "\"><f>SUM(A" + r + ":J" + r + ")</f></c></row>";
+    }
+    sheet += "</sheetData></worksheet>";
+
+    m_fileName = m_dir.path() + QLatin1String("/benchmark.xlsx");
+    KoStore* store = KoStore::createStore(m_fileName, KoStore::Write, s_xlsxMimeType, KoStore::Zip, false);
+    QVERIFY(store && !store->bad());
+    QVERIFY(writeEntry(store, "[Content_Types].xml",
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+        "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+        "<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+        "<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>"
+        "<Override PartName=\"/xl/styles.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml\"/>"
+        "<Override PartName=\"/xl/worksheets/sheet1.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>"
+        "</Types>"));
+    QVERIFY(writeEntry(store, "_rels/.rels",
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+        "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>"
+        "</Relationships>"));
+    QVERIFY(writeEntry(store, "xl/workbook.xml",
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        "<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\""
+        " xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\">"
+        "<sheets><sheet name=\"Sheet1\" sheetId=\"1\" r:id=\"rId1\"/></sheets></workbook>"));
+    QVERIFY(writeEntry(store, "xl/_rels/workbook.xml.rels",
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+        "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"worksheets/sheet1.xml\"/>"
+        "<Relationship Id=\"rId2\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\" Target=\"styles.xml\"/>"
+        "</Relationships>"));
+    QVERIFY(writeEntry(store, "xl/styles.xml",
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        "<styleSheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\">"
+        "<fonts count=\"1\"><font><sz val=\"11\"/><name val=\"Calibri\"/></font></fonts>"
+        "<fills count=\"1\"><fill><patternFill patternType=\"none\"/></fill></fills>"
+        "<borders count=\"1\"><border/></borders>"
+        "<cellXfs count=\"1\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\"/></cellXfs>"
+        "</styleSheet>"));
+    QVERIFY(writeEntry(store, "xl/worksheets/sheet1.xml", sheet));
+    QVERIFY(store->finalize());
+    delete store;
+}
+
+void BenchmarkXlsxImport::testImport_data()
+{
+    QTest::addColumn<bool>("direct");
+
+    // the import into an ODF file, loaded afterwards, as for embedded documents
+    QTest::newRow("ODF") << false;
+    QTest::newRow("direct") << true;
+}
+
+void BenchmarkXlsxImport::testImport()
+{
+    QFETCH(bool, direct);
+    const bool measureMemory = resetPeakMemory();
+
+    Calligra::Sheets::Doc doc(new MockPart);
+    doc.setAutoErrorHandlingEnabled(false);
+    QBENCHMARK_ONCE {
+        KoFilter::ConversionStatus status;
+        if (direct) {
+            KoFilterManager manager(&doc);
+            manager.setBatchMode(true);
+            QVERIFY(manager.importDocument(m_fileName, QString(), status).isEmpty());
+        } else {
+            const QString odsFileName = m_dir.path() + QLatin1String("/benchmark.ods");
+            KoFilterManager manager(m_fileName, s_xlsxMimeType);
+            manager.setBatchMode(true);
+            QByteArray mimeType(s_odsMimeType);
+            status = manager.exportDocument(odsFileName, mimeType);
+            QCOMPARE(status, KoFilter::OK);
+            QVERIFY(doc.loadNativeFormat(odsFileName));
+        }
+        QCOMPARE(status, KoFilter::OK);
+    }
+    if (measureMemory) {
+        qDebug() << QTest::currentDataTag() << "peak resident memory:" << peakMemory() / 1024 << "kB";
+    }
+
+    const Calligra::Sheets::Sheet* sheet = doc.map()->sheet(0);
+    QVERIFY(sheet);
+    const int row = s_rows;
+    int sum = 0;
+    for (int col = 0; col < s_columns; ++col)
+        sum += (row * s_columns + col) % 1000;
+    QCOMPARE(double(sheet->cellStorage()->value(s_columns + 1, row).asFloat()), double(sum));
+}
+
+QTEST_MAIN(BenchmarkXlsxImport)
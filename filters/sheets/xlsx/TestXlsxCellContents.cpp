@@ -0,0 +1,196 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "TestXlsxCellContents.h"
+
+#include "XlsxCellContents.h"
+#include "XlsxXmlWorksheetReader_p.h"
+
+#include <sheets/Cell.h>
+#include <sheets/Map.h>
+#include <sheets/Sheet.h>
+#include <sheets/Value.h>
+#include <sheets/odf/CellContentsLoader.h>
+
+#include <KoXmlReader.h>
+
+#include <QTest>
+
+//! @return the table:table-cell element the worksheet reader writes for @a cell,
+//! if its contents are not written directly
+static QString tableCell(const Cell* cell, const QString& formula)
+{
+    QString attributes;
+    switch (cell->valueType) {
+    case Cell::ConstNone:
+        break;
+    case Cell::ConstString:
+        attributes += " office:value-type=\"string\"";
+        break;
+    case Cell::ConstBoolean:
+        attributes += " office:value-type=\"boolean\"";
+        break;
+    case Cell::ConstDate:
+        attributes += " office:value-type=\"date\"";
+        break;
+    case Cell::ConstFloat:
+        attributes += " office:value-type=\"float\"";
+        break;
+    }
+    if (cell->valueAttrValue) {
+        switch (cell->valueAttr) {
+        case Cell::OfficeNone:
+            break;
+        case Cell::OfficeValue:
+            attributes += " office:value=\"" + *cell->valueAttrValue + '"';
+            break;
+        case Cell::OfficeStringValue:
+            attributes += " office:string-value=\"" + *cell->valueAttrValue + '"';
+            break;
+        case Cell::OfficeBooleanValue:
+            attributes += QString(" office:boolean-value=\"%1\"").arg(*cell->valueAttrValue == "0" ? "false" : "true");
+            break;
+        case Cell::OfficeDateValue:
+            attributes += " office:date-value=\"" + *cell->valueAttrValue + '"';
+            break;
+        }
+    }
+    if (!formula.isEmpty()) {
+        attributes += " table:formula=\"" + formula + '"';
+    }
+    const QString content = cell->text.isEmpty() ? QString() : "<text:p>" + cell->text + "</text:p>";
+    return "<table:table-cell xmlns:text=\"urn:oasis:names:tc:opendocument:xmlns:text:1.0\""
+           " xmlns:table=\"urn:oasis:names:tc:opendocument:xmlns:table:1.0\""
+           " xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\"" + attributes + '>'
+           + content + "</table:table-cell>";
+}
+
+//! Creates the cell at @a column, @a row as the worksheet reader does for an
+//! XLSX cell with the XML escaped @a text and the @a value of the attribute.
+static Cell* createCell(int column, int row, Cell::ValueType valueType, const QString& text,
+                        Cell::ValueAttr valueAttr = Cell::OfficeNone, const QString& value = QString())
+{
+    Cell* cell = new Cell(column, row);
+    cell->valueType = valueType;
+    cell->text = text;
+    cell->valueAttr = valueAttr;
+    if (valueAttr != Cell::OfficeNone) {
+        cell->valueAttrValue = new QString(value);
+    }
+    return cell;
+}
+
+void TestXlsxCellContents::testOdfEquivalence()
+{
+    QList<QPair<Cell*, QString> > cells;
+    // shared strings
+    cells << qMakePair(createCell(0, 0, Cell::ConstString, "Some text"), QString());
+    cells << qMakePair(createCell(0, 1, Cell::ConstString, "Some text"), QString());
+    cells << qMakePair(createCell(0, 2, Cell::ConstString, "  Some  text "), QString());
+    // plain cells
+    cells << qMakePair(createCell(0, 3, Cell::ConstString, "Fish &amp; Chips"), QString());
+    cells << qMakePair(createCell(0, 4, Cell::ConstString, "=1+2"), QString());
+    cells << qMakePair(createCell(1, 0, Cell::ConstFloat, QString(), Cell::OfficeValue, "1.5"), QString());
+    cells << qMakePair(createCell(1, 1, Cell::ConstFloat, QString(), Cell::OfficeValue, "0.1"), QString());
+    cells << qMakePair(createCell(1, 2, Cell::ConstBoolean, "1", Cell::OfficeBooleanValue, "1"), QString());
+    cells << qMakePair(createCell(1, 3, Cell::ConstBoolean, "0", Cell::OfficeBooleanValue, "0"), QString());
+    cells << qMakePair(createCell(1, 4, Cell::ConstDate, "2016-02-29", Cell::OfficeDateValue, "2016-02-29"), QString());
+    cells << qMakePair(createCell(1, 5, Cell::ConstFloat, "#NAME?", Cell::OfficeValue, "0"), QString());
+    // formulas
+    cells << qMakePair(createCell(2, 0, Cell::ConstFloat, QString(), Cell::OfficeValue, "3"), QString("of:=[.B1]*2"));
+    cells << qMakePair(createCell(2, 1, Cell::ConstString, "Some text", Cell::OfficeStringValue, "Some text"), QString("of:=[.A1]"));
+    cells << qMakePair(createCell(2, 2, Cell::ConstBoolean, "1", Cell::OfficeBooleanValue, "1"), QString("of:=[.B3]"));
+
+    Calligra::Sheets::Map map;
+    Calligra::Sheets::Sheet* direct = map.addNewSheet();
+    Calligra::Sheets::Sheet* odf = map.addNewSheet();
+
+    // the contents written directly
+    XlsxCellContents contents;
+    contents.startSheet(direct->sheetName());
+    for (int i = 0; i < cells.count(); ++i) {
+        QVERIFY(contents.take(cells[i].first, cells[i].second));
+    }
+    contents.write(&map);
+
+    // the contents loaded from the ODF document
+    map.setLoading(true);
+    {
+        Calligra::Sheets::Odf::CellContentsLoader loader(&map);
+        for (int i = 0; i < cells.count(); ++i) {
+            const Cell* cell = cells[i].first;
+            KoXmlDocument doc;
+            QVERIFY(doc.setContent(tableCell(cell, cells[i].second), true));
+            QVERIFY(loader.read(odf, doc.documentElement(), cell->column + 1, cell->row + 1, 1, 1));
+        }
+        loader.finish();
+    }
+    map.setLoading(false);
+
+    for (int i = 0; i < cells.count(); ++i) {
+        const int column = cells[i].first->column + 1;
+        const int row = cells[i].first->row + 1;
+        const Calligra::Sheets::Cell expected(odf, column, row);
+        const Calligra::Sheets::Cell actual(direct, column, row);
+        QCOMPARE(actual.value(), expected.value());
+        QCOMPARE(int(actual.value().format()), int(expected.value().format()));
+        QCOMPARE(actual.userInput(), expected.userInput());
+        QCOMPARE(actual.isFormula(), expected.isFormula());
+    }
+
+    // cells repeating a text share its value
+    const Calligra::Sheets::Value first = Calligra::Sheets::Cell(direct, 1, 1).value();
+    const Calligra::Sheets::Value second = Calligra::Sheets::Cell(direct, 1, 2).value();
+    QCOMPARE(first.asString().constData(), second.asString().constData());
+
+    for (int i = 0; i < cells.count(); ++i) {
+        delete cells[i].first;
+    }
+}
+
+void TestXlsxCellContents::testAppend()
+{
+    Cell* first = createCell(0, 0, Cell::ConstString, "Some text");
+    Cell* second = createCell(0, 0, Cell::ConstString, "Some text");
+
+    Calligra::Sheets::Map map;
+    Calligra::Sheets::Sheet* sheet1 = map.addNewSheet();
+    Calligra::Sheets::Sheet* sheet2 = map.addNewSheet();
+
+    // the second worksheet read on its own
+    XlsxCellContents contents;
+    contents.startSheet(sheet1->sheetName());
+    QVERIFY(contents.take(first, QString()));
+    XlsxCellContents other;
+    other.startSheet(sheet2->sheetName());
+    QVERIFY(other.take(second, QString()));
+    contents.append(&other);
+    contents.write(&map);
+
+    const Calligra::Sheets::Value value1 = Calligra::Sheets::Cell(sheet1, 1, 1).value();
+    const Calligra::Sheets::Value value2 = Calligra::Sheets::Cell(sheet2, 1, 1).value();
+    QCOMPARE(value1, Calligra::Sheets::Value("Some text"));
+    QCOMPARE(value2, Calligra::Sheets::Value("Some text"));
+    QCOMPARE(value1.asString().constData(), value2.asString().constData());
+
+    delete first;
+    delete second;
+}
+
+QTEST_MAIN(TestXlsxCellContents)
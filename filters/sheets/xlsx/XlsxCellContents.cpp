@@ -0,0 +1,249 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "XlsxCellContents.h"
+#include "XlsxXmlWorksheetReader_p.h"
+
+#include <sheets/CalculationSettings.h>
+#include <sheets/Cell.h>
+#include <sheets/Map.h>
+#include <sheets/Sheet.h>
+#include <sheets/StringPool.h>
+#include <sheets/Util.h>
+#include <sheets/Value.h>
+#include <sheets/ValueConverter.h>
+
+#include <KoTextLoader.h>
+
+#include <kdebug.h>
+
+#include <QDateTime>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+#include <ctype.h>
+
+class XlsxCellContents::Private
+{
+public:
+    struct Entry {
+        int column;
+        int row;
+        Cell::ValueType valueType;
+        // the text of the cell, unescaped
+        QString text;
+        // the office:*-value attribute, unescaped
+        QString value;
+        QString formula;
+    };
+
+    void write(Calligra::Sheets::Cell& cell, const Entry& entry);
+
+    // the collected cells by worksheet name
+    QList<QPair<QString, QVector<Entry> > > sheets;
+    // the texts of the cells; cells repeating a text share its value
+    Calligra::Sheets::StringPool strings;
+};
+
+//! Replaces the entities in the XML escaped @a text.
+//! @return false for text with markup or other entities, which is left to the ODF loading
+static bool unescapeText(const QString& text, QString* result)
+{
+    if (text.contains(QLatin1Char('<')))
+        return false;
+    if (!text.contains(QLatin1Char('&'))) {
+        *result = text;
+        return true;
+    }
+    QString unescaped;
+    unescaped.reserve(text.length());
+    for (int i = 0; i < text.length(); ++i) {
+        if (text[i] != QLatin1Char('&')) {
+            unescaped += text[i];
+            continue;
+        }
+        const int end = text.indexOf(QLatin1Char(';'), i);
+        if (end < 0)
+            return false;
+        const QStringRef entity = text.midRef(i + 1, end - i - 1);
+        if (entity == QLatin1String("amp"))
+            unescaped += QLatin1Char('&');
+        else if (entity == QLatin1String("lt"))
+            unescaped += QLatin1Char('<');
+        else if (entity == QLatin1String("gt"))
+            unescaped += QLatin1Char('>');
+        else if (entity == QLatin1String("quot"))
+            unescaped += QLatin1Char('"');
+        else if (entity == QLatin1String("apos"))
+            unescaped += QLatin1Char('\'');
+        else
+            return false;
+        i = end;
+    }
+    *result = unescaped;
+    return true;
+}
+
+//! @return @a text with its whitespace collapsed as in a text:p element
+static QString normalizedText(const QString& text)
+{
+    const int length = text.length();
+    for (int i = 0; i < length; ++i) {
+        const ushort ch = text[i].unicode();
+        // only copy the shared text, if there is something to collapse
+        if (ch == ' ' ? (i == 0 || text[i - 1] == QLatin1Char(' ')) : (ch < 0x20 && isspace(ch)))
+            return KoTextLoader::normalizeWhitespace(text, true);
+    }
+    return text;
+}
+
+// Mirrors Odf::loadCell() for the attributes and the text written by the worksheet reader.
+void XlsxCellContents::Private::write(Calligra::Sheets::Cell& cell, const Entry& entry)
+{
+    Calligra::Sheets::Map* const map = cell.sheet()->map();
+    const bool isFormula = !entry.formula.isEmpty();
+    if (isFormula) {
+        cell.setRawUserInput(Calligra::Sheets::Odf::decodeFormula(entry.formula, cell.locale()));
+    } else if (!entry.text.isEmpty()) {
+        // prepend ' to the text to avoid = to be painted
+        if (entry.text[0] == QLatin1Char('='))
+            cell.setRawUserInput(QLatin1Char('\'') + entry.text);
+        else
+            cell.setRawUserInput(entry.text);
+    }
+
+    switch (entry.valueType) {
+    case Cell::ConstNone:
+        // no value type, parse the user input
+        if (!isFormula && !entry.text.isEmpty())
+            cell.parseUserInput(cell.userInput());
+        break;
+    case Cell::ConstString:
+        if (entry.value.isNull())
+            cell.setValue(strings.value(entry.text));
+        else
+            cell.setValue(Calligra::Sheets::Value(entry.value));
+        break;
+    case Cell::ConstBoolean:
+        if (!entry.value.isNull())
+            cell.setValue(Calligra::Sheets::Value(entry.value != QLatin1String("0")));
+        break;
+    case Cell::ConstDate: {
+        const QDateTime dateTime = QDateTime::fromString(entry.value, Qt::ISODate);
+        if (!dateTime.isValid())
+            break;
+        if (entry.value.contains(QLatin1Char('T')))
+            cell.setValue(Calligra::Sheets::Value(dateTime, map->calculationSettings()));
+        else
+            cell.setValue(Calligra::Sheets::Value(dateTime.date(), map->calculationSettings()));
+        break;
+    }
+    case Cell::ConstFloat: {
+        bool ok = false;
+        Calligra::Sheets::Value value(entry.value.toDouble(&ok));
+        if (ok) {
+            value.setFormat(Calligra::Sheets::Value::fmt_Number);
+            cell.setValue(value);
+        }
+        // the textual representation of a value may be less accurate than the value itself
+        if (!isFormula)
+            cell.setRawUserInput(map->converter()->asString(value).asString());
+        break;
+    }
+    }
+}
+
+XlsxCellContents::XlsxCellContents()
+        : d(new Private)
+{
+}
+
+XlsxCellContents::~XlsxCellContents()
+{
+    delete d;
+}
+
+void XlsxCellContents::startSheet(const QString& sheetName)
+{
+    d->sheets.append(qMakePair(sheetName, QVector<Private::Entry>()));
+}
+
+bool XlsxCellContents::take(const Cell* cell, const QString& formula)
+{
+    Q_ASSERT(!d->sheets.isEmpty());
+    if (cell->embedded || !cell->charStyleName.isEmpty())
+        return false;
+
+    Private::Entry entry;
+    if (!unescapeText(cell->text, &entry.text))
+        return false;
+    entry.text = d->strings.string(normalizedText(entry.text));
+    if (cell->valueAttrValue && cell->valueAttr != Cell::OfficeNone) {
+        if (!unescapeText(*cell->valueAttrValue, &entry.value))
+            return false;
+    }
+    entry.valueType = cell->valueType;
+    entry.formula = formula;
+
+    // nothing but the style, which is part of the ODF document
+    if (entry.text.isEmpty() && entry.value.isNull() && formula.isEmpty())
+        return true;
+
+    entry.column = cell->column + 1;
+    entry.row = cell->row + 1;
+    d->sheets.last().second.append(entry);
+    return true;
+}
+
+void XlsxCellContents::append(XlsxCellContents* contents)
+{
+    for (int i = 0; i < contents->d->sheets.count(); ++i) {
+        QVector<Private::Entry>& entries = contents->d->sheets[i].second;
+        // share the texts with the ones collected so far
+        for (int j = 0; j < entries.count(); ++j)
+            entries[j].text = d->strings.string(entries[j].text);
+        d->sheets.append(contents->d->sheets[i]);
+    }
+    contents->d->sheets.clear();
+    contents->d->strings.clear();
+}
+
+void XlsxCellContents::write(Calligra::Sheets::Map* map)
+{
+    map->setLoading(true);
+    for (int i = 0; i < d->sheets.count(); ++i) {
+        Calligra::Sheets::Sheet* const sheet = map->findSheet(d->sheets[i].first);
+        if (!sheet) {
+            kWarning() << "No sheet named" << d->sheets[i].first;
+            continue;
+        }
+        const QVector<Private::Entry> entries = d->sheets[i].second;
+        // release the memory of the collected contents sheet by sheet
+        d->sheets[i].second.clear();
+        for (int j = 0; j < entries.count(); ++j) {
+            Calligra::Sheets::Cell cell(sheet, entries[j].column, entries[j].row);
+            d->write(cell, entries[j]);
+        }
+    }
+    d->sheets.clear();
+    d->strings.clear();
+    map->setLoading(false);
+}
@@ -0,0 +1,71 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef XLSXCELLCONTENTS_H
+#define XLSXCELLCONTENTS_H
+
+#include <QString>
+
+class Cell;
+
+namespace Calligra
+{
+namespace Sheets
+{
+class Map;
+}
+}
+
+//! Cell contents written directly into a Calligra Sheets document
+/*! When importing into a Calligra Sheets document, the worksheet reader hands
+ the contents of plain cells, i.e. cells without rich text, hyperlinks,
+ comments or embedded objects, over to this class instead of writing them
+ to the ODF document. The ODF document then only carries the styles, the
+ structure and the remaining cells of the worksheets.
+ The collected contents are written into the cells after the ODF document
+ got loaded; they are interpreted the way the ODF loading of Calligra Sheets
+ interprets the table:table-cell elements.
+*/
+class XlsxCellContents
+{
+public:
+    XlsxCellContents();
+    ~XlsxCellContents();
+
+    //! Starts collecting the cells of the worksheet named @a sheetName.
+    void startSheet(const QString& sheetName);
+
+    //! Takes the contents of @a cell of the current worksheet. @a formula is
+    //! the cell's formula in ODF syntax, if any.
+    //! @return false if the contents have to be written to the ODF document
+    bool take(const Cell* cell, const QString& formula);
+
+    //! Takes the contents collected by @a contents over, after the ones collected so far,
+    //! e.g. those of a worksheet read in another thread.
+    void append(XlsxCellContents* contents);
+
+    //! Writes the collected contents into the sheets of @a map.
+    void write(Calligra::Sheets::Map* map);
+
+private:
+    class Private;
+    Private * const d;
+};
+
+#endif
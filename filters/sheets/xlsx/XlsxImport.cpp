@@ -28,6 +28,7 @@
 #include "XlsxXmlSharedStringsReader.h"
 #include "XlsxXmlStylesReader.h"
 #include "XlsxXmlCommentsReader.h"
+#include "XlsxCellContents.h"
 
 #include <MsooXmlUtils.h>
 #include <MsooXmlSchemas.h>
@@ -43,6 +44,7 @@
 #include <QPen>
 #include <QRegExp>
 #include <QImage>
+#include <QTemporaryFile>
 
 #include <kdebug.h>
 #include <kpluginfactory.h>
@@ -50,9 +52,14 @@
 #include <KoEmbeddedDocumentSaver.h>
 #include <KoDocumentInfo.h>
 #include <KoDocument.h>
+#include <KoOdfReadStore.h>
 #include <KoFilterChain.h>
 #include <KoPageLayout.h>
 #include <KoXmlWriter.h>
+#include <KoStore.h>
+
+#include <sheets/DocBase.h>
+#include <sheets/Map.h>
 
 K_PLUGIN_FACTORY_WITH_JSON(XlsxImportFactory, "calligra_filter_xlsx2ods.json", registerPlugin<XlsxImport>();)
 
@@ -65,7 +72,7 @@ enum XlsxDocumentType {
 class XlsxImport::Private
 {
 public:
-    Private() : type(XlsxDocument), macrosEnabled(false) {
+    Private() : type(XlsxDocument), macrosEnabled(false), cellContents(0) {
     }
 
     const char* mainDocumentContentType() const
@@ -79,6 +86,7 @@ public:
 
     XlsxDocumentType type;
     bool macrosEnabled;
+    XlsxCellContents* cellContents;
 };
 
 XlsxImport::XlsxImport(QObject* parent, const QVariantList &)
@@ -91,6 +99,88 @@ XlsxImport::~XlsxImport()
     delete d;
 }
 
+KoFilter::ConversionStatus XlsxImport::convert(const QByteArray& from, const QByteArray& to)
+{
+    if (!acceptsSourceMimeType(from) || !acceptsDestinationMimeType(to)) {
+        return MSOOXML::MsooXmlImport::convert(from, to);
+    }
+    // embedded documents get written to an ODF file
+    KoDocument* document = m_chain->outputDocument();
+    if (!document) {
+        return MSOOXML::MsooXmlImport::convert(from, to);
+    }
+    Calligra::Sheets::DocBase* doc = qobject_cast<Calligra::Sheets::DocBase*>(document);
+    if (!doc) {
+        kWarning() << "document isn't a Calligra::Sheets::Doc but a " << document->metaObject()->className();
+        return KoFilter::WrongFormat;
+    }
+
+    // Everything but the plain cell contents goes through an ODF package in a
+    // temporary file. It is read right away, so it is written uncompressed,
+    // and the entries of the file get mapped instead of copied into memory.
+    QTemporaryFile file;
+    if (!file.open()) {
+        kWarning() << "Unable to create a temporary file";
+        return KoFilter::CreationError;
+    }
+    file.close();
+    KoStore* store = KoStore::createStore(file.fileName(), KoStore::Write, to, KoStore::Zip);
+    if (!store || store->bad()) {
+        kWarning() << "Unable to create the ODF store";
+        delete store;
+        return KoFilter::CreationError;
+    }
+    store->setCompressionEnabled(false);
+
+    d->cellContents = new XlsxCellContents;
+    KoFilter::ConversionStatus status = exportDocument(store, to);
+    if (status == KoFilter::OK) {
+        status = loadDocument(doc, file.fileName());
+    }
+    delete d->cellContents;
+    d->cellContents = 0;
+    return status;
+}
+
+KoFilter::ConversionStatus XlsxImport::loadDocument(Calligra::Sheets::DocBase* doc, const QString& fileName)
+{
+    KoStore* store = KoStore::createStore(fileName, KoStore::Read, "", KoStore::Zip);
+    if (!store || store->bad()) {
+        kWarning() << "Unable to read the ODF store";
+        delete store;
+        return KoFilter::ParsingError;
+    }
+
+    // Load the ODF document like KoDocument::loadNativeFormatFromStore() does,
+    // but write the cell contents before completing the loading, so that the
+    // dependencies get built and the workbook gets calculated only once.
+    QString errorMessage;
+    KoOdfReadStore odfStore(store);
+    if (!odfStore.loadAndParse(errorMessage) || !doc->loadOdf(odfStore)) {
+        kWarning() << "Unable to load the ODF document:" << errorMessage;
+        delete store;
+        return KoFilter::ParsingError;
+    }
+    if (store->hasFile("meta.xml")) {
+        KoXmlDocument metaDoc;
+        if (odfStore.loadAndParse("meta.xml", metaDoc, errorMessage)) {
+            doc->documentInfo()->loadOasis(metaDoc);
+        }
+    }
+
+    Calligra::Sheets::Map* map = doc->map();
+    d->cellContents->write(map);
+    // build the dependencies of all formulas and calculate them
+    const bool ok = map->completeLoading(store);
+    delete store;
+    return ok ? KoFilter::OK : KoFilter::ParsingError;
+}
+
+XlsxCellContents* XlsxImport::cellContents() const
+{
+    return d->cellContents;
+}
+
 bool XlsxImport::acceptsSourceMimeType(const QByteArray& mime) const
 {
     kDebug() << "Entering XLSX Import filter: from " << mime;
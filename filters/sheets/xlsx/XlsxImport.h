@@ -29,7 +29,22 @@
 #include <MsooXmlImport.h>
 #include <QVariantList>
 
+class XlsxCellContents;
+
+namespace Calligra
+{
+namespace Sheets
+{
+class DocBase;
+}
+}
+
 //! XLSX to ODS import filter
+/*! When importing into a Calligra Sheets document, the contents of the plain
+ cells are written directly into the document; only the rest of the workbook
+ takes the way through an ODF document, which is kept in memory. Otherwise,
+ e.g. for embedded documents, the complete ODF document gets written.
+*/
 class XlsxImport : public MSOOXML::MsooXmlImport
 {
     Q_OBJECT
@@ -37,6 +52,12 @@ public:
     XlsxImport(QObject * parent, const QVariantList &);
     virtual ~XlsxImport();
 
+    virtual KoFilter::ConversionStatus convert(const QByteArray& from, const QByteArray& to);
+
+    //! @return the collector of the cell contents written directly into the
+    //! Calligra Sheets document or 0 if the complete ODF document gets written
+    XlsxCellContents* cellContents() const;
+
 protected:
     virtual bool acceptsSourceMimeType(const QByteArray& mime) const;
 
@@ -47,6 +68,11 @@ protected:
 
     class Private;
     Private * const d;
+
+private:
+    //! Loads the ODF package @a fileName into @a doc and writes the collected
+    //! cell contents into it, before the loading gets completed.
+    KoFilter::ConversionStatus loadDocument(Calligra::Sheets::DocBase* doc, const QString& fileName);
 };
 
 #endif
@@ -29,13 +29,20 @@
 #include "XlsxXmlWorksheetReader.h"
 #include "XlsxXmlCommentsReader.h"
 #include "XlsxImport.h"
+#include "XlsxCellContents.h"
 #include <MsooXmlSchemas.h>
 #include <MsooXmlUtils.h>
 #include <MsooXmlRelationships.h>
+#include <KoGenStyles.h>
 #include <KoXmlWriter.h>
 #include <KoFontFace.h>
 #include <VmlDrawingReader.h>
 
+#include <QBuffer>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+
 #undef MSOOXML_CURRENT_NS
 #define MSOOXML_CURRENT_CLASS XlsxXmlDocumentReader
 #define BIND_READ_CLASS MSOOXML_CURRENT_CLASS
@@ -72,9 +79,101 @@ public:
     ~Private() {
     }
     uint worksheetNumber;
+
+    //! The sheet elements of the workbook
+    struct SheetInfo {
+        QString filepath;
+        QString path;
+        QString file;
+        QString name;
+        QString state;
+        QString vmlTarget;
+    };
+    QList<SheetInfo> sheets;
+
+    class WorksheetJob;
 private:
 };
 
+//! Reads a worksheet into its own table:table element, automatic styles, autofilters
+//! and cell contents, against the shared strings and styles of the document, which
+//! must not change meanwhile.
+class XlsxXmlDocumentReader::Private::WorksheetJob : public QRunnable
+{
+public:
+    WorksheetJob(XlsxXmlDocumentReaderContext* documentContext, const SheetInfo& sheet,
+                 uint worksheetNumber, unsigned numberOfWorkSheets,
+                 const KoGenStyles* documentStyles, int indentLevel)
+            : documentContext(documentContext)
+            , sheet(sheet)
+            , worksheetNumber(worksheetNumber)
+            , numberOfWorkSheets(numberOfWorkSheets)
+            , documentStyles(documentStyles)
+            , indentLevel(indentLevel)
+            , cellContents(documentContext->import->cellContents() ? new XlsxCellContents : 0)
+            , status(KoFilter::OK) {
+        setAutoDelete(false);
+    }
+    ~WorksheetJob() {
+        delete cellContents;
+    }
+
+    void run() Q_DECL_OVERRIDE {
+        QByteArray data;
+        if (!documentContext->import->readPart(sheet.filepath, &data)) {
+            status = KoFilter::FileNotFound;
+            done.release();
+            return;
+        }
+        QBuffer buffer(&xml);
+        buffer.open(QIODevice::WriteOnly);
+        {
+            KoXmlWriter writer(&buffer, indentLevel);
+            KoOdfWriters writers;
+            writers.body = &writer;
+            writers.mainStyles = &styles;
+            XlsxXmlWorksheetReader worksheetReader(&writers);
+            XlsxXmlWorksheetReaderContext context(worksheetNumber, numberOfWorkSheets, sheet.name, sheet.state,
+                                                  sheet.path, sheet.file,
+                                                  documentContext->themes, *documentContext->sharedStrings,
+                                                  *documentContext->comments,
+                                                  *documentContext->styles,
+                                                  *documentContext->relationships, documentContext->import,
+                                                  QMap<QString, QString>(),
+                                                  QMap<QString, QString>(),
+                                                  autoFilters);
+            context.separate = true;
+            context.cellContents = cellContents;
+            context.documentStyles = documentStyles;
+            // read twice, as in XlsxXmlDocumentReader::readSheet()
+            for (int round = 0; round < 2 && status == KoFilter::OK; ++round) {
+                context.firstRoundOfReading = round == 0;
+                QBuffer device(&data);
+                device.open(QIODevice::ReadOnly);
+                worksheetReader.setDevice(&device);
+                worksheetReader.setFileName(sheet.filepath); // for error reporting
+                status = worksheetReader.read(&context);
+            }
+        }
+        buffer.close();
+        done.release();
+    }
+
+    XlsxXmlDocumentReaderContext* const documentContext;
+    const SheetInfo sheet;
+    const uint worksheetNumber;
+    const unsigned numberOfWorkSheets;
+    const KoGenStyles* const documentStyles;
+    const int indentLevel;
+    // the table:table element and what it refers to
+    QByteArray xml;
+    KoGenStyles styles;
+    QVector<XlsxXmlDocumentReaderContext::AutoFilter> autoFilters;
+    XlsxCellContents* const cellContents;
+    KoFilter::ConversionStatus status;
+    QSemaphore done;
+};
+
 XlsxXmlDocumentReader::XlsxXmlDocumentReader(KoOdfWriters *writers)
         : MSOOXML::MsooXmlReader(writers)
         , m_context(0)
@@ -224,6 +323,7 @@ KoFilter::ConversionStatus XlsxXmlDocumentReader::read_sheets()
         m_context->relationships->targetCountWithWord("chartsheets");
     unsigned worksheet = 1;
 
+    d->sheets.clear();
     while (!atEnd()) {
         readNext();
         kDebug() << *this;
@@ -231,13 +331,69 @@ KoFilter::ConversionStatus XlsxXmlDocumentReader::read_sheets()
         if (isStartElement()) {
             if (name() == "sheet") {
                 TRY_READ(sheet)
-                ++worksheet;
-                m_context->import->reportProgress(45 + (55/numberOfWorkSheets) * worksheet);
             }
             ELSE_WRONG_FORMAT
         }
     }
 
+    // The worksheets without VML drawings are read in parallel, each into its own result,
+    // while the shared strings and styles of the document are only read. The results get
+    // merged in the order of the workbook afterwards. The other worksheets and those, which
+    // turn out to refer to other parts, are read one after another, their parts decompressed
+    // in the background meanwhile.
+    QList<Private::WorksheetJob*> jobs;
+    QStringList parts;
+    const bool threaded = QThreadPool::globalInstance()->maxThreadCount() > 1;
+    for (int i = 0; i < d->sheets.count(); ++i) {
+        const Private::SheetInfo& sheet = d->sheets.at(i);
+        if (threaded && sheet.vmlTarget.isEmpty()) {
+            jobs.append(new Private::WorksheetJob(m_context, sheet, i + 1, numberOfWorkSheets,
+                                                  mainStyles, body->indentLevel()));
+            continue;
+        }
+        jobs.append(0);
+        if (!sheet.vmlTarget.isEmpty()) {
+            parts.append(sheet.vmlTarget);
+        }
+        parts.append(sheet.filepath);
+    }
+    foreach (Private::WorksheetJob* job, jobs) {
+        if (job) {
+            QThreadPool::globalInstance()->start(job);
+        }
+    }
+    foreach (Private::WorksheetJob* job, jobs) {
+        if (job) {
+            job->done.acquire();
+        }
+    }
+    m_context->import->prefetchParts(parts);
+
+    KoFilter::ConversionStatus status = KoFilter::OK;
+    for (int i = 0; i < d->sheets.count() && status == KoFilter::OK; ++i) {
+        Private::WorksheetJob* const job = jobs.at(i);
+        if (job && job->status == KoFilter::OK) {
+            d->worksheetNumber++; // counted from 1
+            // insert the styles as if the worksheet had been read directly
+            const QHash<QString, QString> styleNames = mainStyles->merge(job->styles);
+            KoGenStyles::renameReferences(job->xml, styleNames);
+            body->addCompleteElement(job->xml.constData());
+            m_context->autoFilters += job->autoFilters;
+            if (job->cellContents) {
+                m_context->import->cellContents()->append(job->cellContents);
+            }
+        } else {
+            status = readSheet(i, numberOfWorkSheets);
+        }
+        ++worksheet;
+        m_context->import->reportProgress(45 + (55/numberOfWorkSheets) * worksheet);
+    }
+    qDeleteAll(jobs);
+    if (status != KoFilter::OK) {
+        return status;
+    }
+    d->sheets.clear();
+
     if (!m_context->autoFilters.isEmpty()) {
         body->startElement("table:database-ranges");
         int index = 0;
@@ -302,37 +458,47 @@ KoFilter::ConversionStatus XlsxXmlDocumentReader::read_sheet()
     TRY_READ_ATTR_WITHOUT_NS(state)
     kDebug() << "r:id:" << r_id << "sheetId:" << sheetId << "name:" << name << "state:" << state;
 
-    unsigned numberOfWorkSheets = m_context->relationships->targetCountWithWord("worksheets") +
-        m_context->relationships->targetCountWithWord("dialogsheets") +
-        m_context->relationships->targetCountWithWord("chartsheets");
+    Private::SheetInfo sheet;
+    sheet.name = name;
+    sheet.state = state;
+    sheet.filepath = m_context->relationships->target(m_context->path, m_context->file, r_id);
+    MSOOXML::Utils::splitPathAndFile(sheet.filepath, &sheet.path, &sheet.file);
+    kDebug() << "path:" << sheet.path << "file:" << sheet.file;
+    sheet.vmlTarget = m_context->relationships->targetForType(sheet.path, sheet.file,
+        "http://schemas.openxmlformats.org/officeDocument/2006/relationships/vmlDrawing");
+    d->sheets.append(sheet);
+
+    readNext();
+    READ_EPILOGUE
+}
+
+KoFilter::ConversionStatus XlsxXmlDocumentReader::readSheet(int index, unsigned numberOfWorkSheets)
+{
+    const Private::SheetInfo& sheet = d->sheets.at(index);
+    const QString& filepath = sheet.filepath;
     d->worksheetNumber++; // counted from 1
-    QString path, file;
-    QString filepath = m_context->relationships->target(m_context->path, m_context->file, r_id);
-    MSOOXML::Utils::splitPathAndFile(filepath, &path, &file);
-    kDebug() << "path:" << path << "file:" << file;
 
     // Loading potential ole replacements
     VmlDrawingReader vmlreader(this);
-    QString vmlTarget = m_context->relationships->targetForType(path, file,
-        "http://schemas.openxmlformats.org/officeDocument/2006/relationships/vmlDrawing");
-
-    if (!vmlTarget.isEmpty()) {
+    if (!sheet.vmlTarget.isEmpty()) {
         QString errorMessage, vmlPath, vmlFile;
 
-        MSOOXML::Utils::splitPathAndFile(vmlTarget, &vmlPath, &vmlFile);
+        MSOOXML::Utils::splitPathAndFile(sheet.vmlTarget, &vmlPath, &vmlFile);
 
         VmlDrawingReaderContext vmlContext(*m_context->import,
             vmlPath, vmlFile, *m_context->relationships);
 
         const KoFilter::ConversionStatus status =
-            m_context->import->loadAndParseDocument(&vmlreader, vmlTarget, errorMessage, &vmlContext);
+            m_context->import->loadAndParseDocument(&vmlreader, sheet.vmlTarget, errorMessage, &vmlContext);
         if (status != KoFilter::OK) {
             vmlreader.raiseError(errorMessage);
         }
+        m_context->import->releasePart(sheet.vmlTarget);
     }
 
     XlsxXmlWorksheetReader worksheetReader(this);
-    XlsxXmlWorksheetReaderContext context(d->worksheetNumber, numberOfWorkSheets, name, state, path, file,
+    XlsxXmlWorksheetReaderContext context(d->worksheetNumber, numberOfWorkSheets, sheet.name, sheet.state,
+                                          sheet.path, sheet.file,
                                           m_context->themes, *m_context->sharedStrings,
                                           *m_context->comments,
                                           *m_context->styles,
@@ -345,16 +511,16 @@ KoFilter::ConversionStatus XlsxXmlDocumentReader::read_sheet()
     context.firstRoundOfReading = true;
     KoFilter::ConversionStatus status = m_context->import->loadAndParseDocument(&worksheetReader, filepath, &context);
     if (status != KoFilter::OK) {
+        m_context->import->releasePart(filepath);
         raiseError(worksheetReader.errorString());
         return status;
     }
     context.firstRoundOfReading = false;
     status = m_context->import->loadAndParseDocument(&worksheetReader, filepath, &context);
+    m_context->import->releasePart(filepath);
     if (status != KoFilter::OK) {
         raiseError(worksheetReader.errorString());
         return status;
     }
-
-    readNext();
-    READ_EPILOGUE
+    return KoFilter::OK;
 }
@@ -88,6 +88,8 @@ protected:
     XlsxXmlDocumentReaderContext* m_context;
 private:
     void init();
+    //! Reads the worksheet of the sheet element at @a index, which got read by read_sheet().
+    KoFilter::ConversionStatus readSheet(int index, unsigned numberOfWorkSheets);
 
     class Private;
     Private* const d;
@@ -32,6 +32,7 @@
 #include "XlsxXmlChartReader.h"
 #include "XlsxXmlTableReader.h"
 #include "XlsxImport.h"
+#include "XlsxCellContents.h"
 #include "Charting.h"
 #include "XlsxChartOdfWriter.h"
 #include "FormulaParser.h"
@@ -119,6 +120,10 @@ XlsxXmlWorksheetReaderContext::XlsxXmlWorksheetReaderContext(
         , oleReplacements(_oleReplacements)
         , oleFrameBegins(_oleBeginFrames)
         , autoFilters(autoFilters)
+        , firstRoundOfReading(false)
+        , separate(false)
+        , cellContents(_import ? _import->cellContents() : 0)
+        , documentStyles(0)
 {
 }
 
@@ -364,6 +369,11 @@ inline static QString encodeLabelText(int col, int row)
     return Calligra::Sheets::Util::encodeColumnLabelText(col) + QString::number(row);
 }
 
+bool XlsxXmlWorksheetReader::hasAnnotation(int col, int row) const
+{
+    return !m_context->comments->isEmpty() && m_context->comments->value(encodeLabelText(col + 1, row + 1));
+}
+
 void XlsxXmlWorksheetReader::saveAnnotation(int col, int row)
 {
     QString ref(encodeLabelText(col + 1, row + 1));
@@ -460,6 +470,16 @@ KoFilter::ConversionStatus XlsxXmlWorksheetReader::read_worksheet()
     READ_EPILOGUE
 }
 
+//! @return true for the elements of a worksheet, whose reading needs other parts of the document,
+//! i.e. the relationships, the output store or the manifest
+static bool refersToOtherParts(const QStringRef& name)
+{
+    return name == QLatin1String("drawing") || name == QLatin1String("legacyDrawing")
+        || name == QLatin1String("hyperlinks") || name == QLatin1String("picture")
+        || name == QLatin1String("oleObjects") || name == QLatin1String("controls")
+        || name == QLatin1String("tableParts");
+}
+
 KoFilter::ConversionStatus XlsxXmlWorksheetReader::read_sheetHelper(const QString& type)
 {
     // In the first round we do not wish to output anything
@@ -498,6 +518,12 @@ KoFilter::ConversionStatus XlsxXmlWorksheetReader::read_sheetHelper(const QStrin
         if (isEndElement() && name() == type) {
             break;
         }
+        if (isStartElement() && m_context->separate && refersToOtherParts(name())) {
+            // left to the reading in the document
+            delete body;
+            body = oldBody;
+            return KoFilter::NotImplemented;
+        }
         if (isStartElement() && !m_context->firstRoundOfReading) {
             TRY_READ_IF(sheetFormatPr)
             ELSE_TRY_READ_IF(cols)
@@ -651,6 +677,15 @@ KoFilter::ConversionStatus XlsxXmlWorksheetReader::read_sheetHelper(const QStrin
         body->endElement();  // table:table-column
     }
 
+    // when importing into a Calligra Sheets document, the contents of plain cells get written directly
+    XlsxCellContents* cellContents = 0;
+    if (!m_context->firstRoundOfReading) {
+        cellContents = m_context->cellContents;
+        if (cellContents) {
+            cellContents->startSheet(m_context->worksheetName);
+        }
+    }
+
     const int rowCount = m_context->sheet->maxRow();
     for(int r = 0; r <= rowCount; ++r) {
         const int columnCount = m_context->sheet->maxCellsInRow(r);
@@ -669,15 +704,45 @@ KoFilter::ConversionStatus XlsxXmlWorksheetReader::read_sheetHelper(const QStrin
             }
             //body->addAttribute("table:number-rows-repeated", QByteArray::number(row->repeated));
 
+            QString repeatedStyleName;
+            int repeatedCells = 0;
             for(int c = 0; c <= columnCount; ++c) {
-                body->startElement("table:table-cell");
-                if (Cell* cell = m_context->sheet->cell(c, r, false)) {
-                    const bool hasHyperlink = ! cell->hyperlink().isEmpty();
+                Cell* cell = m_context->sheet->cell(c, r, false);
+                QString formula;
+                if (cell && cell->formula) {
+                    if (cell->formula->isShared()) {
+                        Cell *referencedCell = static_cast<SharedFormula*>(cell->formula)->m_referencedCell;
+                        Q_ASSERT(referencedCell);
+                        formula = MSOOXML::convertFormulaReference(referencedCell, cell);
+                    } else  {
+                        formula = static_cast<FormulaImpl*>(cell->formula)->m_formula;
+                    }
+                }
 
-                    if (!cell->styleName.isEmpty()) {
-                        body->addAttribute("table:style-name", cell->styleName);
+                // cells, whose contents got written directly, only carry their style and spans
+                const bool contentsTaken = cell && cellContents && !hasAnnotation(c, r)
+                                           && cellContents->take(cell, formula);
+                if (!cell || (contentsTaken && cell->rowsMerged == 1 && cell->columnsMerged == 1)) {
+                    const QString styleName = cell ? cell->styleName : QString();
+                    if (repeatedCells > 0 && styleName != repeatedStyleName) {
+                        appendTableCells(repeatedCells, repeatedStyleName);
+                        repeatedCells = 0;
                     }
-                    //body->addAttribute("table:number-columns-repeated", QByteArray::number(cell->repeated));
+                    repeatedStyleName = styleName;
+                    ++repeatedCells;
+                    continue;
+                }
+                appendTableCells(repeatedCells, repeatedStyleName);
+                repeatedCells = 0;
+
+                body->startElement("table:table-cell");
+                const bool hasHyperlink = ! cell->hyperlink().isEmpty();
+
+                if (!cell->styleName.isEmpty()) {
+                    body->addAttribute("table:style-name", cell->styleName);
+                }
+                //body->addAttribute("table:number-columns-repeated", QByteArray::number(cell->repeated));
+                if (!contentsTaken) {
                     if (!hasHyperlink) {
                         switch(cell->valueType) {
                             case Cell::ConstNone:
@@ -719,27 +784,19 @@ KoFilter::ConversionStatus XlsxXmlWorksheetReader::read_sheetHelper(const QStrin
                         }
                     }
 
-                    if (cell->formula) {
-                        QString formula;
-                        if (cell->formula->isShared()) {
-                            Cell *referencedCell = static_cast<SharedFormula*>(cell->formula)->m_referencedCell;
-                            Q_ASSERT(referencedCell);
-                            formula = MSOOXML::convertFormulaReference(referencedCell, cell);
-                        } else  {
-                            formula = static_cast<FormulaImpl*>(cell->formula)->m_formula;
-                        }
-                        if (!formula.isEmpty()) {
-                            body->addAttribute("table:formula", formula);
-                        }
+                    if (!formula.isEmpty()) {
+                        body->addAttribute("table:formula", formula);
                     }
+                }
 
-                    if (cell->rowsMerged > 1) {
-                        body->addAttribute("table:number-rows-spanned", cell->rowsMerged);
-                    }
-                    if (cell->columnsMerged > 1) {
-                        body->addAttribute("table:number-columns-spanned", cell->columnsMerged);
-                    }
+                if (cell->rowsMerged > 1) {
+                    body->addAttribute("table:number-rows-spanned", cell->rowsMerged);
+                }
+                if (cell->columnsMerged > 1) {
+                    body->addAttribute("table:number-columns-spanned", cell->columnsMerged);
+                }
 
+                if (!contentsTaken) {
                     saveAnnotation(c, r);
 
                     if (!cell->text.isEmpty() || !cell->charStyleName.isEmpty() || hasHyperlink) {
@@ -803,6 +860,7 @@ KoFilter::ConversionStatus XlsxXmlWorksheetReader::read_sheetHelper(const QStrin
                 }
                 body->endElement(); // table:table-cell
             }
+            appendTableCells(repeatedCells, repeatedStyleName);
         }
 
         if (!row || columnCount <= 0) {
@@ -1226,11 +1284,13 @@ QString XlsxXmlWorksheetReader::processRowStyle(qreal height)
     return currentTableRowStyleName;
 }
 
-void XlsxXmlWorksheetReader::appendTableCells(int cells)
+void XlsxXmlWorksheetReader::appendTableCells(int cells, const QString& styleName)
 {
     if (cells <= 0)
         return;
     body->startElement("table:table-cell");
+    if (!styleName.isEmpty())
+        body->addAttribute("table:style-name", styleName);
     if (cells > 1)
         body->addAttribute("table:number-columns-repeated", QByteArray::number(cells));
     body->endElement(); // table:table-cell
@@ -1294,10 +1354,12 @@ KoFilter::ConversionStatus XlsxXmlWorksheetReader::read_row()
         BREAK_IF_END_OF(CURRENT_EL)
         if (isStartElement()) {
             if (counter == 40) {
-                // set the progress by the position of what was read
-                qreal progress = 45 + range * (m_context->worksheetNumber - 1)
-                               + range * device()->pos() / device()->size();
-                m_context->import->reportProgress(progress);
+                // set the progress by the position of what was read, unless in another thread
+                if (!m_context->separate) {
+                    qreal progress = 45 + range * (m_context->worksheetNumber - 1)
+                                   + range * device()->pos() / device()->size();
+                    m_context->import->reportProgress(progress);
+                }
                 counter = 0;
             }
             ++counter;
@@ -1438,7 +1500,8 @@ KoFilter::ConversionStatus XlsxXmlWorksheetReader::read_c()
                     return KoFilter::WrongFormat;
                 }
             }
-            const KoGenStyle* const style = mainStyles->style( formattedStyle, "" );
+            const KoGenStyles* const documentStyles = m_context->documentStyles ? m_context->documentStyles : mainStyles;
+            const KoGenStyle* const style = documentStyles->style( formattedStyle, "" );
             if( style == 0 || valueIsNumeric(m_value) ) {
 //            body->addTextSpan(m_value);
                 cell->valueType = Cell::ConstFloat;
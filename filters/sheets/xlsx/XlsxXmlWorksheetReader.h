@@ -40,6 +40,7 @@ class XlsxXmlWorksheetReaderContext;
 class XlsxComments;
 class XlsxStyles;
 class XlsxImport;
+class XlsxCellContents;
 class Sheet;
 
 //! A class reading MSOOXML XLSX markup - xl/worksheets/sheet*.xml part.
@@ -121,7 +122,9 @@ private:
     void showWarningAboutWorksheetSize();
     void saveColumnStyle(const QString& widthString);
     void appendTableColumns(int columns, const QString& width = QString());
-    void appendTableCells(int cells);
+    void appendTableCells(int cells, const QString& styleName = QString());
+    //! @return true if there is an annotation (comment) defined for the cell specified by @a col and @a row.
+    bool hasAnnotation(int col, int row) const;
     //! Saves annotation element (comments) for cell specified by @a col and @a row it there is any annotation defined.
     void saveAnnotation(int col, int row);
 
@@ -182,6 +185,15 @@ public:
 
     bool firstRoundOfReading;
 
+    //! True if the worksheet gets read in another thread, into its own body and styles.
+    //! Reading then stops with KoFilter::NotImplemented at the elements, which refer to
+    //! other parts of the document, and the worksheet has to be read again in the document.
+    bool separate;
+    //! Takes the contents of the plain cells, if any, see XlsxImport::cellContents()
+    XlsxCellContents* cellContents;
+    //! The styles of the document, e.g. the number formats; the main styles, if 0
+    const KoGenStyles* documentStyles;
+
     QList<QMap<QString, QString> > conditionalStyleForPosition(const QString& positionLetter, int positionNumber);
 
     QList<QPair<QString, QMap<QString, QString> > >conditionalStyles;
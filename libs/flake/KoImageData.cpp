@@ -142,7 +142,11 @@ QImage KoImageData::image() const
 {
     if (d->dataStoreState == KoImageDataPrivate::StateNotLoaded) {
         // load image
-        if (d->temporaryFile) {
+        if (!d->mappedData.isNull()) {
+            if (d->errorCode == Success && !d->image.loadFromData(d->mappedData.rawData(), d->suffix.toLatin1())) {
+                d->errorCode = OpenFailed;
+            }
+        } else if (d->temporaryFile) {
             bool r = d->temporaryFile->open();
             if (!r) {
                 d->errorCode = OpenFailed;
@@ -251,8 +255,10 @@ void KoImageData::setImage(const QString &url, KoStore *store, KoImageCollection
             closer.store = store;
             KoStoreDevice device(store);
             const bool lossy = url.endsWith(".jpg", Qt::CaseInsensitive) || url.endsWith(".gif", Qt::CaseInsensitive);
+            // an image stored uncompressed is used in place
+            const KoStoreMappedData mapped = store->mappedData();
             if (!lossy && device.size() < MAX_MEMORY_IMAGESIZE) {
-                QByteArray data = device.readAll();
+                QByteArray data = mapped.isNull() ? device.readAll() : mapped.rawData();
                 if (d->image.loadFromData(data)) {
                     QCryptographicHash md5(QCryptographicHash::Md5);
                     md5.addData(data);
@@ -265,6 +271,20 @@ void KoImageData::setImage(const QString &url, KoStore *store, KoImageCollection
                     return;
                 }
             }
+            if (!mapped.isNull()) {
+                delete d->temporaryFile;
+                d->temporaryFile = 0;
+                d->mappedData = mapped;
+                QCryptographicHash md5(QCryptographicHash::Md5);
+                md5.addData(mapped.rawData());
+                qint64 oldKey = d->key;
+                d->key = KoImageDataPrivate::generateKey(md5.result());
+                if (oldKey != 0 && d->collection) {
+                    d->collection->update(oldKey, d->key);
+                }
+                d->dataStoreState = KoImageDataPrivate::StateNotLoaded;
+                return;
+            }
             if (!device.open(QIODevice::ReadOnly)) {
                 warnFlake << "open file from store " << url << "failed";
                 d->errorCode = OpenFailed;
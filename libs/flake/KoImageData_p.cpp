@@ -57,6 +57,9 @@ bool KoImageDataPrivate::saveData(QIODevice &device)
     // if we have a temp file save that to the store. This is needed as to not lose data when
     // saving lossy formats. Also writing out gif is not supported by qt so saving temp file
     // also fixes the problem that gif images are empty after saving.
+    if (!mappedData.isNull()) {
+        return device.write(mappedData.data(), mappedData.size()) == mappedData.size();
+    }
     if (temporaryFile) {
         if (!temporaryFile->open()) {
             warnFlake << "Read file from temporary store failed";
@@ -86,7 +89,7 @@ bool KoImageDataPrivate::saveData(QIODevice &device)
         return false;
     case KoImageDataPrivate::StateNotLoaded:
         // we should not reach this state as above this will already be saved.
-        Q_ASSERT(temporaryFile);
+        Q_ASSERT(temporaryFile || !mappedData.isNull());
         return true;
     case KoImageDataPrivate::StateImageLoaded:
     case KoImageDataPrivate::StateImageOnly: {
@@ -109,6 +112,7 @@ void KoImageDataPrivate::setSuffix(const QString &name)
 
 void KoImageDataPrivate::copyToTemporary(QIODevice &device)
 {
+    mappedData = KoStoreMappedData();
     delete temporaryFile;
     temporaryFile = new QTemporaryFile(QDir::tempPath() + "/" + qAppName() + QLatin1String("_XXXXXX"));
     if (!temporaryFile->open()) {
@@ -148,6 +152,7 @@ void KoImageDataPrivate::clear()
     errorCode = KoImageData::Success;
     dataStoreState = StateEmpty;
     imageLocation.clear();
+    mappedData = KoStoreMappedData();
     imageSize = QSizeF();
     key = 0;
     image = QImage();
@@ -30,6 +30,8 @@
 #include <QTimer>
 #include <QDir>
 
+#include <KoStoreMappedData.h>
+
 #include "KoImageData.h"
 
 class KoImageCollection;
@@ -86,6 +88,8 @@ public:
     QPixmap pixmap;
 
     QTemporaryFile *temporaryFile;
+    /// the image data stored uncompressed in the store, used instead of the temporaryFile
+    KoStoreMappedData mappedData;
 };
 
 #endif /* KOIMAGEDATA_P_H */
@@ -331,6 +331,25 @@ const KUndo2Command *KUndo2Command::child(int index) const
     return d->child_list.at(index);
 }
 
+/*!
+    Returns the approximate amount of memory in bytes, which this command
+    keeps for undoing and redoing it. The default implementation returns
+    the sum of the sizes of the child commands.
+
+    Reimplement this function in commands, that keep large undo data, so
+    that the stack can honor its undo memory limit.
+
+    \sa KUndo2QStack::setUndoMemoryLimit()
+*/
+
+qint64 KUndo2Command::size() const
+{
+    qint64 size = 0;
+    for (int i = 0; i < d->child_list.count(); ++i)
+        size += d->child_list.at(i)->size();
+    return size;
+}
+
 bool KUndo2Command::hasParent()
 {
     return m_hasParent;
@@ -582,18 +601,36 @@ void KUndo2QStack::purgeRedoState()
 }
 
 /*! \internal
-    If the number of commands on the stack exceedes the undo limit, deletes commands from
-    the bottom of the stack.
+    If the number of commands on the stack exceedes the undo limit or their size exceeds
+    the undo memory limit, deletes commands from the bottom of the stack.
 
     Returns true if commands were deleted.
 */
 
 bool KUndo2QStack::checkUndoLimit()
 {
-    if (m_undo_limit <= 0 || !m_macro_stack.isEmpty() || m_undo_limit >= m_command_list.count())
+    if (!m_macro_stack.isEmpty() || m_command_list.isEmpty())
         return false;
 
-    int del_count = m_command_list.count() - m_undo_limit;
+    int del_count = 0;
+    if (m_undo_limit > 0 && m_undo_limit < m_command_list.count())
+        del_count = m_command_list.count() - m_undo_limit;
+
+    if (m_undo_memory_limit > 0) {
+        // keep the most recent commands fitting into the limit, the last one in any case
+        qint64 size = m_command_list.last()->size();
+        int i = m_command_list.count() - 2;
+        for (; i >= del_count; --i) {
+            const qint64 commandSize = m_command_list.at(i)->size();
+            if (size + commandSize > m_undo_memory_limit)
+                break;
+            size += commandSize;
+        }
+        del_count = i + 1;
+    }
+
+    if (del_count == 0)
+        return false;
 
     for (int i = 0; i < del_count; ++i)
         delete m_command_list.takeFirst();
@@ -617,7 +654,7 @@ bool KUndo2QStack::checkUndoLimit()
 */
 
 KUndo2QStack::KUndo2QStack(QObject *parent)
-    : QObject(parent), m_index(0), m_clean_index(0), m_group(0), m_undo_limit(0), m_useCumulativeUndoRedo(false), m_lastMergedSetCount(0), m_lastMergedIndex(0)
+    : QObject(parent), m_index(0), m_clean_index(0), m_group(0), m_undo_limit(0), m_undo_memory_limit(0), m_useCumulativeUndoRedo(false), m_lastMergedSetCount(0), m_lastMergedIndex(0)
 {
     setTimeT1(5);
     setTimeT2(1);
@@ -1261,6 +1298,39 @@ int KUndo2QStack::undoLimit() const
     return m_undo_limit;
 }
 
+/*!
+    \property KUndo2QStack::undoMemoryLimit
+    \brief the maximum amount of memory in bytes kept by the commands on this stack.
+
+    When the sum of the sizes of the commands on a stack exceeds the stack's
+    undoMemoryLimit, the oldest commands are deleted from the bottom of the stack.
+    The most recent command is kept, even if it exceeds the limit on its own.
+    The size of a command is determined by KUndo2Command::size(). The default value
+    is 0, which means that there is no limit.
+
+    Like the undoLimit, this property may only be set when the undo stack is empty.
+
+    \sa undoLimit
+*/
+
+void KUndo2QStack::setUndoMemoryLimit(qint64 limit)
+{
+    if (!m_command_list.isEmpty()) {
+        qWarning("KUndo2QStack::setUndoMemoryLimit(): an undo memory limit can only be set when the stack is empty");
+        return;
+    }
+
+    if (limit == m_undo_memory_limit)
+        return;
+    m_undo_memory_limit = limit;
+    checkUndoLimit();
+}
+
+qint64 KUndo2QStack::undoMemoryLimit() const
+{
+    return m_undo_memory_limit;
+}
+
 /*!
     \property KUndo2QStack::active
     \brief the active status of this stack.
@@ -107,6 +107,8 @@ public:
     int childCount() const;
     const KUndo2Command *child(int index) const;
 
+    virtual qint64 size() const;
+
     bool hasParent();
     virtual void setTime();
     virtual QTime time();
@@ -155,6 +157,7 @@ class KUNDO2_EXPORT KUndo2QStack : public QObject
 //    Q_DECLARE_PRIVATE(KUndo2QStack)
     Q_PROPERTY(bool active READ isActive WRITE setActive)
     Q_PROPERTY(int undoLimit READ undoLimit WRITE setUndoLimit)
+    Q_PROPERTY(qint64 undoMemoryLimit READ undoMemoryLimit WRITE setUndoMemoryLimit)
 
 public:
     explicit KUndo2QStack(QObject *parent = 0);
@@ -188,6 +191,9 @@ public:
     void setUndoLimit(int limit);
     int undoLimit() const;
 
+    void setUndoMemoryLimit(qint64 limit);
+    qint64 undoMemoryLimit() const;
+
     const KUndo2Command *command(int index) const;
 
     void setUseCumulativeUndoRedo(bool value);
@@ -228,6 +234,7 @@ private:
     int m_clean_index;
     KUndo2Group *m_group;
     int m_undo_limit;
+    qint64 m_undo_memory_limit;
     bool m_useCumulativeUndoRedo;
     double m_timeT1;
     double m_timeT2;
@@ -460,6 +460,8 @@ KoDocument::KoDocument(KoPart *parent, KUndo2Stack *undoStack)
 
     KConfigGroup cfgGrp(d->parentPart->componentData().config(), "Undo");
     d->undoStack->setUndoLimit(cfgGrp.readEntry("UndoLimit", 1000));
+    // in megabytes; 0 means no limit
+    d->undoStack->setUndoMemoryLimit(qint64(cfgGrp.readEntry("UndoMemoryLimit", 512)) * 1024 * 1024);
 
     connect(d->undoStack, SIGNAL(indexChanged(int)), this, SLOT(slotUndoStackIndexChanged(int)));
 
@@ -22,6 +22,7 @@
 #include "KoGenStyle.h"
 #include "KoGenStyles.h"
 
+#include <QHash>
 #include <QTextLength>
 
 #include <KoXmlWriter.h>
@@ -44,6 +45,17 @@ static int compareMap(const QMap<QString, QString>& map1, const QMap<QString, QS
     return 0; // equal
 }
 
+static uint hashMap(const QMap<QString, QString>& map, uint seed)
+{
+    uint hash = seed ^ uint(map.count());
+    QMap<QString, QString>::const_iterator it = map.constBegin();
+    for (; it != map.constEnd(); ++it) {
+        // the order matters, as for compareMap
+        hash = 31 * hash + qHash(it.key(), seed);
+        hash = 31 * hash + qHash(it.value(), seed);
+    }
+    return hash;
+}
 
 KoGenStyle::KoGenStyle(Type type, const char* familyName,
                        const QString& parentName)
@@ -496,6 +508,21 @@ bool KoGenStyle::operator==(const KoGenStyle &other) const
     return true;
 }
 
+uint KoGenStyle::hash() const
+{
+    // Covers exactly what operator== compares.
+    uint hash = qHash(m_familyName) ^ (uint(m_type) << 1) ^ uint(m_autoStyleInStylesDotXml);
+    hash = 31 * hash + qHash(m_parentName);
+    for (uint i = 0 ; i <= LastPropertyType; ++i) {
+        hash = 31 * hash + hashMap(m_properties[i], i);
+        hash = 31 * hash + hashMap(m_childProperties[i], i);
+    }
+    hash = 31 * hash + hashMap(m_attributes, 0);
+    for (int i = 0 ; i < m_maps.count() ; ++i)
+        hash = 31 * hash + hashMap(m_maps[i], 0);
+    return hash;
+}
+
 bool KoGenStyle::isEmpty() const
 {
     if (!m_attributes.isEmpty() || ! m_maps.isEmpty())
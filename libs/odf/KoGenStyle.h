@@ -462,17 +462,20 @@ public:
                               const KoGenStyle *parentStyle = 0) const;
 
     /**
-     *  QMap requires a complete sorting order.
-     *  Another solution would have been a qdict and a key() here, a la KoTextFormat,
-     *  but the key was difficult to generate.
-     *  Solutions with only a hash value (not representative of the whole data)
-     *  require us to write a hashtable by hand....
+     *  A complete sorting order, as required by KoGenStyles::StyleMap.
      */
     bool operator<(const KoGenStyle &other) const;
 
-    /// Not needed for QMap, but can still be useful
+    /// Used together with hash() to look up equal styles
     bool operator==(const KoGenStyle &other) const;
 
+    /**
+     * @return a hash of the style, which is the same for equal styles.
+     * KoGenStyles uses it to look up the styles in a hash table instead of
+     * comparing them one by one.
+     */
+    uint hash() const;
+
     /**
      * Returns a property of this style. In prinicpal this class is meant to be write-only, but
      * some exceptional cases having read-support as well is very useful.  Passing DefaultType
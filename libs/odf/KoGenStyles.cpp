@@ -108,6 +108,21 @@ static void insertRawOdfStyles(const QByteArray& xml, QByteArray& styles)
     styles.append(xml);
 }
 
+// Replaces the values referring to renamed styles, i.e. those of the *-name entries.
+static void renameEntries(QMap<QString, QString> &entries, const QHash<QString, QString> &names)
+{
+    if (names.isEmpty())
+        return;
+    QMap<QString, QString>::iterator it = entries.begin();
+    for (; it != entries.end(); ++it) {
+        if (!it.key().endsWith(QLatin1String("-name")) || it.key() == QLatin1String("style:display-name"))
+            continue;
+        const QHash<QString, QString>::const_iterator name = names.constFind(it.value());
+        if (name != names.constEnd())
+            it.value() = name.value();
+    }
+}
+
 class Q_DECL_HIDDEN KoGenStyles::Private
 {
 public:
@@ -117,6 +132,8 @@ public:
 
     ~Private()
     {
+        for (int i = 0; i < styleList.count(); ++i)
+            delete styleList[i].style;
     }
 
     QVector<KoGenStyles::NamedStyle> styles(bool autoStylesInStylesDotXml, KoGenStyle::Type type) const;
@@ -134,8 +151,14 @@ public:
      */
     void saveOdfFontFaceDecls(KoXmlWriter* xmlWriter) const;
 
-    /// style definition -> name
-    StyleMap styleMap;
+    /// hash of the style definition -> index in styleList
+    QMultiHash<uint, int> styleHashes;
+    /// the hashes of the styles in styleList
+    QVector<uint> hashes;
+    /// indexes of the styles handed out for modification, which need a new hash
+    QSet<int> modifiedStyles;
+    /// style name -> index in styleList
+    QMultiHash<QString, int> styleIndexes;
 
     /// Map with the style name as key.
     /// This map is mainly used to check for name uniqueness
@@ -151,7 +174,12 @@ public:
     /// font faces
     QMap<QString, KoFontFace> fontFaces;
 
-    StyleMap::iterator insertStyle(const KoGenStyle &style, const QString &name, InsertionFlags flags);
+    int insertStyle(const KoGenStyle &style, uint hash, const QString &name, InsertionFlags flags);
+    /// @return the index of the last inserted style equal to @p style or -1
+    int findStyle(const KoGenStyle &style, uint hash) const;
+    void rehashModifiedStyles();
+    /// @return the index of the first inserted style named @p name in @p family or -1
+    int indexOf(const QString &name, const QByteArray &family) const;
 
     struct RelationTarget {
         QString target; // the style we point to
@@ -327,18 +355,20 @@ QString KoGenStyles::insert(const KoGenStyle& style, const QString& baseName, In
         return QString();
     }
 
+    d->rehashModifiedStyles();
+    const uint hash = style.hash();
     if (flags & AllowDuplicates) {
-        StyleMap::iterator it = d->insertStyle(style, baseName, flags);
-        return it.value();
+        const int index = d->insertStyle(style, hash, baseName, flags);
+        return d->styleList[index].name;
     }
 
-    StyleMap::iterator it = d->styleMap.find(style);
-    if (it == d->styleMap.end()) {
+    int index = d->findStyle(style, hash);
+    if (index == -1) {
         // Not found, try if this style is in fact equal to its parent (the find above
         // wouldn't have found it, due to m_parentName being set).
         if (!style.parentName().isEmpty()) {
             KoGenStyle testStyle(style);
-            const KoGenStyle* parentStyle = this->style(style.parentName(), style.familyName());   // ## linear search
+            const KoGenStyle* parentStyle = this->style(style.parentName(), style.familyName());
             if (!parentStyle) {
                 debugOdf << "baseName=" << baseName << "parent style" << style.parentName()
                               << "not found in collection";
@@ -365,13 +395,120 @@ QString KoGenStyles::insert(const KoGenStyle& style, const QString& baseName, In
             }
         }
 
-        it = d->insertStyle(style, baseName, flags);
+        index = d->insertStyle(style, hash, baseName, flags);
+    }
+    return d->styleList[index].name;
+}
+
+QHash<QString, QString> KoGenStyles::merge(const KoGenStyles &styles)
+{
+    QHash<QString, QString> names;
+
+    QMap<int, KoGenStyle>::const_iterator defaultIt = styles.d->defaultStyles.constBegin();
+    for (; defaultIt != styles.d->defaultStyles.constEnd(); ++defaultIt) {
+        if (!d->defaultStyles.contains(defaultIt.key()))
+            d->defaultStyles.insert(defaultIt.key(), defaultIt.value());
+    }
+
+    for (int i = 0; i < styles.d->styleList.count(); ++i) {
+        const NamedStyle &named = styles.d->styleList[i];
+        KoGenStyle style(*named.style);
+        style.m_parentName = names.value(style.m_parentName, style.m_parentName);
+        renameEntries(style.m_attributes, names);
+        for (int type = 0; type <= KoGenStyle::LastPropertyType; ++type) {
+            renameEntries(style.m_properties[type], names);
+            renameEntries(style.m_childProperties[type], names);
+        }
+        for (int j = 0; j < style.m_maps.count(); ++j)
+            renameEntries(style.m_maps[j], names);
+
+        // numbered names get renumbered, others are kept if possible
+        int digits = 0;
+        while (digits < named.name.length() && named.name[named.name.length() - digits - 1].isDigit())
+            ++digits;
+        const QString name = insert(style, named.name.left(named.name.length() - digits),
+                                    digits ? NoFlag : DontAddNumberToName);
+        if (name != named.name)
+            names.insert(named.name, name);
+    }
+
+    QMap<QString, KoFontFace>::const_iterator fontIt = styles.d->fontFaces.constBegin();
+    for (; fontIt != styles.d->fontFaces.constEnd(); ++fontIt) {
+        if (!d->fontFaces.contains(fontIt.key()))
+            d->fontFaces.insert(fontIt.key(), fontIt.value());
     }
-    return it.value();
+
+    QHash<QString, Private::RelationTarget>::const_iterator relationIt = styles.d->relations.constBegin();
+    for (; relationIt != styles.d->relations.constEnd(); ++relationIt) {
+        Private::RelationTarget relation = relationIt.value();
+        relation.target = names.value(relation.target, relation.target);
+        d->relations.insert(names.value(relationIt.key(), relationIt.key()), relation);
+    }
+
+    ::insertRawOdfStyles(styles.d->rawOdfDocumentStyles, d->rawOdfDocumentStyles);
+    ::insertRawOdfStyles(styles.d->rawOdfAutomaticStyles_stylesDotXml, d->rawOdfAutomaticStyles_stylesDotXml);
+    ::insertRawOdfStyles(styles.d->rawOdfAutomaticStyles_contentDotXml, d->rawOdfAutomaticStyles_contentDotXml);
+    ::insertRawOdfStyles(styles.d->rawOdfMasterStyles, d->rawOdfMasterStyles);
+    ::insertRawOdfStyles(styles.d->rawOdfFontFaceDecls, d->rawOdfFontFaceDecls);
+    return names;
 }
 
-KoGenStyles::StyleMap::iterator KoGenStyles::Private::insertStyle(const KoGenStyle &style,
-                                                                  const QString& baseName, InsertionFlags flags)
+void KoGenStyles::renameReferences(QByteArray &xml, const QHash<QString, QString> &names, const QByteArray &suffix)
+{
+    if (names.isEmpty())
+        return;
+    // KoXmlWriter escapes the quote, so it only occurs as a delimiter of attribute values
+    const QByteArray pattern = suffix + "=\"";
+    QByteArray result;
+    int copied = 0;
+    int index = 0;
+    while ((index = xml.indexOf(pattern, index)) != -1) {
+        const int begin = index + pattern.length();
+        const int end = xml.indexOf('"', begin);
+        if (end == -1)
+            break;
+        const QHash<QString, QString>::const_iterator name =
+            names.constFind(QString::fromUtf8(xml.constData() + begin, end - begin));
+        if (name != names.constEnd()) {
+            if (result.isEmpty())
+                result.reserve(xml.size());
+            result.append(xml.constData() + copied, begin - copied);
+            result.append(name.value().toUtf8());
+            copied = end;
+        }
+        index = end;
+    }
+    if (copied == 0)
+        return;
+    result.append(xml.constData() + copied, xml.size() - copied);
+    xml = result;
+}
+
+int KoGenStyles::Private::findStyle(const KoGenStyle &style, uint hash) const
+{
+    // the last inserted one comes first
+    QMultiHash<uint, int>::const_iterator it = styleHashes.constFind(hash);
+    for (; it != styleHashes.constEnd() && it.key() == hash; ++it) {
+        if (*styleList[it.value()].style == style)
+            return it.value();
+    }
+    return -1;
+}
+
+void KoGenStyles::Private::rehashModifiedStyles()
+{
+    if (modifiedStyles.isEmpty())
+        return;
+    foreach (int index, modifiedStyles) {
+        styleHashes.remove(hashes[index], index);
+        hashes[index] = styleList[index].style->hash();
+        styleHashes.insert(hashes[index], index);
+    }
+    modifiedStyles.clear();
+}
+
+int KoGenStyles::Private::insertStyle(const KoGenStyle &style, uint hash,
+                                      const QString& baseName, InsertionFlags flags)
 {
     QString styleName(baseName);
     if (styleName.isEmpty()) {
@@ -389,17 +526,34 @@ KoGenStyles::StyleMap::iterator KoGenStyles::Private::insertStyle(const KoGenSty
         autoStylesInStylesDotXml[style.m_familyName].insert(styleName);
     else
         styleNames[style.m_familyName].insert(styleName);
-    KoGenStyles::StyleMap::iterator it = styleMap.insert(style, styleName);
+    const int index = styleList.count();
     NamedStyle s;
-    s.style = &it.key();
+    s.style = new KoGenStyle(style);
     s.name = styleName;
     styleList.append(s);
-    return it;
+    hashes.append(hash);
+    styleHashes.insert(hash, index);
+    styleIndexes.insert(styleName, index);
+    return index;
+}
+
+int KoGenStyles::Private::indexOf(const QString &name, const QByteArray &family) const
+{
+    int index = -1;
+    QMultiHash<QString, int>::const_iterator it = styleIndexes.constFind(name);
+    for (; it != styleIndexes.constEnd() && it.key() == name; ++it) {
+        if (styleList[it.value()].style->familyName() == family && (index == -1 || it.value() < index))
+            index = it.value();
+    }
+    return index;
 }
 
 KoGenStyles::StyleMap KoGenStyles::styles() const
 {
-    return d->styleMap;
+    StyleMap styleMap;
+    for (int i = 0; i < d->styleList.count(); ++i)
+        styleMap.insert(*d->styleList[i].style, d->styleList[i].name);
+    return styleMap;
 }
 
 QVector<KoGenStyles::NamedStyle> KoGenStyles::styles(KoGenStyle::Type type) const
@@ -409,19 +563,18 @@ QVector<KoGenStyles::NamedStyle> KoGenStyles::styles(KoGenStyle::Type type) cons
 
 const KoGenStyle* KoGenStyles::style(const QString &name, const QByteArray &family) const
 {
-    QVector<KoGenStyles::NamedStyle>::const_iterator it = d->styleList.constBegin();
-    const QVector<KoGenStyles::NamedStyle>::const_iterator end = d->styleList.constEnd();
-    for (; it != end ; ++it) {
-        if ((*it).name == name && (*it).style->familyName() == family) {
-            return (*it).style;
-        }
-    }
-    return 0;
+    const int index = d->indexOf(name, family);
+    return index == -1 ? 0 : d->styleList[index].style;
 }
 
 KoGenStyle* KoGenStyles::styleForModification(const QString &name, const QByteArray &family)
 {
-    return const_cast<KoGenStyle *>(style(name, family));
+    const int index = d->indexOf(name, family);
+    if (index == -1)
+        return 0;
+    // its hash gets updated on the next insertion
+    d->modifiedStyles.insert(index);
+    return const_cast<KoGenStyle *>(d->styleList[index].style);
 }
 
 void KoGenStyles::markStyleForStylesXml(const QString &name, const QByteArray &family)
@@ -23,6 +23,7 @@
 #ifndef KOGENSTYLES_H
 #define KOGENSTYLES_H
 
+#include <QHash>
 #include <QVector>
 #include <QMultiMap>
 #include <QString>
@@ -109,6 +110,34 @@ public:
      */
     QString insert(const KoGenStyle &style, const QString &baseName = QString(), InsertionFlags flags = NoFlag);
 
+    /**
+     * Insert all styles of another collection, in the order they were inserted there,
+     * as if they had been inserted here in the first place.
+     *
+     * This allows to collect the styles of independent parts of a document separately,
+     * e.g. in different threads, and to combine them afterwards. The references between
+     * the styles of @p styles, i.e. the parent names and the values of the attributes,
+     * properties and maps ending in "-name", get adjusted to the assigned names.
+     * Style names are expected to be unique across the families of @p styles.
+     *
+     * Default styles, font faces, style relations and raw styles are taken over as well;
+     * default styles and font faces that exist in this collection are kept.
+     *
+     * @return the assigned names keyed by the names in @p styles, for those styles
+     * whose name changed
+     */
+    QHash<QString, QString> merge(const KoGenStyles &styles);
+
+    /**
+     * Replace the references to renamed styles in XML written by KoXmlWriter, i.e. the
+     * values of the attributes whose names end in @p suffix and are keys of @p names.
+     *
+     * Use this for XML, which was written while its styles were collected in another
+     * collection, with the names returned by merge().
+     */
+    static void renameReferences(QByteArray &xml, const QHash<QString, QString> &names,
+                                 const QByteArray &suffix = "style-name");
+
     /**
      * Return the entire collection of styles
      * Use this for saving the styles
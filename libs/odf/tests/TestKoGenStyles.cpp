@@ -27,6 +27,7 @@
 #include <OdfDebug.h>
 #include <QBuffer>
 #include <QRegExp>
+#include <QVector>
 
 #include <QTest>
 
@@ -375,4 +376,99 @@ void TestKoGenStyles::testStylesDotXml()
     QCOMPARE(firstName, QString("P2"));     // anything but not P1.
 }
 
+void TestKoGenStyles::testStyleForModification()
+{
+    KoGenStyles coll;
+
+    KoGenStyle first(KoGenStyle::TableCellAutoStyle, "table-cell");
+    first.addProperty("fo:background-color", "#ff0000");
+    const QString firstName = coll.insert(first, "ce");
+
+    // a modified style is found by its new definition
+    KoGenStyle* modified = coll.styleForModification(firstName, "table-cell");
+    QVERIFY(modified);
+    modified->addProperty("fo:wrap-option", "wrap");
+    KoGenStyle second(first);
+    second.addProperty("fo:wrap-option", "wrap");
+    QCOMPARE(coll.insert(second, "ce"), firstName);
+
+    // but not by its old one
+    const QString thirdName = coll.insert(first, "ce");
+    QVERIFY(thirdName != firstName);
+    QCOMPARE(coll.styles().count(), 2);
+    QVERIFY(*coll.style(thirdName, "table-cell") == first);
+}
+
+void TestKoGenStyles::testMerge()
+{
+    KoGenStyle number(KoGenStyle::NumericNumberStyle, "data-style");
+    number.addAttribute("style:volatile", "true");
+    KoGenStyle otherNumber(KoGenStyle::NumericNumberStyle, "data-style");
+    otherNumber.addAttribute("style:volatile", "false");
+
+    KoGenStyles coll;
+    QCOMPARE(coll.insert(number, "N"), QString("N1"));
+    KoGenStyle cell(KoGenStyle::TableCellAutoStyle, "table-cell");
+    cell.addAttribute("style:data-style-name", "N1");
+    QCOMPARE(coll.insert(cell, "ce"), QString("ce1"));
+
+    // collected separately, e.g. for another sheet
+    KoGenStyles part;
+    QCOMPARE(part.insert(otherNumber, "N"), QString("N1"));
+    KoGenStyle otherCell(KoGenStyle::TableCellAutoStyle, "table-cell");
+    otherCell.addAttribute("style:data-style-name", "N1");
+    QCOMPARE(part.insert(otherCell, "ce"), QString("ce1"));
+    QCOMPARE(part.insert(number, "N"), QString("N2"));
+    cell.addAttribute("style:data-style-name", "N2");
+    QCOMPARE(part.insert(cell, "ce"), QString("ce2"));
+
+    // the styles get the names they would have got in the first place
+    const QHash<QString, QString> names = coll.merge(part);
+    QCOMPARE(names.count(), 4);
+    QCOMPARE(names.value("N1"), QString("N2"));
+    QCOMPARE(names.value("ce1"), QString("ce2"));
+    QCOMPARE(names.value("N2"), QString("N1"));
+    QCOMPARE(names.value("ce2"), QString("ce1"));
+    QCOMPARE(coll.styles().count(), 4);
+    QCOMPARE(coll.style("ce1", "table-cell")->attribute("style:data-style-name"), QString("N1"));
+    QCOMPARE(coll.style("ce2", "table-cell")->attribute("style:data-style-name"), QString("N2"));
+    QVERIFY(*coll.style("N2", "data-style") == otherNumber);
+
+    // the XML written with the separately collected styles
+    QByteArray xml("<table:table-cell table:style-name=\"ce1\" table:formula=\"of:=&quot;ce1&quot;\">"
+                   "<text:span text:style-name=\"T1\">ce1</text:span></table:table-cell>");
+    KoGenStyles::renameReferences(xml, names);
+    QCOMPARE(xml, QByteArray("<table:table-cell table:style-name=\"ce2\" table:formula=\"of:=&quot;ce1&quot;\">"
+                             "<text:span text:style-name=\"T1\">ce1</text:span></table:table-cell>"));
+}
+
+void TestKoGenStyles::testInsertPerformance()
+{
+    // cell styles like the ones of a large spreadsheet
+    const int count = 20000;
+    QVector<KoGenStyle> styles;
+    for (int i = 0; i < count; ++i) {
+        KoGenStyle style(KoGenStyle::TableCellAutoStyle, "table-cell", "Default");
+        style.addProperty("fo:background-color", QString("#%1").arg(i % 256, 6, 16, QChar('0')));
+        style.addProperty("fo:border", QString("%1pt solid #000000").arg(i / 256));
+        style.addProperty("style:vertical-align", "middle");
+        style.addProperty("fo:font-size", "10pt", KoGenStyle::TextType);
+        style.addProperty("fo:font-weight", (i % 2) ? "bold" : "normal", KoGenStyle::TextType);
+        style.addAttribute("style:data-style-name", QString("N%1").arg(i % 7));
+        styles.append(style);
+    }
+
+    QBENCHMARK {
+        KoGenStyles coll;
+        KoGenStyle defaultStyle(KoGenStyle::TableCellStyle, "table-cell");
+        coll.insert(defaultStyle, "Default", KoGenStyles::DontAddNumberToName);
+        // each style is inserted once and looked up once
+        for (int i = 0; i < count; ++i)
+            coll.insert(styles[i], "ce");
+        for (int i = 0; i < count; ++i)
+            coll.insert(styles[i], "ce");
+        QCOMPARE(coll.styles().count(), count + 1);
+    }
+}
+
 QTEST_MAIN(TestKoGenStyles)
@@ -31,6 +31,9 @@ private Q_SLOTS:
     void testUserStyles();
     void testWriteStyle();
     void testStylesDotXml();
+    void testStyleForModification();
+    void testMerge();
+    void testInsertPerformance();
 };
 
 #endif // TESTKOGENSTYLES_H
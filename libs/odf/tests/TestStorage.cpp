@@ -18,6 +18,7 @@
  * Boston, MA 02110-1301, USA.
 */
 
+#include <QBuffer>
 #include <QFile>
 #include <QDir>
 
@@ -38,6 +39,8 @@ private Q_SLOTS:
     void storage();
     void storage2_data();
     void storage2();
+    void storageLargeZip();
+    void storageInMemoryZip();
 
 private:
     char getch(QIODevice * dev);
@@ -259,6 +262,125 @@ void TestStorage::storage2()
     QFile::remove(testFile);
 }
 
+void TestStorage::storageLargeZip()
+{
+    const QString testFile = QLatin1String("testlarge.zip");
+    const QByteArray mimetype("application/vnd.oasis.opendocument.spreadsheet");
+
+    // entries spanning several chunks of the parallel compression
+    QByteArray content;
+    for (int i = 0; content.size() < 3 * 1024 * 1024; ++i)
+        content += "<table:table-row><table:table-cell office:value=\"" + QByteArray::number(i) + "\"/></table:table-row>\n";
+    QByteArray picture(700 * 1024, '\0');
+    for (int i = 0; i < picture.size(); ++i)
+        picture[i] = char(qrand());
+
+    if (QFile::exists(testFile))
+        QFile::remove(testFile);
+
+    KoStore* store = KoStore::createStore(testFile, KoStore::Write, mimetype, KoStore::Zip);
+    QVERIFY(store);
+    QVERIFY(store->bad() == false);
+
+    QVERIFY(store->open("content.xml"));
+    QCOMPARE(store->write(content), (qint64) content.size());
+    QVERIFY(store->close());
+
+    store->setCompressionEnabled(false);
+    QVERIFY(store->open("Pictures/picture.png"));
+    // in pieces not matching the chunks
+    for (int i = 0; i < picture.size(); i += 100000)
+        store->write(picture.constData() + i, qMin(100000, picture.size() - i));
+    QVERIFY(store->close());
+    store->setCompressionEnabled(true);
+
+    QVERIFY(store->open("empty.xml"));
+    QVERIFY(store->close());
+
+    QVERIFY(store->open("styles.xml"));
+    QCOMPARE(store->write(content.left(256 * 1024)), (qint64) 256 * 1024);
+    QVERIFY(store->close());
+
+    QVERIFY(store->hasFile("Pictures/picture.png"));
+    QVERIFY(store->finalize());
+    delete store;
+
+    // ODF requires the uncompressed mimetype to be the first entry without an extra field
+    QFile file(testFile);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray header = file.read(38 + mimetype.size());
+    file.close();
+    QCOMPARE(header.left(4), QByteArray("PK\3\4", 4));
+    QCOMPARE(header.mid(8, 2), QByteArray(2, '\0'));   // stored
+    QCOMPARE(header.mid(26, 2), QByteArray("\x08\0", 2)); // name length
+    QCOMPARE(header.mid(28, 2), QByteArray(2, '\0'));  // extra field length
+    QCOMPARE(header.mid(30, 8), QByteArray("mimetype"));
+    QCOMPARE(header.mid(38), mimetype);
+
+    store = KoStore::createStore(testFile, KoStore::Read, "", KoStore::Zip);
+    QVERIFY(store->bad() == false);
+    QVERIFY(store->open("content.xml"));
+    QVERIFY(store->mappedData().isNull()); // compressed
+    QCOMPARE(store->read(store->size()), content);
+    store->close();
+    QVERIFY(store->open("Pictures/picture.png"));
+    QCOMPARE(store->read(store->size()), picture);
+    store->close();
+    QVERIFY(store->open("Pictures/picture.png"));
+    const KoStoreMappedData mapped = store->mappedData();
+    store->close();
+#ifndef Q_OS_WIN
+    QVERIFY(!mapped.isNull());
+#endif
+    if (!mapped.isNull())
+        QCOMPARE(mapped.rawData(), picture);
+    QVERIFY(store->open("empty.xml"));
+    QCOMPARE(store->size(), (qint64) 0);
+    store->close();
+    QVERIFY(store->open("styles.xml"));
+    QCOMPARE(store->read(store->size()), content.left(256 * 1024));
+    store->close();
+    delete store;
+
+    // the mapping outlives the store
+    if (!mapped.isNull())
+        QCOMPARE(mapped.rawData(), picture);
+
+    QFile::remove(testFile);
+}
+
+void TestStorage::storageInMemoryZip()
+{
+    QByteArray picture(200 * 1024, '\0');
+    for (int i = 0; i < picture.size(); ++i)
+        picture[i] = char(qrand());
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    KoStore* store = KoStore::createStore(&buffer, KoStore::Write, "application/vnd.oasis.opendocument.text", KoStore::Zip);
+    QVERIFY(store);
+    QVERIFY(store->bad() == false);
+    store->setCompressionEnabled(false);
+    QVERIFY(store->open("Pictures/picture.png"));
+    QCOMPARE(store->write(picture), (qint64) picture.size());
+    QVERIFY(store->close());
+    QVERIFY(store->finalize());
+    delete store;
+
+    QBuffer input(&data);
+    store = KoStore::createStore(&input, KoStore::Read, "", KoStore::Zip);
+    QVERIFY(store->bad() == false);
+    QVERIFY(store->open("Pictures/picture.png"));
+    // an entry must not keep the whole archive alive
+    QVERIFY(store->mappedData().isNull());
+    QCOMPARE(store->read(store->size()), picture);
+    store->close();
+    delete store;
+
+    // the buffer is released once the store is gone
+    QVERIFY(data.isDetached());
+}
+
 QTEST_GUILESS_MAIN(TestStorage)
 #include <TestStorage.moc>
 
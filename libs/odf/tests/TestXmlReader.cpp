@@ -24,6 +24,7 @@ private Q_SLOTS:
     void testNamespace();
     void testParseQString();
     void testUnload();
+    void testLazyLoading();
     void testSimpleXML();
     void testRootError();
     void testMismatchedTag();
@@ -35,6 +36,9 @@ private Q_SLOTS:
     void testSimpleOpenDocumentPresentation();
     void testSimpleOpenDocumentFormula();
     void testLargeOpenDocumentSpreadsheet();
+    void testPullReader();
+    void testPullReaderError();
+    void testLargeOpenDocumentSpreadsheetPullReader();
     void testExternalOpenDocumentSpreadsheet(const QString& filename);
 };
 
@@ -1133,6 +1137,86 @@ void TestXmlReader::testUnload()
     QCOMPARE(KoXml::childNodesCount(continentsElement), 6);
 }
 
+void TestXmlReader::testLazyLoading()
+{
+    QBuffer xmldevice;
+    xmldevice.open(QIODevice::WriteOnly);
+    QTextStream xmlstream(&xmldevice);
+
+    xmlstream << "<earth>";
+    xmlstream << "<continents>";
+    xmlstream << "<asia area=\"44.6\"/>";
+    xmlstream << "<africa area=\"30.4\"/>";
+    xmlstream << "</continents>";
+    xmlstream << "<oceans>";
+    xmlstream << "<pacific area=\"165.3\"/>";
+    xmlstream << "<atlantic area=\"106.5\"/>";
+    xmlstream << "</oceans>";
+    xmlstream << "</earth>";
+    xmldevice.close();
+
+    KoXmlDocument doc;
+    QCOMPARE(doc.setContent(&xmldevice), true);
+
+    KoXmlElement earthElement = doc.documentElement();
+    QCOMPARE(earthElement.tagName(), QString("earth"));
+
+    // a handle keeps its ancestors loaded
+    KoXmlElement africaElement = earthElement.firstChild().firstChild().nextSibling().toElement();
+    QCOMPARE(africaElement.tagName(), QString("africa"));
+    QCOMPARE(africaElement.attribute("area"), QString("30.4"));
+    KoXmlElement continentsElement = africaElement.parentNode().toElement();
+    QCOMPARE(continentsElement.tagName(), QString("continents"));
+    QCOMPARE(continentsElement == earthElement.firstChild().toElement(), true);
+    QCOMPARE(africaElement.previousSibling().toElement().attribute("area"), QString("44.6"));
+
+    // ... even if the ancestors are unloaded explicitly
+    continentsElement = KoXmlElement();
+    KoXml::unload(earthElement);
+    QCOMPARE(africaElement.parentNode().parentNode() == earthElement, true);
+    QCOMPARE(africaElement.parentNode() == earthElement.firstChild(), true);
+    QCOMPARE(africaElement.attribute("area"), QString("30.4"));
+
+    // the subtrees get reloaded after the handles are gone
+    africaElement = KoXmlElement();
+    KoXmlElement oceansElement = earthElement.lastChild().toElement();
+    QCOMPARE(oceansElement.tagName(), QString("oceans"));
+    QCOMPARE(KoXml::childNodesCount(oceansElement), 2);
+    oceansElement = KoXmlElement();
+    for (int i = 0; i < 3; ++i) {
+        KoXmlElement element = earthElement.firstChild().toElement();
+        QCOMPARE(element.tagName(), QString("continents"));
+        element = element.firstChild().toElement();
+        QCOMPARE(element.tagName(), QString("asia"));
+        QCOMPARE(element.attribute("area"), QString("44.6"));
+        element = earthElement.lastChild().lastChild().toElement();
+        QCOMPARE(element.tagName(), QString("atlantic"));
+        QCOMPARE(element.attribute("area"), QString("106.5"));
+        QCOMPARE(element.parentNode().parentNode() == earthElement, true);
+    }
+
+    // loading deeper keeps the children referred to by handles
+    continentsElement = earthElement.firstChild().toElement();
+    KoXml::load(earthElement, 3);
+    QCOMPARE(KoXml::childNodesCount(earthElement), 2);
+    QCOMPARE(earthElement.firstChild() == continentsElement, true);
+    QCOMPARE(earthElement.lastChild().previousSibling() == continentsElement, true);
+    QCOMPARE(continentsElement.nextSibling().toElement().tagName(), QString("oceans"));
+    QCOMPARE(KoXml::childNodesCount(continentsElement), 2);
+    QCOMPARE(continentsElement.lastChild().toElement().attribute("area"), QString("30.4"));
+    QCOMPARE(earthElement.lastChild().lastChild().toElement().attribute("area"), QString("106.5"));
+    continentsElement = KoXmlElement();
+
+    // a handle may outlive its document
+    KoXmlElement pacificElement = earthElement.lastChild().firstChild().toElement();
+    QCOMPARE(pacificElement.nextSibling().isNull(), false);
+    earthElement = KoXmlElement();
+    doc = KoXmlDocument();
+    QCOMPARE(pacificElement.tagName(), QString("pacific"));
+    QCOMPARE(pacificElement.parentNode().isNull(), true);
+    QCOMPARE(pacificElement.nextSibling().isNull(), true);
+}
+
 void TestXmlReader::testSimpleXML()
 {
     QString errorMsg;
@@ -2583,6 +2667,224 @@ void TestXmlReader::testLargeOpenDocumentSpreadsheet()
     printf("Large spreadsheet: iterating time is %d ms\n", timer.elapsed());
 }
 
+void TestXmlReader::testPullReader()
+{
+    QBuffer xmldevice;
+    xmldevice.open(QIODevice::WriteOnly);
+    QTextStream xmlstream(&xmldevice);
+
+    // the office namespace of older OpenOffice.org versions
+    xmlstream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>";
+    xmlstream << "<office:document-content ";
+    xmlstream << "xmlns:office=\"http://openoffice.org/2000/office\" ";
+    xmlstream << "xmlns:text=\"urn:oasis:names:tc:opendocument:xmlns:text:1.0\" ";
+    xmlstream << "xmlns:table=\"urn:oasis:names:tc:opendocument:xmlns:table:1.0\">";
+    xmlstream << "<office:body>";
+    xmlstream << "<table:table table:name=\"Sheet1\">";
+    xmlstream << "<table:table-row table:style-name=\"ro1\">";
+    xmlstream << "<table:table-cell><text:p>A1</text:p></table:table-cell>";
+    xmlstream << "<table:table-cell><text:p>B1</text:p></table:table-cell>";
+    xmlstream << "</table:table-row>";
+    xmlstream << "<table:table-row table:style-name=\"ro2\">";
+    xmlstream << "<table:table-cell><text:p>A2</text:p></table:table-cell>";
+    xmlstream << "</table:table-row>";
+    xmlstream << "<table:table-row table:style-name=\"ro3\">";
+    xmlstream << "<table:table-cell><text:p>A3</text:p></table:table-cell>";
+    xmlstream << "</table:table-row>";
+    xmlstream << "</table:table>";
+    xmlstream << "</office:body>";
+    xmlstream << "</office:document-content>";
+    xmldevice.close();
+
+    QString officeNS = "urn:oasis:names:tc:opendocument:xmlns:office:1.0";
+    QString tableNS = "urn:oasis:names:tc:opendocument:xmlns:table:1.0";
+    QString textNS = "urn:oasis:names:tc:opendocument:xmlns:text:1.0";
+
+    KoXmlPullReader reader(&xmldevice);
+
+    // <office:document-content>
+    QCOMPARE(reader.readNextStartElement(), true);
+    QCOMPARE(reader.localName(), QString("document-content"));
+    QCOMPARE(reader.nodeName(), QString("document-content"));
+    QCOMPARE(reader.namespaceURI(), officeNS);
+
+    // <office:body>
+    QCOMPARE(reader.readNextStartElement(), true);
+    QCOMPARE(reader.localName(), QString("body"));
+    QCOMPARE(reader.namespaceURI(), officeNS);
+
+    // <table:table>
+    QCOMPARE(reader.readNextStartElement(), true);
+    QCOMPARE(reader.localName(), QString("table"));
+    QCOMPARE(reader.namespaceURI(), tableNS);
+    QCOMPARE(reader.hasAttributeNS(tableNS, "name"), true);
+    QCOMPARE(reader.attributeNS(tableNS, "name"), QString("Sheet1"));
+    QCOMPARE(reader.hasAttributeNS(tableNS, "print"), false);
+    QCOMPARE(reader.attributeNS(tableNS, "print", "true"), QString("true"));
+
+    // the first row as a document of its own
+    QCOMPARE(reader.readNextStartElement(), true);
+    QCOMPARE(reader.localName(), QString("table-row"));
+    KoXmlDocument rowDoc = reader.readElement();
+    KoXmlElement rowElement = rowDoc.documentElement();
+    QCOMPARE(rowElement.isNull(), false);
+    QCOMPARE(rowElement.localName(), QString("table-row"));
+    QCOMPARE(rowElement.namespaceURI(), tableNS);
+    QCOMPARE(rowElement.attributeNS(tableNS, "style-name", ""), QString("ro1"));
+    QCOMPARE(rowElement.parentNode().isNull(), false);
+    QCOMPARE(rowElement.parentNode().isDocument(), true);
+    QCOMPARE(KoXml::childNodesCount(rowElement), 2);
+    KoXmlElement cellElement = rowElement.firstChildElement();
+    QCOMPARE(cellElement.localName(), QString("table-cell"));
+    QCOMPARE(cellElement.text(), QString("A1"));
+    QCOMPARE(cellElement.firstChildElement().namespaceURI(), textNS);
+    cellElement = cellElement.nextSibling().toElement();
+    QCOMPARE(cellElement.text(), QString("B1"));
+    QCOMPARE(cellElement.nextSibling().isNull(), true);
+
+    // the second row is skipped
+    QCOMPARE(reader.readNextStartElement(), true);
+    QCOMPARE(reader.attributeNS(tableNS, "style-name"), QString("ro2"));
+    reader.skipCurrentElement();
+
+    // the third row outlives the reader
+    QCOMPARE(reader.readNextStartElement(), true);
+    QCOMPARE(reader.attributeNS(tableNS, "style-name"), QString("ro3"));
+    rowDoc = reader.readElement();
+
+    // no more rows; the ends of the table, the body and the document element
+    QCOMPARE(reader.readNextStartElement(), false);
+    QCOMPARE(reader.readNextStartElement(), false);
+    QCOMPARE(reader.readNextStartElement(), false);
+    QCOMPARE(reader.hasError(), false);
+
+    rowElement = rowDoc.documentElement();
+    QCOMPARE(rowElement.attributeNS(tableNS, "style-name", ""), QString("ro3"));
+    QCOMPARE(rowElement.firstChildElement().text(), QString("A3"));
+}
+
+void TestXmlReader::testPullReaderError()
+{
+    QBuffer xmldevice;
+    xmldevice.open(QIODevice::WriteOnly);
+    QTextStream xmlstream(&xmldevice);
+    xmlstream << "<document><row><cell>A1</cell></row><row><cell>A2</row></document>";
+    xmldevice.close();
+
+    KoXmlPullReader reader(&xmldevice, false);
+    QCOMPARE(reader.readNextStartElement(), true);
+    QCOMPARE(reader.nodeName(), QString("document"));
+    QCOMPARE(reader.localName(), QString());
+
+    QCOMPARE(reader.readNextStartElement(), true);
+    KoXmlDocument rowDoc = reader.readElement();
+    QCOMPARE(rowDoc.documentElement().tagName(), QString("row"));
+    QCOMPARE(rowDoc.documentElement().text(), QString("A1"));
+
+    // the mismatched tag
+    QCOMPARE(reader.readNextStartElement(), true);
+    rowDoc = reader.readElement();
+    QCOMPARE(rowDoc.documentElement().isNull(), true);
+    QCOMPARE(reader.hasError(), true);
+    QCOMPARE(reader.errorString().isEmpty(), false);
+    QCOMPARE(reader.readNextStartElement(), false);
+}
+
+void TestXmlReader::testLargeOpenDocumentSpreadsheetPullReader()
+{
+    int sheetCount = 4;
+    int rowCount = 200;
+    int colCount = 200 / 16;
+
+    QBuffer xmldevice;
+    xmldevice.open(QIODevice::WriteOnly);
+    QTextStream xmlstream(&xmldevice);
+
+    // content.xml, as in testLargeOpenDocumentSpreadsheet
+    xmlstream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    xmlstream << "<office:document-content ";
+    xmlstream << "xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\" ";
+    xmlstream << "xmlns:text=\"urn:oasis:names:tc:opendocument:xmlns:text:1.0\" ";
+    xmlstream << "xmlns:table=\"urn:oasis:names:tc:opendocument:xmlns:table:1.0\" >\n";
+    xmlstream << "<office:body>\n";
+    xmlstream << "<office:spreadsheet>\n";
+    for (int i = 0; i < sheetCount; i++) {
+        QString sheetName = QString("Sheet%1").arg(i + 1);
+        xmlstream << "<table:table table:name=\"" << sheetName;
+        xmlstream << "\" table:print=\"false\">\n";
+        for (int j = 0; j < rowCount; j++) {
+            xmlstream << "<table:table-row>\n";
+            for (int k = 0; k < colCount; k++) {
+                xmlstream << "<table:table-cell office:value-type=\"string\">";
+                xmlstream << "<text:p>Hello, world</text:p>";
+                xmlstream << "</table:table-cell>\n";
+            }
+            xmlstream << "</table:table-row>\n";
+        }
+        xmlstream << "</table:table>\n";
+    }
+    xmlstream << "</office:spreadsheet>\n";
+    xmlstream << "</office:body>\n";
+    xmlstream << "</office:document-content>\n";
+    xmldevice.close();
+
+    printf("Raw XML size: %lld KB\n", xmldevice.size() / 1024);
+
+    QString officeNS = "urn:oasis:names:tc:opendocument:xmlns:office:1.0";
+    QString tableNS = "urn:oasis:names:tc:opendocument:xmlns:table:1.0";
+
+    QTime timer;
+    timer.start();
+
+    // the whole document at once
+    {
+        KoXmlDocument doc;
+        QCOMPARE(doc.setContent(&xmldevice, true), true);
+        KoXmlElement spreadsheetElement = doc.documentElement().firstChildElement().firstChildElement();
+        int cellCount = 0;
+        KoXmlElement tableElement;
+        forEachElement(tableElement, spreadsheetElement) {
+            KoXmlElement rowElement;
+            forEachElement(rowElement, tableElement) {
+                KoXmlElement cellElement;
+                forEachElement(cellElement, rowElement) {
+                    QCOMPARE(cellElement.attributeNS(officeNS, "value-type", ""), QString("string"));
+                    ++cellCount;
+                }
+            }
+        }
+        QCOMPARE(cellCount, sheetCount * rowCount * colCount);
+    }
+    xmldevice.close();
+    printf("Large spreadsheet: KoXmlDocument loading time is %d ms\n", timer.elapsed());
+
+    // row by row
+    timer.start();
+    KoXmlPullReader reader(&xmldevice);
+    QCOMPARE(reader.readNextStartElement(), true); // <office:document-content>
+    QCOMPARE(reader.readNextStartElement(), true); // <office:body>
+    QCOMPARE(reader.readNextStartElement(), true); // <office:spreadsheet>
+    int tableCount = 0;
+    int cellCount = 0;
+    while (reader.readNextStartElement()) {
+        QCOMPARE(reader.localName(), QString("table"));
+        QCOMPARE(reader.attributeNS(tableNS, "name"), QString("Sheet%1").arg(++tableCount));
+        while (reader.readNextStartElement()) {
+            const KoXmlDocument rowDoc = reader.readElement(true);
+            KoXmlElement cellElement;
+            forEachElement(cellElement, rowDoc.documentElement()) {
+                QCOMPARE(cellElement.text(), QString("Hello, world"));
+                QCOMPARE(cellElement.attributeNS(officeNS, "value-type", ""), QString("string"));
+                ++cellCount;
+            }
+        }
+    }
+    QCOMPARE(reader.hasError(), false);
+    QCOMPARE(tableCount, sheetCount);
+    QCOMPARE(cellCount, sheetCount * rowCount * colCount);
+    printf("Large spreadsheet: KoXmlPullReader loading time is %d ms\n", timer.elapsed());
+}
+
 void TestXmlReader::testExternalOpenDocumentSpreadsheet(const QString& filename)
 {
     QProcess unzip;
@@ -23,6 +23,7 @@
 #include "KoEncryptionChecker.h"
 #include "KoStore_p.h"
 #include "KoXmlReader.h"
+#include "KoZipMapping.h"
 #include <KoXmlNS.h>
 
 #include <QString>
@@ -73,6 +74,7 @@ KoEncryptedStore::KoEncryptedStore(const QString & filename, Mode mode,
                                    const QByteArray & appIdentification, bool writeMimetype)
   : KoStore(mode, writeMimetype)
   , m_filename(filename)
+  , m_mapping(0)
   , m_tempFile(0)
   , m_bPasswordUsed(false)
   , m_bPasswordDeclined(false)
@@ -90,6 +92,7 @@ KoEncryptedStore::KoEncryptedStore(const QString & filename, Mode mode,
 KoEncryptedStore::KoEncryptedStore(QIODevice *dev, Mode mode, const QByteArray & appIdentification,
                                    bool writeMimetype)
     : KoStore(mode, writeMimetype)
+    , m_mapping(0)
     , m_tempFile(0)
     , m_bPasswordUsed(false)
     , m_bPasswordDeclined(false)
@@ -108,6 +111,7 @@ KoEncryptedStore::KoEncryptedStore(QWidget* window, const QUrl &url, const QStri
                                    const QByteArray & appIdentification, bool writeMimetype)
     : KoStore(mode, writeMimetype)
     , m_filename(url.url())
+    , m_mapping(0)
     , m_tempFile(0)
     , m_bPasswordUsed(false)
     , m_bPasswordDeclined(false)
@@ -458,6 +462,7 @@ KoEncryptedStore::~KoEncryptedStore()
         finalize();
     }
 
+    delete m_mapping;
     delete m_pZip;
 
     if (d->fileMode == KoStorePrivate::RemoteWrite) {
@@ -632,6 +637,20 @@ bool KoEncryptedStore::closeRead()
     return true;
 }
 
+KoStoreMappedData KoEncryptedStore::mapRead()
+{
+    Q_D(KoStore);
+    // encrypted files have to be decrypted
+    if (bad() || m_encryptionData.contains(d->fileName))
+        return KoStoreMappedData();
+    const KArchiveEntry *entry = m_pZip->directory()->entry(d->fileName);
+    if (!entry || !entry->isFile())
+        return KoStoreMappedData();
+    if (!m_mapping)
+        m_mapping = new KoZipMapping(m_pZip);
+    return m_mapping->map(static_cast<const KZipFileEntry *>(entry));
+}
+
 void KoEncryptedStore::findPasswordInKWallet()
 {
     Q_D(KoStore);
@@ -36,6 +36,7 @@ class QWidget;
 class QUrl;
 class KZip;
 class KArchiveDirectory;
+class KoZipMapping;
 class QTemporaryFile;
 struct KoEncryptedStore_EncryptionData;
 
@@ -80,6 +81,7 @@ protected:
     virtual bool openRead(const QString &name);
     virtual bool closeWrite();
     virtual bool closeRead();
+    virtual KoStoreMappedData mapRead();
     virtual bool enterRelativeDirectory(const QString &dirName);
     virtual bool enterAbsoluteDirectory(const QString &path);
     virtual bool fileExists(const QString &absPath) const;
@@ -118,6 +120,8 @@ protected:
     QString m_filename;
     QByteArray m_manifestBuffer;
     KZip *m_pZip;
+    /** Maps the entries, which are not encrypted, in "Read" mode */
+    KoZipMapping *m_mapping;
     QTemporaryFile *m_tempFile;
     bool m_bPasswordUsed;
     bool m_bPasswordDeclined;
@@ -301,6 +301,25 @@ QByteArray KoStore::read(qint64 max)
     return d->stream->read(max);
 }
 
+KoStoreMappedData KoStore::mappedData()
+{
+    Q_D(KoStore);
+    if (!d->isOpen) {
+        warnStore << "You must open before mapping";
+        return KoStoreMappedData();
+    }
+    if (d->mode != Read) {
+        errorStore << "KoStore: Can not map a file opened for writing" << endl;
+        return KoStoreMappedData();
+    }
+    return mapRead();
+}
+
+KoStoreMappedData KoStore::mapRead()
+{
+    return KoStoreMappedData();
+}
+
 qint64 KoStore::write(const QByteArray& data)
 {
     return write(data.constData(), data.size());   // see below
@@ -448,28 +467,15 @@ bool KoStore::addLocalFile(const QString &fileName, const QString &destName)
 
 bool KoStore::addDataToFile(QByteArray &buffer, const QString &destName)
 {
-    QBuffer file(&buffer);
-    if (!file.open(QIODevice::ReadOnly)) {
-        return false;
-    }
-
     if (!open(destName)) {
         return false;
     }
 
-    QByteArray data;
-    data.resize(8 * 1024);
-
-    uint total = 0;
-    for (int block = 0; (block = file.read(data.data(), data.size())) > 0; total += block) {
-        data.resize(block);
-        if (write(data) != block)
-            return false;
-        data.resize(8*1024);
-    }
+    // the data is in memory already, no need to pass it on in blocks
+    if (write(buffer) != buffer.size())
+        return false;
 
     close();
-    file.close();
 
     return true;
 }
@@ -498,17 +504,22 @@ bool KoStorePrivate::extractFile(const QString &srcName, QIODevice &buffer)
         q->close();
         return false;
     }
-    // ### This could use KArchive::copy or something, no?
 
-    QByteArray data;
-    data.resize(8 * 1024);
-    uint total = 0;
-    for (int block = 0; (block = q->read(data.data(), data.size())) > 0; total += block) {
-        buffer.write(data.data(), block);
-    }
+    const KoStoreMappedData mapped = q->mappedData();
+    if (!mapped.isNull()) {
+        buffer.write(mapped.data(), mapped.size());
+    } else {
+        // ### This could use KArchive::copy or something, no?
+        QByteArray data;
+        data.resize(8 * 1024);
+        uint total = 0;
+        for (int block = 0; (block = q->read(data.data(), data.size())) > 0; total += block) {
+            buffer.write(data.data(), block);
+        }
 
-    if (q->size() != static_cast<qint64>(-1))
-        Q_ASSERT(total == q->size());
+        if (q->size() != static_cast<qint64>(-1))
+            Q_ASSERT(total == q->size());
+    }
 
     buffer.close();
     q->close();
@@ -23,6 +23,7 @@
 
 #include <QByteArray>
 #include <QIODevice>
+#include "KoStoreMappedData.h"
 #include "kostore_export.h"
 
 class QWidget;
@@ -160,6 +161,15 @@ public:
      */
     qint64 read(char *buffer, qint64 length);
 
+    /**
+     * Get the data of the currently opened file without reading it, if the
+     * backend supports that, e.g. for files stored uncompressed in a ZIP
+     * archive file. Stores read from memory are never mapped. The data is
+     * independent of the position of the device.
+     * @return the data, or a null object if the file has to be read
+     */
+    KoStoreMappedData mappedData();
+
     /**
      * Write data into the currently opened file. You can also use the streams
      * for this.
@@ -349,6 +359,12 @@ protected:
      */
     virtual bool closeWrite() = 0;
 
+    /**
+     * Map the currently opened file, see mappedData().
+     * The default implementation returns a null object.
+     */
+    virtual KoStoreMappedData mapRead();
+
     /**
      * Enter a subdirectory of the current directory.
      * The directory might not exist yet in Write mode.
@@ -0,0 +1,59 @@
+/* This file is part of the KDE project
+   Copyright (C) 2016 The Calligra developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#include "KoStoreMappedData.h"
+
+#include <QFile>
+
+KoStoreMappedData::KoStoreMappedData()
+        : m_data(0)
+        , m_size(0)
+{
+}
+
+KoStoreMappedData::KoStoreMappedData(const QSharedPointer<QFile> &file, const uchar *data, qint64 size)
+        : m_file(file)
+        , m_data(reinterpret_cast<const char*>(data))
+        , m_size(size)
+{
+}
+
+KoStoreMappedData::~KoStoreMappedData()
+{
+}
+
+bool KoStoreMappedData::isNull() const
+{
+    return m_data == 0;
+}
+
+const char *KoStoreMappedData::data() const
+{
+    return m_data;
+}
+
+qint64 KoStoreMappedData::size() const
+{
+    return m_size;
+}
+
+QByteArray KoStoreMappedData::rawData() const
+{
+    return QByteArray::fromRawData(m_data, int(m_size));
+}
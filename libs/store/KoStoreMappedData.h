@@ -0,0 +1,68 @@
+/* This file is part of the KDE project
+   Copyright (C) 2016 The Calligra developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KOSTOREMAPPEDDATA_H
+#define KOSTOREMAPPEDDATA_H
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include "kostore_export.h"
+
+class QFile;
+
+/**
+ * The content of a file in a store, which is accessed in place instead of
+ * being read into memory, see KoStore::mappedData().
+ *
+ * The data is read-only. It is shared by all copies of this object and
+ * stays valid as long as one of them exists, even after the store got
+ * deleted.
+ */
+class KOSTORE_EXPORT KoStoreMappedData
+{
+public:
+    /**
+     * Creates a null object.
+     */
+    KoStoreMappedData();
+    /**
+     * Refers to \p size bytes at \p data , which are mapped from \p file .
+     * The mapping is removed, once \p file gets deleted.
+     */
+    KoStoreMappedData(const QSharedPointer<QFile> &file, const uchar *data, qint64 size);
+    ~KoStoreMappedData();
+
+    bool isNull() const;
+    const char *data() const;
+    qint64 size() const;
+
+    /**
+     * \return the data as a QByteArray without copying it. It must not be
+     * used after this object and its copies are gone.
+     */
+    QByteArray rawData() const;
+
+private:
+    // keeps the mapping alive
+    QSharedPointer<QFile> m_file;
+    const char *m_data;
+    qint64 m_size;
+};
+
+#endif
@@ -71,6 +71,9 @@
 
 #include <QTextCodec>
 #include <QTextDecoder>
+#include <QXmlStreamEntityResolver>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 #ifndef KOXML_USE_QDOM
 
@@ -640,6 +643,24 @@ namespace {
         return error;
     }
 
+    // parse the current element of the reader and its children as if it were
+    // the document element of a standalone xml document
+    ParseError parseCurrentElement(QXmlStreamReader &xml, KoXmlPackedDocument &doc, bool stripSpaces = true)
+    {
+        doc.clear();
+        ParseError error;
+        parseElement(xml, doc, stripSpaces);
+        if (xml.hasError()) {
+            error.error = true;
+            error.errorMsg = xml.errorString();
+            error.errorColumn = xml.columnNumber();
+            error.errorLine = xml.lineNumber();
+        } else {
+            doc.finish();
+        }
+        return error;
+    }
+
     void parseElementContents(QXmlStreamReader &xml, KoXmlPackedDocument &doc)
     {
         xml.readNext();
@@ -774,6 +795,23 @@ public:
         }
     }
 
+    // A handle, i.e. a KoXmlNode, refers to this node. As long as a node or
+    // any of its descendants is referred to, its children stay loaded.
+    void attach() {
+        ref();
+        for (KoXmlNodeData* node = this; node && !node->pins++; node = node->parent) {}
+    }
+    // Once the last handle of an element or of its descendants is gone, its
+    // children get unloaded. They are recreated from the packed document on
+    // the next access, so only the subtrees in use are kept in memory.
+    void detach() {
+        for (KoXmlNodeData* node = this; node && !--node->pins; node = node->parent) {
+            if (node->nodeType == KoXmlNode::ElementNode)
+                node->unloadChildren();
+        }
+        unref();
+    }
+
     // type information
     QString nodeName() const;
 
@@ -825,6 +863,8 @@ private:
     QString textData;
     // reference counting
     unsigned long refCount;
+    // the number of handles of this node and of its referred descendants
+    unsigned long pins;
     friend class KoXmlElement;
 };
 
@@ -840,6 +880,7 @@ KoXmlNodeData::KoXmlNodeData(unsigned long initialRefCount)
     , parent(0), prev(0), next(0), first(0), last(0)
     , packedDoc(0), nodeIndex(0)
     , refCount(initialRefCount)
+    , pins(0)
 {
 }
 
@@ -853,6 +894,9 @@ void KoXmlNodeData::clear()
     if (first)
         for (KoXmlNodeData* node = first; node ;) {
             KoXmlNodeData* next = node->next;
+            // a child still referred to by a handle outlives this node
+            node->parent = 0;
+            node->prev = node->next = 0;
             node->unref();
             node = next;
         }
@@ -1006,6 +1050,14 @@ void KoXmlNodeData::loadChildren(int depth)
     // in case depth is different
     unloadChildren();
 
+    // children referred to by handles stay, load the deeper levels into them
+    if (loaded) {
+        if (depth > 1)
+            for (KoXmlNodeData* node = first; node; node = node->next)
+                node->loadChildren(depth - 1);
+        return;
+    }
+
 
     KoXmlNodeData* lastDat = 0;
 
@@ -1109,6 +1161,14 @@ void KoXmlNodeData::loadChildren(int depth)
     // cause we don't know how deep this node's children already loaded are
     unloadChildren();
 
+    // children referred to by handles stay, load the deeper levels into them
+    if (loaded) {
+        if (depth > 1)
+            for (KoXmlNodeData* node = first; node; node = node->next)
+                node->loadChildren(depth - 1);
+        return;
+    }
+
     KoXmlNodeData* lastDat = 0;
     int nodeDepth = packedDoc->items[nodeIndex].depth;
 
@@ -1212,6 +1272,12 @@ void KoXmlNodeData::unloadChildren()
 
     if (!loaded) return;
 
+    // children referred to by handles have to stay
+    for (KoXmlNodeData* node = first; node; node = node->next) {
+        if (node->pins)
+            return;
+    }
+
     if (first)
         for (KoXmlNodeData* node = first; node ;) {
             KoXmlNodeData* next = node->next;
@@ -1461,8 +1527,10 @@ public:
     KoXmlDocumentData(unsigned long initialRefCount = 1);
     ~KoXmlDocumentData();
 
+    // reads the current element of the reader only, if currentElement is true
     bool setContent(QXmlStreamReader *reader,
-                    QString* errorMsg = 0, int* errorLine = 0, int* errorColumn = 0);
+                    QString* errorMsg = 0, int* errorLine = 0, int* errorColumn = 0,
+                    bool currentElement = false);
 
     KoXmlDocumentType dt;
 
@@ -1485,7 +1553,8 @@ KoXmlDocumentData::~KoXmlDocumentData()
 {
 }
 
-bool KoXmlDocumentData::setContent(QXmlStreamReader* reader, QString* errorMsg, int* errorLine, int* errorColumn)
+bool KoXmlDocumentData::setContent(QXmlStreamReader* reader, QString* errorMsg, int* errorLine, int* errorColumn,
+                                   bool currentElement)
 {
     // sanity checks
     if (!reader) return false;
@@ -1499,7 +1568,8 @@ bool KoXmlDocumentData::setContent(QXmlStreamReader* reader, QString* errorMsg,
     packedDoc = new KoXmlPackedDocument;
     packedDoc->processNamespace = reader->namespaceProcessing();
 
-    ParseError error = parseDocument(*reader, *packedDoc, stripSpaces);
+    ParseError error = currentElement ? parseCurrentElement(*reader, *packedDoc, stripSpaces)
+                                      : parseDocument(*reader, *packedDoc, stripSpaces);
     if (error.error) {
         // parsing error has occurred
         if (errorMsg) *errorMsg = error.errorMsg;
@@ -1530,36 +1600,37 @@ bool KoXmlDocumentData::setContent(QXmlStreamReader* reader, QString* errorMsg,
 KoXmlNode::KoXmlNode()
 {
     d = &KoXmlNodeData::null;
-    d->ref();
+    d->attach();
 }
 
 // Destroys this node
 KoXmlNode::~KoXmlNode()
 {
-    d->unref();
+    d->detach();
 }
 
 // Creates a copy of another node
 KoXmlNode::KoXmlNode(const KoXmlNode& node)
 {
     d = node.d;
-    d->ref();
+    d->attach();
 }
 
 // Creates a node for specific implementation
 KoXmlNode::KoXmlNode(KoXmlNodeData* data)
 {
     d = data;
-    data->ref();
+    data->attach();
 }
 
 // Creates a shallow copy of another node
 KoXmlNode& KoXmlNode::operator=(const KoXmlNode & node)
 {
     if (this != &node) {
-        d->unref();
+        // the new node first, so that the common ancestors stay loaded
+        node.d->attach();
+        d->detach();
         d = node.d;
-        d->ref();
     }
     return *this;
 }
@@ -1617,8 +1688,9 @@ bool KoXmlNode::isDocumentType() const
 
 void KoXmlNode::clear()
 {
-    d->unref();
-    d = new KoXmlNodeData;
+    d->detach();
+    d = new KoXmlNodeData(0);
+    d->attach();
 }
 
 QString KoXmlNode::nodeName() const
@@ -2128,10 +2200,11 @@ QString KoXmlDocument::nodeName() const
 
 void KoXmlDocument::clear()
 {
-    d->unref();
-    KoXmlDocumentData *dat = new KoXmlDocumentData;
+    d->detach();
+    KoXmlDocumentData *dat = new KoXmlDocumentData(0);
     dat->emptyDocument = false;
     d = dat;
+    d->attach();
 }
 
 namespace {
@@ -2150,11 +2223,12 @@ bool KoXmlDocument::setContent(QXmlStreamReader *reader,
 {
     if (d->nodeType != KoXmlNode::DocumentNode) {
         const bool stripSpaces = KOXMLDOCDATA(d)->stripSpaces;
-        d->unref();
-        KoXmlDocumentData *dat = new KoXmlDocumentData;
+        d->detach();
+        KoXmlDocumentData *dat = new KoXmlDocumentData(0);
         dat->nodeType = KoXmlNode::DocumentNode;
         dat->stripSpaces = stripSpaces;
         d = dat;
+        d->attach();
     }
 
     const bool result = KOXMLDOCDATA(d)->setContent(reader, errorMsg, errorLine, errorColumn);
@@ -2174,11 +2248,12 @@ bool KoXmlDocument::setContent(QIODevice* device, bool namespaceProcessing,
 {
     if (d->nodeType != KoXmlNode::DocumentNode) {
         const bool stripSpaces = KOXMLDOCDATA(d)->stripSpaces;
-        d->unref();
-        KoXmlDocumentData *dat = new KoXmlDocumentData;
+        d->detach();
+        KoXmlDocumentData *dat = new KoXmlDocumentData(0);
         dat->nodeType = KoXmlNode::DocumentNode;
         dat->stripSpaces = stripSpaces;
         d = dat;
+        d->attach();
     }
 
     if (!device->isOpen()) device->open(QIODevice::ReadOnly);
@@ -2205,11 +2280,12 @@ bool KoXmlDocument::setContent(const QString& text, bool namespaceProcessing,
 {
     if (d->nodeType != KoXmlNode::DocumentNode) {
         const bool stripSpaces = KOXMLDOCDATA(d)->stripSpaces;
-        d->unref();
-        KoXmlDocumentData *dat = new KoXmlDocumentData;
+        d->detach();
+        KoXmlDocumentData *dat = new KoXmlDocumentData(0);
         dat->nodeType = KoXmlNode::DocumentNode;
         dat->stripSpaces = stripSpaces;
         d = dat;
+        d->attach();
     }
 
     QXmlStreamReader reader(text);
@@ -2236,6 +2312,145 @@ void  KoXmlDocument::setWhitespaceStripping(bool stripSpaces)
 
 #endif
 
+// ==================================================================
+//
+//         KoXmlPullReader
+//
+// ==================================================================
+
+class Q_DECL_HIDDEN KoXmlPullReader::Private
+{
+public:
+    /* Ignores undefined entities like the one used by KoXmlDocument. */
+    class EntityResolver : public QXmlStreamEntityResolver {
+    public:
+        QString resolveUndeclaredEntity(const QString &) { return QString(""); }
+    };
+
+    QXmlStreamReader reader;
+    EntityResolver entityResolver;
+};
+
+KoXmlPullReader::KoXmlPullReader(QIODevice* device, bool namespaceProcessing)
+    : d(new Private)
+{
+    if (!device->isOpen()) device->open(QIODevice::ReadOnly);
+    d->reader.setDevice(device);
+    d->reader.setNamespaceProcessing(namespaceProcessing);
+    d->reader.setEntityResolver(&d->entityResolver);
+}
+
+KoXmlPullReader::~KoXmlPullReader()
+{
+    delete d;
+}
+
+bool KoXmlPullReader::readNextStartElement()
+{
+    return d->reader.readNextStartElement();
+}
+
+void KoXmlPullReader::skipCurrentElement()
+{
+    d->reader.skipCurrentElement();
+}
+
+KoXmlDocument KoXmlPullReader::readElement(bool stripSpaces)
+{
+    if (!d->reader.isStartElement())
+        return KoXmlDocument();
+#ifdef KOXML_USE_QDOM
+    // copy the subtree; namespaces declared by the ancestors get declared anew
+    QByteArray data;
+    QXmlStreamWriter writer(&data);
+    int depth = 0;
+    while (!d->reader.atEnd()) {
+        writer.writeCurrentToken(d->reader);
+        if (d->reader.isStartElement())
+            ++depth;
+        else if (d->reader.isEndElement() && --depth == 0)
+            break;
+        d->reader.readNext();
+    }
+    KoXmlDocument doc;
+    if (d->reader.hasError() || !doc.setContent(data, d->reader.namespaceProcessing()))
+        return KoXmlDocument();
+    Q_UNUSED(stripSpaces);
+    return doc;
+#else
+    KoXmlDocumentData *data = new KoXmlDocumentData(0);
+    data->nodeType = KoXmlNode::DocumentNode;
+    data->stripSpaces = stripSpaces;
+    KoXmlDocument doc(data);
+    data->emptyDocument = false;
+    if (!data->setContent(&d->reader, 0, 0, 0, true))
+        return KoXmlDocument();
+    return doc;
+#endif
+}
+
+bool KoXmlPullReader::atEnd() const
+{
+    return d->reader.atEnd();
+}
+
+bool KoXmlPullReader::hasError() const
+{
+    return d->reader.hasError();
+}
+
+QString KoXmlPullReader::errorString() const
+{
+    return d->reader.errorString();
+}
+
+int KoXmlPullReader::lineNumber() const
+{
+    return d->reader.lineNumber();
+}
+
+int KoXmlPullReader::columnNumber() const
+{
+    return d->reader.columnNumber();
+}
+
+QString KoXmlPullReader::namespaceURI() const
+{
+#ifdef KOXML_USE_QDOM
+    return d->reader.namespaceUri().toString();
+#else
+    return fixNamespace(d->reader.namespaceUri().toString());
+#endif
+}
+
+QString KoXmlPullReader::localName() const
+{
+    if (!d->reader.namespaceProcessing())
+        return QString();
+    return d->reader.name().toString();
+}
+
+QString KoXmlPullReader::nodeName() const
+{
+    if (d->reader.namespaceProcessing())
+        return d->reader.name().toString();
+    return d->reader.qualifiedName().toString();
+}
+
+bool KoXmlPullReader::hasAttributeNS(const QString& nsURI, const QString& name) const
+{
+    return d->reader.attributes().hasAttribute(nsURI, name);
+}
+
+QString KoXmlPullReader::attributeNS(const QString& nsURI, const QString& name,
+                                     const QString& defaultValue) const
+{
+    const QXmlStreamAttributes attributes = d->reader.attributes();
+    if (!attributes.hasAttribute(nsURI, name))
+        return defaultValue;
+    return attributes.value(nsURI, name).toString();
+}
+
 // ==================================================================
 //
 //         functions in KoXml namespace
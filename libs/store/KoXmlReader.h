@@ -270,7 +270,9 @@ private:
 *
 * KoXmlDocument is designed to be memory efficient. Unlike QDomDocument from
 * Qt's XML module, KoXmlDocument does not store all nodes in the DOM tree.
-* Some nodes will be loaded and parsed on-demand only.
+* Some nodes will be loaded and parsed on-demand only. The child nodes of an
+* element are unloaded again, once neither the element nor any of its
+* descendants is referred to by a KoXmlNode anymore.
 *
 * KoXmlDocument is read-only, you can not modify its content.
 *
@@ -317,11 +319,104 @@ public:
 
 private:
     friend class KoXmlNode;
+    friend class KoXmlPullReader;
     explicit KoXmlDocument(KoXmlDocumentData*);
 };
 
 #endif // KOXML_USE_QDOM
 
+/**
+* KoXmlPullReader reads an XML document forward only, element by element.
+*
+* Unlike KoXmlDocument, it does not keep the document in memory. Loaders
+* of large documents step to the elements they are interested in, read
+* their attributes and load only the subtree of an element into its own
+* KoXmlDocument with readElement(). The memory of such a subtree is
+* released as soon as the returned document goes out of scope, e.g. after
+* a table row got loaded.
+*
+* Namespaces are handled like the ones of KoXmlDocument, i.e. the ones of
+* older OpenOffice.org versions are translated into the KoXmlNS ones.
+*
+* readNextStartElement() returns \c false at the end of the current element,
+* so each level of the document is read by a loop of its own, here by
+* descending recursively:
+*
+* \code
+* void readRows(KoXmlPullReader& reader)
+* {
+*     while (reader.readNextStartElement()) {
+*         if (reader.namespaceURI() != KoXmlNS::office && reader.namespaceURI() != KoXmlNS::table) {
+*             reader.skipCurrentElement();
+*         } else if (reader.localName() == "table-row") {
+*             const KoXmlDocument row = reader.readElement();
+*             loadRow(row.documentElement());
+*         } else {
+*             readRows(reader);
+*         }
+*     }
+* }
+*
+* KoXmlPullReader reader(device);
+* readRows(reader);
+* \endcode
+*
+* \note None of the loaders uses it yet; they still get the whole part
+* as a KoXmlDocument.
+*/
+class KOSTORE_EXPORT KoXmlPullReader
+{
+public:
+    /**
+     * Creates a reader for the XML document in \p device , which gets
+     * opened, if it is not open yet.
+     */
+    explicit KoXmlPullReader(QIODevice* device, bool namespaceProcessing = true);
+    ~KoXmlPullReader();
+
+    /**
+     * Reads until the next start element within the current element.
+     * \return \c false , if the end of the current element or of the
+     * document was reached instead or an error occurred
+     */
+    bool readNextStartElement();
+
+    /**
+     * Skips the rest of the current element including its children.
+     */
+    void skipCurrentElement();
+
+    /**
+     * Loads the current element and its children into a document of its
+     * own, whose document element it becomes. Afterwards the reader is
+     * positioned at the end of the element.
+     * \return the document or an empty one, if an error occurred
+     */
+    KoXmlDocument readElement(bool stripSpaces = false);
+
+    bool atEnd() const;
+    bool hasError() const;
+    QString errorString() const;
+    int lineNumber() const;
+    int columnNumber() const;
+
+    /**
+     * The properties of the current element.
+     */
+    QString namespaceURI() const;
+    QString localName() const;
+    QString nodeName() const;
+    bool hasAttributeNS(const QString& nsURI, const QString& name) const;
+    QString attributeNS(const QString& nsURI, const QString& name,
+                        const QString& defaultValue = QString()) const;
+
+private:
+    Q_DISABLE_COPY(KoXmlPullReader)
+
+    class Private;
+    Private * const d;
+};
+
 /**
  * This namespace contains a few convenience functions to simplify code using QDom
  * (when loading OASIS documents, in particular).
@@ -386,6 +481,8 @@ KOSTORE_EXPORT void load(KoXmlNode& node, int depth = 1);
 
 /**
  * Unload child nodes of specified node.
+ * Nothing is unloaded, while one of the child nodes or of their descendants
+ * is still referred to by another KoXmlNode.
  * This function has no effect if QDom is used.
  */
 KOSTORE_EXPORT void unload(KoXmlNode& node);
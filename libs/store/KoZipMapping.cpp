@@ -0,0 +1,71 @@
+/* This file is part of the KDE project
+   Copyright (C) 2016 The Calligra developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#include "KoZipMapping.h"
+
+#include "StoreDebug.h"
+
+#include <QFile>
+
+#include <kzip.h>
+
+KoZipMapping::KoZipMapping(KZip *zip)
+        : m_zip(zip)
+        , m_mapped(false)
+        , m_data(0)
+        , m_size(0)
+{
+}
+
+KoStoreMappedData KoZipMapping::map(const KZipFileEntry *entry)
+{
+    // 0 is the method of entries stored uncompressed
+    if (!entry || entry->encoding() != 0 || entry->size() != entry->compressedSize())
+        return KoStoreMappedData();
+
+    if (!m_mapped) {
+        m_mapped = true;
+#ifndef Q_OS_WIN
+        // A mapped file can not be replaced on Windows, which would
+        // make saving over the loaded document fail.
+        // Archives in memory are not mapped: a range of the archive's buffer
+        // would keep the whole archive alive as long as any entry is used.
+        QFile *device = qobject_cast<QFile*>(m_zip->device());
+        const QString fileName = device ? device->fileName() : m_zip->fileName();
+        QSharedPointer<QFile> file(new QFile(fileName));
+        if (!fileName.isEmpty() && file->open(QIODevice::ReadOnly)) {
+            // the mapping stays valid after the file got closed
+            m_data = file->map(0, file->size());
+            if (m_data) {
+                m_file = file;
+                m_size = file->size();
+            } else {
+                debugStore << "Mapping" << fileName << "failed:" << file->errorString();
+            }
+            file->close();
+        }
+#endif
+    }
+
+    if (entry->position() < 0 || entry->position() + entry->size() > m_size)
+        return KoStoreMappedData();
+    if (m_file)
+        return KoStoreMappedData(m_file, m_data + entry->position(), entry->size());
+    return KoStoreMappedData();
+}
@@ -0,0 +1,54 @@
+/* This file is part of the KDE project
+   Copyright (C) 2016 The Calligra developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KOZIPMAPPING_H
+#define KOZIPMAPPING_H
+
+#include "KoStoreMappedData.h"
+
+class KZip;
+class KZipFileEntry;
+
+/**
+ * Maps the archive file read by a KZip into memory, when the first entry
+ * gets mapped, to give access to the entries stored uncompressed in place.
+ * Archives read from memory are not mapped.
+ */
+class KoZipMapping
+{
+public:
+    explicit KoZipMapping(KZip *zip);
+
+    /**
+     * \return the data of \p entry or a null object, if it is compressed
+     * or the archive can not be mapped
+     */
+    KoStoreMappedData map(const KZipFileEntry *entry);
+
+private:
+    Q_DISABLE_COPY(KoZipMapping)
+
+    KZip *m_zip;
+    bool m_mapped;
+    QSharedPointer<QFile> m_file;
+    const uchar *m_data;
+    qint64 m_size;
+};
+
+#endif
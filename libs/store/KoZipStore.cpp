@@ -20,6 +20,8 @@
 
 #include "KoZipStore.h"
 #include "KoStore_p.h"
+#include "KoZipMapping.h"
+#include "KoZipWriter.h"
 
 #include <QBuffer>
 #include <QByteArray>
@@ -86,6 +88,8 @@ KoZipStore::~KoZipStore()
     debugStore << "KoZipStore::~KoZipStore";
     if (!d->finalized)
         finalize(); // ### no error checking when the app forgot to call finalize itself
+    delete m_writer;
+    delete m_mapping;
     delete m_pZip;
 
     // Now we have still some job to do for remote files.
@@ -102,40 +106,51 @@ void KoZipStore::init(const QByteArray& appIdentification)
     Q_D(KoStore);
 
     m_currentDir = 0;
-    d->good = m_pZip->open(d->mode == Write ? QIODevice::WriteOnly : QIODevice::ReadOnly);
-
-    if (!d->good)
-        return;
+    m_writer = 0;
+    m_mapping = 0;
 
     if (d->mode == Write) {
-        //debugStore <<"KoZipStore::init writing mimetype" << appIdentification;
+        // KZip compresses on the calling thread, KoZipWriter on the thread pool.
+        // It writes neither extra fields nor data descriptors, as required for
+        // the mimetype entry.
+        if (m_pZip->device())
+            m_writer = new KoZipWriter(m_pZip->device());
+        else
+            m_writer = new KoZipWriter(m_pZip->fileName());
+        d->good = m_writer->isOpen();
+        if (!d->good)
+            return;
 
-        m_pZip->setCompression(KZip::NoCompression);
-        m_pZip->setExtraField(KZip::NoExtraField);
+        //debugStore <<"KoZipStore::init writing mimetype" << appIdentification;
 
         // Write identification
         if (d->writeMimetype) {
-            (void)m_pZip->writeFile(QLatin1String("mimetype"), appIdentification);
+            m_writer->setCompression(false);
+            m_writer->open(QLatin1String("mimetype"));
+            m_writer->write(appIdentification);
+            m_writer->close();
         }
 
-        m_pZip->setCompression(KZip::DeflateCompression);
-        // We don't need the extra field in Calligra - so we leave it as "no extra field".
+        m_writer->setCompression(true);
     } else {
+        d->good = m_pZip->open(QIODevice::ReadOnly);
+        if (!d->good)
+            return;
         d->good = m_pZip->directory() != 0;
+        m_mapping = new KoZipMapping(m_pZip);
     }
 }
 
 void KoZipStore::setCompressionEnabled(bool e)
 {
-    if (e) {
-        m_pZip->setCompression(KZip::DeflateCompression);
-    } else {
-        m_pZip->setCompression(KZip::NoCompression);        
-    }
+    if (m_writer)
+        m_writer->setCompression(e);
 }
 
 bool KoZipStore::doFinalize()
 {
+    if (m_writer)
+        return m_writer->finish();
     return m_pZip->close();
 }
 
@@ -143,7 +158,7 @@ bool KoZipStore::openWrite(const QString& name)
 {
     Q_D(KoStore);
     d->stream = 0; // Don't use!
-    return m_pZip->prepareWriting(name, "", "" /*m_pZip->rootDir()->user(), m_pZip->rootDir()->group()*/, 0);
+    return m_writer->open(name);
 }
 
 bool KoZipStore::openRead(const QString& name)
@@ -165,6 +180,17 @@ bool KoZipStore::openRead(const QString& name)
     return true;
 }
 
+KoStoreMappedData KoZipStore::mapRead()
+{
+    Q_D(KoStore);
+    if (!m_mapping)
+        return KoStoreMappedData();
+    const KArchiveEntry *entry = m_pZip->directory()->entry(d->fileName);
+    if (!entry || !entry->isFile())
+        return KoStoreMappedData();
+    return m_mapping->map(static_cast<const KZipFileEntry *>(entry));
+}
+
 qint64 KoZipStore::write(const char* _data, qint64 _len)
 {
     Q_D(KoStore);
@@ -181,7 +207,7 @@ qint64 KoZipStore::write(const char* _data, qint64 _len)
     }
 
     d->size += _len;
-    if (m_pZip->writeData(_data, _len))     // writeData returns a bool!
+    if (m_writer->write(_data, _len))
         return _len;
     return 0;
 }
@@ -189,6 +215,16 @@ qint64 KoZipStore::write(const char* _data, qint64 _len)
 QStringList KoZipStore::directoryList() const
 {
     QStringList retval;
+    if (m_writer) {
+        // the top level directories of the files written so far
+        Q_D(const KoStore);
+        foreach (const QString &fileName, d->filesList) {
+            const int slash = fileName.indexOf(QLatin1Char('/'));
+            if (slash != -1 && !retval.contains(fileName.left(slash)))
+                retval << fileName.left(slash);
+        }
+        return retval;
+    }
     const KArchiveDirectory *directory = m_pZip->directory();
     foreach(const QString &name, directory->entries()) {
         const KArchiveEntry* fileArchiveEntry = m_pZip->directory()->entry(name);
@@ -203,7 +239,7 @@ bool KoZipStore::closeWrite()
 {
     Q_D(KoStore);
     debugStore << "Wrote file" << d->fileName << " into ZIP archive. size" << d->size;
-    return m_pZip->finishWriting(d->size);
+    return m_writer->close();
 }
 
 bool KoZipStore::enterRelativeDirectory(const QString& dirName)
@@ -226,6 +262,8 @@ bool KoZipStore::enterRelativeDirectory(const QString& dirName)
 
 bool KoZipStore::enterAbsoluteDirectory(const QString& path)
 {
+    if (m_writer) // Write, no checking here
+        return true;
     if (path.isEmpty()) {
         m_currentDir = 0;
         return true;
@@ -237,6 +275,10 @@ bool KoZipStore::enterAbsoluteDirectory(const QString& path)
 
 bool KoZipStore::fileExists(const QString& absPath) const
 {
+    if (m_writer) {
+        Q_D(const KoStore);
+        return d->filesList.contains(absPath);
+    }
     const KArchiveEntry *entry = m_pZip->directory()->entry(absPath);
     return entry && entry->isFile();
 }
@@ -24,6 +24,8 @@
 
 class KZip;
 class KArchiveDirectory;
+class KoZipMapping;
+class KoZipWriter;
 class QUrl;
 
 class KoZipStore : public KoStore
@@ -55,6 +57,7 @@ protected:
     virtual bool closeRead() {
         return true;
     }
+    virtual KoStoreMappedData mapRead();
     virtual bool enterRelativeDirectory(const QString& dirName);
     virtual bool enterAbsoluteDirectory(const QString& path);
     virtual bool fileExists(const QString& absPath) const;
@@ -64,6 +67,12 @@ private:
     /// The archive
     KZip * m_pZip;
 
+    /// Writes the archive in "Write" mode instead of m_pZip
+    KoZipWriter * m_writer;
+
+    /// Maps the archive in "Read" mode
+    KoZipMapping * m_mapping;
+
     /** In "Read" mode this pointer is pointing to the
     current directory in the archive to speed up the verification process */
     const KArchiveDirectory* m_currentDir;
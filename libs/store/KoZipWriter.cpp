@@ -0,0 +1,443 @@
+/* This file is part of the KDE project
+   Copyright (C) 2016 The Calligra developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#include "KoZipWriter.h"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QIODevice>
+#include <QList>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSemaphore>
+#include <QString>
+#include <QThreadPool>
+
+#include <StoreDebug.h>
+
+#include <zlib.h>
+
+// The size of the chunks, which get compressed independently.
+static const int s_chunkSize = 1 << 18;
+// The size of the deflate window, i.e. the maximum distance of a match.
+static const int s_windowSize = 1 << 15;
+
+namespace
+{
+void put16(QByteArray& data, quint16 value)
+{
+    data.append(char(value));
+    data.append(char(value >> 8));
+}
+
+void put32(QByteArray& data, quint32 value)
+{
+    put16(data, quint16(value));
+    put16(data, quint16(value >> 16));
+}
+
+class Chunk : public QRunnable
+{
+public:
+    Chunk(const QByteArray& data, const QByteArray& dictionary, bool compressed, bool last)
+            : data(data)
+            , dictionary(dictionary)
+            , compressed(compressed)
+            , last(last)
+            , crc(0)
+            , ok(true) {
+        setAutoDelete(false);
+    }
+
+    void run() Q_DECL_OVERRIDE {
+        crc = crc32(0L, reinterpret_cast<const Bytef*>(data.constData()), data.size());
+        if (compressed)
+            compress();
+        else
+            output = data;
+        done.release();
+    }
+
+    // Deflates the data to a raw stream. The last chunk finishes the stream,
+    // the others end with an empty stored block on a byte boundary, so that
+    // the next chunk can be appended.
+    void compress() {
+        z_stream stream;
+        stream.zalloc = Z_NULL;
+        stream.zfree = Z_NULL;
+        stream.opaque = Z_NULL;
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            ok = false;
+            return;
+        }
+        // the previous chunk precedes this one in the stream
+        if (!dictionary.isEmpty()) {
+            deflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dictionary.constData()),
+                                 dictionary.size());
+        }
+        // with room for the flush marker
+        output.resize(deflateBound(&stream, data.size()) + 16);
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.constData()));
+        stream.avail_in = data.size();
+        const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+        forever {
+            stream.next_out = reinterpret_cast<Bytef*>(output.data()) + stream.total_out;
+            stream.avail_out = output.size() - stream.total_out;
+            const int result = ::deflate(&stream, flush);
+            if (result == Z_STREAM_END)
+                break;
+            if (result != Z_OK && result != Z_BUF_ERROR) {
+                ok = false;
+                break;
+            }
+            // the flush is complete, unless the output is full; the end of
+            // the last chunk is signaled by Z_STREAM_END
+            if (stream.avail_out > 0) {
+                ok = !last;
+                break;
+            }
+            output.resize(2 * output.size());
+        }
+        output.resize(stream.total_out);
+        deflateEnd(&stream);
+    }
+
+    const QByteArray data;
+    // the end of the previous chunk of the entry
+    const QByteArray dictionary;
+    const bool compressed;
+    const bool last;
+
+    QByteArray output;
+    quint32 crc;
+    bool ok;
+    QSemaphore done;
+};
+
+struct Entry {
+    QByteArray name;
+    // the general purpose flags
+    quint16 flags;
+    bool compressed;
+    quint16 time;
+    quint16 date;
+    // the chunks in the order of the data; the ones before written are deleted
+    QList<Chunk*> chunks;
+    int written;
+    bool closed;
+    qint64 headerPosition;
+    quint32 crc;
+    qint64 size;
+    qint64 compressedSize;
+};
+}
+
+
+class Q_DECL_HIDDEN KoZipWriter::Private
+{
+public:
+    Private()
+            : file(0)
+            , device(0)
+            , current(0)
+            , pending(0)
+            , count(0)
+            , compressed(true)
+            , ok(false) {
+    }
+
+    bool writeData(const QByteArray& data);
+    // Cuts the buffered data of the current entry into a new chunk.
+    void addChunk(bool last);
+    // Writes the chunks of the leading entries, which are done. If there are
+    // more than limit bytes pending, it waits for them.
+    void writeChunks(qint64 limit);
+    void writeHeader(Entry* entry);
+    void completeEntry(Entry* entry);
+
+    QSaveFile* file;
+    QIODevice* device;
+    bool threaded;
+    // the entries not completely written yet; the last one may still be open
+    QList<Entry*> entries;
+    Entry* current;
+    // the data of the current entry not cut into a chunk yet
+    QByteArray buffer;
+    QByteArray dictionary;
+    // the size of the data in the chunks not written yet
+    qint64 pending;
+    qint64 maximumPending;
+    QByteArray centralDirectory;
+    int count;
+    bool compressed;
+    bool ok;
+};
+
+bool KoZipWriter::Private::writeData(const QByteArray& data)
+{
+    if (ok && device->write(data) != data.size()) {
+        warnStore << "Writing the ZIP archive failed:" << device->errorString();
+        ok = false;
+    }
+    return ok;
+}
+
+void KoZipWriter::Private::addChunk(bool last)
+{
+    Chunk* const chunk = new Chunk(buffer, dictionary, current->compressed, last);
+    current->chunks.append(chunk);
+    pending += buffer.size();
+    dictionary = last ? QByteArray() : buffer.right(s_windowSize);
+    buffer.clear();
+    if (threaded)
+        QThreadPool::globalInstance()->start(chunk);
+    else
+        chunk->run();
+}
+
+void KoZipWriter::Private::writeChunks(qint64 limit)
+{
+    while (!entries.isEmpty()) {
+        Entry* const entry = entries.first();
+        if (entry->headerPosition == -1)
+            writeHeader(entry);
+        while (entry->written < entry->chunks.count()) {
+            Chunk* const chunk = entry->chunks[entry->written];
+            if (!chunk->done.tryAcquire()) {
+                if (limit != -1 && pending <= limit)
+                    return;
+                chunk->done.acquire();
+            }
+            if (!chunk->ok) {
+                warnStore << "Compressing" << entry->name << "failed";
+                ok = false;
+            }
+            writeData(chunk->output);
+            entry->crc = crc32_combine(entry->crc, chunk->crc, chunk->data.size());
+            entry->size += chunk->data.size();
+            entry->compressedSize += chunk->output.size();
+            pending -= chunk->data.size();
+            delete chunk;
+            ++entry->written;
+        }
+        if (!entry->closed)
+            return;
+        completeEntry(entry);
+        entries.removeFirst();
+        delete entry;
+    }
+}
+
+void KoZipWriter::Private::writeHeader(Entry* entry)
+{
+    entry->headerPosition = device->pos();
+    // the checksum and the sizes get filled in by completeEntry()
+    QByteArray header;
+    put32(header, 0x04034b50);
+    put16(header, entry->compressed ? 20 : 10); // version needed to extract
+    put16(header, entry->flags);
+    put16(header, entry->compressed ? 8 : 0);
+    put16(header, entry->time);
+    put16(header, entry->date);
+    put32(header, 0);
+    put32(header, 0);
+    put32(header, 0);
+    put16(header, entry->name.size());
+    put16(header, 0); // no extra field
+    header.append(entry->name);
+    writeData(header);
+}
+
+void KoZipWriter::Private::completeEntry(Entry* entry)
+{
+    if (entry->size > 0xffffffffLL || entry->compressedSize > 0xffffffffLL) {
+        warnStore << entry->name << "is too large for a ZIP archive";
+        ok = false;
+    }
+    if (!ok)
+        return;
+    QByteArray sizes;
+    put32(sizes, entry->crc);
+    put32(sizes, quint32(entry->compressedSize));
+    put32(sizes, quint32(entry->size));
+    const qint64 end = device->pos();
+    if (!device->seek(entry->headerPosition + 14) || !writeData(sizes) || !device->seek(end)) {
+        warnStore << "Writing the ZIP archive failed:" << device->errorString();
+        ok = false;
+        return;
+    }
+
+    put32(centralDirectory, 0x02014b50);
+    put16(centralDirectory, (3 << 8) | 20); // made by Unix, version 2.0
+    put16(centralDirectory, entry->compressed ? 20 : 10);
+    put16(centralDirectory, entry->flags);
+    put16(centralDirectory, entry->compressed ? 8 : 0);
+    put16(centralDirectory, entry->time);
+    put16(centralDirectory, entry->date);
+    centralDirectory.append(sizes);
+    put16(centralDirectory, entry->name.size());
+    put16(centralDirectory, 0); // extra field length
+    put16(centralDirectory, 0); // comment length
+    put16(centralDirectory, 0); // disk number
+    put16(centralDirectory, 0); // internal attributes
+    put32(centralDirectory, 0100644u << 16); // external attributes, the permissions
+    put32(centralDirectory, quint32(entry->headerPosition));
+    centralDirectory.append(entry->name);
+    ++count;
+}
+
+
+KoZipWriter::KoZipWriter(const QString& fileName)
+        : d(new Private)
+{
+    d->file = new QSaveFile(fileName);
+    d->device = d->file;
+    d->ok = d->file->open(QIODevice::WriteOnly);
+    d->threaded = QThreadPool::globalInstance()->maxThreadCount() > 1;
+    d->maximumPending = qint64(s_chunkSize) * qMax(4, 2 * QThreadPool::globalInstance()->maxThreadCount());
+}
+
+KoZipWriter::KoZipWriter(QIODevice* device)
+        : d(new Private)
+{
+    d->device = device;
+    d->ok = device->isOpen() || device->open(QIODevice::WriteOnly);
+    d->threaded = QThreadPool::globalInstance()->maxThreadCount() > 1;
+    d->maximumPending = qint64(s_chunkSize) * qMax(4, 2 * QThreadPool::globalInstance()->maxThreadCount());
+}
+
+KoZipWriter::~KoZipWriter()
+{
+    foreach (Entry* entry, d->entries) {
+        for (int i = entry->written; i < entry->chunks.count(); ++i) {
+            entry->chunks[i]->done.acquire();
+            delete entry->chunks[i];
+        }
+        delete entry;
+    }
+    // not committed by finish()
+    if (d->file)
+        d->file->cancelWriting();
+    delete d->file;
+    delete d;
+}
+
+bool KoZipWriter::isOpen() const
+{
+    return d->ok;
+}
+
+void KoZipWriter::setCompression(bool compressed)
+{
+    d->compressed = compressed;
+}
+
+bool KoZipWriter::open(const QString& name)
+{
+    if (d->current) {
+        warnStore << "The previous entry of the ZIP archive is still open";
+        return false;
+    }
+    if (!d->ok)
+        return false;
+    const QDateTime time = QDateTime::currentDateTime();
+    Entry* const entry = new Entry;
+    entry->name = name.toUtf8();
+    // mark non-ASCII names as UTF-8 encoded
+    entry->flags = (entry->name.size() == name.size()) ? 0 : 0x0800;
+    entry->compressed = d->compressed;
+    entry->time = (time.time().hour() << 11) | (time.time().minute() << 5) | (time.time().second() >> 1);
+    entry->date = ((time.date().year() - 1980) << 9) | (time.date().month() << 5) | time.date().day();
+    entry->written = 0;
+    entry->closed = false;
+    entry->headerPosition = -1;
+    entry->crc = 0;
+    entry->size = 0;
+    entry->compressedSize = 0;
+    d->entries.append(entry);
+    d->current = entry;
+    d->dictionary.clear();
+    return true;
+}
+
+bool KoZipWriter::write(const char* data, qint64 length)
+{
+    if (!d->current || !d->ok)
+        return false;
+    while (length > 0) {
+        const int size = int(qMin(length, qint64(s_chunkSize - d->buffer.size())));
+        d->buffer.append(data, size);
+        data += size;
+        length -= size;
+        if (d->buffer.size() == s_chunkSize) {
+            d->addChunk(false);
+            d->writeChunks(d->maximumPending);
+        }
+    }
+    return d->ok;
+}
+
+bool KoZipWriter::write(const QByteArray& data)
+{
+    return write(data.constData(), data.size());
+}
+
+bool KoZipWriter::close()
+{
+    if (!d->current)
+        return false;
+    d->addChunk(true);
+    d->current->closed = true;
+    d->current = 0;
+    d->writeChunks(d->maximumPending);
+    return d->ok;
+}
+
+bool KoZipWriter::finish()
+{
+    if (d->current)
+        close();
+    d->writeChunks(-1);
+
+    QByteArray end;
+    put32(end, 0x06054b50);
+    put16(end, 0); // number of this disk
+    put16(end, 0); // disk with the central directory
+    put16(end, d->count);
+    put16(end, d->count);
+    put32(end, d->centralDirectory.size());
+    put32(end, quint32(d->device->pos()));
+    put16(end, 0); // comment length
+    d->writeData(d->centralDirectory);
+    d->writeData(end);
+    d->centralDirectory.clear();
+
+    if (d->file) {
+        if (d->ok && !d->file->commit()) {
+            warnStore << "Saving the ZIP archive failed:" << d->file->errorString();
+            d->ok = false;
+        }
+        delete d->file;
+        d->file = 0;
+    } else {
+        // like KArchive::close()
+        d->device->close();
+    }
+    return d->ok;
+}
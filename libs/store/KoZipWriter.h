@@ -0,0 +1,90 @@
+/* This file is part of the KDE project
+   Copyright (C) 2016 The Calligra developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KOZIPWRITER_H
+#define KOZIPWRITER_H
+
+#include <QtGlobal>
+
+class QByteArray;
+class QIODevice;
+class QString;
+
+/**
+ * Writes a ZIP archive, deflating the entries on the global thread pool.
+ *
+ * The data of an entry is cut into chunks, which get compressed
+ * independently of each other, while the next ones are still being
+ * written. Each chunk is primed with the end of the previous one and
+ * ends on a byte boundary, so that the compressed chunks form a single
+ * deflate stream. The entries are written to the device in the order they
+ * were opened; their local headers get completed, once all chunks are
+ * written, like KZip does it.
+ *
+ * Neither extra fields nor data descriptors are written, so the archive
+ * meets the requirements of ODF for the "mimetype" entry.
+ */
+class KoZipWriter
+{
+public:
+    /**
+     * Writes the archive to the file \p fileName , which gets replaced
+     * by finish() only.
+     */
+    explicit KoZipWriter(const QString& fileName);
+    /**
+     * Writes the archive to \p device , which gets opened, if it is not
+     * open yet.
+     */
+    explicit KoZipWriter(QIODevice* device);
+    ~KoZipWriter();
+
+    /**
+     * \return \c false , if the device could not be opened
+     */
+    bool isOpen() const;
+
+    /**
+     * Sets whether the following entries get deflated or stored.
+     */
+    void setCompression(bool compressed);
+
+    /**
+     * Starts the entry \p name . The previous entry has to be closed.
+     */
+    bool open(const QString& name);
+    bool write(const char* data, qint64 length);
+    bool write(const QByteArray& data);
+    bool close();
+
+    /**
+     * Writes the remaining entries and the central directory.
+     * The device gets closed.
+     * \return \c false , if writing to the device failed
+     */
+    bool finish();
+
+private:
+    Q_DISABLE_COPY(KoZipWriter)
+
+    class Private;
+    Private * const d;
+};
+
+#endif
@@ -20,6 +20,8 @@
 
 #include "KoCsvImportDialog.h"
 
+#include "KoCsvParser.h"
+
 // Qt
 #include <QTextCodec>
 #include <QTextStream>
@@ -65,6 +67,7 @@ public:
     QStringList formatList; ///< List of the column formats
 
     explicit Private(KoCsvImportDialog* qq) : q(qq) {}
+    class TableParser;
     void loadSettings();
     void saveSettings();
     void fillTable();
@@ -154,6 +157,69 @@ KoCsvImportDialog::~KoCsvImportDialog()
 }
 
 
+QChar KoCsvImportDialog::textQuote() const
+{
+    return d->textQuote;
+}
+
+bool KoCsvImportDialog::ignoreDuplicates() const
+{
+    return d->ignoreDuplicates;
+}
+
+QTextCodec* KoCsvImportDialog::codec() const
+{
+    return d->codec;
+}
+
+int KoCsvImportDialog::startRow() const
+{
+    return d->startRow;
+}
+
+int KoCsvImportDialog::startCol() const
+{
+    return d->startCol;
+}
+
+int KoCsvImportDialog::endRow() const
+{
+    // ending at the last row of the data means importing all rows
+    if (d->endRow < 0 || d->endRow >= d->dialog->m_rowEnd->maximum())
+        return -1;
+    return d->endRow;
+}
+
+int KoCsvImportDialog::endCol() const
+{
+    if (d->endCol < 0 || d->endCol >= d->dialog->m_colEnd->maximum())
+        return -1;
+    return d->endCol;
+}
+
+void KoCsvImportDialog::setTextQuote(QChar textQuote)
+{
+    d->textQuote = textQuote;
+    d->dialog->m_comboQuote->setCurrentIndex(textQuote == '\'' ? 1 : textQuote == '"' ? 0 : 2);
+    d->fillTable();
+}
+
+void KoCsvImportDialog::setIgnoreDuplicates(bool ignore)
+{
+    // triggers ignoreDuplicatesChanged(), if it changes
+    d->dialog->m_ignoreDuplicates->setChecked(ignore);
+}
+
+void KoCsvImportDialog::setRange(int startRow, int startCol, int endRow, int endCol)
+{
+    d->dialog->m_rowStart->setValue(startRow);
+    d->dialog->m_colStart->setValue(startCol);
+    d->dialog->m_rowEnd->setValue(endRow == -1 ? d->dialog->m_rowEnd->maximum() : endRow);
+    d->dialog->m_colEnd->setValue(endCol == -1 ? d->dialog->m_colEnd->maximum() : endCol);
+    updateClicked();
+}
+
+
 // ----------------------------------------------------------------
 //                       public methods
 
@@ -306,245 +372,41 @@ void KoCsvImportDialog::Private::saveSettings()
     configGroup.sync();
 }
 
+// Fills the table of the dialog.
+class KoCsvImportDialog::Private::TableParser : public KoCsvParser
+{
+public:
+    explicit TableParser(KoCsvImportDialog::Private* d)
+        : KoCsvParser(d->delimiter, d->textQuote, d->ignoreDuplicates)
+        , m_d(d) {}
+
+protected:
+    void addField(int row, int column, const QString& text) Q_DECL_OVERRIDE {
+        m_d->setText(row - m_d->startRow, column - m_d->startCol, text);
+    }
+
+private:
+    KoCsvImportDialog::Private* const m_d;
+};
+
 void KoCsvImportDialog::Private::fillTable()
 {
     int row, column;
-    bool lastCharDelimiter = false;
-    enum { Start, InQuotedField, MaybeQuotedFieldEnd, QuotedFieldEnd,
-           MaybeInNormalField, InNormalField } state = Start;
-
-    QChar x;
-    QString field;
 
     QApplication::setOverrideCursor(Qt::WaitCursor);
 
     dialog->m_sheet->setRowCount(0);
     dialog->m_sheet->setColumnCount(0);
 
-    int maxColumn = 1;
-    row = column = 1;
     QTextStream inputStream(data, QIODevice::ReadOnly);
     debugWidgets <<"Encoding:" << codec->name();
     inputStream.setCodec( codec );
 
-    int delimiterIndex = 0;
-    const int delimiterLength = delimiter.size();
-    bool lastCharWasCr = false; // Last character was a Carriage Return
-    while (!inputStream.atEnd())
-    {
-        inputStream >> x; // read one char
-
-        // ### TODO: we should perhaps skip all other control characters
-        if ( x == '\r' )
-        {
-            // We have a Carriage Return, assume that its role is the one of a LineFeed
-            lastCharWasCr = true;
-            x = '\n'; // Replace by Line Feed
-        }
-        else if ( x == '\n' && lastCharWasCr )
-        {
-            // The end of line was already handled by the Carriage Return, so do nothing for this character
-            lastCharWasCr = false;
-            continue;
-        }
-        else if ( x == QChar( 0xc ) )
-        {
-            // We have a FormFeed, skip it
-            lastCharWasCr = false;
-            continue;
-        }
-        else
-        {
-            lastCharWasCr = false;
-        }
-
-        if ( column > maxColumn )
-          maxColumn = column;
-        switch (state)
-        {
-         case Start :
-            if (x == textQuote)
-            {
-                state = InQuotedField;
-            }
-            else if (delimiterIndex < delimiterLength && x == delimiter.at(delimiterIndex))
-            {
-                field += x;
-                delimiterIndex++;
-                if (field.right(delimiterIndex) == delimiter)
-                {
-                    if ((ignoreDuplicates == false) || (lastCharDelimiter == false))
-                        column += delimiterLength;
-                    lastCharDelimiter = true;
-                    field.clear();
-                    delimiterIndex = 0;
-                    state = Start;
-                }
-                else if (delimiterIndex >= delimiterLength)
-                    delimiterIndex = 0;
-            }
-            else if (x == '\n')
-            {
-                ++row;
-                column = 1;
-                if ( row > ( endRow - startRow ) && endRow >= 0 )
-                  break;
-            }
-            else
-            {
-                field += x;
-                state = MaybeInNormalField;
-            }
-            break;
-         case InQuotedField :
-            if (x == textQuote)
-            {
-                state = MaybeQuotedFieldEnd;
-            }
-            else if (x == '\n')
-            {
-                setText(row - startRow, column - startCol, field);
-                field.clear();
-
-                ++row;
-                column = 1;
-                if ( row > ( endRow - startRow ) && endRow >= 0 )
-                  break;
-
-                state = Start;
-            }
-            else
-            {
-                field += x;
-            }
-            break;
-         case MaybeQuotedFieldEnd :
-            if (x == textQuote)
-            {
-                field += x;
-                state = InQuotedField;
-            }
-            else if (x == '\n')
-            {
-                setText(row - startRow, column - startCol, field);
-                field.clear();
-                ++row;
-                column = 1;
-                if ( row > ( endRow - startRow ) && endRow >= 0 )
-                    break;
-                state = Start;
-            }
-            else if (delimiterIndex < delimiterLength && x == delimiter.at(delimiterIndex))
-            {
-                field += x;
-                delimiterIndex++;
-                if (field.right(delimiterIndex) == delimiter)
-                {
-                    setText(row - startRow, column - startCol, field.left(field.count()-delimiterIndex));
-                    field.clear();
-                    if ((ignoreDuplicates == false) || (lastCharDelimiter == false))
-                        column += delimiterLength;
-                    lastCharDelimiter = true;
-                    field.clear();
-                    delimiterIndex = 0;
-                }
-                else if (delimiterIndex >= delimiterLength)
-                    delimiterIndex = 0;
-                state = Start;
-            }
-            else
-            {
-                state = QuotedFieldEnd;
-            }
-            break;
-         case QuotedFieldEnd :
-            if (x == '\n')
-            {
-                setText(row - startRow, column - startCol, field);
-                field.clear();
-                ++row;
-                column = 1;
-                if ( row > ( endRow - startRow ) && endRow >= 0 )
-                    break;
-                state = Start;
-            }
-            else if (delimiterIndex < delimiterLength && x == delimiter.at(delimiterIndex))
-            {
-                field += x;
-                delimiterIndex++;
-                if (field.right(delimiterIndex) == delimiter)
-                {
-                    setText(row - startRow, column - startCol, field.left(field.count()-delimiterIndex));
-                    field.clear();
-                    if ((ignoreDuplicates == false) || (lastCharDelimiter == false))
-                        column += delimiterLength;
-                    lastCharDelimiter = true;
-                    field.clear();
-                    delimiterIndex = 0;
-                }
-                else if (delimiterIndex >= delimiterLength)
-                    delimiterIndex = 0;
-                state = Start;
-            }
-            else
-            {
-                state = QuotedFieldEnd;
-            }
-            break;
-         case MaybeInNormalField :
-            if (x == textQuote)
-            {
-                field.clear();
-                state = InQuotedField;
-                break;
-            }
-            state = InNormalField;
-         case InNormalField :
-            if (x == '\n')
-            {
-                setText(row - startRow, column - startCol, field);
-                field.clear();
-                ++row;
-                column = 1;
-                if ( row > ( endRow - startRow ) && endRow >= 0 )
-                    break;
-                state = Start;
-            }
-            else if (delimiterIndex < delimiterLength && x == delimiter.at(delimiterIndex))
-            {
-                field += x;
-                delimiterIndex++;
-                if (field.right(delimiterIndex) == delimiter)
-                {
-                    setText(row - startRow, column - startCol, field.left(field.count()-delimiterIndex));
-                    field.clear();
-                    if ((ignoreDuplicates == false) || (lastCharDelimiter == false))
-                        column += delimiterLength;
-                    lastCharDelimiter = true;
-                    field.clear();
-                    delimiterIndex = 0;
-                }
-                else if (delimiterIndex >= delimiterLength)
-                    delimiterIndex = 0;
-                state = Start;
-            }
-            else
-            {
-                field += x;
-            }
-        }
-        if (delimiter.isEmpty() || x != delimiter.at(0))
-          lastCharDelimiter = false;
-    }
-
-    if ( !field.isEmpty() )
-    {
-      // the last line of the file had not any line end
-      setText(row - startRow, column - startCol, field);
-      ++row;
-      field.clear();
-    }
-    if (row) row--;  // row is higher by 1, so reduce it
+    TableParser parser(this);
+    parser.parse(inputStream.readAll());
+    parser.finish();
+    const int maxColumn = parser.maxColumn();
+    row = parser.rows();
 
     columnsAdjusted = true;
     adjustRows( row - startRow );
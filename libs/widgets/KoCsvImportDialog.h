@@ -25,6 +25,8 @@
 
 #include "kowidgets_export.h"
 
+class QTextCodec;
+
 /**
  * A dialog to choose the options for importing CSV data.
  */
@@ -123,6 +125,61 @@ public:
     QString delimiter() const;
     void setDelimiter(const QString& delimit);
 
+    /**
+     * \return the character quoting text fields; a null character, if
+     * fields are not quoted
+     */
+    QChar textQuote() const;
+
+    /**
+     * Sets the character quoting text fields; a null character, if
+     * fields are not quoted.
+     */
+    void setTextQuote(QChar textQuote);
+
+    /**
+     * \return whether consecutive delimiters are treated as one
+     */
+    bool ignoreDuplicates() const;
+
+    /**
+     * Sets whether consecutive delimiters are treated as one.
+     */
+    void setIgnoreDuplicates(bool ignore);
+
+    /**
+     * \return the codec of the data
+     */
+    QTextCodec* codec() const;
+
+    /**
+     * \return the number of leading rows to skip
+     */
+    int startRow() const;
+
+    /**
+     * \return the number of leading columns to skip
+     */
+    int startCol() const;
+
+    /**
+     * \return the last row to import counted from 1, or -1, if the rows
+     * are imported up to the end of the data
+     */
+    int endRow() const;
+
+    /**
+     * \return the last column to import counted from 1, or -1, if the
+     * columns are imported up to the last one
+     */
+    int endCol() const;
+
+    /**
+     * Sets the rows and columns to import like the range chosen in the
+     * dialog, counted from 1. An end of -1 selects the last row or column.
+     */
+    void setRange(int startRow, int startCol, int endRow, int endCol);
+
 protected Q_SLOTS:
     void returnPressed();
     void formatChanged(const QString&);
@@ -0,0 +1,291 @@
+/* This file is part of the KDE project
+   Copyright (C) 1999 David Faure <faure@kde.org>
+   Copyright (C) 2004 Nicolas GOUTTE <goutte@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "KoCsvParser.h"
+
+class Q_DECL_HIDDEN KoCsvParser::Private
+{
+public:
+    enum State { Start, InQuotedField, MaybeQuotedFieldEnd, QuotedFieldEnd,
+                 MaybeInNormalField, InNormalField };
+
+    QString delimiter;
+    QChar textQuote;
+    bool ignoreDuplicates;
+
+    State state;
+    QString field;
+    int row;
+    int column;
+    int maxColumn;
+    int delimiterIndex;
+    bool lastCharDelimiter;
+    bool lastCharWasCr; // Last character was a Carriage Return
+};
+
+KoCsvParser::KoCsvParser(const QString& delimiter, QChar textQuote, bool ignoreDuplicates)
+    : d(new Private)
+{
+    d->delimiter = delimiter;
+    d->textQuote = textQuote;
+    d->ignoreDuplicates = ignoreDuplicates;
+    d->state = Private::Start;
+    d->row = 1;
+    d->column = 1;
+    d->maxColumn = 1;
+    d->delimiterIndex = 0;
+    d->lastCharDelimiter = false;
+    d->lastCharWasCr = false;
+}
+
+KoCsvParser::~KoCsvParser()
+{
+    delete d;
+}
+
+void KoCsvParser::parse(const QString& text)
+{
+    const QString& delimiter = d->delimiter;
+    const QChar textQuote = d->textQuote;
+    const int delimiterLength = delimiter.size();
+    QString& field = d->field;
+    int& row = d->row;
+    int& column = d->column;
+    int& delimiterIndex = d->delimiterIndex;
+    bool& lastCharDelimiter = d->lastCharDelimiter;
+    Private::State& state = d->state;
+
+    const int length = text.length();
+    for (int i = 0; i < length; ++i)
+    {
+        QChar x = text[i];
+
+        // ### TODO: we should perhaps skip all other control characters
+        if ( x == '\r' )
+        {
+            // We have a Carriage Return, assume that its role is the one of a LineFeed
+            d->lastCharWasCr = true;
+            x = '\n'; // Replace by Line Feed
+        }
+        else if ( x == '\n' && d->lastCharWasCr )
+        {
+            // The end of line was already handled by the Carriage Return, so do nothing for this character
+            d->lastCharWasCr = false;
+            continue;
+        }
+        else if ( x == QChar( 0xc ) )
+        {
+            // We have a FormFeed, skip it
+            d->lastCharWasCr = false;
+            continue;
+        }
+        else
+        {
+            d->lastCharWasCr = false;
+        }
+
+        if ( column > d->maxColumn )
+          d->maxColumn = column;
+        switch (state)
+        {
+         case Private::Start :
+            if (x == textQuote)
+            {
+                state = Private::InQuotedField;
+            }
+            else if (delimiterIndex < delimiterLength && x == delimiter.at(delimiterIndex))
+            {
+                field += x;
+                delimiterIndex++;
+                if (field.right(delimiterIndex) == delimiter)
+                {
+                    if ((d->ignoreDuplicates == false) || (lastCharDelimiter == false))
+                        column += delimiterLength;
+                    lastCharDelimiter = true;
+                    field.clear();
+                    delimiterIndex = 0;
+                    state = Private::Start;
+                }
+                else if (delimiterIndex >= delimiterLength)
+                    delimiterIndex = 0;
+            }
+            else if (x == '\n')
+            {
+                ++row;
+                column = 1;
+            }
+            else
+            {
+                field += x;
+                state = Private::MaybeInNormalField;
+            }
+            break;
+         case Private::InQuotedField :
+            if (x == textQuote)
+            {
+                state = Private::MaybeQuotedFieldEnd;
+            }
+            else if (x == '\n')
+            {
+                addField(row, column, field);
+                field.clear();
+                ++row;
+                column = 1;
+                state = Private::Start;
+            }
+            else
+            {
+                field += x;
+            }
+            break;
+         case Private::MaybeQuotedFieldEnd :
+            if (x == textQuote)
+            {
+                field += x;
+                state = Private::InQuotedField;
+            }
+            else if (x == '\n')
+            {
+                addField(row, column, field);
+                field.clear();
+                ++row;
+                column = 1;
+                state = Private::Start;
+            }
+            else if (delimiterIndex < delimiterLength && x == delimiter.at(delimiterIndex))
+            {
+                field += x;
+                delimiterIndex++;
+                if (field.right(delimiterIndex) == delimiter)
+                {
+                    addField(row, column, field.left(field.count()-delimiterIndex));
+                    field.clear();
+                    if ((d->ignoreDuplicates == false) || (lastCharDelimiter == false))
+                        column += delimiterLength;
+                    lastCharDelimiter = true;
+                    field.clear();
+                    delimiterIndex = 0;
+                }
+                else if (delimiterIndex >= delimiterLength)
+                    delimiterIndex = 0;
+                state = Private::Start;
+            }
+            else
+            {
+                state = Private::QuotedFieldEnd;
+            }
+            break;
+         case Private::QuotedFieldEnd :
+            if (x == '\n')
+            {
+                addField(row, column, field);
+                field.clear();
+                ++row;
+                column = 1;
+                state = Private::Start;
+            }
+            else if (delimiterIndex < delimiterLength && x == delimiter.at(delimiterIndex))
+            {
+                field += x;
+                delimiterIndex++;
+                if (field.right(delimiterIndex) == delimiter)
+                {
+                    addField(row, column, field.left(field.count()-delimiterIndex));
+                    field.clear();
+                    if ((d->ignoreDuplicates == false) || (lastCharDelimiter == false))
+                        column += delimiterLength;
+                    lastCharDelimiter = true;
+                    field.clear();
+                    delimiterIndex = 0;
+                }
+                else if (delimiterIndex >= delimiterLength)
+                    delimiterIndex = 0;
+                state = Private::Start;
+            }
+            else
+            {
+                state = Private::QuotedFieldEnd;
+            }
+            break;
+         case Private::MaybeInNormalField :
+            if (x == textQuote)
+            {
+                field.clear();
+                state = Private::InQuotedField;
+                break;
+            }
+            state = Private::InNormalField;
+         case Private::InNormalField :
+            if (x == '\n')
+            {
+                addField(row, column, field);
+                field.clear();
+                ++row;
+                column = 1;
+                state = Private::Start;
+            }
+            else if (delimiterIndex < delimiterLength && x == delimiter.at(delimiterIndex))
+            {
+                field += x;
+                delimiterIndex++;
+                if (field.right(delimiterIndex) == delimiter)
+                {
+                    addField(row, column, field.left(field.count()-delimiterIndex));
+                    field.clear();
+                    if ((d->ignoreDuplicates == false) || (lastCharDelimiter == false))
+                        column += delimiterLength;
+                    lastCharDelimiter = true;
+                    field.clear();
+                    delimiterIndex = 0;
+                }
+                else if (delimiterIndex >= delimiterLength)
+                    delimiterIndex = 0;
+                state = Private::Start;
+            }
+            else
+            {
+                field += x;
+            }
+        }
+        if (delimiter.isEmpty() || x != delimiter.at(0))
+          lastCharDelimiter = false;
+    }
+}
+
+void KoCsvParser::finish()
+{
+    if ( !d->field.isEmpty() )
+    {
+      // the last line of the file had not any line end
+      addField(d->row, d->column, d->field);
+      ++d->row;
+      d->field.clear();
+    }
+}
+
+int KoCsvParser::rows() const
+{
+    return d->row - 1;
+}
+
+int KoCsvParser::maxColumn() const
+{
+    return d->maxColumn;
+}
@@ -0,0 +1,74 @@
+/* This file is part of the KDE project
+   Copyright (C) 1999 David Faure <faure@kde.org>
+   Copyright (C) 2004 Nicolas GOUTTE <goutte@kde.org>
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef KO_CSV_PARSER
+#define KO_CSV_PARSER
+
+#include <QString>
+
+#include "kowidgets_export.h"
+
+/**
+ * Splits CSV data into fields the way KoCsvImportDialog does.
+ *
+ * Each line is a row; quoted fields do not span lines. The data may be
+ * passed in pieces, the parser keeps its state between them.
+ */
+class KOWIDGETS_EXPORT KoCsvParser
+{
+public:
+    KoCsvParser(const QString& delimiter, QChar textQuote, bool ignoreDuplicates);
+    virtual ~KoCsvParser();
+
+    /**
+     * Parses the next piece of the data.
+     */
+    void parse(const QString& text);
+
+    /**
+     * Passes on the field of a last line without a line end.
+     */
+    void finish();
+
+    /**
+     * \return the number of rows parsed so far
+     */
+    int rows() const;
+
+    /**
+     * \return the highest column reached so far
+     */
+    int maxColumn() const;
+
+protected:
+    /**
+     * Called for each field with its \p row and \p column counted from 1.
+     * Fields may also be empty.
+     */
+    virtual void addField(int row, int column, const QString& text) = 0;
+
+private:
+    Q_DISABLE_COPY(KoCsvParser)
+
+    class Private;
+    Private * const d;
+};
+
+#endif // KO_CSV_PARSER
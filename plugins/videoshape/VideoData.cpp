@@ -28,6 +28,7 @@
 
 #include <KoStore.h>
 #include <KoStoreDevice.h>
+#include <KoStoreMappedData.h>
 
 #include <QApplication>
 #include <QBuffer>
@@ -48,8 +49,16 @@ public:
     /// store the suffix based on the full filename.
     void setSuffix(const QString &fileName);
 
+    /// write the mappedData to the temporaryFile
+    bool spool();
+
     QAtomicInt refCount;
     QTemporaryFile *temporaryFile;
+    /**
+     * the video data stored uncompressed in the store; it is spooled
+     * to the temporaryFile only, when the video gets played
+     */
+    KoStoreMappedData mappedData;
     /**
      * a unique key of the video data
      */
@@ -96,6 +105,22 @@ void VideoDataPrivate::setSuffix(const QString &name)
     }
 }
 
+bool VideoDataPrivate::spool()
+{
+    if (temporaryFile)
+        return true;
+    temporaryFile = new QTemporaryFile(QLatin1String("KoVideoData/") + qAppName() + QLatin1String("_XXXXXX") );
+    if (!temporaryFile->open()
+            || temporaryFile->write(mappedData.data(), mappedData.size()) != mappedData.size()) {
+        warnVideo << "write temporary file failed";
+        delete temporaryFile;
+        temporaryFile = 0;
+        return false;
+    }
+    temporaryFile->close();
+    return true;
+}
+
 VideoData::VideoData()
     : KoShapeUserData()
     , d(0)
@@ -168,6 +193,19 @@ void VideoData::setVideo(const QString &url, KoStore *store, VideoCollection *co
             };
             Finalizer closer;
             closer.store = store;
+            const KoStoreMappedData mapped = store->mappedData();
+            if (!mapped.isNull()) {
+                delete d;
+                d = new VideoDataPrivate();
+                d->refCount.ref();
+                d->mappedData = mapped;
+                QCryptographicHash md5(QCryptographicHash::Md5);
+                md5.addData(mapped.rawData());
+                d->key = VideoData::generateKey(md5.result());
+                d->dataStoreState = StateSpooled;
+                d->setSuffix(url);
+                return;
+            }
             KoStoreDevice device(store);
             //QByteArray data = device.readAll();
             if (!device.open(QIODevice::ReadOnly)) {
@@ -192,6 +230,8 @@ QUrl VideoData::playableUrl() const
 {
     if (d->dataStoreState == StateSpooled) {
         Q_ASSERT(d);
+        if (!d->spool())
+            return QUrl();
         return QUrl(d->temporaryFile->fileName());
     } else {
         return d->videoLocation;
@@ -248,6 +288,9 @@ VideoData &VideoData::operator=(const VideoData &other)
 bool VideoData::saveData(QIODevice &device)
 {
     if (d->dataStoreState == StateSpooled) {
+        if (!d->mappedData.isNull()) {
+            return device.write(d->mappedData.data(), d->mappedData.size()) == d->mappedData.size();
+        }
         Q_ASSERT(d->temporaryFile); // otherwise the collection should not have called this
         if (d->temporaryFile) {
             if (!d->temporaryFile->open()) {
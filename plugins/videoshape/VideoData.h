@@ -95,7 +95,7 @@ public:
 
     enum DataStoreState {
         StateEmpty,     ///< No video data, possible an external video
-        StateSpooled, ///< Video data is spooled
+        StateSpooled, ///< Video data is spooled or used in place from the store
     };
 protected:
     friend class VideoCollection;
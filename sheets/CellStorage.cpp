@@ -35,9 +35,11 @@
 // Sheets
 #include "BindingStorage.h"
 #include "ConditionsStorage.h"
+#include "CriteriaCache.h"
 #include "Damages.h"
 #include "DependencyManager.h"
 #include "FormulaStorage.h"
+#include "LookupCache.h"
 #include "Map.h"
 #include "ModelSupport.h"
 #include "RecalcManager.h"
@@ -83,6 +85,8 @@ public:
             , valueStorage(new ValueStorage())
             , richTextStorage(new RichTextStorage())
             , rowRepeatStorage(new RowRepeatStorage())
+            , lookupCache(new LookupCache())
+            , criteriaCache(new CriteriaCache())
             , undoData(0)
 #ifdef CALLIGRA_SHEETS_MT
             , bigUglyLock(QReadWriteLock::Recursive)
@@ -106,6 +110,8 @@ public:
             , valueStorage(new ValueStorage(*other.valueStorage))
             , richTextStorage(new RichTextStorage(*other.richTextStorage))
             , rowRepeatStorage(new RowRepeatStorage(*other.rowRepeatStorage))
+            , lookupCache(new LookupCache())
+            , criteriaCache(new CriteriaCache())
             , undoData(0)
 #ifdef CALLIGRA_SHEETS_MT
             , bigUglyLock(QReadWriteLock::Recursive)
@@ -128,6 +134,8 @@ public:
         delete valueStorage;
         delete richTextStorage;
         delete rowRepeatStorage;
+        delete lookupCache;
+        delete criteriaCache;
     }
 
     void createCommand(KUndo2Command *parent) const;
@@ -148,6 +156,8 @@ public:
     ValueStorage*           valueStorage;
     RichTextStorage*        richTextStorage;
     RowRepeatStorage*       rowRepeatStorage;
+    LookupCache*            lookupCache;
+    CriteriaCache*          criteriaCache;
     CellStorageUndoData*    undoData;
 
 #ifdef CALLIGRA_SHEETS_MT
@@ -275,6 +285,10 @@ void CellStorage::take(int col, int row)
     oldUserInput = d->userInputStorage->take(col, row);
     oldValue = d->valueStorage->take(col, row);
     oldRichText = d->richTextStorage->take(col, row);
+    if (!oldValue.isEmpty()) {
+        d->lookupCache->regionChanged(QRect(col, row, 1, 1));
+        d->criteriaCache->regionChanged(QRect(col, row, 1, 1));
+    }
 
     if (!d->sheet->map()->isLoading()) {
         // Trigger a recalculation of the consuming cells.
@@ -690,6 +704,8 @@ void CellStorage::setValue(int column, int row, const Value& value)
 
     // value changed?
     if (value != old) {
+        d->lookupCache->regionChanged(QRect(column, row, 1, 1));
+        d->criteriaCache->regionChanged(QRect(column, row, 1, 1));
         if (!d->sheet->map()->isLoading()) {
             // Always trigger a repainting and a binding update.
             CellDamage::Changes changes = CellDamage::Appearance | CellDamage::Binding;
@@ -965,6 +981,8 @@ void CellStorage::insertColumns(int position, int number)
     QVector< QPair<QPoint, QSharedPointer<QTextDocument> > > richTexts = d->richTextStorage->insertColumns(position, number);
     QList< QPair<QRectF, Validity> > validities = d->validityStorage->insertColumns(position, number);
     QVector< QPair<QPoint, Value> > values = d->valueStorage->insertColumns(position, number);
+    d->lookupCache->regionChanged(invalidRegion.firstRange());
+    d->criteriaCache->regionChanged(invalidRegion.firstRange());
     // recording undo?
     if (d->undoData) {
         d->undoData->bindings   << bindings;
@@ -1024,6 +1042,8 @@ void CellStorage::removeColumns(int position, int number)
     QVector< QPair<QPoint, QString> > userInputs = d->userInputStorage->removeColumns(position, number);
     QList< QPair<QRectF, Validity> > validities = d->validityStorage->removeColumns(position, number);
     QVector< QPair<QPoint, Value> > values = d->valueStorage->removeColumns(position, number);
+    d->lookupCache->regionChanged(invalidRegion.firstRange());
+    d->criteriaCache->regionChanged(invalidRegion.firstRange());
     QVector< QPair<QPoint, QSharedPointer<QTextDocument> > > richTexts = d->richTextStorage->removeColumns(position, number);
     // recording undo?
     if (d->undoData) {
@@ -1083,6 +1103,8 @@ void CellStorage::insertRows(int position, int number)
     QVector< QPair<QPoint, QString> > userInputs = d->userInputStorage->insertRows(position, number);
     QList< QPair<QRectF, Validity> > validities = d->validityStorage->insertRows(position, number);
     QVector< QPair<QPoint, Value> > values = d->valueStorage->insertRows(position, number);
+    d->lookupCache->regionChanged(invalidRegion.firstRange());
+    d->criteriaCache->regionChanged(invalidRegion.firstRange());
     QVector< QPair<QPoint, QSharedPointer<QTextDocument> > > richTexts = d->richTextStorage->insertRows(position, number);
     // recording undo?
     if (d->undoData) {
@@ -1145,6 +1167,8 @@ void CellStorage::removeRows(int position, int number)
     QVector< QPair<QPoint, QString> > userInputs = d->userInputStorage->removeRows(position, number);
     QList< QPair<QRectF, Validity> > validities = d->validityStorage->removeRows(position, number);
     QVector< QPair<QPoint, Value> > values = d->valueStorage->removeRows(position, number);
+    d->lookupCache->regionChanged(invalidRegion.firstRange());
+    d->criteriaCache->regionChanged(invalidRegion.firstRange());
     QVector< QPair<QPoint, QSharedPointer<QTextDocument> > > richTexts = d->richTextStorage->removeRows(position, number);
     // recording undo?
     if (d->undoData) {
@@ -1207,6 +1231,8 @@ void CellStorage::removeShiftLeft(const QRect& rect)
     QVector< QPair<QPoint, QString> > userInputs = d->userInputStorage->removeShiftLeft(rect);
     QList< QPair<QRectF, Validity> > validities = d->validityStorage->removeShiftLeft(rect);
     QVector< QPair<QPoint, Value> > values = d->valueStorage->removeShiftLeft(rect);
+    d->lookupCache->regionChanged(invalidRegion.firstRange());
+    d->criteriaCache->regionChanged(invalidRegion.firstRange());
     QVector< QPair<QPoint, QSharedPointer<QTextDocument> > > richTexts = d->richTextStorage->removeShiftLeft(rect);
     // recording undo?
     if (d->undoData) {
@@ -1268,6 +1294,8 @@ void CellStorage::insertShiftRight(const QRect& rect)
     QVector< QPair<QPoint, QString> > userInputs = d->userInputStorage->insertShiftRight(rect);
     QList< QPair<QRectF, Validity> > validities = d->validityStorage->insertShiftRight(rect);
     QVector< QPair<QPoint, Value> > values = d->valueStorage->insertShiftRight(rect);
+    d->lookupCache->regionChanged(invalidRegion.firstRange());
+    d->criteriaCache->regionChanged(invalidRegion.firstRange());
     QVector< QPair<QPoint, QSharedPointer<QTextDocument> > > richTexts = d->richTextStorage->insertShiftRight(rect);
     // recording undo?
     if (d->undoData) {
@@ -1330,6 +1358,8 @@ void CellStorage::removeShiftUp(const QRect& rect)
     QVector< QPair<QPoint, QString> > userInputs = d->userInputStorage->removeShiftUp(rect);
     QList< QPair<QRectF, Validity> > validities = d->validityStorage->removeShiftUp(rect);
     QVector< QPair<QPoint, Value> > values = d->valueStorage->removeShiftUp(rect);
+    d->lookupCache->regionChanged(invalidRegion.firstRange());
+    d->criteriaCache->regionChanged(invalidRegion.firstRange());
     QVector< QPair<QPoint, QSharedPointer<QTextDocument> > > richTexts = d->richTextStorage->removeShiftUp(rect);
     // recording undo?
     if (d->undoData) {
@@ -1391,6 +1421,8 @@ void CellStorage::insertShiftDown(const QRect& rect)
     QVector< QPair<QPoint, QString> > userInputs = d->userInputStorage->insertShiftDown(rect);
     QList< QPair<QRectF, Validity> > validities = d->validityStorage->insertShiftDown(rect);
     QVector< QPair<QPoint, Value> > values = d->valueStorage->insertShiftDown(rect);
+    d->lookupCache->regionChanged(invalidRegion.firstRange());
+    d->criteriaCache->regionChanged(invalidRegion.firstRange());
     QVector< QPair<QPoint, QSharedPointer<QTextDocument> > > richTexts = d->richTextStorage->insertShiftDown(rect);
     // recording undo?
     if (d->undoData) {
@@ -1656,6 +1688,11 @@ const LinkStorage* CellStorage::linkStorage() const
     return d->linkStorage;
 }
 
+const RichTextStorage* CellStorage::richTextStorage() const
+{
+    return d->richTextStorage;
+}
+
 const StyleStorage* CellStorage::styleStorage() const
 {
     return d->styleStorage;
@@ -1676,6 +1713,16 @@ const ValueStorage* CellStorage::valueStorage() const
     return d->valueStorage;
 }
 
+LookupCache* CellStorage::lookupCache() const
+{
+    return d->lookupCache;
+}
+
+CriteriaCache* CellStorage::criteriaCache() const
+{
+    return d->criteriaCache;
+}
+
 void CellStorage::startUndoRecording()
 {
 #ifdef CALLIGRA_SHEETS_MT
@@ -42,10 +42,12 @@ class Cell;
 class CommentStorage;
 class Conditions;
 class ConditionsStorage;
+class CriteriaCache;
 class Formula;
 class FormulaStorage;
 class FusionStorage;
 class LinkStorage;
+class LookupCache;
 class Region;
 class RichTextStorage;
 class Sheet;
@@ -379,11 +381,22 @@ public:
     const FormulaStorage* formulaStorage() const;
     const FusionStorage* fusionStorage() const;
     const LinkStorage* linkStorage() const;
+    const RichTextStorage* richTextStorage() const;
     const StyleStorage* styleStorage() const;
     const UserInputStorage* userInputStorage() const;
     const ValidityStorage* validityStorage() const;
     const ValueStorage* valueStorage() const;
 
+    /**
+     * \return the cache of the indices used by the lookup functions
+     */
+    LookupCache* lookupCache() const;
+
+    /**
+     * \return the cache of the criteria ranges used by the conditional aggregates
+     */
+    CriteriaCache* criteriaCache() const;
+
     void loadConditions(const QList<QPair<QRegion, Conditions> >& conditions);
     void loadStyles(const QList<QPair<QRegion, Style> >& styles);
 
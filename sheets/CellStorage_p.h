@@ -28,6 +28,8 @@
 #include "Validity.h"
 #include "Value.h"
 
+#include "commands/PointStorageUndoCommand.h"
+
 namespace Calligra
 {
 namespace Sheets
@@ -72,16 +74,16 @@ public:
     QList< QPair<QRectF, QString> >          comments;
     QList< QPair<QRectF, Conditions> >       conditions;
     QList< QPair<QRectF, Database> >         databases;
-    QVector< QPair<QPoint, Formula> >        formulas;
+    PointStorageUndoData<Formula>            formulas;
     QList< QPair<QRectF, bool> >             fusions;
-    QVector< QPair<QPoint, QString> >        links;
+    PointStorageUndoData<QString>            links;
     QList< QPair<QRectF, bool> >             matrices;
     QList< QPair<QRectF, QString> >          namedAreas;
     QList< QPair<QRectF, SharedSubStyle> >   styles;
-    QVector< QPair<QPoint, QString> >        userInputs;
+    PointStorageUndoData<QString>            userInputs;
     QList< QPair<QRectF, Validity> >         validities;
-    QVector< QPair<QPoint, Value> >          values;
-    QVector< QPair<QPoint, QSharedPointer<QTextDocument> > > richTexts;
+    PointStorageUndoData<Value>              values;
+    PointStorageUndoData<QSharedPointer<QTextDocument> > richTexts;
 };
 
 } // namespace Sheets
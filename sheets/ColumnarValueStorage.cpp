@@ -0,0 +1,768 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "ColumnarValueStorage.h"
+
+#ifdef CALLIGRA_SHEETS_MT
+#include <QMutex>
+#include <QMutexLocker>
+#endif
+
+#include <algorithm>
+
+#include "calligra_sheets_limits.h"
+#include "Region.h"
+
+using namespace Calligra::Sheets;
+
+namespace
+{
+// The value types stored in the lower four bits of a tag.
+enum Tag {
+    BooleanTag,
+    IntegerTag,
+    FloatTag,
+    OtherTag
+};
+
+// The largest magnitude of integers, that doubles represent exactly.
+static const qint64 s_maxExactInteger = Q_INT64_C(1) << 53;
+
+// Converts value into a number and a tag, if it does not lose anything.
+bool pack(const Value& value, double* number, quint8* tag)
+{
+    switch (value.type()) {
+    case Value::Boolean:
+        *number = value.asBoolean() ? 1.0 : 0.0;
+        *tag = BooleanTag;
+        break;
+    case Value::Integer: {
+        const qint64 integer = value.asInteger();
+        if (integer < -s_maxExactInteger || integer > s_maxExactInteger)
+            return false;
+        *number = double(integer);
+        *tag = IntegerTag;
+        break;
+    }
+    case Value::Float: {
+        const long double fraction = numToDouble(value.asFloat());
+        const double converted = double(fraction);
+        // also fails for NaN
+        if ((long double)converted != fraction)
+            return false;
+        *number = converted;
+        *tag = FloatTag;
+        break;
+    }
+    default:
+        // empty values are rare and keep their null state as Value objects
+        return false;
+    }
+    *tag |= quint8(value.format()) << 4;
+    return true;
+}
+
+Value unpack(double number, quint8 tag)
+{
+    Value value;
+    switch (tag & 0x0F) {
+    case BooleanTag:
+        value = Value(number != 0.0);
+        break;
+    case IntegerTag:
+        value = Value(qint64(number));
+        break;
+    default:
+        value = Value(number);
+        break;
+    }
+    const Value::Format format = Value::Format(tag >> 4);
+    if (value.format() != format)
+        value.setFormat(format);
+    return value;
+}
+} // namespace
+
+
+/*****************************************************************************
+ *
+ * Column
+ *
+ ****************************************************************************/
+
+int ColumnarValueStorage::Column::lowerBound(int row) const
+{
+    // appending is the common case while loading or filling
+    if (rows.isEmpty() || rows.last() < row)
+        return rows.count();
+    return std::lower_bound(rows.constBegin(), rows.constEnd(), row) - rows.constBegin();
+}
+
+int ColumnarValueStorage::Column::indexOf(int row) const
+{
+    const int index = lowerBound(row);
+    return (index < rows.count() && rows[index] == row) ? index : -1;
+}
+
+Value ColumnarValueStorage::Column::value(int index) const
+{
+    const quint8 tag = tags[index];
+    if ((tag & 0x0F) == OtherTag)
+        return others.value(rows[index]);
+    return unpack(numbers[index], tag);
+}
+
+void ColumnarValueStorage::Column::set(int index, const Value& data)
+{
+    const int row = rows[index];
+    if ((tags[index] & 0x0F) == OtherTag)
+        others.remove(row);
+    double number;
+    quint8 tag;
+    if (pack(data, &number, &tag)) {
+        numbers[index] = number;
+        tags[index] = tag;
+    } else {
+        numbers[index] = 0.0;
+        tags[index] = OtherTag;
+        others.insert(row, data);
+    }
+}
+
+void ColumnarValueStorage::Column::insert(int index, int row, const Value& data)
+{
+    rows.insert(index, row);
+    numbers.insert(index, 0.0);
+    tags.insert(index, BooleanTag);
+    set(index, data);
+}
+
+void ColumnarValueStorage::Column::remove(int first, int count)
+{
+    if (count <= 0)
+        return;
+    if (!others.isEmpty()) {
+        for (int i = first; i < first + count; ++i) {
+            if ((tags[i] & 0x0F) == OtherTag)
+                others.remove(rows[i]);
+        }
+    }
+    rows.remove(first, count);
+    numbers.remove(first, count);
+    tags.remove(first, count);
+}
+
+void ColumnarValueStorage::Column::append(const Column& other, int index, int row)
+{
+    Q_ASSERT(rows.isEmpty() || rows.last() < row);
+    rows.append(row);
+    numbers.append(other.numbers[index]);
+    tags.append(other.tags[index]);
+    if ((other.tags[index] & 0x0F) == OtherTag)
+        others.insert(row, other.others.value(other.rows[index]));
+}
+
+void ColumnarValueStorage::Column::insert(const Column& block)
+{
+    if (block.rows.isEmpty())
+        return;
+    const int index = lowerBound(block.rows.first());
+    Q_ASSERT(index == lowerBound(block.rows.last() + 1));
+    if (index == rows.count()) {
+        rows += block.rows;
+        numbers += block.numbers;
+        tags += block.tags;
+    } else {
+        rows = rows.mid(0, index) + block.rows + rows.mid(index);
+        numbers = numbers.mid(0, index) + block.numbers + numbers.mid(index);
+        tags = tags.mid(0, index) + block.tags + tags.mid(index);
+    }
+    QHash<int, Value>::ConstIterator end(block.others.constEnd());
+    for (QHash<int, Value>::ConstIterator it(block.others.constBegin()); it != end; ++it)
+        others.insert(it.key(), it.value());
+}
+
+void ColumnarValueStorage::Column::shift(int index, int delta)
+{
+    if (!others.isEmpty()) {
+        // take all moved values first, the new rows may be the old ones of others
+        QVector< QPair<int, Value> > moved;
+        for (int i = index; i < rows.count(); ++i) {
+            if ((tags[i] & 0x0F) == OtherTag)
+                moved.append(qMakePair(rows[i] + delta, others.take(rows[i])));
+        }
+        for (int i = 0; i < moved.count(); ++i)
+            others.insert(moved[i].first, moved[i].second);
+    }
+    for (int i = index; i < rows.count(); ++i)
+        rows[i] += delta;
+}
+
+void ColumnarValueStorage::Column::values(int col, int first, int count, QVector< QPair<QPoint, Value> >& result) const
+{
+    for (int i = first; i < first + count; ++i)
+        result.append(qMakePair(QPoint(col, rows[i]), value(i)));
+}
+
+
+/*****************************************************************************
+ *
+ * ColumnarValueStorage
+ *
+ ****************************************************************************/
+
+class ColumnarValueStorage::Order
+{
+public:
+    Order() : valid(false) {}
+
+    // the row in the upper, the column in the lower 16 bits; sorted
+    QVector<quint64> keys;
+    bool valid;
+#ifdef CALLIGRA_SHEETS_MT
+    QMutex mutex;
+#endif
+};
+
+ColumnarValueStorage::ColumnarValueStorage()
+        : m_count(0)
+        , m_order(new Order)
+{
+}
+
+ColumnarValueStorage::ColumnarValueStorage(const ColumnarValueStorage& other)
+        : m_columns(other.m_columns)
+        , m_count(other.m_count)
+        , m_order(new Order)
+{
+}
+
+ColumnarValueStorage::~ColumnarValueStorage()
+{
+    delete m_order;
+}
+
+ColumnarValueStorage& ColumnarValueStorage::operator=(const ColumnarValueStorage& other)
+{
+    if (this != &other) {
+        m_columns = other.m_columns;
+        m_count = other.m_count;
+        invalidateOrder();
+    }
+    return *this;
+}
+
+void ColumnarValueStorage::clear()
+{
+    m_columns.clear();
+    m_count = 0;
+    invalidateOrder();
+}
+
+int ColumnarValueStorage::count() const
+{
+    return m_count;
+}
+
+Value ColumnarValueStorage::insert(int col, int row, const Value& data)
+{
+    Q_ASSERT(1 <= col && col <= KS_colMax);
+    Q_ASSERT(1 <= row && row <= KS_rowMax);
+    if (col > m_columns.count())
+        m_columns.resize(col);
+    Column& column = m_columns[col - 1];
+    const int index = column.lowerBound(row);
+    if (index < column.rows.count() && column.rows[index] == row) {
+        // the positions do not change
+        const Value oldData = column.value(index);
+        column.set(index, data);
+        return oldData;
+    }
+    column.insert(index, row, data);
+    ++m_count;
+    invalidateOrder();
+    return Value();
+}
+
+Value ColumnarValueStorage::lookup(int col, int row, const Value& defaultVal) const
+{
+    Q_ASSERT(1 <= col && col <= KS_colMax);
+    Q_ASSERT(1 <= row && row <= KS_rowMax);
+    if (col > m_columns.count())
+        return defaultVal;
+    const Column& column = m_columns[col - 1];
+    const int index = column.indexOf(row);
+    if (index == -1)
+        return defaultVal;
+    return column.value(index);
+}
+
+Value ColumnarValueStorage::take(int col, int row, const Value& defaultVal)
+{
+    Q_ASSERT(1 <= col && col <= KS_colMax);
+    Q_ASSERT(1 <= row && row <= KS_rowMax);
+    if (col > m_columns.count())
+        return defaultVal;
+    const int index = m_columns[col - 1].indexOf(row);
+    if (index == -1)
+        return defaultVal;
+    Column& column = m_columns[col - 1];
+    const Value oldData = column.value(index);
+    column.remove(index, 1);
+    --m_count;
+    squeeze();
+    invalidateOrder();
+    return oldData;
+}
+
+QVector< QPair<QPoint, Value> > ColumnarValueStorage::insertColumns(int position, int number)
+{
+    Q_ASSERT(1 <= position && position <= KS_colMax);
+    QVector< QPair<QPoint, Value> > oldData;
+    if (position > m_columns.count())
+        return oldData;
+    // save the data shifted over the end
+    for (int col = qMax(position, KS_colMax - number + 1); col <= m_columns.count(); ++col) {
+        const Column& column = m_columns[col - 1];
+        column.values(col, 0, column.rows.count(), oldData);
+    }
+    m_columns.insert(position - 1, number, Column());
+    if (m_columns.count() > KS_colMax)
+        m_columns.resize(KS_colMax);
+    m_count -= oldData.count();
+    squeeze();
+    invalidateOrder();
+    return oldData;
+}
+
+QVector< QPair<QPoint, Value> > ColumnarValueStorage::removeColumns(int position, int number)
+{
+    Q_ASSERT(1 <= position && position <= KS_colMax);
+    QVector< QPair<QPoint, Value> > oldData;
+    if (position > m_columns.count())
+        return oldData;
+    const int last = qMin(position + number - 1, m_columns.count());
+    for (int col = position; col <= last; ++col) {
+        const Column& column = m_columns[col - 1];
+        column.values(col, 0, column.rows.count(), oldData);
+    }
+    m_columns.remove(position - 1, last - position + 1);
+    m_count -= oldData.count();
+    squeeze();
+    invalidateOrder();
+    return oldData;
+}
+
+QVector< QPair<QPoint, Value> > ColumnarValueStorage::insertRows(int position, int number)
+{
+    Q_ASSERT(1 <= position && position <= KS_rowMax);
+    return shiftRows(1, KS_colMax, position, number);
+}
+
+QVector< QPair<QPoint, Value> > ColumnarValueStorage::removeRows(int position, int number)
+{
+    Q_ASSERT(1 <= position && position <= KS_rowMax);
+    return shiftRows(1, KS_colMax, position, -number);
+}
+
+QVector< QPair<QPoint, Value> > ColumnarValueStorage::removeShiftLeft(const QRect& rect)
+{
+    Q_ASSERT(1 <= rect.left() && rect.left() <= KS_colMax);
+    return shiftColumns(rect.top(), rect.bottom(), rect.left(), -rect.width());
+}
+
+QVector< QPair<QPoint, Value> > ColumnarValueStorage::insertShiftRight(const QRect& rect)
+{
+    Q_ASSERT(1 <= rect.left() && rect.left() <= KS_colMax);
+    return shiftColumns(rect.top(), rect.bottom(), rect.left(), rect.width());
+}
+
+QVector< QPair<QPoint, Value> > ColumnarValueStorage::removeShiftUp(const QRect& rect)
+{
+    Q_ASSERT(1 <= rect.top() && rect.top() <= KS_rowMax);
+    return shiftRows(rect.left(), rect.right(), rect.top(), -rect.height());
+}
+
+QVector< QPair<QPoint, Value> > ColumnarValueStorage::insertShiftDown(const QRect& rect)
+{
+    Q_ASSERT(1 <= rect.top() && rect.top() <= KS_rowMax);
+    return shiftRows(rect.left(), rect.right(), rect.top(), rect.height());
+}
+
+QVector< QPair<QPoint, Value> > ColumnarValueStorage::shiftColumns(int top, int bottom, int position, int delta)
+{
+    QVector< QPair<QPoint, Value> > oldData;
+    const int last = m_columns.count();
+    if (position > last)
+        return oldData;
+    // take the moved entries out of their columns
+    QVector<Column> blocks(last - position + 1);
+    for (int col = position; col <= last; ++col) {
+        Column& column = m_columns[col - 1];
+        const int first = column.lowerBound(top);
+        const int end = column.lowerBound(bottom + 1);
+        Column& block = blocks[col - position];
+        for (int i = first; i < end; ++i)
+            block.append(column, i, column.rows[i]);
+        column.remove(first, end - first);
+    }
+    // put them into the vacated rows of their new columns
+    for (int col = position; col <= last; ++col) {
+        const Column& block = blocks[col - position];
+        if (block.rows.isEmpty())
+            continue;
+        const int newCol = col + delta;
+        if (newCol < position || newCol > KS_colMax) {
+            block.values(col, 0, block.rows.count(), oldData);
+            continue;
+        }
+        if (newCol > m_columns.count())
+            m_columns.resize(newCol);
+        m_columns[newCol - 1].insert(block);
+    }
+    m_count -= oldData.count();
+    squeeze();
+    invalidateOrder();
+    return oldData;
+}
+
+QVector< QPair<QPoint, Value> > ColumnarValueStorage::shiftRows(int left, int right, int position, int delta)
+{
+    QVector< QPair<QPoint, Value> > oldData;
+    const int last = qMin(right, m_columns.count());
+    for (int col = left; col <= last; ++col) {
+        if (m_columns[col - 1].rows.isEmpty())
+            continue;
+        Column& column = m_columns[col - 1];
+        const int first = column.lowerBound(position);
+        if (first == column.rows.count())
+            continue;
+        if (delta < 0) {
+            // the data in the removed rows
+            const int end = column.lowerBound(position - delta);
+            column.values(col, first, end - first, oldData);
+            column.remove(first, end - first);
+        } else {
+            // the data shifted over the end
+            const int end = qMax(first, column.lowerBound(KS_rowMax - delta + 1));
+            column.values(col, end, column.rows.count() - end, oldData);
+            column.remove(end, column.rows.count() - end);
+        }
+        column.shift(first, delta);
+    }
+    m_count -= oldData.count();
+    squeeze();
+    invalidateOrder();
+    return oldData;
+}
+
+Value ColumnarValueStorage::firstInColumn(int col, int* newRow) const
+{
+    Q_ASSERT(1 <= col && col <= KS_colMax);
+    if (col > m_columns.count() || m_columns[col - 1].rows.isEmpty()) {
+        if (newRow)
+            *newRow = 0;
+        return Value();
+    }
+    const Column& column = m_columns[col - 1];
+    if (newRow)
+        *newRow = column.rows.first();
+    return column.value(0);
+}
+
+Value ColumnarValueStorage::firstInRow(int row, int* newCol) const
+{
+    Q_ASSERT(1 <= row && row <= KS_rowMax);
+    for (int col = 1; col <= m_columns.count(); ++col) {
+        const int index = m_columns[col - 1].indexOf(row);
+        if (index != -1) {
+            if (newCol)
+                *newCol = col;
+            return m_columns[col - 1].value(index);
+        }
+    }
+    if (newCol)
+        *newCol = 0;
+    return Value();
+}
+
+Value ColumnarValueStorage::lastInColumn(int col, int* newRow) const
+{
+    Q_ASSERT(1 <= col && col <= KS_colMax);
+    if (col > m_columns.count() || m_columns[col - 1].rows.isEmpty()) {
+        if (newRow)
+            *newRow = 0;
+        return Value();
+    }
+    const Column& column = m_columns[col - 1];
+    if (newRow)
+        *newRow = column.rows.last();
+    return column.value(column.rows.count() - 1);
+}
+
+Value ColumnarValueStorage::lastInRow(int row, int* newCol) const
+{
+    Q_ASSERT(1 <= row && row <= KS_rowMax);
+    for (int col = m_columns.count(); col >= 1; --col) {
+        const int index = m_columns[col - 1].indexOf(row);
+        if (index != -1) {
+            if (newCol)
+                *newCol = col;
+            return m_columns[col - 1].value(index);
+        }
+    }
+    if (newCol)
+        *newCol = 0;
+    return Value();
+}
+
+Value ColumnarValueStorage::nextInColumn(int col, int row, int* newRow) const
+{
+    Q_ASSERT(1 <= col && col <= KS_colMax);
+    Q_ASSERT(1 <= row && row <= KS_rowMax);
+    if (col <= m_columns.count()) {
+        const Column& column = m_columns[col - 1];
+        const int index = column.lowerBound(row + 1);
+        if (index < column.rows.count()) {
+            if (newRow)
+                *newRow = column.rows[index];
+            return column.value(index);
+        }
+    }
+    if (newRow)
+        *newRow = 0;
+    return Value();
+}
+
+Value ColumnarValueStorage::nextInRow(int col, int row, int* newCol) const
+{
+    Q_ASSERT(1 <= col && col <= KS_colMax);
+    Q_ASSERT(1 <= row && row <= KS_rowMax);
+    for (int c = col + 1; c <= m_columns.count(); ++c) {
+        const int index = m_columns[c - 1].indexOf(row);
+        if (index != -1) {
+            if (newCol)
+                *newCol = c;
+            return m_columns[c - 1].value(index);
+        }
+    }
+    if (newCol)
+        *newCol = 0;
+    return Value();
+}
+
+Value ColumnarValueStorage::prevInColumn(int col, int row, int* newRow) const
+{
+    Q_ASSERT(1 <= col && col <= KS_colMax);
+    Q_ASSERT(1 <= row && row <= KS_rowMax);
+    if (col <= m_columns.count()) {
+        const Column& column = m_columns[col - 1];
+        const int index = column.lowerBound(row) - 1;
+        if (index >= 0) {
+            if (newRow)
+                *newRow = column.rows[index];
+            return column.value(index);
+        }
+    }
+    if (newRow)
+        *newRow = 0;
+    return Value();
+}
+
+Value ColumnarValueStorage::prevInRow(int col, int row, int* newCol) const
+{
+    Q_ASSERT(1 <= col && col <= KS_colMax);
+    Q_ASSERT(1 <= row && row <= KS_rowMax);
+    for (int c = qMin(col - 1, m_columns.count()); c >= 1; --c) {
+        const int index = m_columns[c - 1].indexOf(row);
+        if (index != -1) {
+            if (newCol)
+                *newCol = c;
+            return m_columns[c - 1].value(index);
+        }
+    }
+    if (newCol)
+        *newCol = 0;
+    return Value();
+}
+
+int ColumnarValueStorage::col(int index) const
+{
+    ensureOrder();
+    return int(m_order->keys.value(index) & 0xFFFF);
+}
+
+int ColumnarValueStorage::row(int index) const
+{
+    ensureOrder();
+    return int(m_order->keys.value(index) >> 16);
+}
+
+Value ColumnarValueStorage::data(int index) const
+{
+    ensureOrder();
+    if (index < 0 || index >= m_order->keys.count())
+        return Value();
+    const quint64 key = m_order->keys[index];
+    const Column& column = m_columns[int(key & 0xFFFF) - 1];
+    return column.value(column.indexOf(int(key >> 16)));
+}
+
+int ColumnarValueStorage::columns() const
+{
+    return m_columns.count();
+}
+
+int ColumnarValueStorage::rows() const
+{
+    int rows = 0;
+    for (int col = 0; col < m_columns.count(); ++col) {
+        if (!m_columns[col].rows.isEmpty())
+            rows = qMax(m_columns[col].rows.last(), rows);
+    }
+    return rows;
+}
+
+ColumnarValueStorage ColumnarValueStorage::subStorage(const Region& region, bool keepOffset) const
+{
+    // Determine the offset.
+    const QPoint offset = keepOffset ? QPoint(0, 0) : region.boundingRect().topLeft() - QPoint(1, 1);
+    ColumnarValueStorage subStorage;
+    Region::ConstIterator end(region.constEnd());
+    for (Region::ConstIterator it(region.constBegin()); it != end; ++it) {
+        const QRect rect = (*it)->rect();
+        for (int col = rect.left(); col <= rect.right() && col <= m_columns.count(); ++col) {
+            const Column& column = m_columns[col - 1];
+            const int last = column.lowerBound(rect.bottom() + 1);
+            const int newCol = col - offset.x();
+            for (int i = column.lowerBound(rect.top()); i < last; ++i) {
+                const int newRow = column.rows[i] - offset.y();
+                if (newCol > subStorage.m_columns.count())
+                    subStorage.m_columns.resize(newCol);
+                Column& target = subStorage.m_columns[newCol - 1];
+                if (target.rows.isEmpty() || target.rows.last() < newRow) {
+                    // copy without a detour over Value
+                    target.append(column, i, newRow);
+                    ++subStorage.m_count;
+                } else
+                    subStorage.insert(newCol, newRow, column.value(i));
+            }
+        }
+    }
+    return subStorage;
+}
+
+bool ColumnarValueStorage::sumNumbers(const QRect& rect, Number* sum, int* count) const
+{
+    Number total = 0.0;
+    int numbers = 0;
+    const int right = qMin(rect.right(), m_columns.count());
+    for (int col = qMax(rect.left(), 1); col <= right; ++col) {
+        const Column& column = m_columns[col - 1];
+        const int last = column.lowerBound(rect.bottom() + 1);
+        for (int i = column.lowerBound(rect.top()); i < last; ++i) {
+            switch (column.tags[i] & 0x0F) {
+            case IntegerTag:
+            case FloatTag:
+                total += column.numbers[i];
+                ++numbers;
+                break;
+            case OtherTag: {
+                const Value value = column.others.value(column.rows[i]);
+                switch (value.type()) {
+                case Value::Integer:
+                case Value::Float:
+                    total += value.asFloat();
+                    ++numbers;
+                    break;
+                case Value::Empty:
+                case Value::String:
+                    break;
+                default:
+                    return false;
+                }
+                break;
+            }
+            default:
+                // booleans
+                break;
+            }
+        }
+    }
+    *sum += total;
+    *count += numbers;
+    return true;
+}
+
+bool ColumnarValueStorage::operator==(const ColumnarValueStorage& o) const
+{
+    if (m_count != o.m_count || m_columns.count() != o.m_columns.count())
+        return false;
+    for (int col = 0; col < m_columns.count(); ++col) {
+        const Column& column = m_columns[col];
+        const Column& other = o.m_columns[col];
+        if (column.rows != other.rows)
+            return false;
+        // compare like Value::operator==, i.e. ignore the formats
+        for (int i = 0; i < column.rows.count(); ++i) {
+            const int tag = column.tags[i] & 0x0F;
+            if (tag != (other.tags[i] & 0x0F))
+                return false;
+            if (tag == OtherTag) {
+                if (!(column.others.value(column.rows[i]) == other.others.value(other.rows[i])))
+                    return false;
+            } else if (column.numbers[i] != other.numbers[i])
+                return false;
+        }
+    }
+    return true;
+}
+
+void ColumnarValueStorage::squeeze()
+{
+    while (!m_columns.isEmpty() && m_columns.last().rows.isEmpty())
+        m_columns.removeLast();
+}
+
+void ColumnarValueStorage::ensureOrder() const
+{
+#ifdef CALLIGRA_SHEETS_MT
+    QMutexLocker locker(&m_order->mutex);
+#endif
+    if (m_order->valid)
+        return;
+    QVector<quint64> keys;
+    keys.reserve(m_count);
+    for (int col = 0; col < m_columns.count(); ++col) {
+        const QVector<int>& rows = m_columns[col].rows;
+        for (int i = 0; i < rows.count(); ++i)
+            keys.append((quint64(rows[i]) << 16) | quint64(col + 1));
+    }
+    std::sort(keys.begin(), keys.end());
+    m_order->keys = keys;
+    m_order->valid = true;
+}
+
+void ColumnarValueStorage::invalidateOrder()
+{
+    if (m_order->valid) {
+        m_order->valid = false;
+        m_order->keys.clear();
+    }
+}
@@ -0,0 +1,363 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "CriteriaCache.h"
+
+#ifdef CALLIGRA_SHEETS_MT
+#include <QMutex>
+#include <QMutexLocker>
+#endif
+
+#include <QHash>
+#include <QPair>
+
+#include "RangeIndex.h"
+
+using namespace Calligra::Sheets;
+
+// Smaller ranges are tested cell by cell.
+static const int s_minimumSize = 32;
+// The maximum number of cached cells per sheet; larger ranges are tested cell by cell, too.
+static const int s_maximumCost = 1 << 22;
+
+namespace
+{
+// A value and its format; unlike Value::operator== floating point values
+// are compared exactly, so all values in a group match the same conditions.
+struct GroupKey {
+    Value::Type type;
+    Value::Format format;
+    qint64 integer;
+    Number number;
+    QString string;
+
+    bool operator==(const GroupKey& other) const {
+        return type == other.type && format == other.format && integer == other.integer
+               && number == other.number && string == other.string;
+    }
+};
+
+uint qHash(const GroupKey& key, uint seed = 0)
+{
+    return ::qHash(key.integer, seed) ^ ::qHash(numToDouble(key.number), seed)
+           ^ ::qHash(key.string, seed) ^ (uint(key.type) << 4) ^ uint(key.format);
+}
+}
+
+CriteriaGroups::CriteriaGroups(const Value& data)
+        : m_valid(data.isArray())
+{
+    if (!m_valid)
+        return;
+    const int columns = data.columns();
+    const int rows = data.rows();
+    m_groups.fill(-1, columns * rows);
+    QHash<GroupKey, int> groups;
+    GroupKey key;
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            const Value value = data.element(column, row);
+            key.type = value.type();
+            key.format = value.format();
+            key.integer = 0;
+            key.number = 0.0;
+            key.string.clear();
+            switch (value.type()) {
+            case Value::Empty:
+                continue;
+            case Value::Boolean:
+                key.integer = value.asBoolean();
+                break;
+            case Value::Integer:
+                key.integer = value.asInteger();
+                break;
+            case Value::Float:
+                key.number = value.asFloat();
+                break;
+            case Value::String:
+                key.string = value.asString();
+                break;
+            case Value::Error:
+                key.string = value.errorMessage();
+                break;
+            default:
+                m_valid = false;
+                m_values.clear();
+                m_sizes.clear();
+                m_groups.clear();
+                return;
+            }
+            QHash<GroupKey, int>::ConstIterator it = groups.constFind(key);
+            if (it == groups.constEnd()) {
+                it = groups.insert(key, m_values.count());
+                m_values.append(value);
+                m_sizes.append(0);
+            }
+            m_groups[row * columns + column] = it.value();
+            ++m_sizes[it.value()];
+        }
+    }
+}
+
+bool CriteriaGroups::isValid() const
+{
+    return m_valid;
+}
+
+int CriteriaGroups::count() const
+{
+    return m_values.count();
+}
+
+Value CriteriaGroups::value(int group) const
+{
+    return m_values.value(group);
+}
+
+int CriteriaGroups::size(int group) const
+{
+    return m_sizes.value(group);
+}
+
+int CriteriaGroups::cells() const
+{
+    return m_groups.count();
+}
+
+int CriteriaGroups::group(int index) const
+{
+    return m_groups.value(index, -1);
+}
+
+
+CriteriaSums::CriteriaSums(const CriteriaGroups& groups, const Value& data)
+        : m_sums(groups.count(), 0.0)
+        , m_counts(groups.count(), 0)
+{
+    const int columns = data.columns();
+    const int cells = qMin(groups.cells(), int(data.rows()) * columns);
+    for (int i = 0; i < cells; ++i) {
+        const int group = groups.group(i);
+        if (group == -1)
+            continue;
+        const Value value = data.element(i % columns, i / columns);
+        // only add numbers, no conversion from string allowed
+        if (value.isNumber()) {
+            m_sums[group] += value.asFloat();
+            ++m_counts[group];
+        }
+    }
+}
+
+Number CriteriaSums::sum(int group) const
+{
+    return m_sums.value(group);
+}
+
+int CriteriaSums::count(int group) const
+{
+    return m_counts.value(group);
+}
+
+
+class Q_DECL_HIDDEN CriteriaCache::Private
+{
+public:
+    // the top left and the bottom right corner
+    typedef QPair<quint64, quint64> Key;
+
+    struct Entry {
+        QRect range;
+        QSharedPointer<const CriteriaGroups> groups;
+        // the partial sums keyed by the top left corner of their sum range
+        QHash<quint64, QSharedPointer<const CriteriaSums> > sums;
+    };
+
+    static quint64 key(const QPoint& point);
+    static Key key(const QRect& range);
+    // Clears the cache, if there is no room for size more cells.
+    void makeRoom(int size);
+    QHash<Key, Entry>::Iterator insert(const QRect& range, const Value& data);
+    void remove(const Key& key);
+
+    QHash<Key, Entry> entries;
+    // the keys of the entries by their criteria and sum ranges
+    RangeIndex<Key> ranges;
+    int cost;
+#ifdef CALLIGRA_SHEETS_MT
+    QMutex mutex;
+#endif
+};
+
+quint64 CriteriaCache::Private::key(const QPoint& point)
+{
+    return (quint64(point.x()) << 32) | quint32(point.y());
+}
+
+CriteriaCache::Private::Key CriteriaCache::Private::key(const QRect& range)
+{
+    return qMakePair(key(range.topLeft()), key(range.bottomRight()));
+}
+
+void CriteriaCache::Private::makeRoom(int size)
+{
+    if (cost + size > s_maximumCost) {
+        entries.clear();
+        ranges.clear();
+        cost = 0;
+    }
+}
+
+QHash<CriteriaCache::Private::Key, CriteriaCache::Private::Entry>::Iterator
+CriteriaCache::Private::insert(const QRect& range, const Value& data)
+{
+    const Key key = Private::key(range);
+    Entry entry;
+    entry.range = range;
+    entry.groups = QSharedPointer<const CriteriaGroups>(new CriteriaGroups(data));
+    ranges.insert(range, key);
+    cost += range.width() * range.height();
+    return entries.insert(key, entry);
+}
+
+void CriteriaCache::Private::remove(const Key& key)
+{
+    QHash<Key, Entry>::Iterator it = entries.find(key);
+    if (it == entries.end())
+        return;
+    const Entry& entry = it.value();
+    const int size = entry.range.width() * entry.range.height();
+    ranges.remove(entry.range, key);
+    QHash<quint64, QSharedPointer<const CriteriaSums> >::ConstIterator end = entry.sums.constEnd();
+    for (QHash<quint64, QSharedPointer<const CriteriaSums> >::ConstIterator sit = entry.sums.constBegin(); sit != end; ++sit) {
+        const QPoint topLeft(int(sit.key() >> 32), int(quint32(sit.key())));
+        ranges.remove(QRect(topLeft, entry.range.size()), key);
+        cost -= size;
+    }
+    cost -= size;
+    entries.erase(it);
+}
+
+CriteriaCache::CriteriaCache()
+        : d(new Private)
+{
+    d->cost = 0;
+}
+
+CriteriaCache::~CriteriaCache()
+{
+    delete d;
+}
+
+QSharedPointer<const CriteriaGroups> CriteriaCache::groups(const QRect& range, const Value& data)
+{
+    // the values have to be the ones of the range
+    if (range.width() != int(data.columns()) || range.height() != int(data.rows()))
+        return QSharedPointer<const CriteriaGroups>();
+    const qint64 size = qint64(range.width()) * range.height();
+    if (size < s_minimumSize || size > s_maximumCost)
+        return QSharedPointer<const CriteriaGroups>();
+
+#ifdef CALLIGRA_SHEETS_MT
+    QMutexLocker locker(&d->mutex);
+#endif
+    QHash<Private::Key, Private::Entry>::Iterator it = d->entries.find(Private::key(range));
+    if (it == d->entries.end()) {
+        d->makeRoom(int(size));
+        it = d->insert(range, data);
+    }
+    // invalid groups are kept to not rebuild them each time
+    if (!it.value().groups->isValid())
+        return QSharedPointer<const CriteriaGroups>();
+    return it.value().groups;
+}
+
+QSharedPointer<const CriteriaSums> CriteriaCache::sums(const QRect& range, const QRect& sumRange) const
+{
+#ifdef CALLIGRA_SHEETS_MT
+    QMutexLocker locker(&d->mutex);
+#endif
+    QHash<Private::Key, Private::Entry>::ConstIterator it = d->entries.constFind(Private::key(range));
+    if (it == d->entries.constEnd() || sumRange.size() != range.size())
+        return QSharedPointer<const CriteriaSums>();
+    return it.value().sums.value(Private::key(sumRange.topLeft()));
+}
+
+QSharedPointer<const CriteriaSums> CriteriaCache::sums(const QRect& range, const Value& data,
+                                                       const QRect& sumRange, const Value& sumData)
+{
+    if (range.width() != int(data.columns()) || range.height() != int(data.rows()))
+        return QSharedPointer<const CriteriaSums>();
+    if (sumRange.size() != range.size() || sumRange.width() != int(sumData.columns())
+            || sumRange.height() != int(sumData.rows()))
+        return QSharedPointer<const CriteriaSums>();
+    const qint64 size = qint64(range.width()) * range.height();
+    if (size < s_minimumSize || 2 * size > s_maximumCost)
+        return QSharedPointer<const CriteriaSums>();
+
+#ifdef CALLIGRA_SHEETS_MT
+    QMutexLocker locker(&d->mutex);
+#endif
+    const Private::Key key = Private::key(range);
+    const quint64 sumKey = Private::key(sumRange.topLeft());
+    QHash<Private::Key, Private::Entry>::Iterator it = d->entries.find(key);
+    if (it == d->entries.end()) {
+        // room for the groups and the sums
+        d->makeRoom(2 * int(size));
+        it = d->insert(range, data);
+    } else if (it.value().groups->isValid() && !it.value().sums.contains(sumKey)) {
+        d->makeRoom(int(size));
+        it = d->entries.find(key);
+        if (it == d->entries.end())
+            it = d->insert(range, data);
+    }
+    Private::Entry& entry = it.value();
+    if (!entry.groups->isValid())
+        return QSharedPointer<const CriteriaSums>();
+    QHash<quint64, QSharedPointer<const CriteriaSums> >::ConstIterator sit = entry.sums.constFind(sumKey);
+    if (sit != entry.sums.constEnd())
+        return sit.value();
+    const QSharedPointer<const CriteriaSums> sums(new CriteriaSums(*entry.groups, sumData));
+    entry.sums.insert(sumKey, sums);
+    d->ranges.insert(sumRange, key);
+    d->cost += int(size);
+    return sums;
+}
+
+void CriteriaCache::regionChanged(const QRect& rect)
+{
+#ifdef CALLIGRA_SHEETS_MT
+    QMutexLocker locker(&d->mutex);
+#endif
+    if (d->entries.isEmpty())
+        return;
+    const QList<Private::Key> keys = d->ranges.intersects(rect);
+    for (int i = 0; i < keys.count(); ++i)
+        d->remove(keys[i]);
+}
+
+void CriteriaCache::clear()
+{
+#ifdef CALLIGRA_SHEETS_MT
+    QMutexLocker locker(&d->mutex);
+#endif
+    d->entries.clear();
+    d->ranges.clear();
+    d->cost = 0;
+}
@@ -0,0 +1,184 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_CRITERIA_CACHE
+#define CALLIGRA_SHEETS_CRITERIA_CACHE
+
+#include <QRect>
+#include <QSharedPointer>
+#include <QVector>
+
+#include "Number.h"
+#include "Value.h"
+
+#include "sheets_odf_export.h"
+
+namespace Calligra
+{
+namespace Sheets
+{
+
+/**
+ * \ingroup Value
+ * The values of a criteria range, i.e. a range tested by SUMIF, SUMIFS,
+ * COUNTIF or COUNTIFS, grouped by equality.
+ *
+ * Whether a value matches a condition only depends on the value, so a
+ * condition has to be tested once per group instead of once per cell.
+ * Values are equal, if they have the same type, format and content;
+ * floating point values are compared exactly. Empty cells, which never
+ * match, do not belong to any group.
+ */
+class CALLIGRA_SHEETS_ODF_EXPORT CriteriaGroups
+{
+public:
+    /**
+     * Groups the elements of the array \p data .
+     */
+    explicit CriteriaGroups(const Value& data);
+
+    /**
+     * \return \c false , if the values contain arrays or complex numbers,
+     * which are not grouped
+     */
+    bool isValid() const;
+
+    /**
+     * \return the number of groups
+     */
+    int count() const;
+
+    /**
+     * \return the value shared by the cells of \p group
+     */
+    Value value(int group) const;
+
+    /**
+     * \return the number of cells in \p group
+     */
+    int size(int group) const;
+
+    /**
+     * \return the number of grouped cells including the empty ones
+     */
+    int cells() const;
+
+    /**
+     * \return the group of the cell at \p index , counted row by row,
+     * or -1 for an empty cell
+     */
+    int group(int index) const;
+
+private:
+    QVector<Value> m_values;
+    QVector<int> m_sizes;
+    // the group of each cell row by row
+    QVector<int> m_groups;
+    bool m_valid;
+};
+
+/**
+ * \ingroup Value
+ * The partial sums of a sum range per group of a criteria range, as used
+ * by SUMIF. The cells of the sum range correspond to the cells of the
+ * criteria range at the same position.
+ */
+class CALLIGRA_SHEETS_ODF_EXPORT CriteriaSums
+{
+public:
+    /**
+     * Sums up the numbers in \p data per group of the cells at the same
+     * position in \p groups . Other values are skipped.
+     */
+    CriteriaSums(const CriteriaGroups& groups, const Value& data);
+
+    /**
+     * \return the sum of the numbers in \p group
+     */
+    Number sum(int group) const;
+
+    /**
+     * \return the number of numbers in \p group
+     */
+    int count(int group) const;
+
+private:
+    QVector<Number> m_sums;
+    QVector<int> m_counts;
+};
+
+/**
+ * \ingroup Value
+ * Caches the CriteriaGroups and CriteriaSums of the cell ranges of a sheet.
+ *
+ * Like the LookupCache, the CellStorage owns the cache and drops the entries
+ * of changed cell ranges immediately, i.e. before dependent cells get
+ * recalculated.
+ */
+class CALLIGRA_SHEETS_ODF_EXPORT CriteriaCache
+{
+public:
+    CriteriaCache();
+    ~CriteriaCache();
+
+    /**
+     * \return the groups of the cell range \p range , whose values are
+     * \p data . The groups get created, if they are not cached yet.
+     * A null pointer is returned, if the range is too small to be worth
+     * the grouping or if it can not be grouped.
+     */
+    QSharedPointer<const CriteriaGroups> groups(const QRect& range, const Value& data);
+
+    /**
+     * \return the cached partial sums of the cell range \p sumRange per group
+     * of the cell range \p range or a null pointer, if they are not cached
+     */
+    QSharedPointer<const CriteriaSums> sums(const QRect& range, const QRect& sumRange) const;
+
+    /**
+     * \return the partial sums of the cell range \p sumRange , whose values
+     * are \p sumData , per group of the cell range \p range , whose values
+     * are \p data . Both ranges have to be of the same size and on this
+     * cache's sheet. A null pointer is returned, if the criteria range can
+     * not be grouped.
+     */
+    QSharedPointer<const CriteriaSums> sums(const QRect& range, const Value& data,
+                                            const QRect& sumRange, const Value& sumData);
+
+    /**
+     * Drops the entries of the cell ranges intersecting \p rect .
+     */
+    void regionChanged(const QRect& rect);
+
+    /**
+     * Drops all entries.
+     */
+    void clear();
+
+private:
+    Q_DISABLE_COPY(CriteriaCache)
+
+    class Private;
+    Private * const d;
+};
+
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_CRITERIA_CACHE
@@ -30,7 +30,7 @@
 #include "Map.h"
 #include "NamedAreaManager.h"
 #include "Region.h"
-#include "RTree.h"
+#include "RangeIndex.h"
 #include "Sheet.h"
 #include "Value.h"
 #include "DocBase.h"
@@ -61,10 +61,10 @@ void DependencyManager::Private::dump() const
     }
 
     foreach(Sheet* sheet, consumers.keys()) {
-        const QList< QPair<QRectF, Cell> > pairs = consumers[sheet]->intersectingPairs(QRect(1, 1, KS_colMax, KS_rowMax)).values();
+        const QList< QPair<QRect, Cell> > pairs = consumers[sheet]->intersectingPairs(QRect(1, 1, KS_colMax, KS_rowMax)).values();
         QHash<QString, QString> table;
         for (int i = 0; i < pairs.count(); ++i) {
-            Region tmpRange(pairs[i].first.toRect(), sheet);
+            Region tmpRange(pairs[i].first, sheet);
             table.insertMulti(tmpRange.name(), pairs[i].second.name());
         }
         foreach(const QString &uniqueKey, table.uniqueKeys()) {
@@ -241,20 +241,25 @@ Calligra::Sheets::Region DependencyManager::consumingRegion(const Cell& cell) co
     return d->consumingRegion(cell);
 }
 
+QMap<int, Cell> DependencyManager::cellsToCalculate(const Region& region) const
+{
+    return d->cellsToCalculate(region);
+}
+
 Calligra::Sheets::Region DependencyManager::reduceToProvidingRegion(const Region& region) const
 {
     Region providingRegion;
-    QList< QPair<QRectF, Cell> > pairs;
+    QList< QPair<QRect, Cell> > pairs;
     Region::ConstIterator end(region.constEnd());
     for (Region::ConstIterator it(region.constBegin()); it != end; ++it) {
         Sheet* const sheet = (*it)->sheet();
-        QHash<Sheet*, RTree<Cell>*>::ConstIterator cit = d->consumers.constFind(sheet);
+        QHash<Sheet*, RangeIndex<Cell>*>::ConstIterator cit = d->consumers.constFind(sheet);
         if (cit == d->consumers.constEnd())
             continue;
 
         pairs = cit.value()->intersectingPairs((*it)->rect()).values();
         for (int i = 0; i < pairs.count(); ++i)
-            providingRegion.add(pairs[i].first.toRect() & (*it)->rect(), sheet);
+            providingRegion.add(pairs[i].first & (*it)->rect(), sheet);
     }
     return providingRegion;
 }
@@ -268,7 +273,7 @@ void DependencyManager::regionMoved(const Region& movedRegion, const Cell& desti
         Sheet* const sheet = (*it)->sheet();
         locationOffset.setSheet((sheet == destination.sheet()) ? 0 : destination.sheet());
 
-        QHash<Sheet*, RTree<Cell>*>::ConstIterator cit = d->consumers.constFind(sheet);
+        QHash<Sheet*, RangeIndex<Cell>*>::ConstIterator cit = d->consumers.constFind(sheet);
         if (cit == d->consumers.constEnd())
             continue;
 
@@ -325,12 +330,13 @@ void DependencyManager::updateFormula(const Cell& cell, const Region::Element* o
 void DependencyManager::Private::reset()
 {
     providers.clear();
+    qDeleteAll(consumers);
     consumers.clear();
 }
 
 Calligra::Sheets::Region DependencyManager::Private::consumingRegion(const Cell& cell) const
 {
-    QHash<Sheet*, RTree<Cell>*>::ConstIterator cit = consumers.constFind(cell.sheet());
+    QHash<Sheet*, RangeIndex<Cell>*>::ConstIterator cit = consumers.constFind(cell.sheet());
     if (cit == consumers.constEnd()) {
         //debugSheetsFormula << "No consumer tree found for the cell's sheet.";
         return Region();
@@ -344,6 +350,62 @@ Calligra::Sheets::Region DependencyManager::Private::consumingRegion(const Cell&
     return region;
 }
 
+QMap<int, Cell> DependencyManager::Private::cellsToCalculate(const Region& region) const
+{
+    QMap<int, Cell> cells;
+    // cells already collected; each one is processed only once
+    QSet<Cell> processedCells;
+    // collected cells, whose consumers are not looked up yet
+    QList<Cell> pendingCells;
+
+    Region::ConstIterator end(region.constEnd());
+    for (Region::ConstIterator it(region.constBegin()); it != end; ++it) {
+        const QRect range = (*it)->rect();
+        Sheet* const sheet = (*it)->sheet();
+        if (!sheet)
+            continue;
+
+        // the cells with formulas in the changed region itself
+        const FormulaStorage* formulas = sheet->formulaStorage();
+        const int bottom = qMin(range.bottom(), formulas->rows());
+        for (int row = range.top(); row <= bottom; ++row) {
+            int col = range.left();
+            if (formulas->lookup(col, row).expression().isEmpty())
+                formulas->nextInRow(col, row, &col);
+            while (col && col <= range.right()) {
+                const Cell cell(sheet, col, row);
+                if (!processedCells.contains(cell)) {
+                    processedCells.insert(cell);
+                    cells.insertMulti(depths.value(cell), cell);
+                }
+                if (col == KS_colMax)
+                    break;
+                formulas->nextInRow(col, row, &col);
+            }
+        }
+
+        // the direct consumers of the whole range in one lookup;
+        // this includes the consumers of the formula cells above
+        QHash<Sheet*, RangeIndex<Cell>*>::ConstIterator cit = consumers.constFind(sheet);
+        if (cit != consumers.constEnd())
+            pendingCells.append(cit.value()->intersects(range));
+    }
+
+    // the indirect consumers
+    while (!pendingCells.isEmpty()) {
+        const Cell cell = pendingCells.takeLast();
+        if (processedCells.contains(cell))
+            continue;
+        processedCells.insert(cell);
+        cells.insertMulti(depths.value(cell), cell);
+
+        QHash<Sheet*, RangeIndex<Cell>*>::ConstIterator cit = consumers.constFind(cell.sheet());
+        if (cit != consumers.constEnd())
+            pendingCells.append(cit.value()->contains(cell.cellPosition()));
+    }
+    return cells;
+}
+
 void DependencyManager::Private::namedAreaModified(const QString& name)
 {
     // since area names are something like aliases, modifying an area name
@@ -374,7 +436,7 @@ void DependencyManager::Private::removeDependencies(const Cell& cell)
     Region region = pit.value();
     Region::ConstIterator end(region.constEnd());
     for (Region::ConstIterator it(region.constBegin()); it != end; ++it) {
-        QHash<Sheet*, RTree<Cell>*>::ConstIterator cit = consumers.constFind((*it)->sheet());
+        QHash<Sheet*, RangeIndex<Cell>*>::ConstIterator cit = consumers.constFind((*it)->sheet());
         if (cit != consumers.constEnd()) {
             cit.value()->remove((*it)->rect(), cell);
         }
@@ -403,7 +465,7 @@ void DependencyManager::Private::removeDepths(const Cell& cell)
     QMap<Cell, int>::Iterator dit = depths.find(cell);
     if (dit == depths.end())
         return;
-    QHash<Sheet*, RTree<Cell>*>::ConstIterator cit = consumers.constFind(cell.sheet());
+    QHash<Sheet*, RangeIndex<Cell>*>::ConstIterator cit = consumers.constFind(cell.sheet());
     if (cit == consumers.constEnd())
         return;
     depths.erase(dit);
@@ -476,7 +538,7 @@ void DependencyManager::Private::generateDepths(Cell cell, QSet<Cell>& computedD
 
     // Recursion. We need the whole dependency tree of the changed region.
     // An infinite loop is prevented by the check above.
-    QHash<Sheet*, RTree<Cell>*>::ConstIterator cit = consumers.constFind(cell.sheet());
+    QHash<Sheet*, RangeIndex<Cell>*>::ConstIterator cit = consumers.constFind(cell.sheet());
     if (cit == consumers.constEnd()) {
         processedCells.remove(cell);
         return;
@@ -602,9 +664,9 @@ void DependencyManager::Private::computeDependencies(const Cell& cell, const For
                     Sheet* sheet = region.firstSheet();
 
                     // create consumer tree, if not existing yet
-                    QHash<Sheet*, RTree<Cell>*>::iterator it = consumers.find(sheet);
+                    QHash<Sheet*, RangeIndex<Cell>*>::iterator it = consumers.find(sheet);
                     if (it == consumers.end()) {
-                        it = consumers.insert(sheet, new RTree<Cell>());
+                        it = consumers.insert(sheet, new RangeIndex<Cell>());
                     }
                     // add cell as consumer of the range
                     it.value()->insert(region.firstRange(), cell);
@@ -88,6 +88,19 @@ public:
      */
     Region consumingRegion(const Cell& cell) const;
 
+    /**
+     * Returns the cells, that need to be recalculated after values in
+     * \p region have changed, ordered by their reference depth.
+     *
+     * These are the cells in \p region, that have got a formula, and all
+     * cells consuming their values directly or indirectly. Each cell is
+     * visited once, i.e. the cost depends on the number of affected cells,
+     * not on the size of \p region or the depth of the dependency chains.
+     *
+     * \return the affected cells keyed by their reference depth
+     */
+    QMap<int, Cell> cellsToCalculate(const Region& region) const;
+
     /**
      * Returns the region, that is reduced to those parts of \p region, that provide values.
      * \return region providing values for others
@@ -29,7 +29,7 @@
 
 #include "Cell.h"
 #include "Region.h"
-#include "RTree.h"
+#include "RangeIndex.h"
 
 namespace Calligra
 {
@@ -96,6 +96,11 @@ public:
      */
     Region consumingRegion(const Cell& cell) const;
 
+    /**
+     * \see DependencyManager::cellsToCalculate(const Region&)
+     */
+    QMap<int, Cell> cellsToCalculate(const Region& region) const;
+
     void namedAreaModified(const QString& name);
 
     /**
@@ -140,7 +145,7 @@ public:
     // use QMap rather then QHash cause it's faster for our use-case
     QMap<Cell, Region> providers;
     // stores consuming cell locations ordered by their providing regions
-    QHash<Sheet*, RTree<Cell>*> consumers;
+    QHash<Sheet*, RangeIndex<Cell>*> consumers;
     // stores consuming cell locations ordered by their providing named area
     // (in addition to the general storage of the consuming cell locations)
     QHash<QString, QList<Cell> > namedAreaConsumers;
@@ -87,8 +87,9 @@ class Opcode
 {
 public:
 
+    // CellRange is a Range passed to a function as Value::CellRange
     enum { Nop = 0, Load, Ref, Cell, Range, Function, Add, Sub, Neg, Mul, Div,
-           Pow, Concat, Intersect, Not, Equal, Less, Greater, Array, Union
+           Pow, Concat, Intersect, Not, Equal, Less, Greater, Array, Union, CellRange
          };
 
     unsigned type;
@@ -99,6 +100,16 @@ public:
     Opcode(unsigned t, unsigned i): type(t), index(i) {}
 };
 
+// a function call, resolved once at compile time
+struct CompiledFunction {
+    CompiledFunction(): argCount(0) {}
+    CompiledFunction(const QString& n, const QSharedPointer<Function>& f, unsigned c)
+        : name(n), function(f), argCount(c) {}
+    QString name;
+    QSharedPointer<Function> function;
+    unsigned argCount;
+};
+
 // used when evaluation formulas
 struct stackEntry {
     void reset() {
@@ -122,8 +133,27 @@ public:
     QString expression;
     mutable QVector<Opcode> codes;
     mutable QVector<Value> constants;
+    // function calls, indexed by Opcode::Function
+    mutable QVector<CompiledFunction> functions;
+    // pre-parsed sheet-local references, indexed like the constants;
+    // invalid for references, that need to be resolved on evaluation
+    mutable QVector<Region> references;
+    // maximum number of stack entries needed to run the codes
+    mutable int stackDepth;
+    mutable int maxArgCount;
 
     Value valueOrElement(FuncExtra &fe, const stackEntry& entry) const;
+
+    /**
+     * Emits the call of the function \p name with \p argCount arguments.
+     */
+    void appendFunction(const QString& name, unsigned argCount, QStack<int>& functionStack) const;
+
+    /**
+     * Removes no-ops, folds constant arithmetic and computes the
+     * stack sizes needed for the evaluation.
+     */
+    void optimize() const;
 };
 
 class TokenStack : public QVector<Token>
@@ -623,6 +653,10 @@ void Formula::clear()
     d->valid = false;
     d->constants.clear();
     d->codes.clear();
+    d->functions.clear();
+    d->references.clear();
+    d->stackDepth = 0;
+    d->maxArgCount = 0;
 }
 
 // Returns list of token for the expression.
@@ -1080,12 +1114,17 @@ void Formula::compile(const Tokens& tokens) const
     d->valid = false;
     d->codes.clear();
     d->constants.clear();
+    d->functions.clear();
+    d->references.clear();
+    d->stackDepth = 0;
+    d->maxArgCount = 0;
 
     // sanity check
     if (tokens.count() == 0) return;
 
     TokenStack syntaxStack;
     QStack<int> argStack;
+    QStack<int> functionStack; // code positions of the function names
     unsigned argCount = 1;
 
     for (int i = 0; i <= tokens.count(); i++) {
@@ -1105,6 +1144,8 @@ void Formula::compile(const Tokens& tokens) const
                 if (id.isIdentifier()) {
                     argStack.push(argCount);
                     argCount = 1;
+                    // the function name was the last loaded reference
+                    functionStack.push(d->codes.count() - 1);
                 }
         }
 
@@ -1143,6 +1184,18 @@ void Formula::compile(const Tokens& tokens) const
                 d->codes.append(Opcode(Opcode::Range, d->constants.count() - 1));
             else
                 d->codes.append(Opcode(Opcode::Ref, d->constants.count() - 1));
+
+            // Parse references into the own sheet only once. Named areas and
+            // references into other sheets may change their meaning without
+            // the expression being touched and are resolved on evaluation.
+            if (tokenType != Token::Identifier && d->sheet &&
+                    !token.text().contains('!') && !isNamedArea(token.text())) {
+                const Region region(token.text(), d->sheet->map(), d->sheet);
+                if (region.isValid()) {
+                    d->references.resize(d->constants.count());
+                    d->references[d->constants.count() - 1] = region;
+                }
+            }
         }
 
         // special case for percentage
@@ -1225,7 +1278,7 @@ void Formula::compile(const Tokens& tokens) const
                                             syntaxStack.pop();
                                             syntaxStack.pop();
                                             syntaxStack.push(arg);
-                                            d->codes.append(Opcode(Opcode::Function, argCount));
+                                            d->appendFunction(id.text(), argCount, functionStack);
                                             Q_ASSERT(!argStack.empty());
                                             argCount = argStack.empty() ? 0 : argStack.pop();
                                         }
@@ -1246,7 +1299,7 @@ void Formula::compile(const Tokens& tokens) const
                                         syntaxStack.pop();
                                         syntaxStack.pop();
                                         syntaxStack.push(Token(Token::Integer));
-                                        d->codes.append(Opcode(Opcode::Function, 0));
+                                        d->appendFunction(id.text(), 0, functionStack);
                                         Q_ASSERT(!argStack.empty());
                                         argCount = argStack.empty() ? 0 : argStack.pop();
                                     }
@@ -1465,7 +1518,143 @@ void Formula::compile(const Tokens& tokens) const
     if (!d->valid) {
         d->constants.clear();
         d->codes.clear();
+        d->functions.clear();
+        d->references.clear();
+        return;
     }
+
+    d->references.resize(d->constants.count());
+    d->optimize();
+}
+
+void Formula::Private::appendFunction(const QString& name, unsigned argCount, QStack<int>& functionStack) const
+{
+    // The function gets resolved here once. Its name does not need to be
+    // loaded onto the stack anymore.
+    Q_ASSERT(!functionStack.isEmpty());
+    if (!functionStack.isEmpty()) {
+        const int pos = functionStack.pop();
+        Q_ASSERT(codes[pos].type == Opcode::Ref);
+        codes[pos] = Opcode(Opcode::Nop);
+    }
+    functions.append(CompiledFunction(name, FunctionRepository::self()->function(name), argCount));
+    codes.append(Opcode(Opcode::Function, functions.count() - 1));
+}
+
+void Formula::Private::optimize() const
+{
+    ValueCalc* calc = sheet ? sheet->map()->calc() : 0;
+
+    QVector<Opcode> result;
+    result.reserve(codes.count());
+    // the positions of the opcodes in result, which pushed the stack entries
+    QVector<int> producers;
+    int depth = 0;
+    stackDepth = 0;
+    maxArgCount = 0;
+    for (int pc = 0; pc < codes.count(); ++pc) {
+        const Opcode& opcode = codes[pc];
+        const int count = result.count();
+        // the stack entries taken by the opcode
+        int pops = 0;
+        switch (opcode.type) {
+        case Opcode::Nop:
+            continue;
+
+        case Opcode::Neg:
+            if (calc && count >= 1 && result[count - 1].type == Opcode::Load) {
+                const Value& value = constants[result[count - 1].index];
+                if (value.isInteger() || value.isFloat()) {
+                    constants.append(calc->mul(value, -1));
+                    result[count - 1] = Opcode(Opcode::Load, constants.count() - 1);
+                    continue;
+                }
+            }
+            pops = 1;
+            break;
+
+        case Opcode::Add:
+        case Opcode::Sub:
+        case Opcode::Mul:
+        case Opcode::Div:
+        case Opcode::Pow:
+            depth--;
+            if (calc && count >= 2 && result[count - 1].type == Opcode::Load &&
+                    result[count - 2].type == Opcode::Load) {
+                const Value& val1 = constants[result[count - 2].index];
+                const Value& val2 = constants[result[count - 1].index];
+                if ((val1.isInteger() || val1.isFloat()) && (val2.isInteger() || val2.isFloat())) {
+                    Value folded;
+                    switch (opcode.type) {
+                    case Opcode::Add: folded = calc->add(val1, val2); break;
+                    case Opcode::Sub: folded = calc->sub(val1, val2); break;
+                    case Opcode::Mul: folded = calc->mul(val1, val2); break;
+                    case Opcode::Div: folded = calc->div(val1, val2); break;
+                    default:          folded = calc->pow(val1, val2); break;
+                    }
+                    constants.append(folded);
+                    result.resize(count - 1);
+                    result[count - 2] = Opcode(Opcode::Load, constants.count() - 1);
+                    // the folded constant replaces both operands
+                    producers.resize(qMax(0, producers.count() - 1));
+                    continue;
+                }
+            }
+            pops = 2;
+            break;
+
+        case Opcode::Load:
+        case Opcode::Ref:
+        case Opcode::Cell:
+        case Opcode::Range:
+        case Opcode::CellRange:
+            depth++;
+            break;
+
+        case Opcode::Concat:
+        case Opcode::Intersect:
+        case Opcode::Union:
+        case Opcode::Equal:
+        case Opcode::Less:
+        case Opcode::Greater:
+            depth--;
+            pops = 2;
+            break;
+
+        case Opcode::Function: {
+            const CompiledFunction& call = functions[opcode.index];
+            const int argCount = call.argCount;
+            maxArgCount = qMax(maxArgCount, argCount);
+            depth += 1 - argCount;
+            pops = argCount;
+            // the values of cell ranges are not fetched for functions, which read them themselves
+            if (call.function && producers.count() >= argCount) {
+                const int first = producers.count() - argCount;
+                for (int i = 0; i < argCount; ++i) {
+                    Opcode& producer = result[producers[first + i]];
+                    if (producer.type == Opcode::Range && call.function->acceptsCellRange(i))
+                        producer.type = Opcode::CellRange;
+                }
+            }
+            break;
+        }
+
+        case Opcode::Array:
+            pops = constants[opcode.index].asInteger() * constants[opcode.index + 1].asInteger();
+            depth += 1 - pops;
+            break;
+
+        default:
+            pops = 1;
+            break;
+        }
+        result.append(opcode);
+        producers.resize(qMax(0, producers.count() - pops));
+        producers.append(result.count() - 1);
+        stackDepth = qMax(stackDepth, depth);
+    }
+    codes = result;
+    references.resize(constants.count());
 }
 
 bool Formula::isNamedArea(const QString& expr) const
@@ -1560,6 +1749,9 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
     if (!d->valid)
         return Value::errorPARSE();
 
+    stack.reserve(d->stackDepth);
+    args.reserve(d->maxArgCount);
+
     for (int pc = 0; pc < d->codes.count(); pc++) {
         Value ret;   // for the function caller
         Opcode& opcode = d->codes[pc];
@@ -1766,7 +1958,8 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
             val1 = Value::empty();
             entry.reset();
 
-            const Region region(c, map, d->sheet);
+            const bool resolved = d->references[index].isValid();
+            const Region region = resolved ? d->references[index] : Region(c, map, d->sheet);
             if (!region.isValid()) {
                 val1 = Value::errorREF();
             } else if (region.isSingular()) {
@@ -1791,7 +1984,7 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
                 entry.col1 = entry.col2 = position.x();
                 entry.row1 = entry.row2 = position.y();
                 entry.reg = region;
-                entry.regIsNamedOrLabeled = map->namedAreaManager()->contains(c);
+                entry.regIsNamedOrLabeled = !resolved && map->namedAreaManager()->contains(c);
             } else {
                 warnSheets << "Unhandled non singular region in Opcode::Cell with rects=" << region.rects();
             }
@@ -1801,21 +1994,27 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
         break;
 
         // selected range in a sheet
-        case Opcode::Range: {
+        case Opcode::Range:
+        case Opcode::CellRange: {
             c = d->constants[index].asString();
             val1 = Value::empty();
             entry.reset();
 
-            const Region region(c, map, d->sheet);
+            const bool resolved = d->references[index].isValid();
+            const Region region = resolved ? d->references[index] : Region(c, map, d->sheet);
             if (region.isValid()) {
-                val1 = region.firstSheet()->cellStorage()->valueRegion(region);
+                // the function fetches the values of a CellRange itself, if needed
+                if (opcode.type == Opcode::CellRange)
+                    val1 = Value(Value::CellRange);
+                else
+                    val1 = region.firstSheet()->cellStorage()->valueRegion(region);
                 // store the reference, so we can use it within functions
                 entry.col1 = region.firstRange().left();
                 entry.row1 = region.firstRange().top();
                 entry.col2 = region.firstRange().right();
                 entry.row2 = region.firstRange().bottom();
                 entry.reg = region;
-                entry.regIsNamedOrLabeled = map->namedAreaManager()->contains(c);
+                entry.regIsNamedOrLabeled = !resolved && map->namedAreaManager()->contains(c);
             }
 
             entry.val = val1; // any array is valid here
@@ -1832,13 +2031,15 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
             break;
 
             // calling function
-        case Opcode::Function:
+        case Opcode::Function: {
+            const CompiledFunction& call = d->functions[index];
+            index = call.argCount;
             // sanity check, this should not happen unless opcode is wrong
             // (i.e. there's a bug in the compile() function)
             if (stack.count() < index)
                 return Value::errorVALUE(); // not enough arguments
 
-            args.clear();
+            args.resize(index);
             fe.ranges.clear();
             fe.ranges.resize(index);
             fe.regions.clear();
@@ -1846,7 +2047,7 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
             fe.sheet = d->sheet;
             for (; index; index--) {
                 stackEntry e = stack.pop();
-                args.insert(args.begin(), e.val);
+                args[index - 1] = e.val;
                 // fill the FunctionExtra object
                 fe.ranges[index - 1].col1 = e.col1;
                 fe.ranges[index - 1].row1 = e.row1;
@@ -1855,11 +2056,9 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
                 fe.regions[index - 1] = e.reg;
             }
 
-            // function name as string value
-            val1 = converter->asString(stack.pop().val);
-            if (val1.isError())
-                return val1;
-            function = FunctionRepository::self()->function(val1.asString());
+            // the function was resolved on compilation; a function module
+            // may have been loaded later on, though
+            function = call.function ? call.function : FunctionRepository::self()->function(call.name);
             if (!function)
                 return Value::errorNAME(); // no such function
 
@@ -1869,6 +2068,7 @@ Value Formula::evalRecursive(CellIndirection cellIndirections, QHash<Cell, Value
             stack.push(entry);
 
             break;
+        }
 
 #ifdef CALLIGRA_SHEETS_INLINE_ARRAYS
             // creating an array
@@ -1953,7 +2153,7 @@ QString Formula::dump() const
         switch (d->codes[i].type) {
         case Opcode::Load:      ctext = QString("Load #%1").arg(d->codes[i].index); break;
         case Opcode::Ref:       ctext = QString("Ref #%1").arg(d->codes[i].index); break;
-        case Opcode::Function:  ctext = QString("Function (%1)").arg(d->codes[i].index); break;
+        case Opcode::Function:  ctext = QString("Function %1 (%2)").arg(d->functions[d->codes[i].index].name).arg(d->functions[d->codes[i].index].argCount); break;
         case Opcode::Add:       ctext = "Add"; break;
         case Opcode::Sub:       ctext = "Sub"; break;
         case Opcode::Mul:       ctext = "Mul"; break;
@@ -1970,6 +2170,7 @@ QString Formula::dump() const
         case Opcode::Nop:       ctext = "Nop"; break;
         case Opcode::Cell:      ctext = "Cell"; break;
         case Opcode::Range:     ctext = "Range"; break;
+        case Opcode::CellRange: ctext = "CellRange"; break;
         default: ctext = "Unknown"; break;
         }
         result.append("   ").append(ctext).append("\n");
@@ -21,6 +21,8 @@
 // Local
 #include "Function.h"
 
+#include "CellStorage.h"
+#include "Sheet.h"
 #include "Value.h"
 
 using namespace Calligra::Sheets;
@@ -33,6 +35,8 @@ public:
     FunctionPtr ptr;
     int paramMin, paramMax;
     bool acceptArray;
+    // the positions of the cell ranges passed without their values; -1 for all
+    QList<int> cellRangePositions;
     bool ne;   // need FunctionExtra* when called ?
 };
 
@@ -90,6 +94,17 @@ void Function::setAcceptArray(bool accept)
     d->acceptArray = accept;
 }
 
+void Function::setAcceptCellRange(int position)
+{
+    if (!d->cellRangePositions.contains(position))
+        d->cellRangePositions.append(position);
+}
+
+bool Function::acceptsCellRange(int position) const
+{
+    return d->cellRangePositions.contains(-1) || d->cellRangePositions.contains(position);
+}
+
 bool Function::needsExtra()
 {
     return d->ne;
@@ -160,6 +175,17 @@ Value Function::exec(valVector args, ValueCalc *calc, FuncExtra *extra)
         return (*d->ptr)(args, calc, extra);
 }
 
+Value Calligra::Sheets::argumentValue(const valVector& args, const FuncExtra* extra, int position)
+{
+    const Value& arg = args[position];
+    if (arg.type() != Value::CellRange)
+        return arg;
+    if (!extra || position >= extra->regions.count() || !extra->regions[position].isValid())
+        return Value::errorREF();
+    const Region& region = extra->regions[position];
+    return region.firstSheet()->cellStorage()->valueRegion(region);
+}
+
 FunctionCaller::FunctionCaller(FunctionPtr ptr, const valVector &args, ValueCalc *calc, FuncExtra *extra)
     : m_ptr(ptr), m_args(args), m_calc(calc), m_extra(extra)
 {
@@ -82,6 +82,12 @@ public:
     false, the auto-array mechamism will be used for arrays (so the
     function will receive simple values, not arrays). */
     void setAcceptArray(bool accept = true);
+    /** lets the cell range argument at \p position , or at any position if
+    it is -1, be passed as a value of type Value::CellRange instead of the
+    values of its cells. FuncExtra::regions holds the range; the function
+    fetches the values it needs itself, e.g. with argumentValue(). */
+    void setAcceptCellRange(int position = -1);
+    bool acceptsCellRange(int position) const;
     bool needsExtra();
     void setNeedsExtra(bool extra);
     QString name() const;
@@ -100,6 +106,14 @@ private:
     Private * const d;
 };
 
+/**
+ * \ingroup Value
+ * \return the argument at \p position of a function or the values of its
+ * cells, if it is a cell range passed as Value::CellRange
+ * \see Function::setAcceptCellRange
+ */
+CALLIGRA_SHEETS_ODF_EXPORT Value argumentValue(const valVector& args, const FuncExtra* extra, int position);
+
 /**
  * \ingroup Value
  * A helper-class to call a function.
@@ -0,0 +1,344 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "LookupCache.h"
+
+#ifdef CALLIGRA_SHEETS_MT
+#include <QMutex>
+#include <QMutexLocker>
+#endif
+
+#include <algorithm>
+
+#include "RangeIndex.h"
+#include "ValueStorage.h"
+
+using namespace Calligra::Sheets;
+
+// Shorter vectors are searched linearly.
+static const int s_minimumIndexSize = 32;
+// The maximum number of indexed positions per sheet.
+static const int s_maximumCost = 1 << 22;
+
+static bool numberLowerThan(const QPair<Number, int>& entry, const Number& number)
+{
+    return entry.first < number;
+}
+
+// The order of Value::compare, which treats numbers closer than DBL_EPSILON as equal.
+static bool numberLowerThanKey(const QPair<Number, int>& entry, const Number& key)
+{
+    return Value::compare(key, entry.first) > 0;
+}
+
+static bool stringLowerThan(const QPair<QString, int>& entry, const QString& string)
+{
+    return entry.first < string;
+}
+
+LookupIndex::LookupIndex(const Value& data, Qt::Orientation orientation)
+        : m_firstFalse(-1)
+        , m_firstTrue(-1)
+        , m_valid(true)
+{
+    m_count = (orientation == Qt::Vertical) ? data.rows() : data.columns();
+    for (int i = 0; i < m_count && m_valid; ++i)
+        add(i, (orientation == Qt::Vertical) ? data.element(0, i) : data.element(i, 0));
+    finish();
+}
+
+LookupIndex::LookupIndex(const ValueStorage& values, const QRect& range, Qt::Orientation orientation)
+        : m_firstFalse(-1)
+        , m_firstTrue(-1)
+        , m_valid(true)
+{
+    // only the used cells of the vector are visited
+    if (orientation == Qt::Vertical) {
+        const int column = range.left();
+        m_count = range.height();
+        int row = range.top();
+        Value value = values.lookup(column, row);
+        while (row != 0 && row <= range.bottom() && m_valid) {
+            add(row - range.top(), value);
+            value = values.nextInColumn(column, row, &row);
+        }
+    } else {
+        const int row = range.top();
+        m_count = range.width();
+        int column = range.left();
+        Value value = values.lookup(column, row);
+        while (column != 0 && column <= range.right() && m_valid) {
+            add(column - range.left(), value);
+            value = values.nextInRow(column, row, &column);
+        }
+    }
+    finish();
+}
+
+void LookupIndex::add(int position, const Value& value)
+{
+    switch (value.type()) {
+    case Value::Empty:
+        break;
+    case Value::Boolean:
+        if (value.asBoolean() && m_firstTrue == -1)
+            m_firstTrue = position;
+        else if (!value.asBoolean() && m_firstFalse == -1)
+            m_firstFalse = position;
+        break;
+    case Value::Integer:
+    case Value::Float:
+        m_numbers.append(qMakePair(value.asFloat(), position));
+        break;
+    case Value::String: {
+        const QString string = value.asString();
+        m_strings.append(qMakePair(string, position));
+        if (!m_exactStrings.contains(string))
+            m_exactStrings.insert(string, position);
+        const QString folded = string.toLower();
+        if (!m_foldedStrings.contains(folded))
+            m_foldedStrings.insert(folded, position);
+        break;
+    }
+    default:
+        m_valid = false;
+        break;
+    }
+}
+
+void LookupIndex::finish()
+{
+    if (!m_valid) {
+        m_numbers.clear();
+        m_strings.clear();
+        m_exactStrings.clear();
+        m_foldedStrings.clear();
+        return;
+    }
+    std::sort(m_numbers.begin(), m_numbers.end());
+    std::sort(m_strings.begin(), m_strings.end());
+}
+
+bool LookupIndex::isValid() const
+{
+    return m_valid;
+}
+
+int LookupIndex::count() const
+{
+    return m_count;
+}
+
+bool LookupIndex::isIndexable(const Value& key)
+{
+    switch (key.type()) {
+    case Value::Boolean:
+    case Value::Integer:
+    case Value::Float:
+        return true;
+    case Value::String:
+        // an empty string equals empty cells
+        return !key.asString().isEmpty();
+    default:
+        return false;
+    }
+}
+
+int LookupIndex::find(const Value& key, bool caseSensitive) const
+{
+    switch (key.type()) {
+    case Value::Boolean:
+        return key.asBoolean() ? m_firstTrue : m_firstFalse;
+    case Value::Integer:
+    case Value::Float: {
+        const Number number = key.asFloat();
+        QVector<NumberEntry>::ConstIterator it = std::lower_bound(m_numbers.constBegin(), m_numbers.constEnd(),
+                                                                   number, numberLowerThanKey);
+        int position = -1;
+        for (; it != m_numbers.constEnd() && Value::compare(number, it->first) == 0; ++it) {
+            if (position == -1 || it->second < position)
+                position = it->second;
+        }
+        return position;
+    }
+    case Value::String:
+        if (caseSensitive)
+            return m_exactStrings.value(key.asString(), -1);
+        return m_foldedStrings.value(key.asString().toLower(), -1);
+    default:
+        return -1;
+    }
+}
+
+int LookupIndex::findLower(const Value& key) const
+{
+    QVector<NumberEntry>::ConstIterator numbersEnd = m_numbers.constEnd();
+    QVector<StringEntry>::ConstIterator stringsEnd = m_strings.constEnd();
+    switch (key.type()) {
+    case Value::Boolean:
+        if (key.asBoolean() && m_firstFalse != -1)
+            return m_firstFalse;
+        break;
+    case Value::Integer:
+    case Value::Float:
+        // only numbers are lower than numbers
+        numbersEnd = std::lower_bound(m_numbers.constBegin(), m_numbers.constEnd(),
+                                      key.asFloat(), numberLowerThanKey);
+        stringsEnd = m_strings.constBegin();
+        break;
+    case Value::String:
+        stringsEnd = std::lower_bound(m_strings.constBegin(), m_strings.constEnd(),
+                                      key.asString(), stringLowerThan);
+        break;
+    default:
+        return -1;
+    }
+    // the greatest candidate; the first position of it
+    if (stringsEnd != m_strings.constBegin()) {
+        const QString& greatest = (stringsEnd - 1)->first;
+        return std::lower_bound(m_strings.constBegin(), stringsEnd, greatest, stringLowerThan)->second;
+    }
+    if (numbersEnd != m_numbers.constBegin()) {
+        const Number greatest = (numbersEnd - 1)->first;
+        return std::lower_bound(m_numbers.constBegin(), numbersEnd, greatest, numberLowerThan)->second;
+    }
+    return -1;
+}
+
+
+class Q_DECL_HIDDEN LookupCache::Private
+{
+public:
+    struct Entry {
+        QRect vector;
+        QSharedPointer<const LookupIndex> index;
+    };
+
+    static quint64 key(const QRect& vector, Qt::Orientation orientation);
+    void remove(quint64 key);
+
+    QHash<quint64, Entry> entries;
+    // the keys of the entries by their lookup vector
+    RangeIndex<quint64> vectors;
+    int cost;
+#ifdef CALLIGRA_SHEETS_MT
+    QMutex mutex;
+#endif
+};
+
+quint64 LookupCache::Private::key(const QRect& vector, Qt::Orientation orientation)
+{
+    // 15 bits for the column, 21 bits for the row and the length
+    const int length = (orientation == Qt::Vertical) ? vector.height() : vector.width();
+    return (quint64(orientation == Qt::Vertical) << 63) | (quint64(vector.left()) << 42)
+           | (quint64(vector.top()) << 21) | quint64(length);
+}
+
+void LookupCache::Private::remove(quint64 key)
+{
+    QHash<quint64, Entry>::Iterator it = entries.find(key);
+    if (it == entries.end())
+        return;
+    vectors.remove(it.value().vector, key);
+    cost -= it.value().index->count();
+    entries.erase(it);
+}
+
+LookupCache::LookupCache()
+        : d(new Private)
+{
+    d->cost = 0;
+}
+
+LookupCache::~LookupCache()
+{
+    delete d;
+}
+
+QSharedPointer<const LookupIndex> LookupCache::index(const QRect& range, const Value& data, Qt::Orientation orientation)
+{
+    // the values have to be the ones of the range
+    if (range.width() != int(data.columns()) || range.height() != int(data.rows()))
+        return QSharedPointer<const LookupIndex>();
+    return index(range, &data, 0, orientation);
+}
+
+QSharedPointer<const LookupIndex> LookupCache::index(const QRect& range, const ValueStorage& values, Qt::Orientation orientation)
+{
+    return index(range, 0, &values, orientation);
+}
+
+QSharedPointer<const LookupIndex> LookupCache::index(const QRect& range, const Value* data, const ValueStorage* values,
+                                                     Qt::Orientation orientation)
+{
+    const QRect vector = (orientation == Qt::Vertical)
+                         ? QRect(range.left(), range.top(), 1, range.height())
+                         : QRect(range.left(), range.top(), range.width(), 1);
+    const int length = (orientation == Qt::Vertical) ? vector.height() : vector.width();
+    if (length < s_minimumIndexSize)
+        return QSharedPointer<const LookupIndex>();
+
+#ifdef CALLIGRA_SHEETS_MT
+    QMutexLocker locker(&d->mutex);
+#endif
+    const quint64 key = Private::key(vector, orientation);
+    QHash<quint64, Private::Entry>::ConstIterator it = d->entries.constFind(key);
+    if (it == d->entries.constEnd()) {
+        if (d->cost + length > s_maximumCost) {
+            d->entries.clear();
+            d->vectors.clear();
+            d->cost = 0;
+        }
+        Private::Entry entry;
+        entry.vector = vector;
+        if (data)
+            entry.index = QSharedPointer<const LookupIndex>(new LookupIndex(*data, orientation));
+        else
+            entry.index = QSharedPointer<const LookupIndex>(new LookupIndex(*values, vector, orientation));
+        d->vectors.insert(vector, key);
+        d->cost += length;
+        it = d->entries.insert(key, entry);
+    }
+    // indices of unordered values are kept to not rebuild them each time
+    if (!it.value().index->isValid())
+        return QSharedPointer<const LookupIndex>();
+    return it.value().index;
+}
+
+void LookupCache::regionChanged(const QRect& rect)
+{
+#ifdef CALLIGRA_SHEETS_MT
+    QMutexLocker locker(&d->mutex);
+#endif
+    if (d->entries.isEmpty())
+        return;
+    const QList<quint64> keys = d->vectors.intersects(rect);
+    for (int i = 0; i < keys.count(); ++i)
+        d->remove(keys[i]);
+}
+
+void LookupCache::clear()
+{
+#ifdef CALLIGRA_SHEETS_MT
+    QMutexLocker locker(&d->mutex);
+#endif
+    d->entries.clear();
+    d->vectors.clear();
+    d->cost = 0;
+}
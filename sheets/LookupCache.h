@@ -0,0 +1,165 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_LOOKUP_CACHE
+#define CALLIGRA_SHEETS_LOOKUP_CACHE
+
+#include <QHash>
+#include <QPair>
+#include <QRect>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include "Number.h"
+#include "Value.h"
+
+#include "sheets_odf_export.h"
+
+namespace Calligra
+{
+namespace Sheets
+{
+class ValueStorage;
+
+/**
+ * \ingroup Value
+ * An index of the values of a lookup vector, i.e. the first column or row
+ * of the range searched by VLOOKUP, HLOOKUP or MATCH.
+ *
+ * The positions found are the same as the ones of a linear search using
+ * ValueCalc::naturalEqual and ValueCalc::naturalLower: the first position
+ * of an equal value resp. the first position of the greatest value lower
+ * than the key. Numbers sort before strings, strings before booleans.
+ * Empty cells never match.
+ */
+class CALLIGRA_SHEETS_ODF_EXPORT LookupIndex
+{
+public:
+    /**
+     * Indexes the first column (Qt::Vertical) or the first row
+     * (Qt::Horizontal) of \p data .
+     */
+    LookupIndex(const Value& data, Qt::Orientation orientation);
+
+    /**
+     * Indexes the first column (Qt::Vertical) or the first row
+     * (Qt::Horizontal) of the cell range \p range in \p values .
+     */
+    LookupIndex(const ValueStorage& values, const QRect& range, Qt::Orientation orientation);
+
+    /**
+     * \return \c false , if the vector contains values without an ordering,
+     * like errors, which only a linear search handles correctly
+     */
+    bool isValid() const;
+
+    /**
+     * \return the number of indexed positions
+     */
+    int count() const;
+
+    /**
+     * \return \c true for the keys the index is able to look up, i.e.
+     * numbers, booleans and non-empty strings
+     */
+    static bool isIndexable(const Value& key);
+
+    /**
+     * \return the first position of a value equal to \p key or -1
+     */
+    int find(const Value& key, bool caseSensitive = true) const;
+
+    /**
+     * \return the first position of the greatest value lower than \p key or -1
+     */
+    int findLower(const Value& key) const;
+
+private:
+    void add(int position, const Value& value);
+    void finish();
+
+    typedef QPair<Number, int> NumberEntry;
+    typedef QPair<QString, int> StringEntry;
+
+    // sorted by value, then position
+    QVector<NumberEntry> m_numbers;
+    QVector<StringEntry> m_strings;
+    // the first position of each string
+    QHash<QString, int> m_exactStrings;
+    QHash<QString, int> m_foldedStrings;
+    int m_firstFalse;
+    int m_firstTrue;
+    int m_count;
+    bool m_valid;
+};
+
+/**
+ * \ingroup Value
+ * Caches the LookupIndex of lookup vectors of a sheet.
+ *
+ * The CellStorage owns the cache and drops the indices of changed cell ranges
+ * immediately, i.e. before dependent cells get recalculated.
+ */
+class CALLIGRA_SHEETS_ODF_EXPORT LookupCache
+{
+public:
+    LookupCache();
+    ~LookupCache();
+
+    /**
+     * \return the index of the first column (Qt::Vertical) or the first row
+     * (Qt::Horizontal) of the cell range \p range , whose values are \p data .
+     * The index gets created, if it is not cached yet. A null pointer is
+     * returned, if the vector is too short to be worth an index or if it
+     * can not be indexed.
+     */
+    QSharedPointer<const LookupIndex> index(const QRect& range, const Value& data, Qt::Orientation orientation);
+
+    /**
+     * \return the index of the first column (Qt::Vertical) or the first row
+     * (Qt::Horizontal) of the cell range \p range like above, whose values
+     * are read from \p values , if the index gets created.
+     */
+    QSharedPointer<const LookupIndex> index(const QRect& range, const ValueStorage& values, Qt::Orientation orientation);
+
+    /**
+     * Drops the indices of the lookup vectors intersecting \p rect .
+     */
+    void regionChanged(const QRect& rect);
+
+    /**
+     * Drops all indices.
+     */
+    void clear();
+
+private:
+    Q_DISABLE_COPY(LookupCache)
+
+    QSharedPointer<const LookupIndex> index(const QRect& range, const Value* data, const ValueStorage* values,
+                                            Qt::Orientation orientation);
+
+    class Private;
+    Private * const d;
+};
+
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_LOOKUP_CACHE
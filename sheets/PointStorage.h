@@ -61,6 +61,10 @@ namespace Sheets
  * \note For data assigned to rectangular regions use RectStorage.
  * \note It's QVector based. To boost performance a lot, declare the stored
  *       data type as movable.
+ * \note Structural edits are linear in the amount of data, which moves:
+ *       inserting or removing rows and shifting cells up or down move all
+ *       data and row offsets from the edited row on, the column moves
+ *       rewrite the affected rows.
  */
 template<typename T>
 class PointStorage
@@ -188,14 +192,13 @@ public:
         // row's missing?
         if (row > m_rows.count())
             return defaultVal;
-        const int rowStart = (row - 1 < m_rows.count()) ? m_rows.value(row - 1) : m_data.count();
-        const int rowLength = (row < m_rows.count()) ? m_rows.value(row) - rowStart : -1;
-        const QVector<int> cols = m_cols.mid(rowStart, rowLength);
-        QVector<int>::const_iterator cit = qBinaryFind(cols, col);
+        const QVector<int>::const_iterator cstart(m_cols.constBegin() + m_rows.value(row - 1));
+        const QVector<int>::const_iterator cend((row < m_rows.count()) ? (m_cols.constBegin() + m_rows.value(row)) : m_cols.constEnd());
+        const QVector<int>::const_iterator cit = qBinaryFind(cstart, cend, col);
         // column's missing?
-        if (cit == cols.constEnd())
+        if (cit == cend)
             return defaultVal;
-        const int index = rowStart + (cit - cols.constBegin());
+        const int index = cit - m_cols.constBegin();
         // save the old data
         const T oldData = m_data[ index ];
         // remove the actual data
@@ -215,25 +218,7 @@ public:
      */
     QVector< QPair<QPoint, T> > insertColumns(int position, int number) {
         Q_ASSERT(1 <= position && position <= KS_colMax);
-        QVector< QPair<QPoint, T> > oldData;
-        for (int row = m_rows.count(); row >= 1; --row) {
-            const int rowStart = m_rows.value(row - 1);
-            const int rowLength = (row < m_rows.count()) ? m_rows.value(row) - rowStart : -1;
-            const QVector<int> cols = m_cols.mid(rowStart, rowLength);
-            for (int col = cols.count(); col >= 0; --col) {
-                if (cols.value(col) + number > KS_colMax) {
-                    oldData.append(qMakePair(QPoint(cols.value(col), row), m_data.value(rowStart + col)));
-                    m_cols.remove(rowStart + col);
-                    m_data.remove(rowStart + col);
-                    // adjust the offsets of the following rows
-                    for (int r = row; r < m_rows.count(); ++r)
-                        --m_rows[r];
-                } else if (cols.value(col) >= position)
-                    m_cols[rowStart + col] += number;
-            }
-        }
-        squeezeRows();
-        return oldData;
+        return shiftColumns(1, KS_rowMax, position, number);
     }
 
     /**
@@ -242,26 +227,7 @@ public:
      */
     QVector< QPair<QPoint, T> > removeColumns(int position, int number) {
         Q_ASSERT(1 <= position && position <= KS_colMax);
-        QVector< QPair<QPoint, T> > oldData;
-        for (int row = m_rows.count(); row >= 1; --row) {
-            const int rowStart = m_rows.value(row - 1);
-            const int rowLength = (row < m_rows.count()) ? m_rows.value(row) - rowStart : -1;
-            const QVector<int> cols = m_cols.mid(rowStart, rowLength);
-            for (int col = cols.count() - 1; col >= 0; --col) {
-                if (cols.value(col) >= position) {
-                    if (cols.value(col) < position + number) {
-                        oldData.append(qMakePair(QPoint(cols.value(col), row), m_data.value(rowStart + col)));
-                        m_cols.remove(rowStart + col);
-                        m_data.remove(rowStart + col);
-                        for (int r = row; r < m_rows.count(); ++r)
-                            --m_rows[r];
-                    } else
-                        m_cols[rowStart + col] -= number;
-                }
-            }
-        }
-        squeezeRows();
-        return oldData;
+        return shiftColumns(1, KS_rowMax, position, -number);
     }
 
     /**
@@ -292,10 +258,11 @@ public:
         }
         while (rowCount-- > 0)
             m_rows.remove(m_rows.count() - 1);
-        // insert the new rows
-        const int index = m_rows.value(position - 1);
-        for (int r = 0; r < number; ++r)
-            m_rows.insert(position, index);
+        // insert the new rows, unless all following rows were shifted out of range
+        if (position <= m_rows.count()) {
+            const int index = m_rows.value(position - 1);
+            m_rows.insert(position, number, index);
+        }
         squeezeRows();
         return oldData;
     }
@@ -315,24 +282,19 @@ public:
         // save the old data
         for (int row = position; row <= m_rows.count() && row <= position + number - 1; ++row) {
             const int rowStart = m_rows.value(row - 1);
-            const int rowLength = (row < m_rows.count()) ? m_rows.value(row) - rowStart : -1;
-            const QVector<int> cols = m_cols.mid(rowStart, rowLength);
-            const QVector<T> data = m_data.mid(rowStart, rowLength);
-            for (int col = 0; col < cols.count(); ++col)
-                oldData.append(qMakePair(QPoint(cols.value(col), row), data.value(col)));
-            dataCount += data.count();
+            const int rowEnd = (row < m_rows.count()) ? m_rows.value(row) : m_data.count();
+            for (int index = rowStart; index < rowEnd; ++index)
+                oldData.append(qMakePair(QPoint(m_cols.value(index), row), m_data.value(index)));
+            dataCount += rowEnd - rowStart;
             ++rowCount;
         }
         // adjust the offsets of the following rows
         for (int r = position + number - 1; r < m_rows.count(); ++r)
             m_rows[r] -= dataCount;
-        // remove the out of range data
-        while (dataCount-- > 0) {
-            m_data.remove(m_rows.value(position - 1));
-            m_cols.remove(m_rows.value(position - 1));
-        }
-        while (rowCount-- > 0)
-            m_rows.remove(position - 1);
+        // remove the out of range data at once
+        m_data.remove(m_rows.value(position - 1), dataCount);
+        m_cols.remove(m_rows.value(position - 1), dataCount);
+        m_rows.remove(position - 1, rowCount);
         squeezeRows();
         return oldData;
     }
@@ -344,26 +306,7 @@ public:
      */
     QVector< QPair<QPoint, T> > removeShiftLeft(const QRect& rect) {
         Q_ASSERT(1 <= rect.left() && rect.left() <= KS_colMax);
-        QVector< QPair<QPoint, T> > oldData;
-        for (int row = qMin(rect.bottom(), m_rows.count()); row >= rect.top(); --row) {
-            const int rowStart = m_rows.value(row - 1);
-            const int rowLength = (row < m_rows.count()) ? m_rows.value(row) - rowStart : -1;
-            const QVector<int> cols = m_cols.mid(rowStart, rowLength);
-            for (int col = cols.count() - 1; col >= 0; --col) {
-                if (cols.value(col) >= rect.left()) {
-                    if (cols.value(col) <= rect.right()) {
-                        oldData.append(qMakePair(QPoint(cols.value(col), row), m_data.value(rowStart + col)));
-                        m_cols.remove(rowStart + col);
-                        m_data.remove(rowStart + col);
-                        for (int r = row; r < m_rows.count(); ++r)
-                            --m_rows[r];
-                    } else
-                        m_cols[rowStart + col] -= rect.width();
-                }
-            }
-        }
-        squeezeRows();
-        return oldData;
+        return shiftColumns(rect.top(), rect.bottom(), rect.left(), -rect.width());
     }
 
     /**
@@ -372,25 +315,7 @@ public:
      */
     QVector< QPair<QPoint, T> > insertShiftRight(const QRect& rect) {
         Q_ASSERT(1 <= rect.left() && rect.left() <= KS_colMax);
-        QVector< QPair<QPoint, T> > oldData;
-        for (int row = rect.top(); row <= rect.bottom() && row <= m_rows.count(); ++row) {
-            const int rowStart = m_rows.value(row - 1);
-            const int rowLength = (row < m_rows.count()) ? m_rows.value(row) - rowStart : -1;
-            const QVector<int> cols = m_cols.mid(rowStart, rowLength);
-            for (int col = cols.count(); col >= 0; --col) {
-                if (cols.value(col) + rect.width() > KS_colMax) {
-                    oldData.append(qMakePair(QPoint(cols.value(col), row), m_data.value(rowStart + col)));
-                    m_cols.remove(rowStart + col);
-                    m_data.remove(rowStart + col);
-                    // adjust the offsets of the following rows
-                    for (int r = row; r < m_rows.count(); ++r)
-                        --m_rows[r];
-                } else if (cols.value(col) >= rect.left())
-                    m_cols[rowStart + col] += rect.width();
-            }
-        }
-        squeezeRows();
-        return oldData;
+        return shiftColumns(rect.top(), rect.bottom(), rect.left(), rect.width());
     }
 
     /**
@@ -400,96 +325,7 @@ public:
      */
     QVector< QPair<QPoint, T> > removeShiftUp(const QRect& rect) {
         Q_ASSERT(1 <= rect.top() && rect.top() <= KS_rowMax);
-        // row's missing?
-        if (rect.top() > m_rows.count())
-            return QVector< QPair<QPoint, T> >();
-        QVector< QPair<QPoint, T> > oldData;
-        for (int row = rect.top(); row <= m_rows.count() && row <= KS_rowMax - rect.height(); ++row) {
-            const int rowStart = m_rows.value(row - 1);
-            const int rowLength = (row < m_rows.count()) ? m_rows.value(row) - rowStart : -1;
-            const QVector<int> cols = m_cols.mid(rowStart, rowLength);
-            const QVector<T> data = m_data.mid(rowStart, rowLength);
-            // first, iterate over the destination row
-            for (int col = cols.count() - 1; col >= 0; --col) {
-                const int column = cols.value(col); // real column value (1...KS_colMax)
-                if (column >= rect.left() && column <= rect.right()) {
-                    // save the old data
-                    if (row <= rect.bottom())
-                        oldData.append(qMakePair(QPoint(column, row), data.value(col)));
-                    // search
-                    const int srcRow = row + rect.height();
-                    const QVector<int>::const_iterator cstart2((srcRow - 1 < m_rows.count()) ? m_cols.begin() + m_rows.value(srcRow - 1) : m_cols.end());
-                    const QVector<int>::const_iterator cend2((srcRow < m_rows.count()) ? (m_cols.begin() + m_rows.value(srcRow)) : m_cols.end());
-                    const QVector<int>::const_iterator cit2 = qBinaryFind(cstart2, cend2, column);
-                    // column's missing?
-                    if (cit2 == cend2) {
-                        m_cols.remove(rowStart + col);
-                        m_data.remove(rowStart + col);
-                        // adjust the offsets of the following rows
-                        for (int r = row; r < m_rows.count(); ++r)
-                            --m_rows[r];
-                    }
-                    // column exists
-                    else {
-                        // copy
-                        m_data[rowStart + col] = m_data.value(cit2 - m_cols.constBegin());
-                        // remove
-                        m_cols.remove(cit2 - m_cols.constBegin());
-                        m_data.remove(cit2 - m_cols.constBegin());
-                        // adjust the offsets of the following rows
-                        for (int r = row + rect.height(); r < m_rows.count(); ++r)
-                            --m_rows[r];
-                    }
-                }
-            }
-            // last, iterate over the source row
-            const int srcRow = row + rect.height();
-            const int rowStart2 = (srcRow - 1 < m_rows.count()) ? m_rows.value(srcRow - 1) : m_data.count();
-            const int rowLength2 = (srcRow < m_rows.count()) ? m_rows.value(srcRow) - rowStart2 : -1;
-            const QVector<int> cols2 = m_cols.mid(rowStart2, rowLength2);
-            const QVector<T> data2 = m_data.mid(rowStart2, rowLength2);
-            int offset = 0;
-            for (int col = cols2.count() - 1; col >= 0; --col) {
-                const int column = cols2.value(col); // real column value (1...KS_colMax)
-                if (column >= rect.left() && column <= rect.right()) {
-                    // find the insertion position
-                    const QVector<int>::const_iterator cstart((row - 1 < m_rows.count()) ? m_cols.begin() + m_rows.value(row - 1) : m_cols.end());
-                    const QVector<int>::const_iterator cend(((row < m_rows.count())) ? (m_cols.begin() + m_rows.value(row)) : m_cols.end());
-                    const QVector<int>::const_iterator cit = qUpperBound(cstart, cend, cols2.value(col));
-                    // Destination column:
-                    const QVector<int>::const_iterator dstcit = qBinaryFind(cols.begin(), cols.end(), column);
-                    if (dstcit != cols.end()) { // destination column exists
-                        // replace the existing destination value
-                        const int dstCol = (dstcit - cols.constBegin());
-                        m_data[rowStart + dstCol] = m_data.value(rowStart2 + col);
-                        // remove it from its old position
-                        m_data.remove(rowStart2 + col + 1);
-                        m_cols.remove(rowStart2 + col + 1);
-                        // The amount of values in the range from the
-                        // destination row to the source row have not changed.
-                        // adjust the offsets of the following rows
-                        for (int r = srcRow; r < m_rows.count(); ++r) {
-                            ++m_rows[r];
-                        }
-                    } else { // destination column does not exist yet
-                        // copy it to its new position
-                        const int dstCol = cit - m_cols.constBegin();
-                        m_data.insert(dstCol, data2.value(col));
-                        m_cols.insert(dstCol, cols2.value(col));
-                        // remove it from its old position
-                        m_data.remove(rowStart2 + col + 1 + offset);
-                        m_cols.remove(rowStart2 + col + 1 + offset);
-                        ++offset;
-                        // adjust the offsets of the following rows
-                        for (int r = row; r < srcRow; ++r) {
-                            ++m_rows[r];
-                        }
-                    }
-                }
-            }
-        }
-        squeezeRows();
-        return oldData;
+        return shiftRows(rect.left(), rect.right(), rect.top(), -rect.height());
     }
 
     /**
@@ -498,60 +334,7 @@ public:
      */
     QVector< QPair<QPoint, T> > insertShiftDown(const QRect& rect) {
         Q_ASSERT(1 <= rect.top() && rect.top() <= KS_rowMax);
-        // row's missing?
-        if (rect.top() > m_rows.count())
-            return QVector< QPair<QPoint, T> >();
-        QVector< QPair<QPoint, T> > oldData;
-        for (int row = m_rows.count(); row >= rect.top(); --row) {
-            const int rowStart = m_rows.value(row - 1);
-            const int rowLength = (row < m_rows.count()) ? m_rows.value(row) - rowStart : -1;
-            const QVector<int> cols = m_cols.mid(rowStart, rowLength);
-            const QVector<T> data = m_data.mid(rowStart, rowLength);
-            for (int col = cols.count() - 1; col >= 0; --col) {
-                if (cols.value(col) >= rect.left() && cols.value(col) <= rect.right()) {
-                    if (row + rect.height() > KS_rowMax) {
-                        // save old data
-                        oldData.append(qMakePair(QPoint(cols.value(col), row), data.value(col)));
-                    } else {
-                        // insert missing rows
-                        if (row + rect.height() > m_rows.count())
-                            m_rows.insert(m_rows.count(), row + rect.height() - m_rows.count(), m_data.count());
-
-                        // copy the data down
-                        const int row2 = row + rect.height();
-                        const QVector<int>::const_iterator cstart2(m_cols.begin() + m_rows.value(row2 - 1));
-                        const QVector<int>::const_iterator cend2((row2 < m_rows.count()) ? (m_cols.begin() + m_rows.value(row2)) : m_cols.end());
-                        const QVector<int>::const_iterator cit2 = qLowerBound(cstart2, cend2, cols.value(col));
-                        // column's missing?
-                        if (cit2 == cend2 || *cit2 != cols.value(col)) {
-                            // determine the index where the data and column has to be inserted
-                            const int index = m_rows.value(row2 - 1) + (cit2 - cstart2);
-                            // insert the actual data
-                            m_data.insert(index, data.value(col));
-                            // insert the column index
-                            m_cols.insert(index, cols.value(col));
-                            // adjust the offsets of the following rows
-                            for (int r = row2; r < m_rows.count(); ++r)
-                                ++m_rows[r];
-                        }
-                        // column exists
-                        else {
-                            const int index = m_rows.value(row2 - 1) + (cit2 - cstart2);
-                            m_data[ index ] = data.value(col);
-                        }
-                    }
-
-                    // remove the data
-                    m_cols.remove(rowStart + col);
-                    m_data.remove(rowStart + col);
-                    // adjust the offsets of the following rows
-                    for (int r = row; r < m_rows.count(); ++r)
-                        --m_rows[r];
-                }
-            }
-        }
-        squeezeRows();
-        return oldData;
+        return shiftRows(rect.left(), rect.right(), rect.top(), rect.height());
     }
 
     /**
@@ -858,6 +641,120 @@ public:
     }
 
 private:
+    /**
+     * Moves the data in the rows from \p top to \p bottom and in the columns
+     * from \p position on by \p delta columns. The data moved left of
+     * \p position or beyond KS_colMax is removed.
+     * The order of the columns in a row does not change, so the data gets
+     * compacted in place in one pass over the affected rows.
+     * \return the removed data
+     */
+    QVector< QPair<QPoint, T> > shiftColumns(int top, int bottom, int position, int delta) {
+        QVector< QPair<QPoint, T> > oldData;
+        const int last = qMin(bottom, m_rows.count());
+        // the number of entries removed so far
+        int removed = 0;
+        for (int row = top; row <= last; ++row) {
+            const int rowStart = m_rows.value(row - 1);
+            const int rowEnd = (row < m_rows.count()) ? m_rows.value(row) : m_data.count();
+            m_rows[row - 1] = rowStart - removed;
+            for (int index = rowStart; index < rowEnd; ++index) {
+                const int col = m_cols.value(index);
+                if (col < position) {
+                    if (removed) {
+                        m_cols[index - removed] = col;
+                        m_data[index - removed] = m_data.value(index);
+                    }
+                } else if (col + delta < position || col + delta > KS_colMax) {
+                    oldData.append(qMakePair(QPoint(col, row), m_data.value(index)));
+                    ++removed;
+                } else {
+                    m_cols[index - removed] = col + delta;
+                    if (removed)
+                        m_data[index - removed] = m_data.value(index);
+                }
+            }
+        }
+        if (removed) {
+            // close the gap left behind the last affected row
+            const int end = (last < m_rows.count()) ? m_rows.value(last) : m_data.count();
+            m_cols.remove(end - removed, removed);
+            m_data.remove(end - removed, removed);
+            // adjust the offsets of the following rows
+            for (int r = last; r < m_rows.count(); ++r)
+                m_rows[r] -= removed;
+        }
+        squeezeRows();
+        return oldData;
+    }
+
+    /**
+     * Moves the data in the columns from \p left to \p right and in the rows
+     * from \p position on by \p delta rows. The data in the rows, which the
+     * following rows are moved onto, and the data moved beyond KS_rowMax
+     * is removed.
+     * The rows from \p position on get rebuilt by merging the staying and
+     * the moved data, so the costs are linear in the amount of data there.
+     * \return the removed data
+     */
+    QVector< QPair<QPoint, T> > shiftRows(int left, int right, int position, int delta) {
+        QVector< QPair<QPoint, T> > oldData;
+        // row's missing?
+        if (position > m_rows.count())
+            return oldData;
+        struct Entry {
+            int row;
+            int col;
+            int index;
+        };
+        // the staying and the moved data row by row, referencing the old index
+        QVector<Entry> staying;
+        QVector<Entry> moved;
+        for (int row = position; row <= m_rows.count(); ++row) {
+            const int rowStart = m_rows.value(row - 1);
+            const int rowEnd = (row < m_rows.count()) ? m_rows.value(row) : m_data.count();
+            for (int index = rowStart; index < rowEnd; ++index) {
+                const Entry entry = { row, m_cols.value(index), index };
+                if (entry.col < left || entry.col > right)
+                    staying.append(entry);
+                else if (row + delta < position || row + delta > KS_rowMax)
+                    oldData.append(qMakePair(QPoint(entry.col, row), m_data.value(index)));
+                else {
+                    moved.append(entry);
+                    moved.last().row += delta;
+                }
+            }
+        }
+        // merge both in the row-major order; a column is either staying or moved
+        const int start = m_rows.value(position - 1);
+        QVector<int> rows;
+        QVector<int> cols;
+        QVector<T> data;
+        cols.reserve(staying.count() + moved.count());
+        data.reserve(staying.count() + moved.count());
+        int s = 0;
+        int m = 0;
+        while (s < staying.count() || m < moved.count()) {
+            const bool takeStaying = (m == moved.count()) ||
+                                     (s < staying.count() &&
+                                      (staying[s].row < moved[m].row ||
+                                       (staying[s].row == moved[m].row && staying[s].col < moved[m].col)));
+            const Entry& entry = takeStaying ? staying[s++] : moved[m++];
+            while (rows.count() <= entry.row - position)
+                rows.append(start + cols.count());
+            cols.append(entry.col);
+            data.append(m_data.value(entry.index));
+        }
+        m_cols.resize(start);
+        m_data.resize(start);
+        m_rows.resize(position - 1);
+        m_cols += cols;
+        m_data += data;
+        m_rows += rows;
+        squeezeRows();
+        return oldData;
+    }
+
     void squeezeRows() {
         int row = m_rows.count() - 1;
         while (m_rows.value(row) == m_data.count() && row >= 0)
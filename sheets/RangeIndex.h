@@ -0,0 +1,326 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_RANGE_INDEX
+#define CALLIGRA_SHEETS_RANGE_INDEX
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QPoint>
+#include <QRect>
+#include <QVector>
+
+#include "calligra_sheets_limits.h"
+
+namespace Calligra
+{
+namespace Sheets
+{
+
+/**
+ * \class RangeIndex
+ * \brief A spatial index for cell ranges
+ * \ingroup Storage
+ *
+ * Stores data items associated with cell ranges and finds the items,
+ * whose range contains a cell or intersects a cell range.
+ *
+ * The ranges are grouped by their extent: a range of \c w columns and
+ * \c h rows belongs to the grid, whose buckets are the smallest powers of
+ * two not less than \c w and \c h. Within this grid the range covers at
+ * most two by two buckets and is stored in each of them. A cell lies in
+ * exactly one bucket of each grid, so a lookup costs one hash lookup per
+ * populated grid, of which there are at most log2(KS_colMax) * log2(KS_rowMax),
+ * plus the items in the found buckets.
+ *
+ * In contrast to an R-Tree the result does not degrade, if a lot of long
+ * ranges overlap, like many references to complete columns do: those end
+ * up in narrow buckets of a tall grid and only items in the column of the
+ * looked up cell are visited.
+ *
+ * Unlike RTree, RangeIndex takes integer cell ranges, i.e. QRect(1, 1, 1, 1)
+ * does not intersect QRect(2, 1, 1, 1).
+ */
+template<typename T>
+class RangeIndex
+{
+public:
+    RangeIndex() : m_nextId(0), m_count(0) {}
+
+    /**
+     * Inserts \p data for the cell range \p rect .
+     */
+    void insert(const QRect& rect, const T& data);
+
+    /**
+     * Removes one item with \p data , that was inserted for \p rect .
+     */
+    void remove(const QRect& rect, const T& data);
+
+    /**
+     * Removes all items.
+     */
+    void clear() {
+        m_grids.clear();
+        m_count = 0;
+    }
+
+    /**
+     * \return the number of items
+     */
+    int count() const {
+        return m_count;
+    }
+
+    /**
+     * Finds all data items, whose range contains \p point .
+     */
+    QList<T> contains(const QPoint& point) const;
+
+    /**
+     * Finds all data items, whose range covers \p rect completely.
+     */
+    QList<T> contains(const QRect& rect) const;
+
+    /**
+     * Finds all data items, whose range intersects \p rect .
+     */
+    QList<T> intersects(const QRect& rect) const;
+
+    /**
+     * Finds all data items, whose range intersects \p rect .
+     * \return the ranges and data items keyed by an insertion id
+     */
+    QMap<int, QPair<QRect, T> > intersectingPairs(const QRect& rect) const;
+
+private:
+    struct Item {
+        QRect rect;
+        T data;
+        int id;
+    };
+    typedef QVector<Item> Bucket;
+    // buckets keyed by their column and row index
+    typedef QHash<quint64, Bucket> Grid;
+
+    static int level(int extent) {
+        int level = 0;
+        while ((1 << level) < extent)
+            ++level;
+        return level;
+    }
+    static int gridKey(const QRect& rect) {
+        return (level(rect.width()) << 8) | level(rect.height());
+    }
+    static quint64 bucketKey(int column, int row) {
+        return (quint64(column) << 32) | quint32(row);
+    }
+    static int bucketColumn(int gridKey, int column) {
+        return (column - 1) >> (gridKey >> 8);
+    }
+    static int bucketRow(int gridKey, int row) {
+        return (row - 1) >> (gridKey & 0xFF);
+    }
+
+    // Calls the functor for each item in the buckets covering rect.
+    // Items stored in several of those buckets are visited several times.
+    template<typename Functor>
+    void forEachItem(const QRect& rect, Functor& functor) const;
+
+    QHash<int, Grid> m_grids;
+    int m_nextId;
+    int m_count;
+};
+
+template<typename T>
+void RangeIndex<T>::insert(const QRect& rect, const T& data)
+{
+    const QRect range = rect.normalized() & QRect(1, 1, KS_colMax, KS_rowMax);
+    if (range.isEmpty())
+        return;
+    const int key = gridKey(range);
+    Grid& grid = m_grids[key];
+    Item item;
+    item.rect = range;
+    item.data = data;
+    item.id = m_nextId++;
+    const int right = bucketColumn(key, range.right());
+    const int bottom = bucketRow(key, range.bottom());
+    for (int column = bucketColumn(key, range.left()); column <= right; ++column) {
+        for (int row = bucketRow(key, range.top()); row <= bottom; ++row) {
+            grid[bucketKey(column, row)].append(item);
+        }
+    }
+    ++m_count;
+}
+
+template<typename T>
+void RangeIndex<T>::remove(const QRect& rect, const T& data)
+{
+    const QRect range = rect.normalized() & QRect(1, 1, KS_colMax, KS_rowMax);
+    if (range.isEmpty())
+        return;
+    const int key = gridKey(range);
+    typename QHash<int, Grid>::Iterator git = m_grids.find(key);
+    if (git == m_grids.end())
+        return;
+    Grid& grid = git.value();
+    // the item is stored in each covered bucket; identify it in the first one
+    int id = -1;
+    const int right = bucketColumn(key, range.right());
+    const int bottom = bucketRow(key, range.bottom());
+    for (int column = bucketColumn(key, range.left()); column <= right; ++column) {
+        for (int row = bucketRow(key, range.top()); row <= bottom; ++row) {
+            typename Grid::Iterator bit = grid.find(bucketKey(column, row));
+            if (bit == grid.end())
+                continue;
+            Bucket& bucket = bit.value();
+            for (int i = 0; i < bucket.count(); ++i) {
+                if ((id == -1 && bucket[i].rect == range && bucket[i].data == data) || bucket[i].id == id) {
+                    id = bucket[i].id;
+                    bucket.remove(i);
+                    break;
+                }
+            }
+            if (bucket.isEmpty())
+                grid.erase(bit);
+        }
+    }
+    if (grid.isEmpty())
+        m_grids.erase(git);
+    if (id != -1)
+        --m_count;
+}
+
+template<typename T>
+QList<T> RangeIndex<T>::contains(const QPoint& point) const
+{
+    QList<T> result;
+    typename QHash<int, Grid>::ConstIterator end(m_grids.constEnd());
+    for (typename QHash<int, Grid>::ConstIterator git(m_grids.constBegin()); git != end; ++git) {
+        const int key = git.key();
+        const Grid& grid = git.value();
+        typename Grid::ConstIterator bit = grid.constFind(bucketKey(bucketColumn(key, point.x()),
+                                                                     bucketRow(key, point.y())));
+        if (bit == grid.constEnd())
+            continue;
+        // the point lies in exactly one bucket, i.e. there are no duplicates
+        const Bucket& bucket = bit.value();
+        for (int i = 0; i < bucket.count(); ++i) {
+            if (bucket[i].rect.contains(point))
+                result.append(bucket[i].data);
+        }
+    }
+    return result;
+}
+
+template<typename T>
+template<typename Functor>
+void RangeIndex<T>::forEachItem(const QRect& rect, Functor& functor) const
+{
+    typename QHash<int, Grid>::ConstIterator end(m_grids.constEnd());
+    for (typename QHash<int, Grid>::ConstIterator git(m_grids.constBegin()); git != end; ++git) {
+        const int key = git.key();
+        const Grid& grid = git.value();
+        const int left = bucketColumn(key, rect.left());
+        const int right = bucketColumn(key, rect.right());
+        const int top = bucketRow(key, rect.top());
+        const int bottom = bucketRow(key, rect.bottom());
+        if (qint64(right - left + 1) * qint64(bottom - top + 1) <= grid.count()) {
+            // few buckets covered: look them up
+            for (int column = left; column <= right; ++column) {
+                for (int row = top; row <= bottom; ++row) {
+                    typename Grid::ConstIterator bit = grid.constFind(bucketKey(column, row));
+                    if (bit == grid.constEnd())
+                        continue;
+                    const Bucket& bucket = bit.value();
+                    for (int i = 0; i < bucket.count(); ++i)
+                        functor(bucket[i]);
+                }
+            }
+        } else {
+            // more buckets covered than populated: walk the populated ones
+            typename Grid::ConstIterator bend(grid.constEnd());
+            for (typename Grid::ConstIterator bit(grid.constBegin()); bit != bend; ++bit) {
+                const int column = int(bit.key() >> 32);
+                const int row = int(quint32(bit.key()));
+                if (column < left || column > right || row < top || row > bottom)
+                    continue;
+                const Bucket& bucket = bit.value();
+                for (int i = 0; i < bucket.count(); ++i)
+                    functor(bucket[i]);
+            }
+        }
+    }
+}
+
+template<typename T>
+QList<T> RangeIndex<T>::contains(const QRect& rect) const
+{
+    struct Collector {
+        QRect rect;
+        QMap<int, T> result;
+        void operator()(const Item& item) {
+            if (item.rect.contains(rect))
+                result.insert(item.id, item.data);
+        }
+    } collector;
+    collector.rect = rect.normalized();
+    forEachItem(collector.rect, collector);
+    return collector.result.values();
+}
+
+template<typename T>
+QList<T> RangeIndex<T>::intersects(const QRect& rect) const
+{
+    struct Collector {
+        QRect rect;
+        QMap<int, T> result;
+        void operator()(const Item& item) {
+            if (item.rect.intersects(rect))
+                result.insert(item.id, item.data);
+        }
+    } collector;
+    collector.rect = rect.normalized();
+    forEachItem(collector.rect, collector);
+    return collector.result.values();
+}
+
+template<typename T>
+QMap<int, QPair<QRect, T> > RangeIndex<T>::intersectingPairs(const QRect& rect) const
+{
+    struct Collector {
+        QRect rect;
+        QMap<int, QPair<QRect, T> > result;
+        void operator()(const Item& item) {
+            if (item.rect.intersects(rect))
+                result.insert(item.id, qMakePair(item.rect, item.data));
+        }
+    } collector;
+    collector.rect = rect.normalized();
+    forEachItem(collector.rect, collector);
+    return collector.result;
+}
+
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_RANGE_INDEX
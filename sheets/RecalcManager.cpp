@@ -38,9 +38,41 @@
 
 #include <QHash>
 #include <QMap>
+#ifdef CALLIGRA_SHEETS_MT
+#include <QRunnable>
+#include <QThreadPool>
+#include <QVector>
+#endif
 
 using namespace Calligra::Sheets;
 
+#ifdef CALLIGRA_SHEETS_MT
+/**
+ * Evaluates the formulas of a part of a reference depth level.
+ * Writes the results into its own slots of the result vector.
+ */
+class RecalcJob : public QRunnable
+{
+public:
+    RecalcJob(const Cell* cells, Value* results, int begin, int end)
+        : m_cells(cells), m_results(results), m_begin(begin), m_end(end) {}
+
+    void run() Q_DECL_OVERRIDE {
+        for (int i = m_begin; i < m_end; ++i)
+            m_results[i] = m_cells[i].formula().eval();
+    }
+
+private:
+    const Cell* const m_cells;
+    Value* const m_results;
+    const int m_begin;
+    const int m_end;
+};
+
+// Levels with fewer cells are not worth the overhead of the thread pool.
+static const int s_minimumParallelLevelSize = 128;
+#endif
+
 class Q_DECL_HIDDEN RecalcManager::Private
 {
 public:
@@ -62,9 +94,27 @@ public:
     void cellsToCalculate(Sheet* sheet = 0);
 
     /**
-     * Helper function for cellsToCalculate(const Region&) and cellsToCalculate(Sheet*).
+     * Checks, whether the formula of \p cell can be evaluated.
+     * Parses the expression, if not done already.
      */
-    void cellsToCalculate(const Region& region, QSet<Cell>& cells) const;
+    bool isCalculable(const Cell& cell) const;
+
+    /**
+     * Stores the \p result of the formula in \p cell .
+     * Distributes array results over the locked cells.
+     */
+    void setResult(const Cell& cell, const Value& result) const;
+
+#ifdef CALLIGRA_SHEETS_MT
+    /**
+     * Evaluates the formulas of \p cells, which all have the same
+     * reference depth and thereby do not depend on each other.
+     * The results are stored in \p results in the same order.
+     */
+    void evaluateLevel(const QVector<Cell>& cells, QVector<Value>& results);
+
+    QThreadPool threadPool;
+#endif
 
     /*
      * Stores cells ordered by its reference depth.
@@ -91,16 +141,16 @@ void RecalcManager::Private::cellsToCalculate(const Region& region)
     if (region.isEmpty())
         return;
 
-    // retrieve the cell depths
-    QMap<Cell, int> depths = map->dependencyManager()->depths();
+    // the affected cells are already ordered by depth
+    cells = map->dependencyManager()->cellsToCalculate(region);
 
-    // create the cell map ordered by depth
-    QSet<Cell> cells;
-    cellsToCalculate(region, cells);
-    const QSet<Cell>::ConstIterator end(cells.end());
-    for (QSet<Cell>::ConstIterator it(cells.begin()); it != end; ++it) {
-        if ((*it).sheet()->isAutoCalculationEnabled())
-            this->cells.insertMulti(depths[*it], *it);
+    // skip the sheets without automatic recalculation
+    QMap<int, Cell>::Iterator it(cells.begin());
+    while (it != cells.end()) {
+        if (it.value().sheet()->isAutoCalculationEnabled())
+            ++it;
+        else
+            it = cells.erase(it);
     }
 }
 
@@ -121,43 +171,64 @@ void RecalcManager::Private::cellsToCalculate(Sheet* sheet)
             sheet = map->sheet(s);
             for (int c = 0; c < sheet->formulaStorage()->count(); ++c) {
                 cell = Cell(sheet, sheet->formulaStorage()->col(c), sheet->formulaStorage()->row(c));
-                cells.insertMulti(depths[cell], cell);
+                cells.insertMulti(depths.value(cell), cell);
             }
         }
     } else { // sheet recalculation
         for (int c = 0; c < sheet->formulaStorage()->count(); ++c) {
             cell = Cell(sheet, sheet->formulaStorage()->col(c), sheet->formulaStorage()->row(c));
-            cells.insertMulti(depths[cell], cell);
+            cells.insertMulti(depths.value(cell), cell);
         }
     }
 }
 
-void RecalcManager::Private::cellsToCalculate(const Region& region, QSet<Cell>& cells) const
+bool RecalcManager::Private::isCalculable(const Cell& cell) const
+{
+    // only recalculate, if no circular dependency occurred
+    if (cell.value() == Value::errorCIRCLE())
+        return false;
+    // Check for valid formula; parses the expression, if not done already.
+    return cell.formula().isValid();
+}
+
+void RecalcManager::Private::setResult(const Cell& cell, const Value& result) const
 {
-    Region::ConstIterator end(region.constEnd());
-    for (Region::ConstIterator it(region.constBegin()); it != end; ++it) {
-        const QRect range = (*it)->rect();
-        const Sheet* sheet = (*it)->sheet();
-        for (int col = range.left(); col <= range.right(); ++col) {
-            for (int row = range.top(); row <= range.bottom(); ++row) {
-                Cell cell(sheet, col, row);
-                // Even empty cells may act as value
-                // providers and need to be processed.
-
-                // check for already processed cells
-                if (cells.contains(cell))
-                    continue;
-
-                // add it to the list
-                if (cell.isFormula())
-                    cells.insert(cell);
-
-                // add its consumers to the list
-                cellsToCalculate(map->dependencyManager()->consumingRegion(cell), cells);
+    const Sheet* sheet = cell.sheet();
+    if (result.isArray() && (result.columns() > 1 || result.rows() > 1)) {
+        const QRect rect = cell.lockedCells();
+        // unlock
+        sheet->cellStorage()->unlockCells(rect.left(), rect.top());
+        for (int row = rect.top(); row <= rect.bottom(); ++row) {
+            for (int col = rect.left(); col <= rect.right(); ++col) {
+                Cell(sheet, col, row).setValue(result.element(col - rect.left(), row - rect.top()));
             }
         }
+        // relock
+        sheet->cellStorage()->lockCells(rect);
+    } else {
+        Cell(cell).setValue(result);
+    }
+}
+
+#ifdef CALLIGRA_SHEETS_MT
+void RecalcManager::Private::evaluateLevel(const QVector<Cell>& cells, QVector<Value>& results)
+{
+    const int count = cells.count();
+    results.resize(count);
+    // detach once here; the jobs only write into their own slots
+    Value* const data = results.data();
+    const int threadCount = threadPool.maxThreadCount();
+    if (count < s_minimumParallelLevelSize || threadCount < 2) {
+        RecalcJob(cells.constData(), data, 0, count).run();
+        return;
+    }
+    const int chunkSize = (count + threadCount - 1) / threadCount;
+    for (int begin = 0; begin < count; begin += chunkSize) {
+        threadPool.start(new RecalcJob(cells.constData(), data, begin, qMin(begin + chunkSize, count)));
     }
+    threadPool.waitForDone();
 }
+#endif
 
 RecalcManager::RecalcManager(Map *const map)
         : QObject(map)
@@ -165,6 +236,21 @@ RecalcManager::RecalcManager(Map *const map)
 {
     d->map  = map;
     d->active = false;
+#ifdef CALLIGRA_SHEETS_MT
+    // The shared error values are created on first use. Make sure, that
+    // this does not happen concurrently in the recalculation threads.
+    Value::errorCIRCLE();
+    Value::errorDEPEND();
+    Value::errorDIV0();
+    Value::errorNA();
+    Value::errorNAME();
+    Value::errorNULL();
+    Value::errorNUM();
+    Value::errorPARSE();
+    Value::errorREF();
+    Value::errorVALUE();
+    Value::null();
+#endif
 }
 
 RecalcManager::~RecalcManager()
@@ -172,6 +258,13 @@ RecalcManager::~RecalcManager()
     delete d;
 }
 
+#ifdef CALLIGRA_SHEETS_MT
+QThreadPool* RecalcManager::threadPool() const
+{
+    return &d->threadPool;
+}
+#endif
+
 void RecalcManager::regionChanged(const Region& region)
 {
     if (d->active || region.isEmpty())
@@ -236,37 +329,45 @@ void RecalcManager::recalc(KoUpdater *updater)
     if (updater)
         updater->setProgress(0);
 
+#ifdef CALLIGRA_SHEETS_MT
+    // The cells of one reference depth do not depend on each other.
+    // Evaluate them concurrently and store the results level by level,
+    // before the next level reads them.
+    const int cellsCount = d->cells.count();
+    int cellsDone = 0;
+    QVector<Cell> level;
+    QVector<Value> results;
+    QMap<int, Cell>::ConstIterator it(d->cells.constBegin());
+    const QMap<int, Cell>::ConstIterator end(d->cells.constEnd());
+    while (it != end) {
+        const int depth = it.key();
+        level.clear();
+        for (; it != end && it.key() == depth; ++it, ++cellsDone) {
+            // parses the formulas here, not in the threads
+            if (d->isCalculable(it.value()))
+                level.append(it.value());
+        }
+
+        d->evaluateLevel(level, results);
+        for (int c = 0; c < level.count(); ++c)
+            d->setResult(level[c], results[c]);
+
+        if (updater)
+            updater->setProgress(int(qreal(cellsDone) / qreal(cellsCount) * 100.));
+    }
+#else
     const QList<Cell> cells = d->cells.values();
     const int cellsCount = cells.count();
     for (int c = 0; c < cellsCount; ++c) {
-        // only recalculate, if no circular dependency occurred
-        if (cells.value(c).value() == Value::errorCIRCLE())
+        if (!d->isCalculable(cells.value(c)))
             continue;
-        // Check for valid formula; parses the expression, if not done already.
-        if (!cells.value(c).formula().isValid())
-            continue;
-
-        const Sheet* sheet = cells.value(c).sheet();
 
         // evaluate the formula and set the result
-        Value result = cells.value(c).formula().eval();
-        if (result.isArray() && (result.columns() > 1 || result.rows() > 1)) {
-            const QRect rect = cells.value(c).lockedCells();
-            // unlock
-            sheet->cellStorage()->unlockCells(rect.left(), rect.top());
-            for (int row = rect.top(); row <= rect.bottom(); ++row) {
-                for (int col = rect.left(); col <= rect.right(); ++col) {
-                    Cell(sheet, col, row).setValue(result.element(col - rect.left(), row - rect.top()));
-                }
-            }
-            // relock
-            sheet->cellStorage()->lockCells(rect);
-        } else {
-            Cell(cells.value(c)).setValue(result);
-        }
+        d->setResult(cells.value(c), cells.value(c).formula().eval());
         if (updater)
             updater->setProgress(int(qreal(c) / qreal(cellsCount) * 100.));
     }
+#endif
 
     if (updater)
         updater->setProgress(100);
@@ -25,6 +25,7 @@
 #include <QObject>
 
 class KoUpdater;
+class QThreadPool;
 
 namespace Calligra
 {
@@ -51,6 +52,10 @@ class Sheet;
  *
  * Cell value changes are blocked while doing this, i.e. they do not
  * trigger a new recalculation event.
+ *
+ * If built with CALLIGRA_SHEETS_MT, the cells of one reference depth,
+ * which do not depend on each other, are evaluated in a thread pool.
+ * Their results are stored at once, before the next depth is processed.
  */
 class CALLIGRA_SHEETS_ODF_EXPORT RecalcManager : public QObject
 {
@@ -126,6 +131,12 @@ protected:
 private:
     Q_DISABLE_COPY(RecalcManager)
 
+    friend class TestRecalcManager;
+#ifdef CALLIGRA_SHEETS_MT
+    // the pool evaluating the cells of a reference depth
+    QThreadPool* threadPool() const;
+#endif
+
     class Private;
     Private * const d;
 };
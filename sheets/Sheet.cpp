@@ -1792,11 +1792,17 @@ void Sheet::applyDatabaseFilter(const Database &database)
     const QRect range = database.range().lastRange();
     const int start = database.orientation() == Qt::Vertical ? range.top() : range.left();
     const int end = database.orientation() == Qt::Vertical ? range.bottom() : range.right();
+    const QBitArray results = database.filter().evaluate(database, start + 1, end);
     for (int i = start + 1; i <= end; ++i) {
-        const bool isFiltered = !database.filter().evaluate(database, i);
+        const bool isFiltered = !results.testBit(i - start - 1);
 //         debugSheets <<"Filtering column/row" << i <<"?" << isFiltered;
         if (database.orientation() == Qt::Vertical) {
-            sheet->rowFormats()->setFiltered(i, i, isFiltered);
+            // the rows with the same result at once
+            int last = i;
+            while (last < end && results.testBit(last - start) == !isFiltered)
+                ++last;
+            sheet->rowFormats()->setFiltered(i, last, isFiltered);
+            i = last;
         } else { // database.orientation() == Qt::Horizontal
             sheet->nonDefaultColumnFormat(i)->setFiltered(isFiltered);
         }
@@ -0,0 +1,67 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "StringPool.h"
+
+#include <QHash>
+
+using namespace Calligra::Sheets;
+
+class Q_DECL_HIDDEN StringPool::Private
+{
+public:
+    // the keys share their characters with the values
+    QHash<QString, Value> values;
+};
+
+StringPool::StringPool()
+        : d(new Private)
+{
+}
+
+StringPool::~StringPool()
+{
+    delete d;
+}
+
+Value StringPool::value(const QString& string)
+{
+    QHash<QString, Value>::ConstIterator it = d->values.constFind(string);
+    if (it == d->values.constEnd())
+        it = d->values.insert(string, Value(string));
+    return it.value();
+}
+
+QString StringPool::string(const QString& string)
+{
+    QHash<QString, Value>::ConstIterator it = d->values.constFind(string);
+    if (it == d->values.constEnd())
+        it = d->values.insert(string, Value(string));
+    return it.key();
+}
+
+int StringPool::count() const
+{
+    return d->values.count();
+}
+
+void StringPool::clear()
+{
+    d->values.clear();
+}
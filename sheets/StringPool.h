@@ -0,0 +1,82 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_STRING_POOL
+#define CALLIGRA_SHEETS_STRING_POOL
+
+#include <QString>
+
+#include "Value.h"
+
+#include "sheets_odf_export.h"
+
+namespace Calligra
+{
+namespace Sheets
+{
+
+/**
+ * \ingroup Value
+ * Interns strings and string values.
+ *
+ * Equal strings share one Value, i.e. one allocation of the value data and
+ * one of the characters, however many cells hold them. Meant for importers,
+ * which load many cells repeating the same labels: values and user inputs
+ * taken from the pool share their data with all the other cells holding the
+ * same text.
+ */
+class CALLIGRA_SHEETS_ODF_EXPORT StringPool
+{
+public:
+    StringPool();
+    ~StringPool();
+
+    /**
+     * \return the string value \p string , which shares its data with the
+     * values returned before for equal strings
+     */
+    Value value(const QString& string);
+
+    /**
+     * \return \p string , which shares its characters with the strings and
+     * values returned before for equal strings
+     */
+    QString string(const QString& string);
+
+    /**
+     * \return the number of distinct strings
+     */
+    int count() const;
+
+    /**
+     * Drops all strings. Values and strings already returned keep their data.
+     */
+    void clear();
+
+private:
+    Q_DISABLE_COPY(StringPool)
+
+    class Private;
+    Private * const d;
+};
+
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_STRING_POOL
@@ -21,10 +21,9 @@
 // Local
 #include "StyleStorage.h"
 
-#include <QCache>
 #include <QRegion>
-#include <QTimer>
 #include <QRunnable>
+#include <QTimer>
 #ifdef CALLIGRA_SHEETS_MT
 #include <QMutex>
 #include <QMutexLocker>
@@ -37,10 +36,28 @@
 #include "StyleManager.h"
 #include "RectStorage.h"
 
+#include <algorithm>
+
+// The maximum number of cached style spans.
 static const int g_maximumCachedStyles = 10000;
+// The maximum number of columns looked at on each side of a cell to find
+// the extent of its style span.
+static const int g_spanWindow = 256;
+// The maximum number of possible garbage substyles checked at once.
+static const int g_garbageBatchSize = 64;
 
 using namespace Calligra::Sheets;
 
+namespace
+{
+// consecutive cells in a row with the same style
+struct StyleSpan {
+    int left;
+    int right;
+    Style style;
+};
+}
+
 class Q_DECL_HIDDEN StyleStorage::Private
 {
 public:
@@ -56,16 +73,33 @@ public:
     QRegion usedArea;
     QHash<Style::Key, QList<SharedSubStyle> > subStyles;
     QMap<int, QPair<QRectF, SharedSubStyle> > possibleGarbage;
-    QCache<QPoint, Style> cache;
-    QRegion cachedArea;
+    bool garbageCollectionScheduled;
+    // the composed styles of the looked up cells row by row
+    QMap<int, QVector<StyleSpan> > rows;
+    int cachedSpans;
     StyleStorageLoaderJob* loader;
 #ifdef CALLIGRA_SHEETS_MT
     QMutex cacheMutex;
 #endif
 
     void ensureLoaded();
+    // Looks up the cached span containing point.
+    bool cachedSpan(const QPoint& point, StyleSpan* span) const;
+    // Caches the span of style from left to right in row, which is clipped to
+    // the uncached columns around column and merged with adjacent spans of the
+    // same style. Returns the cached span, which always contains column.
+    StyleSpan insertSpan(int row, int column, int left, int right, const Style& style);
+    // Drops the cached spans intersecting rect.
+    void invalidate(const QRect& rect);
+    // Removes the next possible garbage, if it is redundant.
+    void collectGarbage();
 };
 
+static bool columnLowerThanSpan(int column, const StyleSpan& span)
+{
+    return column < span.left;
+}
+
 class Calligra::Sheets::StyleStorageLoaderJob : public QRunnable
 {
 public:
@@ -110,8 +144,8 @@ void StyleStorageLoaderJob::run()
 #ifdef CALLIGRA_SHEETS_MT
         QMutexLocker(&d->cacheMutex);
 #endif
-        d->cachedArea = QRegion();
-        d->cache.clear();
+        d->rows.clear();
+        d->cachedSpans = 0;
     }
     typedef QPair<QRegion, Style> StyleRegion;
     foreach (const StyleRegion& styleArea, m_styles) {
@@ -174,12 +208,90 @@ void StyleStorage::Private::ensureLoaded()
     }
 }
 
+bool StyleStorage::Private::cachedSpan(const QPoint& point, StyleSpan* span) const
+{
+    const QMap<int, QVector<StyleSpan> >::ConstIterator row = rows.constFind(point.y());
+    if (row == rows.constEnd())
+        return false;
+    const QVector<StyleSpan>& spans = row.value();
+    QVector<StyleSpan>::ConstIterator it = std::upper_bound(spans.constBegin(), spans.constEnd(),
+                                                            point.x(), columnLowerThanSpan);
+    if (it == spans.constBegin() || (it - 1)->right < point.x())
+        return false;
+    *span = *(it - 1);
+    return true;
+}
+
+StyleSpan StyleStorage::Private::insertSpan(int row, int column, int left, int right, const Style& style)
+{
+    Q_ASSERT(left <= column && column <= right);
+    if (cachedSpans >= g_maximumCachedStyles) {
+        rows.clear();
+        cachedSpans = 0;
+    }
+    QVector<StyleSpan>& spans = rows[row];
+    QVector<StyleSpan>::Iterator it = std::upper_bound(spans.begin(), spans.end(), column, columnLowerThanSpan);
+    if (it != spans.begin() && (it - 1)->right >= column)
+        return *(it - 1); // cached meanwhile
+    // The spans got looked up in different windows; only fill the gap
+    // between the cached neighbours of column.
+    if (it != spans.begin())
+        left = qMax(left, (it - 1)->right + 1);
+    if (it != spans.end())
+        right = qMin(right, it->left - 1);
+    // merge with the adjacent spans of the same style
+    const bool mergePrevious = it != spans.begin() && (it - 1)->right + 1 == left && (it - 1)->style == style;
+    const bool mergeNext = it != spans.end() && it->left == right + 1 && it->style == style;
+    if (mergePrevious && mergeNext) {
+        const int index = it - spans.begin();
+        spans[index - 1].right = it->right;
+        spans.remove(index);
+        --cachedSpans;
+        return spans[index - 1];
+    } else if (mergePrevious) {
+        (it - 1)->right = right;
+        return *(it - 1);
+    } else if (mergeNext) {
+        it->left = left;
+        return *it;
+    }
+    StyleSpan span;
+    span.left = left;
+    span.right = right;
+    span.style = style;
+    spans.insert(it, span);
+    ++cachedSpans;
+    return span;
+}
+
+void StyleStorage::Private::invalidate(const QRect& rect)
+{
+#ifdef CALLIGRA_SHEETS_MT
+    QMutexLocker ml(&cacheMutex);
+#endif
+    QMap<int, QVector<StyleSpan> >::Iterator it = rows.lowerBound(rect.top());
+    while (it != rows.end() && it.key() <= rect.bottom()) {
+        QVector<StyleSpan>& spans = it.value();
+        QVector<StyleSpan>::Iterator first = std::upper_bound(spans.begin(), spans.end(), rect.left(), columnLowerThanSpan);
+        if (first != spans.begin() && (first - 1)->right >= rect.left())
+            --first;
+        QVector<StyleSpan>::Iterator last = std::upper_bound(first, spans.end(), rect.right(), columnLowerThanSpan);
+        cachedSpans -= int(last - first);
+        spans.erase(first, last);
+        if (spans.isEmpty())
+            it = rows.erase(it);
+        else
+            ++it;
+    }
+}
+
 StyleStorage::StyleStorage(Map* map)
         : QObject(map)
         , d(new Private)
 {
     d->map = map;
-    d->cache.setMaxCost(g_maximumCachedStyles);
+    d->cachedSpans = 0;
+    d->garbageCollectionScheduled = false;
     d->loader = 0;
 }
 
@@ -193,6 +305,8 @@ StyleStorage::StyleStorage(const StyleStorage& other)
     d->usedRows = other.d->usedRows;
     d->usedArea = other.d->usedArea;
     d->subStyles = other.d->subStyles;
+    d->cachedSpans = 0;
+    d->garbageCollectionScheduled = false;
     if (other.d->loader) {
         d->loader = new StyleStorageLoaderJob(this, other.d->loader->data());
     } else {
@@ -212,47 +326,113 @@ Style StyleStorage::contains(const QPoint& point) const
     d->ensureLoaded();
     if (!d->usedArea.contains(point) && !d->usedColumns.contains(point.x()) && !d->usedRows.contains(point.y()))
         return *styleManager()->defaultStyle();
+    return styleSpan(point, 0, 0);
+}
 
+Style StyleStorage::styleSpan(const QPoint& point, int* left, int* right) const
+{
+    d->ensureLoaded();
     {
 #ifdef CALLIGRA_SHEETS_MT
         QMutexLocker ml(&d->cacheMutex);
 #endif
         // first, lookup point in the cache
-        if (d->cache.contains(point)) {
-    //         debugSheetsStyle <<"StyleStorage: Using cached style for" << cellName;
-            Style st = *d->cache.object(point);
-            return st;
+        StyleSpan span;
+        if (d->cachedSpan(point, &span)) {
+            if (left)
+                *left = span.left;
+            if (right)
+                *right = span.right;
+            return span.style;
         }
     }
-    // not found, lookup in the tree
-    QList<SharedSubStyle> subStyles = d->tree.contains(point);
-
-    if (subStyles.isEmpty()) {
-        Style *style = styleManager()->defaultStyle();
-        // let's try caching empty styles too, the lookup is rather expensive still
-        {
-#ifdef CALLIGRA_SHEETS_MT
-            QMutexLocker ml(&d->cacheMutex);
-#endif
-            // insert style into the cache
-            d->cache.insert(point, style);
-            d->cachedArea += QRect(point, point);
+    // not found, lookup the substyles around point in the tree
+    const QRect window(QPoint(qMax(1, point.x() - g_spanWindow), point.y()),
+                       QPoint(qMin(KS_colMax, point.x() + g_spanWindow), point.y()));
+    int first = window.left();
+    int last = window.right();
+    QList<SharedSubStyle> subStyles;
+    typedef QPair<QRectF, SharedSubStyle> SharedSubStylePair;
+    const QMap<int, SharedSubStylePair> pairs = d->tree.intersectingPairs(window);
+    QMap<int, SharedSubStylePair>::ConstIterator end = pairs.constEnd();
+    for (QMap<int, SharedSubStylePair>::ConstIterator it = pairs.constBegin(); it != end; ++it) {
+        // the columns, in which the substyles stay the same
+        const QRect rect = it.value().first.toRect();
+        if (rect.right() < point.x()) {
+            first = qMax(first, rect.right() + 1);
+        } else if (rect.left() > point.x()) {
+            last = qMin(last, rect.left() - 1);
+        } else {
+            first = qMax(first, rect.left());
+            last = qMin(last, rect.right());
+            subStyles.append(it.value().second);
         }
-
-        return *style;
     }
-    Style* style = new Style();
-    (*style) = composeStyle(subStyles);
-
+    const Style style = composeStyle(subStyles);
+    StyleSpan span;
     {
 #ifdef CALLIGRA_SHEETS_MT
         QMutexLocker ml(&d->cacheMutex);
 #endif
         // insert style into the cache
-        d->cache.insert(point, style);
-        d->cachedArea += QRect(point, point);
+        span = d->insertSpan(point.y(), point.x(), first, last, style);
     }
-    return *style;
+    if (left)
+        *left = span.left;
+    if (right)
+        *right = span.right;
+    return span.style;
+}
+
+StyleStorage::RowIterator::RowIterator(const StyleStorage* storage, int row, int left, int right)
+        : m_storage(storage)
+        , m_row(row)
+        , m_left(left)
+        , m_right(left - 1)
+        , m_end(right)
+{
+    lookup();
+}
+
+bool StyleStorage::RowIterator::atEnd() const
+{
+    return m_left > m_end;
+}
+
+void StyleStorage::RowIterator::next()
+{
+    m_left = m_right + 1;
+    lookup();
+}
+
+int StyleStorage::RowIterator::left() const
+{
+    return m_left;
+}
+
+int StyleStorage::RowIterator::right() const
+{
+    return m_right;
+}
+
+Style StyleStorage::RowIterator::style() const
+{
+    return m_style;
+}
+
+void StyleStorage::RowIterator::lookup()
+{
+    if (atEnd())
+        return;
+    m_style = m_storage->styleSpan(QPoint(m_left, m_row), 0, &m_right);
+    // spans looked up in different windows may continue with the same style
+    while (m_right < m_end) {
+        int right;
+        if (m_storage->styleSpan(QPoint(m_right + 1, m_row), 0, &right) != m_style)
+            break;
+        m_right = right;
+    }
+    m_right = qMin(m_right, m_end);
 }
 
 Style StyleStorage::contains(const QRect& rect) const
@@ -676,8 +856,8 @@ void StyleStorage::invalidateCache()
 #ifdef CALLIGRA_SHEETS_MT
     QMutexLocker ml(&d->cacheMutex);
 #endif
-    d->cache.clear();
-    d->cachedArea = QRegion();
+    d->rows.clear();
+    d->cachedSpans = 0;
 }
 
 void StyleStorage::garbageCollection()
@@ -686,27 +866,41 @@ void StyleStorage::garbageCollection()
     if (d->loader && !d->loader->isFinished())
         return;
 
-    // any possible garbage left?
-    if (d->possibleGarbage.isEmpty())
-        return;
+    // compact in batches, so large changes do not block the event loop
+    for (int i = 0; i < g_garbageBatchSize && !d->possibleGarbage.isEmpty(); ++i)
+        d->collectGarbage();
+    if (!d->possibleGarbage.isEmpty() && !d->garbageCollectionScheduled) {
+        d->garbageCollectionScheduled = true;
+        QTimer::singleShot(0, this, SLOT(scheduledGarbageCollection()));
+    }
+}
+
+void StyleStorage::scheduledGarbageCollection()
+{
+    d->garbageCollectionScheduled = false;
+    garbageCollection();
+}
 
-    const int currentZIndex = d->possibleGarbage.constBegin().key();
-    const QPair<QRectF, SharedSubStyle> currentPair = d->possibleGarbage.take(currentZIndex);
+void StyleStorage::Private::collectGarbage()
+{
+    const int currentZIndex = possibleGarbage.constBegin().key();
+    const QPair<QRectF, SharedSubStyle> currentPair = possibleGarbage.take(currentZIndex);
 
     // check whether the named style still exists
     if (currentPair.second->type() == Style::NamedStyleKey &&
-            !styleManager()->style(static_cast<const NamedStyle*>(currentPair.second.data())->name)) {
+            !map->styleManager()->style(static_cast<const NamedStyle*>(currentPair.second.data())->name)) {
         debugSheetsStyle << "removing" << currentPair.second->debugData()
         << "at" << Region(currentPair.first.toRect()).name()
         << "used" << currentPair.second->ref << "times" << endl;
-        d->tree.remove(currentPair.first.toRect(), currentPair.second);
-        d->subStyles[currentPair.second->type()].removeAll(currentPair.second);
-        QTimer::singleShot(g_garbageCollectionTimeOut, this, SLOT(garbageCollection()));
+        tree.remove(currentPair.first.toRect(), currentPair.second);
+        subStyles[currentPair.second->type()].removeAll(currentPair.second);
+        // the missing named style reset the style
+        invalidate(currentPair.first.toRect());
         return; // already done
     }
 
     typedef QPair<QRectF, SharedSubStyle> SharedSubStylePair;
-    QMap<int, SharedSubStylePair> pairs = d->tree.intersectingPairs(currentPair.first.toRect());
+    QMap<int, SharedSubStylePair> pairs = tree.intersectingPairs(currentPair.first.toRect());
     if (pairs.isEmpty())   // actually never true, just for sanity
         return;
     int zIndex = pairs.constBegin().key();
@@ -720,8 +914,7 @@ void StyleStorage::garbageCollection()
         debugSheetsStyle << "removing default style"
         << "at" << Region(currentPair.first.toRect()).name()
         << "used" << currentPair.second->ref << "times" << endl;
-        d->tree.remove(currentPair.first.toRect(), currentPair.second);
-        QTimer::singleShot(g_garbageCollectionTimeOut, this, SLOT(garbageCollection()));
+        tree.remove(currentPair.first.toRect(), currentPair.second);
         return; // already done
     }
 
@@ -734,8 +927,7 @@ void StyleStorage::garbageCollection()
         debugSheetsStyle << "removing default indentation"
         << "at" << Region(currentPair.first.toRect()).name()
         << "used" << currentPair.second->ref << "times" << endl;
-        d->tree.remove(currentPair.first.toRect(), currentPair.second);
-        QTimer::singleShot(g_garbageCollectionTimeOut, this, SLOT(garbageCollection()));
+        tree.remove(currentPair.first.toRect(), currentPair.second);
         return; // already done
     }
 
@@ -748,8 +940,7 @@ void StyleStorage::garbageCollection()
         debugSheetsStyle << "removing default precision"
         << "at" << Region(currentPair.first.toRect()).name()
         << "used" << currentPair.second->ref << "times" << endl;
-        d->tree.remove(currentPair.first.toRect(), currentPair.second);
-        QTimer::singleShot(g_garbageCollectionTimeOut, this, SLOT(garbageCollection()));
+        tree.remove(currentPair.first.toRect(), currentPair.second);
         return; // already done
     }
 
@@ -795,7 +986,7 @@ void StyleStorage::garbageCollection()
             debugSheetsStyle << "removing" << currentPair.second->debugData()
             << "at" << Region(currentPair.first.toRect()).name()
             << "used" << currentPair.second->ref << "times" << endl;
-            d->tree.remove(currentPair.first.toRect(), currentPair.second, currentZIndex);
+            tree.remove(currentPair.first.toRect(), currentPair.second, currentZIndex);
 #if 0
             debugSheetsStyle << "StyleStorage: usage of" << currentPair.second->debugData() << " is" << currentPair.second->ref;
             // FIXME Stefan: The usage of substyles used once should be
@@ -807,13 +998,12 @@ void StyleStorage::garbageCollection()
             //               d) the undo data of operations (!)
             if (currentPair.second->ref == 2) {
                 debugSheetsStyle << "StyleStorage: removing" << currentPair.second << " from the used subStyles";
-                d->subStyles[currentPair.second->type()].removeAll(currentPair.second);
+                subStyles[currentPair.second->type()].removeAll(currentPair.second);
             }
 #endif
             break;
         }
     }
-    QTimer::singleShot(g_garbageCollectionTimeOut, this, SLOT(garbageCollection()));
 }
 
 void StyleStorage::regionChanged(const QRect& rect)
@@ -827,9 +1017,10 @@ void StyleStorage::regionChanged(const QRect& rect)
     // NOTE Stefan: The map may contain multiple indices. The already existing possible garbage has
     // has to be inserted most recently, because it should be accessed first.
     d->possibleGarbage = d->tree.intersectingPairs(rect).unite(d->possibleGarbage);
-    QTimer::singleShot(g_garbageCollectionTimeOut, this, SLOT(garbageCollection()));
     // invalidate cache
     invalidateCache(rect);
+    // compact the tree right away; remaining garbage is collected in later batches
+    garbageCollection();
 }
 
 void StyleStorage::invalidateCache(const QRect& rect)
@@ -838,20 +1029,8 @@ void StyleStorage::invalidateCache(const QRect& rect)
     if (d->loader && !d->loader->isFinished())
         return;
 
-#ifdef CALLIGRA_SHEETS_MT
-    QMutexLocker ml(&d->cacheMutex);
-#endif
 //     debugSheetsStyle <<"StyleStorage: Invalidating" << rect;
-    const QRegion region = d->cachedArea.intersected(rect);
-    d->cachedArea = d->cachedArea.subtracted(rect);
-    foreach(const QRect& rect, region.rects()) {
-        for (int col = rect.left(); col <= rect.right(); ++col) {
-            for (int row = rect.top(); row <= rect.bottom(); ++row) {
-//                 debugSheetsStyle <<"StyleStorage: Removing cached style for" << Cell::name( col, row );
-                d->cache.remove(QPoint(col, row));     // also deletes it
-            }
-        }
-    }
+    d->invalidate(rect);
 }
 
 Style StyleStorage::composeStyle(const QList<SharedSubStyle>& subStyles) const
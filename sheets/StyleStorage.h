@@ -46,12 +46,67 @@ class StyleStorageLoaderJob;
  * Acts mainly as a wrapper around the R-Tree data structure to allow a future
  * replacement of this backend. Decorated with some additional features like
  * garbage collection, caching, used area tracking, etc.
+ *
+ * The composed styles of looked up cells are cached row by row as spans of
+ * consecutive columns sharing a style. Adjacent spans with the same style get
+ * merged, so uniformly formatted areas cost one cache entry per row. Redundant
+ * substyles are removed from the tree right after each modification.
  */
 class CALLIGRA_SHEETS_ODF_EXPORT StyleStorage : public QObject
 {
     Q_OBJECT
 
 public:
+    /**
+     * Iterates over the styles of a row as spans of consecutive columns
+     * sharing a style, e.g. to paint or save a row without composing the
+     * style of each cell. Adjacent spans differ in their styles.
+     */
+    class CALLIGRA_SHEETS_ODF_EXPORT RowIterator
+    {
+    public:
+        /**
+         * Starts at the span containing the cell at \p left , \p row .
+         * The spans are clipped to the columns from \p left to \p right .
+         */
+        RowIterator(const StyleStorage* storage, int row, int left, int right);
+
+        /**
+         * \return \c true , if all spans have been visited
+         */
+        bool atEnd() const;
+
+        /**
+         * Moves to the next span.
+         */
+        void next();
+
+        /**
+         * \return the first column of the current span
+         */
+        int left() const;
+
+        /**
+         * \return the last column of the current span
+         */
+        int right() const;
+
+        /**
+         * \return the style of the current span
+         */
+        Style style() const;
+
+    private:
+        void lookup();
+
+        const StyleStorage* m_storage;
+        int m_row;
+        int m_left;
+        int m_right;
+        int m_end;
+        Style m_style;
+    };
+
     explicit StyleStorage(Map* map);
     StyleStorage(const StyleStorage& other);
     virtual ~StyleStorage();
@@ -196,14 +251,19 @@ public:
      */
     void invalidateCache();
 
-protected Q_SLOTS:
+protected:
+    /**
+     * Removes the redundant substyles among the possible garbage, i.e. the
+     * substyles being overridden completely by others.
+     * Called after each modification. Checks a bounded batch of the possible
+     * garbage and schedules the next batch, if there is garbage left.
+     */
     void garbageCollection();
 
-protected:
     /**
      * Triggers all necessary actions after a change of \p rect .
-     * Calls invalidateCache() and adds the substyles in
-     * \p rect to the list of possible garbage.
+     * Calls invalidateCache() and collects the garbage among the
+     * substyles in \p rect .
      */
     void regionChanged(const QRect& rect);
 
@@ -224,7 +284,21 @@ protected:
      */
     StyleManager* styleManager() const;
 
+private Q_SLOTS:
+    /**
+     * Collects the next batch of garbage.
+     */
+    void scheduledGarbageCollection();
+
 private:
+    /**
+     * Composes the style for \p point and the columns around it, which share
+     * the style, if it is not cached yet.
+     * \param left, right set to the first and last column of the span, if given
+     * \return the Style at the position \p point .
+     */
+    Style styleSpan(const QPoint& point, int* left, int* right) const;
+
     friend class StyleStorageLoaderJob;
     // disable assignment
     void operator=(const StyleStorage& other);
@@ -595,6 +595,12 @@ unsigned Value::count() const
     return d->pa->storage().count();
 }
 
+const ValueStorage* Value::arrayStorage() const
+{
+    if (d->type != Array) return 0;
+    return d->pa ? &d->pa->storage() : 0;
+}
+
 // reference to empty value
 const Value& Value::empty()
 {
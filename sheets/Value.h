@@ -372,6 +372,13 @@ public:
      */
     unsigned count() const;
 
+    /**
+     * If this value is an array, returns the storage of its elements, which
+     * are kept at 1-based positions. Returns 0 otherwise.
+     * Usable to process the elements without copying them.
+     */
+    const ValueStorage* arrayStorage() const;
+
     /**
      * Returns error message associated with this value.
      *
@@ -23,6 +23,7 @@
 #include "Cell.h"
 #include "Number.h"
 #include "ValueConverter.h"
+#include "ValueStorage.h"
 #include "CalculationSettings.h"
 #include "SheetsDebug.h"
 
@@ -191,6 +192,207 @@ void awDevSqA(ValueCalc *c, Value &res, Value val,
 }
 
 
+// Bulk versions of the array-walk functions above for arrays of numbers,
+// strings, booleans and empty values. Instead of calling a function and
+// creating a Value per element, they gather the numbers into a buffer and
+// reduce it at once. They yield the same result as arrayWalk, including the
+// format, and return false without touching res for anything else, e.g.
+// errors or nested arrays, which then take the element-wise path.
+
+typedef bool (*bulkWalkFunc)(Value &res, const Value &range);
+
+// The numbers gathered before they get reduced.
+static const int s_bulkBufferSize = 1024;
+
+// Sums up numbers with four independent accumulators, which keeps the
+// additions from waiting on each other and lets the compiler vectorize them.
+static Number sumNumbers(const Number *numbers, int count)
+{
+    Number sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        sum0 += numbers[i];
+        sum1 += numbers[i + 1];
+        sum2 += numbers[i + 2];
+        sum3 += numbers[i + 3];
+    }
+    for (; i < count; ++i)
+        sum0 += numbers[i];
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
+#ifdef CALLIGRA_SHEETS_COLUMNAR_VALUES
+// Adds up the numbers of an array straight from the typed columns of its
+// storage. Only done, if the element formats cannot change the result
+// format, i.e. if it is set and no date, because the columns are not
+// walked in the order of the elements.
+static bool columnarSum(Value::Format format, const Value &range, Number *sum, int *count)
+{
+    if (format == Value::fmt_None || format == Value::fmt_Boolean ||
+            format == Value::fmt_Date || format == Value::fmt_DateTime)
+        return false;
+    const ValueStorage *storage = range.arrayStorage();
+    if (!storage)
+        return false;
+    return storage->sumNumbers(QRect(1, 1, storage->columns(), storage->rows()), sum, count);
+}
+#endif
+
+static bool bulkSum(Value &res, const Value &range)
+{
+    // awSum combines the formats like this for numeric results only
+    if (!range.isArray() || !res.isNumber())
+        return false;
+    Value::Format format = res.format();
+#ifdef CALLIGRA_SHEETS_COLUMNAR_VALUES
+    Number total = 0.0;
+    int numbers = 0;
+    if (columnarSum(format, range, &total, &numbers)) {
+        if (numbers)
+            res = Value(res.asFloat() + total);
+        if (res.format() != format)
+            res.setFormat(format);
+        return true;
+    }
+#endif
+    Number buffer[s_bulkBufferSize];
+    int buffered = 0;
+    Number sum = 0.0;
+    bool found = false;
+    const unsigned count = range.count();
+    for (unsigned i = 0; i < count; ++i) {
+        const Value v = range.element(i);
+        switch (v.type()) {
+        case Value::Integer:
+        case Value::Float:
+            buffer[buffered++] = v.asFloat();
+            if (buffered == s_bulkBufferSize) {
+                sum += sumNumbers(buffer, buffered);
+                buffered = 0;
+            }
+            format = ValueCalc::format(format, v.format());
+            found = true;
+            break;
+        case Value::Empty:
+        case Value::Boolean:
+        case Value::String:
+            break;
+        default:
+            return false;
+        }
+        if (format == Value::fmt_None)
+            format = v.format();
+    }
+    if (found)
+        res = Value(res.asFloat() + sum + sumNumbers(buffer, buffered));
+    if (res.format() != format)
+        res.setFormat(format);
+    return true;
+}
+
+static bool bulkCount(Value &res, const Value &range)
+{
+    if (!range.isArray() || !res.isNumber())
+        return false;
+    Value::Format format = res.format();
+    int numbers = 0;
+#ifdef CALLIGRA_SHEETS_COLUMNAR_VALUES
+    Number sum = 0.0;
+    if (columnarSum(format, range, &sum, &numbers)) {
+        if (numbers)
+            res = Value(res.asFloat() + numbers);
+        if (res.format() != format)
+            res.setFormat(format);
+        return true;
+    }
+#endif
+    const unsigned count = range.count();
+    for (unsigned i = 0; i < count; ++i) {
+        const Value v = range.element(i);
+        switch (v.type()) {
+        case Value::Integer:
+        case Value::Float:
+            ++numbers;
+            break;
+        case Value::Empty:
+        case Value::Boolean:
+        case Value::String:
+            break;
+        default:
+            return false;
+        }
+        if (format == Value::fmt_None)
+            format = v.format();
+    }
+    if (numbers)
+        res = Value(res.asFloat() + numbers);
+    if (res.format() != format)
+        res.setFormat(format);
+    return true;
+}
+
+// The extremes are kept as the elements themselves, so there is no buffer.
+static bool bulkExtreme(Value &res, const Value &range, bool maximum)
+{
+    if (!range.isArray() || !(res.isEmpty() || res.isNumber()))
+        return false;
+    const Value original(res);
+    Number extreme = res.asFloat();
+    const unsigned count = range.count();
+    for (unsigned i = 0; i < count; ++i) {
+        const Value v = range.element(i);
+        switch (v.type()) {
+        case Value::Integer:
+        case Value::Float: {
+            const Number number = v.asFloat();
+            if (res.isEmpty() || (maximum ? number > extreme : number < extreme)) {
+                res = v;
+                extreme = number;
+            }
+            break;
+        }
+        case Value::Empty:
+        case Value::Boolean:
+        case Value::String:
+            break;
+        default:
+            res = original;
+            return false;
+        }
+        if (res.format() == Value::fmt_None)
+            res.setFormat(v.format());
+    }
+    return true;
+}
+
+static bool bulkMax(Value &res, const Value &range)
+{
+    return bulkExtreme(res, range, true);
+}
+
+static bool bulkMin(Value &res, const Value &range)
+{
+    return bulkExtreme(res, range, false);
+}
+
+// arrayWalk using the bulk function for each array
+static void bulkArrayWalk(ValueCalc *c, const Value &range, Value &res,
+                          bulkWalkFunc bulk, arrayWalkFunc func)
+{
+    if (res.isError())
+        return;
+    if (!bulk(res, range))
+        c->arrayWalk(range, res, func, Value(0));
+}
+
+static void bulkArrayWalk(ValueCalc *c, const QVector<Value> &range, Value &res,
+                          bulkWalkFunc bulk, arrayWalkFunc func)
+{
+    for (int i = 0; i < range.count() && !res.isError(); ++i)
+        bulkArrayWalk(c, range[i], res, bulk, func);
+}
+
+
 // ***********************
 // ****** ValueCalc ******
 // ***********************
@@ -1926,14 +2128,20 @@ void ValueCalc::registerAwFunc(const QString &name, arrayWalkFunc func)
 Value ValueCalc::sum(const Value &range, bool full)
 {
     Value res(0);
-    arrayWalk(range, res, full ? awSumA : awSum, Value(0));
+    if (full)
+        arrayWalk(range, res, awSumA, Value(0));
+    else
+        bulkArrayWalk(this, range, res, bulkSum, awSum);
     return res;
 }
 
 Value ValueCalc::sum(QVector<Value> range, bool full)
 {
     Value res(0);
-    arrayWalk(range, res, full ? awSumA : awSum, Value(0));
+    if (full)
+        arrayWalk(range, res, awSumA, Value(0));
+    else
+        bulkArrayWalk(this, range, res, bulkSum, awSum);
     return res;
 }
 
@@ -2193,14 +2401,20 @@ Value ValueCalc::averageIfs(const Cell &avgRangeStart, QList<Value> range, QList
 int ValueCalc::count(const Value &range, bool full)
 {
     Value res(0);
-    arrayWalk(range, res, full ? awCountA : awCount, Value(0));
+    if (full)
+        arrayWalk(range, res, awCountA, Value(0));
+    else
+        bulkArrayWalk(this, range, res, bulkCount, awCount);
     return converter->asInteger(res).asInteger();
 }
 
 int ValueCalc::count(QVector<Value> range, bool full)
 {
     Value res(0);
-    arrayWalk(range, res, full ? awCountA : awCount, Value(0));
+    if (full)
+        arrayWalk(range, res, awCountA, Value(0));
+    else
+        bulkArrayWalk(this, range, res, bulkCount, awCount);
     return converter->asInteger(res).asInteger();
 }
 
@@ -2292,28 +2506,40 @@ Value ValueCalc::avg(QVector<Value> range, bool full)
 Value ValueCalc::max(const Value &range, bool full)
 {
     Value res;
-    arrayWalk(range, res, full ? awMaxA : awMax, Value(0));
+    if (full)
+        arrayWalk(range, res, awMaxA, Value(0));
+    else
+        bulkArrayWalk(this, range, res, bulkMax, awMax);
     return res;
 }
 
 Value ValueCalc::max(QVector<Value> range, bool full)
 {
     Value res;
-    arrayWalk(range, res, full ? awMaxA: awMax, Value(0));
+    if (full)
+        arrayWalk(range, res, awMaxA, Value(0));
+    else
+        bulkArrayWalk(this, range, res, bulkMax, awMax);
     return res;
 }
 
 Value ValueCalc::min(const Value &range, bool full)
 {
     Value res;
-    arrayWalk(range, res, full ? awMinA : awMin, Value(0));
+    if (full)
+        arrayWalk(range, res, awMinA, Value(0));
+    else
+        bulkArrayWalk(this, range, res, bulkMin, awMin);
     return res;
 }
 
 Value ValueCalc::min(QVector<Value> range, bool full)
 {
     Value res;
-    arrayWalk(range, res, full ? awMinA : awMin, Value(0));
+    if (full)
+        arrayWalk(range, res, awMinA, Value(0));
+    else
+        bulkArrayWalk(this, range, res, bulkMin, awMin);
     return res;
 }
 
@@ -2408,9 +2634,11 @@ bool isDate(Value::Format fmt)
 
 Value::Format ValueCalc::format(Value a, Value b)
 {
-    Value::Format af = a.format();
-    Value::Format bf = b.format();
+    return format(a.format(), b.format());
+}
 
+Value::Format ValueCalc::format(Value::Format af, Value::Format bf)
+{
     // operation on two dates should produce a number
     if (isDate(af) && isDate(bf))
         return Value::fmt_Number;
@@ -2462,8 +2690,10 @@ void ValueCalc::getCond(Condition &cond, Value val)
         cond.stringValue = text;
         if (settings()->useWildcards()) { // HOST-USE-WILDCARDS Excel like wildcard matching
             cond.comp = wildcardMatch;
+            cond.regex = QRegExp(text, Qt::CaseInsensitive, QRegExp::Wildcard);
         } else if (settings()->useRegularExpressions()) { // HOST-USE-REGULAR-EXPRESSION ODF like regex matching
             cond.comp = regexMatch;
+            cond.regex = QRegExp(text, Qt::CaseInsensitive, QRegExp::RegExp);
         } else { // Simple string matching
             cond.comp = stringMatch;
         }
@@ -2549,21 +2779,11 @@ bool ValueCalc::matches(const Condition &cond, Value val)
             if (d.toLower() == cond.stringValue.toLower()) return true;
             break;
 
-        case regexMatch: {
-            QRegExp rx;
-            rx.setPattern(cond.stringValue);
-            rx.setPatternSyntax(QRegExp::RegExp);
-            rx.setCaseSensitivity(Qt::CaseInsensitive);
-            if (rx.exactMatch(d)) return true;
-        } break;
-
-        case wildcardMatch: {
-            QRegExp rx;
-            rx.setPattern(cond.stringValue);
-            rx.setPatternSyntax(QRegExp::Wildcard);
-            rx.setCaseSensitivity(Qt::CaseInsensitive);
-            if (rx.exactMatch(d)) return true;
-        } break;
+        case regexMatch:
+        case wildcardMatch:
+            // compiled by getCond()
+            if (cond.regex.exactMatch(d)) return true;
+            break;
 
         }
     }
@@ -22,6 +22,7 @@
 
 #include <map>
 
+#include <QRegExp>
 #include <QVector>
 
 #include "Number.h"
@@ -54,6 +55,8 @@ struct Condition {
     Number   value;
     QString  stringValue;
     Type     type;
+    // the compiled pattern of a regexMatch or a wildcardMatch
+    QRegExp  regex;
 };
 
 typedef void (*arrayWalkFunc)(ValueCalc *, Value &result,
@@ -327,6 +330,7 @@ public:
 
     /** return formatting for the result, based on formattings of input values */
     Value::Format format(Value a, Value b);
+    static Value::Format format(Value::Format a, Value::Format b);
 
 protected:
     ValueConverter* converter;
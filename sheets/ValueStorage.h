@@ -22,6 +22,10 @@
 
 #include "PointStorage.h"
 
+#ifdef CALLIGRA_SHEETS_COLUMNAR_VALUES
+#include "ColumnarValueStorage.h"
+#endif
+
 namespace Calligra
 {
 namespace Sheets
@@ -32,7 +36,28 @@ namespace Sheets
  * \ingroup Storage
  * \ingroup Value
  * Stores cell values.
+ *
+ * With CALLIGRA_SHEETS_COLUMNAR_VALUES defined the values are kept column
+ * by column in typed arrays, which saves memory for numeric sheets.
  */
+#ifdef CALLIGRA_SHEETS_COLUMNAR_VALUES
+class ValueStorage : public ColumnarValueStorage
+{
+public:
+    ValueStorage()
+            : ColumnarValueStorage() {
+    }
+
+    ValueStorage(const ColumnarValueStorage& o)  //krazy:exclude=explicit
+            : ColumnarValueStorage(o) {
+    }
+
+    ValueStorage& operator=(const ColumnarValueStorage& o) {
+        ColumnarValueStorage::operator=(o);
+        return *this;
+    }
+};
+#else
 class ValueStorage : public PointStorage<Value>
 {
 public:
@@ -49,6 +74,7 @@ public:
         return *this;
     }
 };
+#endif
 
 } // namespace Sheets
 } // namespace Calligra
@@ -52,12 +52,19 @@ void ApplyFilterCommand::redo()
     const QRect range = database.range().lastRange();
     const int start = database.orientation() == Qt::Vertical ? range.top() : range.left();
     const int end = database.orientation() == Qt::Vertical ? range.bottom() : range.right();
+    const QBitArray results = database.filter().evaluate(database, start + 1, end);
     for (int i = start + 1; i <= end; ++i) {
-        const bool isFiltered = !database.filter().evaluate(database, i);
+        const bool isFiltered = !results.testBit(i - start - 1);
 //         debugSheets <<"Filtering column/row" << i <<"?" << isFiltered;
         if (database.orientation() == Qt::Vertical) {
-            m_undoData[i] = sheet->rowFormats()->isFiltered(i);
-            sheet->rowFormats()->setFiltered(i, i, isFiltered);
+            // the rows with the same result at once
+            int last = i;
+            while (last < end && results.testBit(last - start) == !isFiltered)
+                ++last;
+            for (int row = i; row <= last; ++row)
+                m_undoData[row] = sheet->rowFormats()->isFiltered(row);
+            sheet->rowFormats()->setFiltered(i, last, isFiltered);
+            i = last;
         } else { // database.orientation() == Qt::Horizontal
             m_undoData[i] = sheet->columnFormat(i)->isFiltered();
             sheet->nonDefaultColumnFormat(i)->setFiltered(isFiltered);
@@ -83,9 +90,14 @@ void ApplyFilterCommand::undo()
     const int start = database.orientation() == Qt::Vertical ? range.top() : range.left();
     const int end = database.orientation() == Qt::Vertical ? range.bottom() : range.right();
     for (int i = start + 1; i <= end; ++i) {
-        if (database.orientation() == Qt::Vertical)
-            sheet->rowFormats()->setFiltered(i, i, m_undoData[i]);
-        else // database.orientation() == Qt::Horizontal
+        if (database.orientation() == Qt::Vertical) {
+            // the rows with the same state at once
+            int last = i;
+            while (last < end && m_undoData[last + 1] == m_undoData[i])
+                ++last;
+            sheet->rowFormats()->setFiltered(i, last, m_undoData[i]);
+            i = last;
+        } else // database.orientation() == Qt::Horizontal
             sheet->nonDefaultColumnFormat(i)->setFiltered(m_undoData[i]);
     }
     if (database.orientation() == Qt::Vertical)
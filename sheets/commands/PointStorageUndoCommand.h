@@ -23,6 +23,7 @@
 // Qt
 #include <QAbstractItemModel>
 #include <QPair>
+#include <QRect>
 #include <kundo2command.h>
 #include <QVector>
 
@@ -34,6 +35,151 @@ namespace Calligra
 namespace Sheets
 {
 
+/**
+ * \ingroup Commands
+ * \brief The undo data of PointStorage locations.
+ *
+ * Keeps the old data of the altered locations in the order of their alteration.
+ * Bulk edits, like pasting or filling, mostly alter empty cells. Hence, the
+ * locations of default data are not kept one by one, but as rectangles, which
+ * grow while the locations are recorded row by row or column by column.
+ */
+template<typename T>
+class PointStorageUndoData
+{
+public:
+    typedef QPair<QPoint, T> Pair;
+
+    bool isEmpty() const;
+
+    /**
+     * \return the approximate amount of memory in bytes kept by the undo data
+     */
+    qint64 size() const;
+
+    /**
+     * Restores the data in \p model in reverse order.
+     */
+    void undo(QAbstractItemModel *const model, int role) const;
+
+    PointStorageUndoData& operator<<(const Pair &pair);
+    PointStorageUndoData& operator<<(const QVector<Pair> &pairs);
+    PointStorageUndoData& operator<<(const PointStorageUndoData &other);
+
+private:
+    // Merges the last rectangle of default data into the one before, if possible.
+    void mergeDefaults();
+
+    // non-default data
+    QVector<Pair> m_pairs;
+    // the locations of default data and the number of pairs recorded before them
+    QVector<QPair<QRect, int> > m_defaults;
+};
+
+template<typename T>
+bool PointStorageUndoData<T>::isEmpty() const
+{
+    return m_pairs.isEmpty() && m_defaults.isEmpty();
+}
+
+template<typename T>
+qint64 PointStorageUndoData<T>::size() const
+{
+    return qint64(m_pairs.count()) * sizeof(Pair) + qint64(m_defaults.count()) * sizeof(QPair<QRect, int>);
+}
+
+template<typename T>
+void PointStorageUndoData<T>::undo(QAbstractItemModel *const model, int role) const
+{
+    QVariant defaultData;
+    defaultData.setValue(T());
+    // In reverse order for the case that a location was altered multiple times.
+    int j = m_defaults.count() - 1;
+    for (int i = m_pairs.count() - 1; i >= -1; --i) {
+        // the default data recorded after the pair
+        for (; j >= 0 && m_defaults[j].second > i; --j) {
+            const QRect rect = m_defaults[j].first;
+            for (int row = rect.bottom(); row >= rect.top(); --row) {
+                for (int column = rect.right(); column >= rect.left(); --column)
+                    model->setData(model->index(row - 1, column - 1), defaultData, role);
+            }
+        }
+        if (i < 0)
+            break;
+        const int column = m_pairs[i].first.x();
+        const int row = m_pairs[i].first.y();
+        QVariant data;
+        data.setValue(m_pairs[i].second);
+        model->setData(model->index(row - 1, column - 1), data, role);
+    }
+}
+
+template<typename T>
+PointStorageUndoData<T>& PointStorageUndoData<T>::operator<<(const Pair& pair)
+{
+    if (!(pair.second == T())) {
+        m_pairs << pair;
+        return *this;
+    }
+    const QPoint point = pair.first;
+    if (!m_defaults.isEmpty() && m_defaults.last().second == m_pairs.count()) {
+        QRect& rect = m_defaults.last().first;
+        if (rect.contains(point))
+            return *this;
+        // grow the row or column
+        if (rect.height() == 1 && point.y() == rect.top() && point.x() == rect.right() + 1) {
+            rect.setRight(point.x());
+            return *this;
+        }
+        if (rect.width() == 1 && point.x() == rect.left() && point.y() == rect.bottom() + 1) {
+            rect.setBottom(point.y());
+            return *this;
+        }
+    }
+    mergeDefaults();
+    m_defaults << qMakePair(QRect(point, point), m_pairs.count());
+    return *this;
+}
+
+template<typename T>
+PointStorageUndoData<T>& PointStorageUndoData<T>::operator<<(const QVector<Pair>& pairs)
+{
+    for (int i = 0; i < pairs.count(); ++i)
+        *this << pairs[i];
+    return *this;
+}
+
+template<typename T>
+PointStorageUndoData<T>& PointStorageUndoData<T>::operator<<(const PointStorageUndoData& other)
+{
+    if (isEmpty()) {
+        *this = other;
+        return *this;
+    }
+    const int offset = m_pairs.count();
+    m_pairs << other.m_pairs;
+    for (int i = 0; i < other.m_defaults.count(); ++i)
+        m_defaults << qMakePair(other.m_defaults[i].first, other.m_defaults[i].second + offset);
+    return *this;
+}
+
+template<typename T>
+void PointStorageUndoData<T>::mergeDefaults()
+{
+    const int count = m_defaults.count();
+    if (count < 2 || m_defaults[count - 2].second != m_defaults[count - 1].second)
+        return;
+    QRect& previous = m_defaults[count - 2].first;
+    const QRect last = m_defaults[count - 1].first;
+    if (last.left() == previous.left() && last.right() == previous.right() && last.top() == previous.bottom() + 1)
+        previous.setBottom(last.bottom());
+    else if (last.top() == previous.top() && last.bottom() == previous.bottom() && last.left() == previous.right() + 1)
+        previous.setRight(last.right());
+    else
+        return;
+    m_defaults.removeLast();
+}
+
 /**
  * \ingroup Commands
  * \brief An undo command for PointStorage data.
@@ -52,8 +198,10 @@ public:
     PointStorageUndoCommand(QAbstractItemModel *const model, int role, KUndo2Command *parent = 0);
 
     virtual void undo();
+    virtual qint64 size() const;
 
     void add(const QVector<Pair> &pairs);
+    void add(const PointStorageUndoData<T> &data);
 
     PointStorageUndoCommand& operator<<(const Pair &pair);
     PointStorageUndoCommand& operator<<(const QVector<Pair> &pairs);
@@ -61,7 +209,7 @@ public:
 private:
     QAbstractItemModel *const m_model;
     const int m_role;
-    QVector<Pair> m_undoData;
+    PointStorageUndoData<T> m_undoData;
 };
 
 template<typename T>
@@ -76,24 +224,28 @@ PointStorageUndoCommand<T>::PointStorageUndoCommand(QAbstractItemModel *const mo
 template<typename T>
 void PointStorageUndoCommand<T>::undo()
 {
-    // In reverse order for the case that a location was altered multiple times.
-    for (int i = m_undoData.count() - 1; i >= 0; --i) {
-        const int column = m_undoData[i].first.x();
-        const int row = m_undoData[i].first.y();
-        const QModelIndex index = m_model->index(row - 1, column - 1);
-        QVariant data;
-        data.setValue(m_undoData[i].second);
-        m_model->setData(index, data, m_role);
-    }
+    m_undoData.undo(m_model, m_role);
     KUndo2Command::undo(); // undo possible child commands
 }
 
+template<typename T>
+qint64 PointStorageUndoCommand<T>::size() const
+{
+    return m_undoData.size() + KUndo2Command::size();
+}
+
 template<typename T>
 void PointStorageUndoCommand<T>::add(const QVector<Pair>& pairs)
 {
     m_undoData << pairs;
 }
 
+template<typename T>
+void PointStorageUndoCommand<T>::add(const PointStorageUndoData<T>& data)
+{
+    m_undoData << data;
+}
+
 template<typename T>
 PointStorageUndoCommand<T>& PointStorageUndoCommand<T>::operator<<(const Pair& pair)
 {
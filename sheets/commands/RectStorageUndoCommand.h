@@ -52,6 +52,7 @@ public:
     RectStorageUndoCommand(QAbstractItemModel *const model, int role, KUndo2Command *parent = 0);
 
     virtual void undo();
+    virtual qint64 size() const;
 
     void add(const QList<Pair> &pairs);
 
@@ -85,6 +86,12 @@ void RectStorageUndoCommand<T>::undo()
     KUndo2Command::undo(); // undo possible child commands
 }
 
+template<typename T>
+qint64 RectStorageUndoCommand<T>::size() const
+{
+    return qint64(m_undoData.count()) * sizeof(Pair) + KUndo2Command::size();
+}
+
 template<typename T>
 void RectStorageUndoCommand<T>::add(const QList<Pair>& pairs)
 {
@@ -20,6 +20,7 @@
 
 #include "SortManipulator.h"
 
+#include "FormulaStorage.h"
 #include "Map.h"
 #include "Sheet.h"
 #include "ValueCalc.h"
@@ -27,8 +28,151 @@
 
 #include <KLocalizedString>
 
+#ifdef CALLIGRA_SHEETS_MT
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#endif
+
+#include <algorithm>
+
 using namespace Calligra::Sheets;
 
+#ifdef CALLIGRA_SHEETS_MT
+// Smaller ranges are sorted by a single thread.
+static const int s_minimumChunkSize = 8192;
+#endif
+
+namespace
+{
+/**
+ * The sort keys of all rows (columns) to sort, looked up once before sorting.
+ * Compares the rows (columns) by their indices. Empty values go to the end;
+ * values in the custom list are ordered as in the list; all others are
+ * compared like ValueCalc::naturalGreater() does.
+ */
+class SortKeys
+{
+public:
+    SortKeys(ValueCalc* calc, int count, int criteria)
+            : m_calc(calc), m_criteria(criteria), m_values(count * criteria) {}
+
+    void addCriterion(bool ascending, bool caseSensitive) {
+        m_ascending.append(ascending);
+        m_caseSensitive.append(caseSensitive);
+    }
+
+    void setValue(int index, int criterion, const Value& value) {
+        // lower the strings once; ValueCalc::natural* does it for each comparison
+        if (!m_caseSensitive[criterion] && value.isString())
+            m_values[index * m_criteria + criterion] = Value(value.asString().toLower());
+        else
+            m_values[index * m_criteria + criterion] = value;
+    }
+
+    void setCustomPosition(int index, int criterion, int position) {
+        if (m_customPositions.isEmpty())
+            m_customPositions.fill(-1, m_values.count());
+        m_customPositions[index * m_criteria + criterion] = position;
+    }
+
+    // Whether second has to be placed before first.
+    bool reorder(int first, int second) const {
+        for (int i = 0; i < m_criteria; ++i) {
+            const Value& val1 = m_values[first * m_criteria + i];
+            const Value& val2 = m_values[second * m_criteria + i];
+            // empty values always go to the end
+            if (!val1.isEmpty() && val2.isEmpty())
+                return false;
+            if (val1.isEmpty() && !val2.isEmpty())
+                return true;
+
+            // both are in the custom list, not the same
+            if (!m_customPositions.isEmpty()) {
+                const int pos1 = m_customPositions[first * m_criteria + i];
+                const int pos2 = m_customPositions[second * m_criteria + i];
+                if ((pos1 >= 0) && (pos2 >= 0) && (pos1 != pos2))
+                    return (pos1 > pos2);
+            }
+
+            if (naturalGreater(val1, val2, m_caseSensitive[i]))
+                return m_ascending[i];
+            if (naturalGreater(val2, val1, m_caseSensitive[i]))
+                return !m_ascending[i];
+        }
+        return false;
+    }
+
+    // The order of the indices for std::stable_sort.
+    bool operator()(int first, int second) const {
+        return reorder(second, first);
+    }
+
+private:
+    // ValueCalc::naturalGreater() with the strings already lowered
+    bool naturalGreater(const Value& a, const Value& b, bool caseSensitive) const {
+        if (a.allowComparison(b))
+            return a.greater(b);
+        return m_calc->strEqual(a, b, caseSensitive);
+    }
+
+    ValueCalc* m_calc;
+    int m_criteria;
+    // the values index by index, criterion by criterion
+    QVector<Value> m_values;
+    // the positions of the values in the custom list or -1; empty without list
+    QVector<int> m_customPositions;
+    QVector<bool> m_ascending;
+    QVector<bool> m_caseSensitive;
+};
+
+#ifdef CALLIGRA_SHEETS_MT
+/**
+ * Sorts a chunk of the indices.
+ */
+class SortJob : public QRunnable
+{
+public:
+    SortJob(int* begin, int* end, const SortKeys& keys)
+        : m_begin(begin), m_end(end), m_keys(keys) {}
+
+    void run() Q_DECL_OVERRIDE {
+        std::stable_sort(m_begin, m_end, m_keys);
+    }
+
+private:
+    int* m_begin;
+    int* m_end;
+    const SortKeys& m_keys;
+};
+#endif
+
+// A stable merge sort of the indices; in chunks in parallel, if possible.
+void stableSort(int* begin, int* end, const SortKeys& keys)
+{
+#ifdef CALLIGRA_SHEETS_MT
+    const int count = end - begin;
+    const int chunks = qMin(QThread::idealThreadCount(), count / s_minimumChunkSize);
+    if (chunks > 1) {
+        QVector<int*> bounds;
+        for (int i = 0; i <= chunks; ++i)
+            bounds.append(begin + qint64(count) * i / chunks);
+        QThreadPool threadPool;
+        for (int i = 0; i < chunks; ++i)
+            threadPool.start(new SortJob(bounds[i], bounds[i + 1], keys));
+        threadPool.waitForDone();
+        // merge the sorted chunks; equal keys keep the order of the chunks
+        for (int width = 1; width < chunks; width *= 2) {
+            for (int i = 0; i + width < chunks; i += 2 * width)
+                std::inplace_merge(bounds[i], bounds[i + width], bounds[qMin(i + 2 * width, chunks)], keys);
+        }
+        return;
+    }
+#endif
+    std::stable_sort(begin, end, keys);
+}
+}
+
 SortManipulator::SortManipulator()
         : AbstractDFManipulator()
         , m_cellStorage(0)
@@ -70,16 +214,24 @@ bool SortManipulator::preProcessing()
 
     m_cellStorage = new CellStorage(m_sheet->cellStorage()->subStorage(*this));
 
-    Region::ConstIterator endOfList(cells().constEnd());
-    for (Region::ConstIterator it = cells().constBegin(); it != endOfList; ++it) {
-        QRect range = (*it)->rect();
-        for (int col = range.left(); col <= range.right(); ++col)
-            for (int row = range.top(); row <= range.bottom(); ++row) {
-                Cell cell = Cell(m_sheet, col, row);
-                m_styles.insert(cell, cell.style());
-                // encode the formula if there is one, so that cell references get updated correctly
-                if (cell.isFormula()) m_formulas.insert(cell, cell.encodeFormula());
-            }
+    const FormulaStorage* formulas = m_cellStorage->formulaStorage();
+    for (int i = 0; i < formulas->count(); ++i) {
+        Cell cell = Cell(m_sheet, formulas->col(i), formulas->row(i));
+        // encode the formula, so that cell references get updated correctly
+        m_formulas.insert(cell, cell.encodeFormula());
+    }
+
+    // the styles are only needed, if they get moved
+    if (m_changeformat) {
+        Region::ConstIterator endOfList(cells().constEnd());
+        for (Region::ConstIterator it = cells().constBegin(); it != endOfList; ++it) {
+            QRect range = (*it)->rect();
+            for (int col = range.left(); col <= range.right(); ++col)
+                for (int row = range.top(); row <= range.bottom(); ++row) {
+                    Cell cell = Cell(m_sheet, col, row);
+                    m_styles.insert(cell, cell.style());
+                }
+        }
     }
 
     // to start undo recording
@@ -111,6 +263,15 @@ void SortManipulator::clearCriteria()
     m_criteria.clear();
 }
 
+bool SortManipulator::wantChange(Element *element, int col, int row)
+{
+    // the rows/columns staying in place keep their values
+    QRect range = element->rect();
+    if (m_rows)
+        return sorted[row - range.top()] != row - range.top();
+    return sorted[col - range.left()] != col - range.left();
+}
+
 Value SortManipulator::newValue(Element *element, int col, int row,
                                 bool *parse, Format::Type *)
 {
@@ -155,92 +316,46 @@ Style SortManipulator::newFormat(Element *element, int col, int row)
 
 void SortManipulator::sort(Element *element)
 {
-    // we'll use insert-sort to sort
     QRect range = element->rect();
-    int max = m_rows ? range.bottom() : range.right();
-    int min = m_rows ? range.top() : range.left();
-    int count = max - min + 1;
+    int count = m_rows ? range.height() : range.width();
     // initially, all values are at their original positions
-    sorted.clear();
+    sorted.resize(count);
     for (int i = 0; i < count; ++i) sorted[i] = i;
 
-    // for each position, find the lowest value and move it there
     int start = m_skipfirst ? 1 : 0;
-    for (int i = start; i < count - 1; ++i) {
-        int lowest = i;
-        for (int j = i + 1; j < count; ++j)
-            if (shouldReorder(element, sorted[lowest], sorted[j]))
-                lowest = j;
-        // move lowest to start
-        int tmp = sorted[i];
-        sorted[i] = sorted[lowest];
-        sorted[lowest] = tmp;
-    }
-
-    // that's all - process will take care of the rest, together with our
-    // newValue/newFormat
-}
-
-bool SortManipulator::shouldReorder(Element *element, int first, int second)
-{
-    // we use ValueCalc::natural* to compare
-    // indexes are real indexes, we don't use the sorted array here
+    if (count - start < 2 || m_criteria.isEmpty())
+        return;
 
+    // Look up the sort keys once; comparing them is what takes the time.
     ValueCalc *calc = m_sheet->map()->calc();
     ValueConverter *conv = m_sheet->map()->converter();
+    const CellStorage *storage = m_sheet->cellStorage();
 
-    QRect range = element->rect();
-    int firstrow = range.top();
-    int firstcol = range.left();
+    QHash<QString, int> customPositions;
+    if (m_usecustomlist) {
+        for (int i = m_customlist.count() - 1; i >= 0; --i)
+            customPositions.insert(m_customlist[i].toLower(), i);
+    }
 
+    SortKeys keys(calc, count, m_criteria.count());
     for (int i = 0; i < m_criteria.count(); ++i) {
         int which = m_criteria[i].index;
-        bool ascending = m_criteria[i].order == Qt::AscendingOrder;
-        bool caseSensitive = m_criteria[i].caseSensitivity == Qt::CaseSensitive;
-
-        // figure out coordinates of the cells
-        int row1 = firstrow + (m_rows ? first : which);
-        int row2 = firstrow + (m_rows ? second : which);
-        int col1 = firstcol + (m_rows ? which : first);
-        int col2 = firstcol + (m_rows ? which : second);
-        Value val1 = Cell(m_sheet, col1, row1).value();
-        Value val2 = Cell(m_sheet, col2, row2).value();
-        // empty values always go to the end, so if second value is empty and
-        // first one is not, we don't need to reorder
-        if (!val1.isEmpty() && val2.isEmpty())
-            return false;
-        if (val1.isEmpty() && !val2.isEmpty())
-            return true;
-
-        // custom list ?
-        if (m_usecustomlist) {
-            QString s1 = conv->asString(val1).asString().toLower();
-            QString s2 = conv->asString(val2).asString().toLower();
-            int pos1 = -1, pos2 = -1;
-            int pos = 0;
-            // Try to locate our two strings in the list. If both are there, assume
-            // ordering as specified by the list.
-            for (QStringList::ConstIterator  it = m_customlist.constBegin(); it != m_customlist.constEnd(); ++it) {
-                if ((pos1 == -1) && ((*it).toLower() == s1))
-                    pos1 = pos;
-                if ((pos2 == -1) && ((*it).toLower() == s2))
-                    pos2 = pos;
-                pos++;
+        keys.addCriterion(m_criteria[i].order == Qt::AscendingOrder,
+                          m_criteria[i].caseSensitivity == Qt::CaseSensitive);
+        for (int j = start; j < count; ++j) {
+            int row = range.top() + (m_rows ? j : which);
+            int col = range.left() + (m_rows ? which : j);
+            const Value value = storage->value(col, row);
+            keys.setValue(j, i, value);
+            if (m_usecustomlist && !value.isEmpty()) {
+                const QString string = conv->asString(value).asString().toLower();
+                keys.setCustomPosition(j, i, customPositions.value(string, -1));
             }
-            if ((pos1 >= 0) && (pos2 >= 0) && (pos1 != pos2))
-                // both are in the list, not the same
-                return (pos1 > pos2);
         }
-
-        if (calc->naturalGreater(val1, val2, caseSensitive))
-            // first one greater - must reorder if ascending, don't reorder if not
-            return ascending;
-        if (calc->naturalLower(val1, val2, caseSensitive))
-            // first one lower - don't reorder if ascending, reorder if not
-            return !ascending;
-        // equal - don't know yet, continue
     }
 
-    // no difference found, they're the same - no need to reorder
-    return false;
+    stableSort(sorted.data() + start, sorted.data() + count, keys);
+
+    // that's all - process will take care of the rest, together with our
+    // newValue/newFormat
 }
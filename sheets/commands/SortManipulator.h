@@ -75,13 +75,17 @@ public:
 protected:
     virtual bool preProcessing();
     virtual bool postProcessing();
+    virtual bool wantChange(Element *element, int col, int row);
     virtual Value newValue(Element *element, int col, int row,
                            bool *parse, Format::Type *fmtType);
     virtual Style newFormat(Element *element, int col, int row);
 
-    /** sort the data, filling the "sorted" structure */
+    /**
+     * Sorts the data, filling the "sorted" structure.
+     * The sort keys are looked up once; the rows/columns get sorted by a
+     * stable merge sort, so rows/columns with equal keys keep their order.
+     */
     void sort(Element *element);
-    bool shouldReorder(Element *element, int first, int second);
 
     bool m_rows, m_skipfirst, m_usecustomlist;
     QStringList m_customlist;
@@ -94,7 +98,7 @@ protected:
     QList<Criterion> m_criteria;
 
     /** sorted order - which row/column will move to where */
-    QMap<int, int> sorted;
+    QVector<int> sorted;
 
     CellStorage* m_cellStorage; // temporary
     QHash<Cell, Style> m_styles; // temporary
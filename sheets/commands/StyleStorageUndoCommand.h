@@ -50,6 +50,7 @@ public:
     explicit StyleStorageUndoCommand(StyleStorage *storage, KUndo2Command *parent = 0);
 
     virtual void undo();
+    virtual qint64 size() const;
 
     void add(const QList<Pair> &pairs);
 
@@ -75,6 +76,11 @@ void StyleStorageUndoCommand::undo()
     KUndo2Command::undo(); // undo possible child commands
 }
 
+qint64 StyleStorageUndoCommand::size() const
+{
+    return qint64(m_undoData.count()) * sizeof(Pair) + KUndo2Command::size();
+}
+
 void StyleStorageUndoCommand::add(const QList<Pair>& pairs)
 {
     m_undoData << pairs;
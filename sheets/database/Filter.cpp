@@ -32,19 +32,139 @@
 #include "Sheet.h"
 #include "Value.h"
 #include "ValueConverter.h"
+#include "ValueStorage.h"
 #include "odf/SheetsOdf.h"
 
 using namespace Calligra::Sheets;
 
+FilterFieldIndex::FilterFieldIndex(const Database& database, int fieldNumber, int first, int last)
+{
+    const Sheet* sheet = database.range().lastSheet();
+    const QRect range = database.range().lastRange();
+    const CellStorage* storage = sheet->cellStorage();
+    const ValueConverter* converter = sheet->map()->converter();
+    // the string of the empty cells gets the id 0
+    insert(converter->asString(Value()).asString());
+    m_ids.fill(0, qMax(0, last - first + 1));
+    if (m_ids.isEmpty())
+        return;
+    if (database.orientation() == Qt::Vertical) {
+        // visit the non-empty cells only
+        const int column = range.left() + fieldNumber;
+        int row = first;
+        Value value = storage->value(column, row);
+        while (row && row <= last) {
+            if (!value.isEmpty())
+                m_ids[row - first] = insert(converter->asString(value).asString());
+            value = storage->valueStorage()->nextInColumn(column, row, &row);
+        }
+    } else { // database.orientation() == Qt::Horizontal
+        const int row = range.top() + fieldNumber;
+        for (int column = first; column <= last; ++column) {
+            const Value value = storage->value(column, row);
+            if (!value.isEmpty())
+                m_ids[column - first] = insert(converter->asString(value).asString());
+        }
+    }
+}
+
+int FilterFieldIndex::insert(const QString& string)
+{
+    QHash<QString, int>::ConstIterator it = m_exactStrings.constFind(string);
+    if (it != m_exactStrings.constEnd())
+        return it.value();
+    const int id = m_strings.count();
+    m_strings.append(string);
+    m_exactStrings.insert(string, id);
+    m_foldedStrings[string.toCaseFolded()].append(id);
+    return id;
+}
+
+int FilterFieldIndex::count() const
+{
+    return m_strings.count();
+}
+
+QString FilterFieldIndex::string(int id) const
+{
+    return m_strings.value(id);
+}
+
+int FilterFieldIndex::size() const
+{
+    return m_ids.count();
+}
+
+int FilterFieldIndex::id(int index) const
+{
+    return m_ids.value(index, -1);
+}
+
+QVector<int> FilterFieldIndex::find(const QString& string, Qt::CaseSensitivity caseSensitivity) const
+{
+    QVector<int> ids;
+    if (caseSensitivity == Qt::CaseSensitive) {
+        QHash<QString, int>::ConstIterator it = m_exactStrings.constFind(string);
+        if (it != m_exactStrings.constEnd())
+            ids.append(it.value());
+        return ids;
+    }
+    // the case folding is a hint; the comparison decides
+    const QVector<int> candidates = m_foldedStrings.value(string.toCaseFolded());
+    for (int i = 0; i < candidates.count(); ++i) {
+        if (QString::compare(string, m_strings[candidates[i]], Qt::CaseInsensitive) == 0)
+            ids.append(candidates[i]);
+    }
+    return ids;
+}
+
+QBitArray FilterFieldIndex::select(const QBitArray& ids) const
+{
+    QBitArray result(m_ids.count());
+    for (int i = 0; i < m_ids.count(); ++i) {
+        if (ids.testBit(m_ids[i]))
+            result.setBit(i);
+    }
+    return result;
+}
+
+
 class Calligra::Sheets::AbstractCondition
 {
 public:
+    // The indexed fields of the columns/rows evaluated at once.
+    class Fields
+    {
+    public:
+        Fields(const Database& database, int first, int last)
+                : m_database(database), m_first(first), m_last(last) {}
+        ~Fields() {
+            qDeleteAll(m_indices);
+        }
+        int count() const {
+            return m_last - m_first + 1;
+        }
+        const FilterFieldIndex& field(int fieldNumber) {
+            FilterFieldIndex*& index = m_indices[fieldNumber];
+            if (!index)
+                index = new FilterFieldIndex(m_database, fieldNumber, m_first, m_last);
+            return *index;
+        }
+    private:
+        Q_DISABLE_COPY(Fields)
+        const Database& m_database;
+        const int m_first;
+        const int m_last;
+        QHash<int, FilterFieldIndex*> m_indices;
+    };
+
     virtual ~AbstractCondition() {}
     enum Type { And, Or, Condition };
     virtual Type type() const = 0;
     virtual bool loadOdf(const KoXmlElement& element) = 0;
     virtual void saveOdf(KoXmlWriter& xmlWriter) = 0;
     virtual bool evaluate(const Database& database, int index) const = 0;
+    virtual QBitArray evaluate(Fields& fields) const = 0;
     virtual bool isEmpty() const = 0;
     virtual QHash<QString, Filter::Comparison> conditions(int fieldNumber) const = 0;
     virtual void removeConditions(int fieldNumber) = 0;
@@ -85,6 +205,7 @@ public:
         }
         return true;
     }
+    virtual QBitArray evaluate(Fields& fields) const;
     virtual bool isEmpty() const {
         return list.isEmpty();
     }
@@ -154,6 +275,7 @@ public:
         }
         return false;
     }
+    virtual QBitArray evaluate(Fields& fields) const;
     virtual bool isEmpty() const {
         return list.isEmpty();
     }
@@ -368,6 +490,20 @@ public:
         }
         return false;
     }
+    virtual QBitArray evaluate(Fields& fields) const {
+        const FilterFieldIndex& field = fields.field(fieldNumber);
+        return field.select(matches(field));
+    }
+    // \return the distinct strings of the field fulfilling the condition
+    QBitArray matches(const FilterFieldIndex& field) const {
+        if (operation != Match && operation != NotMatch)
+            return QBitArray(field.count());
+        QBitArray result(field.count(), operation == NotMatch);
+        const QVector<int> ids = field.find(value, caseSensitivity);
+        for (int i = 0; i < ids.count(); ++i)
+            result.setBit(ids[i], operation == Match);
+        return result;
+    }
     virtual bool isEmpty() const {
         return fieldNumber == -1;
     }
@@ -417,6 +553,46 @@ public:
     Mode dataType;
 };
 
+QBitArray Filter::And::evaluate(Fields& fields) const
+{
+    QBitArray result(fields.count(), true);
+    // the conditions on a field are combined on its distinct strings
+    QHash<int, QBitArray> matches;
+    for (int i = 0; i < list.count(); ++i) {
+        if (list[i]->type() == AbstractCondition::Condition) {
+            const Filter::Condition* condition = static_cast<Filter::Condition*>(list[i]);
+            const QBitArray bits = condition->matches(fields.field(condition->fieldNumber));
+            QBitArray& fieldMatches = matches[condition->fieldNumber];
+            fieldMatches = fieldMatches.isNull() ? bits : (fieldMatches & bits);
+        } else
+            result &= list[i]->evaluate(fields);
+    }
+    QHash<int, QBitArray>::ConstIterator end = matches.constEnd();
+    for (QHash<int, QBitArray>::ConstIterator it = matches.constBegin(); it != end; ++it)
+        result &= fields.field(it.key()).select(it.value());
+    return result;
+}
+
+QBitArray Filter::Or::evaluate(Fields& fields) const
+{
+    QBitArray result(fields.count(), false);
+    // the conditions on a field are combined on its distinct strings
+    QHash<int, QBitArray> matches;
+    for (int i = 0; i < list.count(); ++i) {
+        if (list[i]->type() == AbstractCondition::Condition) {
+            const Filter::Condition* condition = static_cast<Filter::Condition*>(list[i]);
+            const QBitArray bits = condition->matches(fields.field(condition->fieldNumber));
+            QBitArray& fieldMatches = matches[condition->fieldNumber];
+            fieldMatches = fieldMatches.isNull() ? bits : (fieldMatches | bits);
+        } else
+            result |= list[i]->evaluate(fields);
+    }
+    QHash<int, QBitArray>::ConstIterator end = matches.constEnd();
+    for (QHash<int, QBitArray>::ConstIterator it = matches.constBegin(); it != end; ++it)
+        result |= fields.field(it.key()).select(it.value());
+    return result;
+}
+
 Filter::And::And(const And& other)
         : AbstractCondition()
 {
@@ -663,6 +839,16 @@ bool Filter::evaluate(const Database& database, int index) const
     return d->condition ? d->condition->evaluate(database, index) : true;
 }
 
+QBitArray Filter::evaluate(const Database& database, int first, int last) const
+{
+    if (last < first)
+        return QBitArray();
+    if (!d->condition)
+        return QBitArray(last - first + 1, true);
+    AbstractCondition::Fields fields(database, first, last);
+    return d->condition->evaluate(fields);
+}
+
 bool Filter::loadOdf(const KoXmlElement& element, const Map* map)
 {
     if (element.hasAttributeNS(KoXmlNS::table, "target-range-address")) {
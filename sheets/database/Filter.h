@@ -20,8 +20,10 @@
 #ifndef CALLIGRA_SHEETS_FILTER
 #define CALLIGRA_SHEETS_FILTER
 
+#include <QBitArray>
 #include <QHash>
 #include <QString>
+#include <QVector>
 
 #include <KoXmlReader.h>
 
@@ -37,6 +39,61 @@ class Database;
 class Map;
 class AbstractCondition;
 
+/**
+ * The strings of a database field, i.e. of a column of the database range for
+ * a row filter or of a row for a column filter, as the filter conditions
+ * compare them. The strings are indexed by distinct value, so a condition has
+ * to be tested once per distinct value instead of once per cell.
+ */
+class CALLIGRA_SHEETS_ODF_EXPORT FilterFieldIndex
+{
+public:
+    /**
+     * Indexes the field \p fieldNumber of the rows/columns \p first to \p last .
+     */
+    FilterFieldIndex(const Database& database, int fieldNumber, int first, int last);
+
+    /**
+     * \return the number of distinct strings
+     */
+    int count() const;
+
+    /**
+     * \return the distinct string \p id
+     */
+    QString string(int id) const;
+
+    /**
+     * \return the number of indexed rows/columns
+     */
+    int size() const;
+
+    /**
+     * \return the id of the string of the row/column \p first + \p index
+     */
+    int id(int index) const;
+
+    /**
+     * \return the ids of the strings equal to \p string
+     */
+    QVector<int> find(const QString& string, Qt::CaseSensitivity caseSensitivity) const;
+
+    /**
+     * \return the rows/columns, whose string is one of the strings set in \p ids
+     */
+    QBitArray select(const QBitArray& ids) const;
+
+private:
+    // \return the id of \p string , which gets added, if it is a new one
+    int insert(const QString& string);
+
+    QVector<QString> m_strings;
+    QHash<QString, int> m_exactStrings;
+    // the ids of the strings by their case folded string
+    QHash<QString, QVector<int> > m_foldedStrings;
+    QVector<int> m_ids;
+};
+
 /**
  * OpenDocument, 8.7.1 Table Filter
  */
@@ -101,6 +158,14 @@ public:
      */
     bool evaluate(const Database& database, int index) const;
 
+    /**
+     * Evaluates the filter for the columns/rows \p first to \p last at once.
+     * The fields are indexed once by FilterFieldIndex and the conditions are
+     * tested once per distinct value of their field.
+     * \return the results of evaluate() for \p first to \p last
+     */
+    QBitArray evaluate(const Database& database, int first, int last) const;
+
     bool loadOdf(const KoXmlElement& element, const Map* map);
     void saveOdf(KoXmlWriter& xmlWriter) const;
 
@@ -79,19 +79,19 @@ void FilterPopup::Private::initGUI(FilterPopup* parent, const Cell& cell, const
     layout->addWidget(notEmptyCheckbox);
     layout->addSpacing(3);
 
-    const Sheet* sheet = cell.sheet();
     const QRect range = database->range().lastRange();
     const bool isRowFilter = database->orientation() == Qt::Vertical;
     const int start = isRowFilter ? range.top() : range.left();
     const int end = isRowFilter ? range.bottom() : range.right();
     const int j = isRowFilter ? cell.column() : cell.row();
-    QSet<QString> items;
-    for (int i = start + (database->containsHeader() ? 1 : 0); i <= end; ++i) {
-        const Value value = isRowFilter ? sheet->cellStorage()->value(j, i)
-                            : sheet->cellStorage()->value(i, j);
-        const QString string = sheet->map()->converter()->asString(value).asString();
+    const int fieldNumber = j - (isRowFilter ? range.left() : range.top());
+    // the distinct strings as the filter conditions compare them
+    const FilterFieldIndex index(*database, fieldNumber, start + (database->containsHeader() ? 1 : 0), end);
+    QList<QString> sortedItems;
+    for (int i = 0; i < index.count(); ++i) {
+        const QString string = index.string(i);
         if (!string.isEmpty())
-            items.insert(string);
+            sortedItems.append(string);
     }
 
     QWidget* scrollWidget = new QWidget(parent);
@@ -99,12 +99,10 @@ void FilterPopup::Private::initGUI(FilterPopup* parent, const Cell& cell, const
     scrollLayout->setMargin(0);
     scrollLayout->setSpacing(0);
 
-    const int fieldNumber = j - (isRowFilter ? range.left() : range.top());
     const QHash<QString, Filter::Comparison> conditions = database->filter().conditions(fieldNumber);
     const bool defaultCheckState = conditions.isEmpty() ? true
                                    : !(conditions[conditions.keys()[0]] == Filter::Match ||
                                        conditions[conditions.keys()[0]] == Filter::Empty);
-    QList<QString> sortedItems = items.toList();
     qSort(sortedItems);
     bool isAll = true;
     QCheckBox* item;
@@ -39,6 +39,10 @@
 // needed for SUBTOTAL:
 #include "Cell.h"
 #include "Sheet.h"
+
+// needed for SUMIF and COUNTIF:
+#include "CellStorage.h"
+#include "CriteriaCache.h"
 #include "RowColumnFormat.h"
 #include "RowFormatStorage.h"
 
@@ -567,6 +571,80 @@ Value func_suma(valVector args, ValueCalc *calc, FuncExtra *)
     return calc->sum(args, true);
 }
 
+// Returns the cell range of the argument at \p position and its sheet in
+// \p sheet , if the argument is a single cell range. Otherwise, the range is null.
+static QRect cellRange(FuncExtra *e, int position, Sheet **sheet)
+{
+    if (!e || position >= e->regions.count())
+        return QRect();
+    const Region& region = e->regions[position];
+    if (!region.isValid() || !region.isContiguous())
+        return QRect();
+    *sheet = region.firstSheet();
+    return region.firstRange();
+}
+
+// Returns the cached groups of the values of the argument at \p position ,
+// if the argument is a cell range, which can be grouped.
+static QSharedPointer<const CriteriaGroups> criteriaGroups(FuncExtra *e, int position, const Value& data)
+{
+    Sheet *sheet = 0;
+    const QRect range = cellRange(e, position, &sheet);
+    if (range.isNull())
+        return QSharedPointer<const CriteriaGroups>();
+    return sheet->cellStorage()->criteriaCache()->groups(range, data);
+}
+
+// Tests the conditions against the groups of the criteria ranges in \p args
+// starting at \p first , which are every second argument. Each distinct
+// value of a range gets tested once. Fails, if one of the ranges has no
+// cached groups or is not of the size of \p data .
+static bool matchGroups(ValueCalc *calc, FuncExtra *e, const valVector& args, int first,
+                        const QList<Condition>& conditions, const Value& data,
+                        QVector<QSharedPointer<const CriteriaGroups> >& groups,
+                        QVector<QVector<bool> >& matches)
+{
+    for (int i = 0; i < conditions.count(); ++i) {
+        const int position = first + 2 * i;
+        if (args[position].columns() != data.columns() || args[position].rows() != data.rows())
+            return false;
+        const QSharedPointer<const CriteriaGroups> rangeGroups = criteriaGroups(e, position, args[position]);
+        if (!rangeGroups)
+            return false;
+        QVector<bool> rangeMatches(rangeGroups->count());
+        for (int group = 0; group < rangeGroups->count(); ++group)
+            rangeMatches[group] = calc->matches(conditions[i], rangeGroups->value(group));
+        groups.append(rangeGroups);
+        matches.append(rangeMatches);
+    }
+    return !groups.isEmpty();
+}
+
+// Returns, whether the cell at \p index matches in all of the \p groups .
+static bool matchesAll(const QVector<QSharedPointer<const CriteriaGroups> >& groups,
+                       const QVector<QVector<bool> >& matches, int index)
+{
+    for (int i = 0; i < groups.count(); ++i) {
+        const int group = groups[i]->group(index);
+        if (group == -1 || !matches[i][group])
+            return false;
+    }
+    return true;
+}
+
+// Sums up the partial sums of the groups matching \p cond the same way
+// ValueCalc::sumIf() sums up the cells.
+static Value sumGroups(ValueCalc *calc, const CriteriaGroups& groups, const CriteriaSums& sums,
+                       const Condition& cond)
+{
+    Value res(0);
+    for (int group = 0; group < groups.count(); ++group) {
+        if (sums.count(group) && calc->matches(cond, groups.value(group)))
+            res = calc->add(res, Value(sums.sum(group)));
+    }
+    return res;
+}
+
 // Function: SUMIF
 Value func_sumif(valVector args, ValueCalc *calc, FuncExtra *e)
 {
@@ -575,6 +653,33 @@ Value func_sumif(valVector args, ValueCalc *calc, FuncExtra *e)
     Condition cond;
     calc->getCond(cond, Value(condition));
 
+    // sum up the cached partial sums per distinct value of a cell range
+    Sheet *sheet = 0;
+    const QRect range = cellRange(e, 0, &sheet);
+    if (!range.isNull()) {
+        CriteriaCache *const cache = sheet->cellStorage()->criteriaCache();
+        const QSharedPointer<const CriteriaGroups> groups = cache->groups(range, checkRange);
+        if (groups && args.count() == 3) {
+            Sheet *sumSheet = 0;
+            const QRect sumArgument = cellRange(e, 2, &sumSheet);
+            // the sum range has the size of the criteria range
+            const QRect sumRange(sumArgument.topLeft(), range.size());
+            if (!sumArgument.isNull() && sumSheet == sheet && QRect(1, 1, KS_colMax, KS_rowMax).contains(sumRange)) {
+                QSharedPointer<const CriteriaSums> sums = cache->sums(range, sumRange);
+                if (!sums) {
+                    const Value sumData = sheet->cellStorage()->valueRegion(Region(sumRange, sheet));
+                    sums = cache->sums(range, checkRange, sumRange, sumData);
+                }
+                if (sums)
+                    return sumGroups(calc, *groups, *sums, cond);
+            }
+        } else if (groups) {
+            const QSharedPointer<const CriteriaSums> sums = cache->sums(range, checkRange, range, checkRange);
+            if (sums)
+                return sumGroups(calc, *groups, *sums, cond);
+        }
+    }
+
     if (args.count() == 3) {
         Cell sumRangeStart(e->regions[2].firstSheet(), e->regions[2].firstRange().topLeft());
         return calc->sumIf(sumRangeStart, checkRange, cond);
@@ -601,6 +706,29 @@ Value func_sumifs(valVector args, ValueCalc *calc, FuncExtra *e)
         calc->getCond(c, Value(condition.last()));
         cond.append(c);
     }
+
+    // test the distinct values of the criteria cell ranges instead of each cell
+    const Value sumRange = c_Range[0];
+    QVector<QSharedPointer<const CriteriaGroups> > groups;
+    QVector<QVector<bool> > matches;
+    if (sumRange.isArray() && matchGroups(calc, e, args, 1, cond.mid(0, lim), sumRange, groups, matches)) {
+        Value res(0);
+        bool mismatch = false;
+        const int cols = sumRange.columns();
+        const int cells = sumRange.rows() * cols;
+        for (int i = 0; i < cells; ++i) {
+            if (!matchesAll(groups, matches, i)) {
+                mismatch = true;
+                continue;
+            }
+            const Value val = sumRange.element(i % cols, i / cols);
+            if (val.isNumber()) // only add numbers, no conversion from string allowed
+                res = calc->add(res, val);
+        }
+        // ValueCalc::sumIfs() adds a zero for each mismatch
+        return mismatch ? calc->add(res, Value(0.0)) : res;
+    }
+
     Cell sumRangeStart(e->sheet, e->ranges[2].col1, e->ranges[2].row1);
     return calc->sumIfs(sumRangeStart, c_Range, cond, lim);
 }
@@ -1053,6 +1181,17 @@ Value func_countif(valVector args, ValueCalc *calc, FuncExtra *e)
     Condition cond;
     calc->getCond(cond, Value(condition));
 
+    // test each distinct value of a cell range once
+    const QSharedPointer<const CriteriaGroups> groups = criteriaGroups(e, 0, range);
+    if (groups) {
+        int count = 0;
+        for (int group = 0; group < groups->count(); ++group) {
+            if (calc->matches(cond, groups->value(group)))
+                count += groups->size(group);
+        }
+        return Value(count);
+    }
+
     return Value(calc->countIf(range, cond));
 }
 
@@ -1076,6 +1215,21 @@ Value func_countifs(valVector args, ValueCalc *calc, FuncExtra *e)
         calc->getCond(c, Value(condition.last()));
         cond.append(c);
     }
+
+    // test the distinct values of the criteria cell ranges instead of each cell
+    QVector<QSharedPointer<const CriteriaGroups> > groups;
+    QVector<QVector<bool> > matches;
+    if (c_Range[0].isArray() && matchGroups(calc, e, args, 0, cond.mid(0, lim + 1), c_Range[0], groups, matches)) {
+        int count = 0;
+        const int cells = c_Range[0].rows() * c_Range[0].columns();
+        for (int i = 0; i < cells; ++i) {
+            if (matchesAll(groups, matches, i))
+                ++count;
+        }
+        // ValueCalc::countIfs() adds up ones
+        return count ? calc->add(Value(0), Value(count)) : Value(0);
+    }
+
     Cell cntRangeStart(e->sheet, e->ranges[2].col1, e->ranges[2].row1);
     return calc->countIfs(cntRangeStart, c_Range, cond, lim);
 }
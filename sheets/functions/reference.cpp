@@ -32,8 +32,10 @@
 #include "Formula.h"
 #include "Function.h"
 #include "FunctionModuleRegistry.h"
+#include "LookupCache.h"
 #include "ValueCalc.h"
 #include "ValueConverter.h"
+#include "ValueStorage.h"
 
 using namespace Calligra::Sheets;
 
@@ -92,8 +94,10 @@ ReferenceModule::ReferenceModule(QObject* parent, const QVariantList&)
     f->setNeedsExtra(true);
     add(f);
     f = new Function("HLOOKUP",  func_hlookup);
+    f->setAcceptCellRange(1);
     f->setParamCount(3, 4);
     f->setAcceptArray();
+    f->setNeedsExtra(true);
     add(f);
     f = new Function("INDEX",   func_index);
     f->setParamCount(3);
@@ -108,6 +112,7 @@ ReferenceModule::ReferenceModule(QObject* parent, const QVariantList&)
     f->setAcceptArray();
     add(f);
     f = new Function("MATCH", func_match);
+    f->setAcceptCellRange(1);
     f->setParamCount(2, 3);
     f->setAcceptArray();
     f->setNeedsExtra(true);
@@ -138,8 +143,10 @@ ReferenceModule::ReferenceModule(QObject* parent, const QVariantList&)
     f->setNeedsExtra(true);
     add(f);
     f = new Function("VLOOKUP",  func_vlookup);
+    f->setAcceptCellRange(1);
     f->setParamCount(3, 4);
     f->setAcceptArray();
+    f->setNeedsExtra(true);
     add(f);
 }
 
@@ -350,13 +357,77 @@ Value func_columns(valVector, ValueCalc *, FuncExtra *e)
 }
 
 
+// Returns the cached index of the lookup vector of the argument at \p position ,
+// if the argument is a cell range and its vector is long enough to be indexed.
+static QSharedPointer<const LookupIndex> lookupIndex(FuncExtra *e, int position, const Value& data,
+                                                     Qt::Orientation orientation)
+{
+    if (!e || position >= e->regions.count())
+        return QSharedPointer<const LookupIndex>();
+    const Region& region = e->regions[position];
+    if (!region.isValid() || !region.isContiguous())
+        return QSharedPointer<const LookupIndex>();
+    return region.firstSheet()->cellStorage()->lookupCache()->index(region.firstRange(), data, orientation);
+}
+
+// The table searched by a lookup function. If it is a cell range passed as
+// Value::CellRange, only the cells looked at are read from the sheet instead
+// of fetching the values of the whole range.
+class LookupTable
+{
+public:
+    LookupTable(const valVector& args, FuncExtra *e, int position)
+        : m_extra(e)
+        , m_position(position)
+        , m_sheet(0)
+    {
+        if (args[position].type() == Value::CellRange && e && e->regions[position].isContiguous()) {
+            m_sheet = e->regions[position].firstSheet();
+            m_range = e->regions[position].firstRange();
+        } else {
+            m_data = argumentValue(args, e, position);
+        }
+    }
+
+    int columns() const {
+        return m_sheet ? m_range.width() : m_data.columns();
+    }
+
+    int rows() const {
+        return m_sheet ? m_range.height() : m_data.rows();
+    }
+
+    Value element(int column, int row) const {
+        if (!m_sheet)
+            return m_data.element(column, row);
+        if (column >= m_range.width() || row >= m_range.height())
+            return Value::empty();
+        return m_sheet->cellStorage()->value(m_range.left() + column, m_range.top() + row);
+    }
+
+    // Returns the cached index of the first column (Qt::Vertical) or row (Qt::Horizontal).
+    QSharedPointer<const LookupIndex> index(Qt::Orientation orientation) const {
+        if (m_sheet)
+            return m_sheet->cellStorage()->lookupCache()->index(m_range, *m_sheet->valueStorage(), orientation);
+        return lookupIndex(m_extra, m_position, m_data, orientation);
+    }
+
+private:
+    FuncExtra* const m_extra;
+    const int m_position;
+    Sheet* m_sheet;
+    QRect m_range;
+    Value m_data;
+};
+
+
 //
 // Function: HLOOKUP
 //
-Value func_hlookup(valVector args, ValueCalc *calc, FuncExtra *)
+Value func_hlookup(valVector args, ValueCalc *calc, FuncExtra *e)
 {
     const Value key = args[0];
-    const Value data = args[1];
+    const LookupTable data(args, e, 1);
     const int row = calc->conv()->asInteger(args[2]).asInteger();
     const int cols = data.columns();
     const int rows = data.rows();
@@ -364,9 +435,21 @@ Value func_hlookup(valVector args, ValueCalc *calc, FuncExtra *)
         return Value::errorVALUE();
     const bool rangeLookup = (args.count() > 3) ? calc->conv()->asBoolean(args[3]).asBoolean() : true;
 
+    // use the cached index of the first row, if it is a cell range
+    if (LookupIndex::isIndexable(key)) {
+        const QSharedPointer<const LookupIndex> index = data.index(Qt::Horizontal);
+        if (index) {
+            int col = index->find(key);
+            if (col == -1 && rangeLookup)
+                col = index->findLower(key);
+            return (col == -1) ? Value::errorNA() : data.element(col, row - 1);
+        }
+    }
+
     // now traverse the array and perform comparison
     Value r;
     Value v = Value::errorNA();
+    bool found = false;
     for (int col = 0; col < cols; ++col) {
         // search in the first row
         const Value le = data.element(col, 0);
@@ -374,9 +457,10 @@ Value func_hlookup(valVector args, ValueCalc *calc, FuncExtra *)
             return data.element(col, row - 1);
         }
         // optionally look for the next largest value that is less than key
-        if (rangeLookup && calc->naturalLower(le, key) && calc->naturalLower(r, le)) {
+        if (rangeLookup && !le.isEmpty() && calc->naturalLower(le, key) && (!found || calc->naturalLower(r, le))) {
             r = le;
             v = data.element(col, row - 1);
+            found = true;
         }
     }
     return v;
@@ -474,7 +558,7 @@ Value func_match(valVector args, ValueCalc *calc, FuncExtra* e)
     }
 
     const Value& searchValue = args[0];
-    const Value& searchArray = args[1];
+    const LookupTable searchArray(args, e, 1);
 
     if (e->ranges[1].rows() != 1 && e->ranges[1].columns() != 1)
         return Value::errorNA();
@@ -485,6 +569,15 @@ Value func_match(valVector args, ValueCalc *calc, FuncExtra* e)
     int n = qMax(searchArray.rows(), searchArray.columns());
 
     if (matchType == 0) {
+        // use the cached index, if it is a cell range
+        if (LookupIndex::isIndexable(searchValue)) {
+            const Qt::Orientation orientation = (dr == 1) ? Qt::Vertical : Qt::Horizontal;
+            const QSharedPointer<const LookupIndex> index = searchArray.index(orientation);
+            if (index) {
+                const int position = index->find(searchValue, false);
+                return (position == -1) ? Value::errorNA() : Value(position + 1);
+            }
+        }
         // linear search
         for (int r = 0, c = 0; r < n && c < n; r += dr, c += dc) {
             if (calc->naturalEqual(searchValue, searchArray.element(c, r), false)) {
@@ -648,10 +741,10 @@ Value func_sheets(valVector /*args*/, ValueCalc *, FuncExtra *e)
 //
 // Function: VLOOKUP
 //
-Value func_vlookup(valVector args, ValueCalc *calc, FuncExtra *)
+Value func_vlookup(valVector args, ValueCalc *calc, FuncExtra *e)
 {
     const Value key = args[0];
-    const Value data = args[1];
+    const LookupTable data(args, e, 1);
     const int col = calc->conv()->asInteger(args[2]).asInteger();
     const int cols = data.columns();
     const int rows = data.rows();
@@ -659,9 +752,21 @@ Value func_vlookup(valVector args, ValueCalc *calc, FuncExtra *)
         return Value::errorVALUE();
     const bool rangeLookup = (args.count() > 3) ? calc->conv()->asBoolean(args[3]).asBoolean() : true;
 
+    // use the cached index of the first column, if it is a cell range
+    if (LookupIndex::isIndexable(key)) {
+        const QSharedPointer<const LookupIndex> index = data.index(Qt::Vertical);
+        if (index) {
+            int row = index->find(key);
+            if (row == -1 && rangeLookup)
+                row = index->findLower(key);
+            return (row == -1) ? Value::errorNA() : data.element(col - 1, row);
+        }
+    }
+
     // now traverse the array and perform comparison
     Value r;
     Value v = Value::errorNA();
+    bool found = false;
     for (int row = 0; row < rows; ++row) {
         // search in the first column
         const Value le = data.element(0, row);
@@ -669,9 +774,10 @@ Value func_vlookup(valVector args, ValueCalc *calc, FuncExtra *)
             return data.element(col - 1, row);
         }
         // optionally look for the next largest value that is less than key
-        if (rangeLookup && calc->naturalLower(le, key) && calc->naturalLower(r, le)) {
+        if (rangeLookup && !le.isEmpty() && calc->naturalLower(le, key) && (!found || calc->naturalLower(r, le))) {
             r = le;
             v = data.element(col - 1, row);
+            found = true;
         }
     }
     return v;
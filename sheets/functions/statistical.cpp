@@ -743,6 +743,70 @@ void tawSumxmy(ValueCalc *c, Value &res, Value v1,
     res = c->add(res, c->sub(v1, v2));
 }
 
+// The products gathered before they get summed up.
+static const int s_bulkBufferSize = 1024;
+
+// Sums up the products with four independent accumulators, which keeps
+// the additions from waiting on each other and lets the compiler vectorize them.
+static Number sumOfProducts(const Number *a, const Number *b, int count)
+{
+    Number sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        sum0 += a[i] * b[i];
+        sum1 += a[i + 1] * b[i + 1];
+        sum2 += a[i + 2] * b[i + 2];
+        sum3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < count; ++i)
+        sum0 += a[i] * b[i];
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
+// twoArrayWalk with tawSumproduct for two arrays of numbers and empty
+// values, which multiplies the elements in bulk instead of creating two
+// Values per element. Returns false without touching res for anything
+// else, e.g. strings, which get converted, or errors.
+static bool bulkSumproduct(const Value &a1, const Value &a2, Value &res)
+{
+    if (!a1.isArray() || !a2.isArray() || !res.isEmpty())
+        return false;
+    const unsigned rows = a1.rows();
+    const unsigned cols = a1.columns();
+    if (a2.rows() != rows || a2.columns() != cols)
+        return false;
+    // completely filled arrays are walked by index instead of by position
+    const bool dense = a1.count() == rows * cols && a2.count() == rows * cols;
+    Number buffer1[s_bulkBufferSize];
+    Number buffer2[s_bulkBufferSize];
+    int buffered = 0;
+    Number sum = 0.0;
+    Value::Format format = res.format();
+    for (unsigned r = 0; r < rows; ++r) {
+        for (unsigned c = 0; c < cols; ++c) {
+            const Value v1 = dense ? a1.element(r * cols + c) : a1.element(c, r);
+            const Value v2 = dense ? a2.element(r * cols + c) : a2.element(c, r);
+            if (!(v1.isEmpty() || v1.isInteger() || v1.isFloat()) ||
+                    !(v2.isEmpty() || v2.isInteger() || v2.isFloat()))
+                return false;
+            buffer1[buffered] = v1.asFloat();
+            buffer2[buffered] = v2.asFloat();
+            if (++buffered == s_bulkBufferSize) {
+                sum += sumOfProducts(buffer1, buffer2, buffered);
+                buffered = 0;
+            }
+            // the format of the product, then the one of the sum
+            format = ValueCalc::format(format, ValueCalc::format(v1.format(), v2.format()));
+        }
+    }
+    if (rows * cols == 0)
+        return true;
+    res = Value(sum + sumOfProducts(buffer1, buffer2, buffered));
+    if (res.format() != format)
+        res.setFormat(format);
+    return true;
+}
+
 ///////////////////////////////////////////////////////////
 //
 // functions used in this file
@@ -2643,7 +2707,8 @@ Value func_steyx(valVector args, ValueCalc* calc, FuncExtra*)
 Value func_sumproduct(valVector args, ValueCalc *calc, FuncExtra *)
 {
     Value result;
-    calc->twoArrayWalk(args[0], args[1], result, tawSumproduct);
+    if (!bulkSumproduct(args[0], args[1], result))
+        calc->twoArrayWalk(args[0], args[1], result, tawSumproduct);
     return result;
 }
 
@@ -0,0 +1,370 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "CellContentsLoader.h"
+
+#include <QDateTime>
+#ifdef CALLIGRA_SHEETS_MT
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QVector>
+#endif
+
+#include <KoTextLoader.h>
+#include <KoXmlNS.h>
+
+#include "SheetsOdfPrivate.h"
+
+#include "CalculationSettings.h"
+#include "Cell.h"
+#include "Map.h"
+#include "Sheet.h"
+#include "ValueConverter.h"
+
+using namespace Calligra::Sheets;
+using namespace Calligra::Sheets::Odf;
+
+namespace
+{
+// Mirrors loadCellText() and loadCell() for plain cells, as far as nothing
+// but the contents themselves are involved.
+void parse(CellContents& contents)
+{
+    QString userInput;
+    if (!contents.text.isNull()) {
+        userInput = KoTextLoader::normalizeWhitespace(contents.text, true);
+        if (userInput.isEmpty())
+            userInput = QString();
+    }
+
+    if (!contents.isFormula && !userInput.isEmpty() && userInput[0] == '=') //prepend ' to the text to avoid = to be painted
+        userInput.prepend('\'');
+
+    bool ok = false;
+    switch (contents.valueType) {
+    case CellContents::Boolean: {
+        const QString value = contents.attribute.toLower();
+        if (value == QLatin1String("true") || value == QLatin1String("false"))
+            contents.value = Value(value == QLatin1String("true"));
+        break;
+    }
+    case CellContents::Float: {
+        Value value(contents.attribute.toDouble(&ok));
+        if (ok) {
+            value.setFormat(Value::fmt_Number);
+            contents.value = value;
+        }
+        break;
+    }
+    case CellContents::Currency: {
+        Value value(contents.attribute.toDouble(&ok));
+        if (ok) {
+            value.setFormat(Value::fmt_Money);
+            contents.value = value;
+        }
+        break;
+    }
+    case CellContents::Percentage: {
+        Value value(contents.attribute.toDouble(&ok));
+        if (ok) {
+            value.setFormat(Value::fmt_Percent);
+            contents.value = value;
+        }
+        break;
+    }
+    case CellContents::Date: {
+        QDate date;
+        QTime time;
+        if (loadDateValue(contents.attribute, &date, &time, &contents.hasTime))
+            contents.dateTime = QDateTime(date, time);
+        break;
+    }
+    case CellContents::Time: {
+        QTime time;
+        if (loadTimeValue(contents.attribute, &time))
+            contents.value = Value(time);
+        break;
+    }
+    case CellContents::String:
+        break;
+    }
+
+    contents.text = userInput;
+    if (contents.valueType != CellContents::String)
+        contents.attribute.clear();
+}
+
+// Mirrors loadCellText() and loadCell() for the parts depending on the
+// document's locale and settings; runs after parse().
+void localize(CellContents& contents, const CalculationSettings* settings, const ValueConverter* converter)
+{
+    if (contents.isFormula) {
+        contents.text = loadCellFormula(contents.formula, settings->locale());
+        contents.formula.clear();
+    }
+
+    switch (contents.valueType) {
+    case CellContents::Float:
+        // an invalid number gets formatted as zero
+        if (!contents.isFormula)
+            contents.text = converter->asString(contents.value.isEmpty() ? Value(0.0) : contents.value).asString();
+        break;
+    case CellContents::Percentage:
+        if (!contents.value.isEmpty() && !contents.isFormula && contents.text.isEmpty())
+            contents.text = converter->asString(contents.value).asString();
+        break;
+    case CellContents::Date:
+        if (contents.dateTime.isValid()) {
+            if (contents.hasTime)
+                contents.value = Value(contents.dateTime, settings);
+            else
+                contents.value = Value(contents.dateTime.date(), settings);
+        }
+        break;
+    case CellContents::String:
+        contents.value = Value(contents.hasStringValue ? contents.attribute : contents.text);
+        contents.attribute.clear();
+        break;
+    default:
+        break;
+    }
+}
+}
+
+#ifdef CALLIGRA_SHEETS_MT
+// The number of cells parsed by a job.
+static const int s_chunkSize = 4096;
+
+class CellContentsLoader::Job : public QRunnable
+{
+public:
+    Job(Sheet* sheet)
+            : sheet(sheet) {
+        setAutoDelete(false);
+        contents.reserve(s_chunkSize);
+    }
+
+    void run() Q_DECL_OVERRIDE {
+        for (int i = 0; i < contents.count(); ++i)
+            parse(contents[i]);
+        done.release();
+    }
+
+    Sheet* const sheet;
+    QVector<CellContents> contents;
+    QSemaphore done;
+};
+#endif
+
+
+CellContentsLoader::CellContentsLoader(Map* map)
+        : m_map(map)
+        , m_current(0)
+{
+}
+
+CellContentsLoader::~CellContentsLoader()
+{
+    finish();
+}
+
+bool CellContentsLoader::read(Sheet* sheet, const KoXmlElement& element, int column, int row, int columns, int rows)
+{
+    static const QString sValueType             = QString::fromLatin1("value-type");
+    static const QString sBoolean               = QString::fromLatin1("boolean");
+    static const QString sBooleanValue          = QString::fromLatin1("boolean-value");
+    static const QString sFloat                 = QString::fromLatin1("float");
+    static const QString sValue                 = QString::fromLatin1("value");
+    static const QString sCurrency              = QString::fromLatin1("currency");
+    static const QString sPercentage            = QString::fromLatin1("percentage");
+    static const QString sDate                  = QString::fromLatin1("date");
+    static const QString sDateValue             = QString::fromLatin1("date-value");
+    static const QString sTime                  = QString::fromLatin1("time");
+    static const QString sTimeValue             = QString::fromLatin1("time-value");
+    static const QString sString                = QString::fromLatin1("string");
+    static const QString sStringValue           = QString::fromLatin1("string-value");
+    static const QString sFormula               = QString::fromLatin1("formula");
+    static const QString sValidationName        = QString::fromLatin1("validation-name");
+    static const QString sNumberColumnsSpanned  = QString::fromLatin1("number-columns-spanned");
+    static const QString sNumberRowsSpanned     = QString::fromLatin1("number-rows-spanned");
+    static const QString sP                     = QString::fromLatin1("p");
+
+    Q_ASSERT(sheet->map() == m_map);
+
+    // Cells without a value type get their value by parsing the user input,
+    // which depends on the style.
+    if (!element.hasAttributeNS(KoXmlNS::office, sValueType))
+        return false;
+    if (element.hasAttributeNS(KoXmlNS::table, sValidationName))
+        return false;
+    if (element.attributeNS(KoXmlNS::table, sNumberColumnsSpanned, QString()).toInt() > 1)
+        return false;
+    if (element.attributeNS(KoXmlNS::table, sNumberRowsSpanned, QString()).toInt() > 1)
+        return false;
+
+    CellContents contents;
+    const QString valueType = element.attributeNS(KoXmlNS::office, sValueType, QString());
+    contents.hasStringValue = false;
+    if (valueType == sFloat) {
+        contents.valueType = CellContents::Float;
+        contents.attribute = element.attributeNS(KoXmlNS::office, sValue, QString());
+    } else if (valueType == sString) {
+        contents.valueType = CellContents::String;
+        contents.hasStringValue = element.hasAttributeNS(KoXmlNS::office, sStringValue);
+        if (contents.hasStringValue)
+            contents.attribute = element.attributeNS(KoXmlNS::office, sStringValue, QString());
+    } else if (valueType == sBoolean) {
+        contents.valueType = CellContents::Boolean;
+        contents.attribute = element.attributeNS(KoXmlNS::office, sBooleanValue, QString());
+    } else if (valueType == sCurrency) {
+        contents.valueType = CellContents::Currency;
+        contents.attribute = element.attributeNS(KoXmlNS::office, sValue, QString());
+    } else if (valueType == sPercentage) {
+        contents.valueType = CellContents::Percentage;
+        contents.attribute = element.attributeNS(KoXmlNS::office, sValue, QString());
+    } else if (valueType == sDate) {
+        contents.valueType = CellContents::Date;
+        contents.attribute = element.attributeNS(KoXmlNS::office, sDateValue, QString());
+    } else if (valueType == sTime) {
+        contents.valueType = CellContents::Time;
+        contents.attribute = element.attributeNS(KoXmlNS::office, sTimeValue, QString());
+    } else {
+        return false;
+    }
+
+    // a single paragraph of plain text; anything else, like annotations,
+    // shapes, links or rich text, needs loadCell()
+    bool hasParagraph = false;
+    KoXmlElement paragraph;
+    forEachElement(paragraph, element) {
+        if (hasParagraph || paragraph.localName() != sP || paragraph.namespaceURI() != KoXmlNS::text)
+            return false;
+        hasParagraph = true;
+        for (KoXmlNode node = paragraph.firstChild(); !node.isNull(); node = node.nextSibling()) {
+            if (!node.isText() || !contents.text.isNull())
+                return false;
+            contents.text = node.toText().data();
+        }
+    }
+
+    contents.isFormula = element.hasAttributeNS(KoXmlNS::table, sFormula);
+    if (contents.isFormula)
+        contents.formula = element.attributeNS(KoXmlNS::table, sFormula, QString());
+    contents.column = column;
+    contents.row = row;
+    contents.columns = columns;
+    contents.rows = rows;
+    contents.hasTime = false;
+
+#ifdef CALLIGRA_SHEETS_MT
+    if (m_current && m_current->sheet != sheet)
+        start();
+    if (!m_current)
+        m_current = new Job(sheet);
+    m_current->contents.append(contents);
+    if (m_current->contents.count() == s_chunkSize)
+        start();
+#else
+    parse(contents);
+    localize(contents, m_map->calculationSettings(), m_map->converter());
+    for (int r = row; r < row + rows; ++r)
+        write(sheet, contents, r);
+#endif
+    return true;
+}
+
+void CellContentsLoader::finish()
+{
+#ifdef CALLIGRA_SHEETS_MT
+    if (m_current)
+        start();
+    writeDone(0);
+#endif
+}
+
+void CellContentsLoader::start()
+{
+#ifdef CALLIGRA_SHEETS_MT
+    Job* const job = m_current;
+    m_current = 0;
+    m_jobs.append(job);
+    QThreadPool::globalInstance()->start(job);
+    // Bound the memory held by the read cells; the loading thread waits,
+    // if it reads faster than the jobs parse.
+    writeDone(2 * QThreadPool::globalInstance()->maxThreadCount());
+#endif
+}
+
+void CellContentsLoader::writeDone(int pending)
+{
+#ifdef CALLIGRA_SHEETS_MT
+    while (!m_jobs.isEmpty()) {
+        Job* const job = m_jobs.first();
+        if (m_jobs.count() > pending)
+            job->done.acquire();
+        else if (!job->done.tryAcquire())
+            break;
+        m_jobs.removeFirst();
+        write(job);
+        delete job;
+    }
+#else
+    Q_UNUSED(pending);
+#endif
+}
+
+#ifdef CALLIGRA_SHEETS_MT
+void CellContentsLoader::write(Job* job) const
+{
+    const CalculationSettings* const settings = m_map->calculationSettings();
+    const ValueConverter* const converter = m_map->converter();
+    QVector<CellContents>& contents = job->contents;
+    for (int i = 0; i < contents.count(); ++i)
+        localize(contents[i], settings, converter);
+
+    // The cells of a row element are read in column order and repeated in
+    // the same rows; they get written row by row, so that they get appended
+    // to the storages.
+    int begin = 0;
+    while (begin < contents.count()) {
+        int end = begin + 1;
+        while (end < contents.count() && contents[end].row == contents[begin].row)
+            ++end;
+        for (int row = contents[begin].row; row < contents[begin].row + contents[begin].rows; ++row) {
+            for (int i = begin; i < end; ++i)
+                write(job->sheet, contents[i], row);
+        }
+        begin = end;
+    }
+}
+#endif
+
+void CellContentsLoader::write(Sheet* sheet, const CellContents& contents, int row)
+{
+    // Mirrors Cell::hasDefaultContent(); only a formula or a value get written.
+    const bool hasFormula = !contents.text.isEmpty() && contents.text[0] == '=';
+    if (!hasFormula && contents.value.isEmpty())
+        return;
+    for (int column = contents.column; column < contents.column + contents.columns; ++column) {
+        Cell target(sheet, column, row);
+        target.setUserInput(contents.text);
+        target.setValue(contents.value);
+    }
+}
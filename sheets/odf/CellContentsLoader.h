@@ -0,0 +1,137 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_ODF_CELL_CONTENTS_LOADER
+#define CALLIGRA_SHEETS_ODF_CELL_CONTENTS_LOADER
+
+#include <QDateTime>
+#include <QList>
+#include <QString>
+
+#include <KoXmlReader.h>
+
+#include "Value.h"
+
+#include "sheets_odf_export.h"
+
+namespace Calligra
+{
+namespace Sheets
+{
+class Map;
+class Sheet;
+
+namespace Odf
+{
+
+/**
+ * \ingroup OpenDocument
+ * The contents of a plain cell as read from its element: a value type, at
+ * most one paragraph of text without any markup and optionally a formula.
+ * The value and the user input of such a cell depend on nothing else, so
+ * they can be converted while the following cells get read.
+ */
+struct CellContents {
+    enum ValueType { Boolean, Float, Currency, Percentage, Date, Time, String };
+
+    int column;
+    int row;
+    int columns;
+    int rows;
+    ValueType valueType;
+    bool isFormula;
+    bool hasStringValue;
+    // the office:*-value attribute of the value type
+    QString attribute;
+    // the text of the paragraph, not normalized yet;
+    // the user input after the conversion
+    QString text;
+    QString formula;
+    // the date of a date value, which is stored relative to the reference date
+    QDateTime dateTime;
+    bool hasTime;
+    // the value after the conversion
+    Value value;
+};
+
+/**
+ * \ingroup OpenDocument
+ * Loads the plain cells of the sheets.
+ *
+ * If built with CALLIGRA_SHEETS_MT, the parsing of the values and user
+ * inputs, i.e. normalizing the text and parsing numbers and dates, runs in
+ * chunks in the global thread pool, while the loading continues with the
+ * following rows and sheets. The elements are read in the loading thread,
+ * as the XML document is not thread-safe. The steps depending on the
+ * document's locale and settings, formatting numbers, decoding formulas and
+ * the dates, and the writing of the cells happen in the loading thread
+ * again, as soon as a chunk is done. Otherwise, each cell gets converted
+ * and written, when it is read.
+ *
+ * Only the conversion of the cell contents is affected. content.xml is
+ * still parsed into a KoXmlDocument as a whole before the sheets load, and
+ * the sheets are read one after another into their cell storages.
+ *
+ * Used while the map is loading, so no damages are triggered.
+ */
+class CALLIGRA_SHEETS_ODF_EXPORT CellContentsLoader
+{
+public:
+    explicit CellContentsLoader(Map* map);
+    ~CellContentsLoader();
+
+    /**
+     * Reads the contents of the cell \p element at \p column , \p row , which
+     * is repeated \p columns times in \p rows rows, and schedules their
+     * conversion.
+     * \return \c false , if the cell is not a plain cell and has to be loaded
+     * by loadCell()
+     */
+    bool read(Sheet* sheet, const KoXmlElement& element, int column, int row, int columns, int rows);
+
+    /**
+     * Waits for the scheduled conversions and writes the cells.
+     */
+    void finish();
+
+private:
+    Q_DISABLE_COPY(CellContentsLoader)
+
+    class Job;
+
+    // Schedules the current job.
+    void start();
+    // Writes the cells of the done jobs in order; waits for the oldest ones,
+    // while more than pending jobs are scheduled.
+    void writeDone(int pending);
+    void write(Job* job) const;
+    // Writes the converted cell contents into all cells they are repeated in.
+    static void write(Sheet* sheet, const CellContents& contents, int row);
+
+    Map* const m_map;
+    Job* m_current;
+    // the scheduled jobs in order
+    QList<Job*> m_jobs;
+};
+
+} // namespace Odf
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_ODF_CELL_CONTENTS_LOADER
@@ -53,6 +53,21 @@ QString GenValidationStyles::insert(const GenValidationStyle& style)
     return it.value();
 }
 
+QHash<QString, QString> GenValidationStyles::merge(const GenValidationStyles& styles)
+{
+    // the names are numbered in the order of insertion
+    QMap<int, StyleMap::ConstIterator> order;
+    for (StyleMap::ConstIterator it = styles.m_styles.begin(); it != styles.m_styles.end(); ++it)
+        order.insert(it.value().mid(3).toInt(), it);
+    QHash<QString, QString> names;
+    foreach (const StyleMap::ConstIterator& it, order) {
+        const QString name = insert(it.key());
+        if (name != it.value())
+            names.insert(it.value(), name);
+    }
+    return names;
+}
+
 QString GenValidationStyles::makeUniqueName(const QString& base) const
 {
     int num = 1;
@@ -24,6 +24,7 @@
 
 #include "sheets_odf_export.h"
 
+#include <QHash>
 #include <QMap>
 #include <QString>
 
@@ -94,6 +95,11 @@ public:
     GenValidationStyles();
     ~GenValidationStyles();
     QString insert(const GenValidationStyle& style);
+    /**
+     * Inserts the validations of \p styles in the order they were inserted there.
+     * \return the assigned names keyed by the names in \p styles, if they differ
+     */
+    QHash<QString, QString> merge(const GenValidationStyles& styles);
 
     typedef QMap<GenValidationStyle, QString> StyleMap;
     void writeStyle(KoXmlWriter& writer) const;
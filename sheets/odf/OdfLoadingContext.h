@@ -35,6 +35,7 @@ namespace Sheets
 {
 namespace Odf
 {
+class CellContentsLoader;
 
 /**
  * \ingroup OpenDocument
@@ -44,12 +45,14 @@ class OdfLoadingContext
 {
 public:
     explicit OdfLoadingContext(KoOdfLoadingContext &odfContext)
-            : odfContext(odfContext), shapeContext(0) {}
+            : odfContext(odfContext), shapeContext(0), cellContents(0) {}
 
 public:
     KoOdfLoadingContext& odfContext;
     KoShapeLoadingContext* shapeContext;
     QHash<QString, KoXmlElement> validities;
+    // loads the plain cells, if set
+    CellContentsLoader* cellContents;
 };
 
 struct ShapeLoadingData {
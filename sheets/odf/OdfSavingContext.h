@@ -38,6 +38,7 @@ namespace Sheets
 {
 namespace Odf
 {
+class RowHashes;
 
 /**
  * \ingroup OpenDocument
@@ -47,7 +48,8 @@ class OdfSavingContext
 {
 public:
     explicit OdfSavingContext(KoShapeSavingContext &shapeContext)
-            : shapeContext(shapeContext) {}
+            : shapeContext(shapeContext)
+            , rowHashes(0) {}
 
     void insertCellAnchoredShape(const Sheet *sheet, int row, int column, KoShape* shape) {
         Q_ASSERT_X(1 <= column && column <= KS_colMax, __FUNCTION__, QString("%1 out of bounds").arg(column).toLocal8Bit());
@@ -102,6 +104,8 @@ public:
     GenValidationStyles valStyle;
     QMap<int, Style> columnDefaultStyles;
     QMap<int, Style> rowDefaultStyles;
+    // the content hashes of the rows, if any
+    RowHashes* rowHashes;
 
 private:
     typedef QHash < int /*row*/, QMultiHash < int /*col*/, KoShape* > > AnchoredShape;
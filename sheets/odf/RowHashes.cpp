@@ -0,0 +1,117 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "RowHashes.h"
+
+#include <QRunnable>
+#include <QSemaphore>
+#ifdef CALLIGRA_SHEETS_MT
+#include <QThreadPool>
+#endif
+
+#include "CellStorage.h"
+#include "FormulaStorage.h"
+#include "Sheet.h"
+#include "ValueStorage.h"
+
+using namespace Calligra::Sheets;
+using namespace Calligra::Sheets::Odf;
+
+class RowHashes::Job : public QRunnable
+{
+public:
+    explicit Job(const Sheet* sheet)
+            : sheet(sheet)
+            , started(false)
+            , waited(false) {
+        setAutoDelete(false);
+    }
+
+    void run() Q_DECL_OVERRIDE {
+        // The storages are iterated separately, so the hashes of the
+        // cells get combined independently of their order.
+        const ValueStorage* values = sheet->cellStorage()->valueStorage();
+        for (int i = 0; i < values->count(); ++i)
+            add(values->row(i), values->col(i), qHash(values->data(i)));
+        const FormulaStorage* formulas = sheet->cellStorage()->formulaStorage();
+        for (int i = 0; i < formulas->count(); ++i)
+            add(formulas->row(i), formulas->col(i), qHash(formulas->data(i)) ^ 0x5bd1e995);
+        done.release();
+    }
+
+    void add(int row, int column, uint hash) {
+        hashes[row] += (hash ^ uint(column)) * 2654435761u;
+    }
+
+    const Sheet* const sheet;
+    // the combined hashes of the cells keyed by their row
+    QHash<int, uint> hashes;
+    QSemaphore done;
+    bool started;
+    bool waited;
+};
+
+RowHashes::RowHashes(const QList<Sheet*>& sheets, bool background)
+{
+#ifdef CALLIGRA_SHEETS_MT
+    const bool threaded = background && QThreadPool::globalInstance()->maxThreadCount() > 1;
+#else
+    Q_UNUSED(background);
+#endif
+    foreach (const Sheet* sheet, sheets) {
+        Job* const job = new Job(sheet);
+        m_jobs.insert(sheet, job);
+#ifdef CALLIGRA_SHEETS_MT
+        // hash in this thread, when the sheet gets saved, if there is no other one
+        if (threaded) {
+            QThreadPool::globalInstance()->start(job);
+            job->started = true;
+        }
+#endif
+    }
+}
+
+RowHashes::~RowHashes()
+{
+    foreach (Job* job, m_jobs) {
+        if (job->started && !job->waited)
+            job->done.acquire();
+        delete job;
+    }
+}
+
+void RowHashes::wait(const Sheet* sheet)
+{
+    Job* const job = m_jobs.value(sheet);
+    if (!job || job->waited)
+        return;
+    if (!job->started)
+        job->run();
+    job->done.acquire();
+    job->waited = true;
+}
+
+bool RowHashes::mayBeEqual(const Sheet* sheet, int row1, int row2)
+{
+    wait(sheet);
+    Job* const job = m_jobs.value(sheet);
+    if (!job)
+        return false;
+    return job->hashes.value(row1) == job->hashes.value(row2);
+}
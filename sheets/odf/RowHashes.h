@@ -0,0 +1,85 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_ODF_ROW_HASHES
+#define CALLIGRA_SHEETS_ODF_ROW_HASHES
+
+#include <QHash>
+#include <QList>
+
+#include "sheets_odf_export.h"
+
+namespace Calligra
+{
+namespace Sheets
+{
+class Sheet;
+
+namespace Odf
+{
+
+/**
+ * \ingroup OpenDocument
+ * The content hashes of the rows of the sheets to save.
+ *
+ * A row's hash covers the columns, values and formulas of its cells. Rows
+ * with different hashes differ, so only the cells of rows with equal hashes
+ * have to be compared to find repeated rows, which were not repeated while
+ * loading, i.e. the ones the RowRepeatStorage does not know about.
+ *
+ * If built with CALLIGRA_SHEETS_MT, the hashes of each sheet are created in
+ * the global thread pool, while the preceding sheets get saved. A sheet must
+ * not be accessed by the saving thread until wait() was called for it.
+ * Otherwise, the hashes of a sheet are created, when wait() is called for it.
+ */
+class CALLIGRA_SHEETS_ODF_EXPORT RowHashes
+{
+public:
+    /**
+     * Starts to create the row hashes of \p sheets .
+     * If \p background is \c false , they are always created in wait(),
+     * e.g. if the saving thread is a thread of the pool itself.
+     */
+    explicit RowHashes(const QList<Sheet*>& sheets, bool background = true);
+    ~RowHashes();
+
+    /**
+     * Waits for the row hashes of \p sheet .
+     */
+    void wait(const Sheet* sheet);
+
+    /**
+     * \return \c true , if the rows \p row1 and \p row2 of \p sheet may
+     * be equal, i.e. their hashes are equal. Rows without values and
+     * formulas may be equal to each other.
+     */
+    bool mayBeEqual(const Sheet* sheet, int row1, int row2);
+
+private:
+    Q_DISABLE_COPY(RowHashes)
+
+    class Job;
+    QHash<const Sheet*, Job*> m_jobs;
+};
+
+} // namespace Odf
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_ODF_ROW_HASHES
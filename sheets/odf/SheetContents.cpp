@@ -0,0 +1,140 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "SheetContents.h"
+
+#include <QBuffer>
+#include <QRunnable>
+#include <QSemaphore>
+#ifdef CALLIGRA_SHEETS_MT
+#include <QThreadPool>
+#endif
+
+#include <KoGenStyles.h>
+#include <KoShapeSavingContext.h>
+#include <KoXmlWriter.h>
+
+#include "CellStorage.h"
+#include "ConditionsStorage.h"
+#include "GenValidationStyle.h"
+#include "OdfSavingContext.h"
+#include "RowHashes.h"
+#include "Sheet.h"
+#include "SheetsOdfPrivate.h"
+
+using namespace Calligra::Sheets;
+using namespace Calligra::Sheets::Odf;
+
+class SheetContents::Job : public QRunnable
+{
+public:
+    Job(Sheet* sheet, KoEmbeddedDocumentSaver& embeddedSaver, int indentLevel)
+            : sheet(sheet)
+            , embeddedSaver(embeddedSaver)
+            , indentLevel(indentLevel)
+            , started(false) {
+        setAutoDelete(false);
+    }
+
+    void run() Q_DECL_OVERRIDE {
+        QBuffer buffer(&xml);
+        buffer.open(QIODevice::WriteOnly);
+        {
+            KoXmlWriter xmlWriter(&buffer, indentLevel);
+            KoShapeSavingContext shapeContext(xmlWriter, styles, embeddedSaver);
+            OdfSavingContext tableContext(shapeContext);
+            // hash in this thread; waiting for another job of the pool could deadlock it
+            RowHashes rowHashes(QList<Sheet*>() << sheet, false);
+            tableContext.rowHashes = &rowHashes;
+            saveSheet(sheet, tableContext);
+            tableContext.rowHashes = 0;
+            validations = tableContext.valStyle;
+        }
+        buffer.close();
+        done.release();
+    }
+
+    Sheet* const sheet;
+    KoEmbeddedDocumentSaver& embeddedSaver;
+    const int indentLevel;
+    // the table:table element and the styles and validations it refers to
+    QByteArray xml;
+    KoGenStyles styles;
+    GenValidationStyles validations;
+    QSemaphore done;
+    bool started;
+};
+
+SheetContents::SheetContents(const QList<Sheet*>& sheets, KoShapeSavingContext& context)
+{
+#ifdef CALLIGRA_SHEETS_MT
+    const bool threaded = QThreadPool::globalInstance()->maxThreadCount() > 1;
+#endif
+    const int indentLevel = context.xmlWriter().indentLevel();
+    foreach (Sheet* sheet, sheets) {
+        const CellStorage* const storage = sheet->cellStorage();
+        if (!sheet->shapes().isEmpty() || storage->richTextStorage()->count() != 0 ||
+                !storage->conditionsStorage()->usedArea().isEmpty()) {
+            m_remainingSheets.append(sheet);
+            continue;
+        }
+        Job* const job = new Job(sheet, context.embeddedSaver(), indentLevel);
+        m_jobs.insert(sheet, job);
+#ifdef CALLIGRA_SHEETS_MT
+        // serialize in this thread, when the sheet gets saved, if there is no other one
+        if (threaded) {
+            QThreadPool::globalInstance()->start(job);
+            job->started = true;
+        }
+#endif
+    }
+}
+
+SheetContents::~SheetContents()
+{
+    foreach (Job* job, m_jobs) {
+        if (job->started)
+            job->done.acquire();
+        delete job;
+    }
+}
+
+QList<Sheet*> SheetContents::remainingSheets() const
+{
+    return m_remainingSheets;
+}
+
+bool SheetContents::write(const Sheet* sheet, OdfSavingContext& tableContext)
+{
+    Job* const job = m_jobs.take(sheet);
+    if (!job)
+        return false;
+    if (!job->started)
+        job->run();
+    job->done.acquire();
+
+    // insert the styles as if the sheet had been saved directly
+    const QHash<QString, QString> styleNames = tableContext.shapeContext.mainStyles().merge(job->styles);
+    const QHash<QString, QString> validationNames = tableContext.valStyle.merge(job->validations);
+    KoGenStyles::renameReferences(job->xml, styleNames);
+    KoGenStyles::renameReferences(job->xml, validationNames, "validation-name");
+    tableContext.shapeContext.xmlWriter().addCompleteElement(job->xml.constData());
+    delete job;
+    return true;
+}
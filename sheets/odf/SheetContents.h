@@ -0,0 +1,96 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_ODF_SHEET_CONTENTS
+#define CALLIGRA_SHEETS_ODF_SHEET_CONTENTS
+
+#include <QHash>
+#include <QList>
+
+#include "sheets_odf_export.h"
+
+class KoShapeSavingContext;
+
+namespace Calligra
+{
+namespace Sheets
+{
+class Sheet;
+
+namespace Odf
+{
+class OdfSavingContext;
+
+/**
+ * \ingroup OpenDocument
+ * The table:table elements of the sheets to save, serialized apart from
+ * the document.
+ *
+ * Each sheet is written into its own buffer and registers its styles and
+ * validations in its own collections. Those get merged into the ones of the
+ * document in the order of the sheets, so the result is the same as if the
+ * sheets had been saved one after another.
+ *
+ * Only sheets without shapes, rich text and conditional styles are taken, as
+ * saving those uses the text and shape saving, which is not thread-safe, or
+ * evaluates formulas, which may refer to other sheets. The other sheets have
+ * to be saved directly.
+ *
+ * If built with CALLIGRA_SHEETS_MT, the sheets are serialized in the global
+ * thread pool, while the preceding sheets get saved. A taken sheet must not
+ * be accessed by the saving thread until write() was called for it.
+ * Otherwise, a sheet is serialized, when write() is called for it.
+ */
+class CALLIGRA_SHEETS_ODF_EXPORT SheetContents
+{
+public:
+    /**
+     * Starts to serialize those of \p sheets , that can be saved apart from
+     * the document. The elements get indented for the current position of
+     * the writer of \p context .
+     */
+    SheetContents(const QList<Sheet*>& sheets, KoShapeSavingContext& context);
+    ~SheetContents();
+
+    /**
+     * \return the sheets, that have to be saved directly
+     */
+    QList<Sheet*> remainingSheets() const;
+
+    /**
+     * Waits for \p sheet to be serialized and writes its table:table element
+     * to the writer of \p tableContext . Its styles and validations get
+     * inserted into the ones of \p tableContext .
+     * \return \c false , if \p sheet has to be saved directly
+     */
+    bool write(const Sheet* sheet, OdfSavingContext& tableContext);
+
+private:
+    Q_DISABLE_COPY(SheetContents)
+
+    class Job;
+    QHash<const Sheet*, Job*> m_jobs;
+    QList<Sheet*> m_remainingSheets;
+};
+
+} // namespace Odf
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_ODF_SHEET_CONTENTS
@@ -113,8 +113,6 @@ bool Odf::loadCell(Cell *cell, const KoXmlElement& element, OdfLoadingContext& t
     static const QString sAnnotation        = QString::fromLatin1("annotation");
     static const QString sP                 = QString::fromLatin1("p");
 
-    static const QStringList formulaNSPrefixes = QStringList() << "oooc:" << "kspr:" << "of:" << "msoxl:";
-
     //Search and load each paragraph of text. Each paragraph is separated by a line break.
     loadCellText(cell, element, tableContext, autoStyles, cellStyleName);
 
@@ -124,20 +122,9 @@ bool Odf::loadCell(Cell *cell, const KoXmlElement& element, OdfLoadingContext& t
     bool isFormula = false;
     if (element.hasAttributeNS(KoXmlNS::table, sFormula)) {
         isFormula = true;
-        QString oasisFormula(element.attributeNS(KoXmlNS::table, sFormula, QString()));
+        const QString oasisFormula(element.attributeNS(KoXmlNS::table, sFormula, QString()));
         // debugSheetsODF << "cell:" << cell->name() << "formula :" << oasisFormula;
-        // each spreadsheet application likes to safe formulas with a different namespace
-        // prefix, so remove all of them
-        QString namespacePrefix;
-        foreach(const QString &prefix, formulaNSPrefixes) {
-            if (oasisFormula.startsWith(prefix)) {
-                oasisFormula.remove(0, prefix.length());
-                namespacePrefix = prefix;
-                break;
-            }
-        }
-        oasisFormula = Odf::decodeFormula(oasisFormula, cell->locale(), namespacePrefix);
-        cell->setUserInput(oasisFormula);
+        cell->setUserInput(loadCellFormula(oasisFormula, cell->locale()));
     } else if (!cell->userInput().isEmpty() && cell->userInput().at(0) == '=')  //prepend ' to the text to avoid = to be painted
         cell->setUserInput(cell->userInput().prepend('\''));
 
@@ -218,47 +205,15 @@ bool Odf::loadCell(Cell *cell, const KoXmlElement& element, OdfLoadingContext& t
 #endif
             }
         } else if (valuetype == sDate) {
-            QString value = element.attributeNS(KoXmlNS::office, sDateValue, QString());
-
-            // "1980-10-15" or "2001-01-01T19:27:41"
-            int year = 0, month = 0, day = 0, hours = 0, minutes = 0, seconds = 0;
+            const QString value = element.attributeNS(KoXmlNS::office, sDateValue, QString());
+            QDate date;
+            QTime time;
             bool hasTime = false;
-            bool ok = false;
-
-            int p1 = value.indexOf('-');
-            if (p1 > 0) {
-                year  = value.left(p1).toInt(&ok);
-                if (ok) {
-                    int p2 = value.indexOf('-', ++p1);
-                    month = value.mid(p1, p2 - p1).toInt(&ok);
-                    if (ok) {
-                        // the date can optionally have a time attached
-                        int p3 = value.indexOf('T', ++p2);
-                        if (p3 > 0) {
-                            hasTime = true;
-                            day = value.mid(p2, p3 - p2).toInt(&ok);
-                            if (ok) {
-                                int p4 = value.indexOf(':', ++p3);
-                                hours = value.mid(p3, p4 - p3).toInt(&ok);
-                                if (ok) {
-                                    int p5 = value.indexOf(':', ++p4);
-                                    minutes = value.mid(p4, p5 - p4).toInt(&ok);
-                                    if (ok)
-                                        seconds = value.right(value.length() - p5 - 1).toInt(&ok);
-                                }
-                            }
-                        } else {
-                            day = value.right(value.length() - p2).toInt(&ok);
-                        }
-                    }
-                }
-            }
-
-            if (ok) {
+            if (loadDateValue(value, &date, &time, &hasTime)) {
                 if (hasTime)
-                    cell->setValue(Value(QDateTime(QDate(year, month, day), QTime(hours, minutes, seconds)), cell->sheet()->map()->calculationSettings()));
+                    cell->setValue(Value(QDateTime(date, time), cell->sheet()->map()->calculationSettings()));
                 else
-                    cell->setValue(Value(QDate(year, month, day), cell->sheet()->map()->calculationSettings()));
+                    cell->setValue(Value(date, cell->sheet()->map()->calculationSettings()));
 // FIXME Stefan: Should be handled by Value::Format. Verify and remove!
 //Sebsauer: Fixed now. Value::Format handles it correct.
 #if 0
@@ -269,35 +224,12 @@ bool Odf::loadCell(Cell *cell, const KoXmlElement& element, OdfLoadingContext& t
                 // debugSheetsODF << "cell:" << cell->name() << "Type: date, value:" << value << "Date:" << year << " -" << month << " -" << day;
             }
         } else if (valuetype == sTime) {
-            QString value = element.attributeNS(KoXmlNS::office, sTimeValue, QString());
-
-            // "PT15H10M12S"
-            int hours = 0, minutes = 0, seconds = 0;
-            int l = value.length();
-            QString num;
-            bool ok = false;
-            for (int i = 0; i < l; ++i) {
-                if (value[i].isNumber()) {
-                    num += value[i];
-                    continue;
-                } else if (value[i] == 'H')
-                    hours   = num.toInt(&ok);
-                else if (value[i] == 'M')
-                    minutes = num.toInt(&ok);
-                else if (value[i] == 'S')
-                    seconds = num.toInt(&ok);
-                else
-                    continue;
-                //debugSheetsODF << "Num:" << num;
-                num.clear();
-                if (!ok)
-                    break;
-            }
-
-            if (ok) {
+            const QString value = element.attributeNS(KoXmlNS::office, sTimeValue, QString());
+            QTime time;
+            if (loadTimeValue(value, &time)) {
                 // Value kval( timeToNum( hours, minutes, seconds ) );
                 // cell->setValue( kval );
-                cell->setValue(Value(QTime(hours % 24, minutes, seconds)));
+                cell->setValue(Value(time));
 // FIXME Stefan: Should be handled by Value::Format. Verify and remove!
 #if 0
                 Style style;
@@ -375,6 +307,96 @@ bool Odf::loadCell(Cell *cell, const KoXmlElement& element, OdfLoadingContext& t
     return true;
 }
 
+QString Odf::loadCellFormula(const QString& oasisFormula, const KLocale* locale)
+{
+    static const QStringList formulaNSPrefixes = QStringList() << "oooc:" << "kspr:" << "of:" << "msoxl:";
+
+    // each spreadsheet application likes to safe formulas with a different namespace
+    // prefix, so remove all of them
+    QString formula = oasisFormula;
+    QString namespacePrefix;
+    foreach(const QString &prefix, formulaNSPrefixes) {
+        if (formula.startsWith(prefix)) {
+            formula.remove(0, prefix.length());
+            namespacePrefix = prefix;
+            break;
+        }
+    }
+    return Odf::decodeFormula(formula, locale, namespacePrefix);
+}
+
+bool Odf::loadDateValue(const QString& value, QDate* date, QTime* time, bool* hasTime)
+{
+    // "1980-10-15" or "2001-01-01T19:27:41"
+    int year = 0, month = 0, day = 0, hours = 0, minutes = 0, seconds = 0;
+    bool ok = false;
+    *hasTime = false;
+
+    int p1 = value.indexOf('-');
+    if (p1 > 0) {
+        year  = value.left(p1).toInt(&ok);
+        if (ok) {
+            int p2 = value.indexOf('-', ++p1);
+            month = value.mid(p1, p2 - p1).toInt(&ok);
+            if (ok) {
+                // the date can optionally have a time attached
+                int p3 = value.indexOf('T', ++p2);
+                if (p3 > 0) {
+                    *hasTime = true;
+                    day = value.mid(p2, p3 - p2).toInt(&ok);
+                    if (ok) {
+                        int p4 = value.indexOf(':', ++p3);
+                        hours = value.mid(p3, p4 - p3).toInt(&ok);
+                        if (ok) {
+                            int p5 = value.indexOf(':', ++p4);
+                            minutes = value.mid(p4, p5 - p4).toInt(&ok);
+                            if (ok)
+                                seconds = value.right(value.length() - p5 - 1).toInt(&ok);
+                        }
+                    }
+                } else {
+                    day = value.right(value.length() - p2).toInt(&ok);
+                }
+            }
+        }
+    }
+    if (!ok)
+        return false;
+    *date = QDate(year, month, day);
+    *time = QTime(hours, minutes, seconds);
+    return true;
+}
+
+bool Odf::loadTimeValue(const QString& value, QTime* time)
+{
+    // "PT15H10M12S"
+    int hours = 0, minutes = 0, seconds = 0;
+    int l = value.length();
+    QString num;
+    bool ok = false;
+    for (int i = 0; i < l; ++i) {
+        if (value[i].isNumber()) {
+            num += value[i];
+            continue;
+        } else if (value[i] == 'H')
+            hours   = num.toInt(&ok);
+        else if (value[i] == 'M')
+            minutes = num.toInt(&ok);
+        else if (value[i] == 'S')
+            seconds = num.toInt(&ok);
+        else
+            continue;
+        //debugSheetsODF << "Num:" << num;
+        num.clear();
+        if (!ok)
+            break;
+    }
+    if (!ok)
+        return false;
+    *time = QTime(hours % 24, minutes, seconds);
+    return true;
+}
+
 bool Odf::saveCell(Cell *cell, int &repeated, OdfSavingContext& tableContext)
 {
     KoXmlWriter & xmlwriter = tableContext.shapeContext.xmlWriter();
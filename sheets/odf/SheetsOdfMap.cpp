@@ -33,6 +33,9 @@
 
 #include "SheetsOdf.h"
 #include "SheetsOdfPrivate.h"
+#include "CellContentsLoader.h"
+#include "RowHashes.h"
+#include "SheetContents.h"
 
 #include "CalculationSettings.h"
 #include "DocBase.h"
@@ -202,6 +205,10 @@ bool Odf::loadMap(Map *map, const KoXmlElement& body, KoOdfLoadingContext& odfCo
     Styles autoStyles = loadAutoStyles(map->styleManager(), odfContext.stylesReader(),
                         conditionalStyles, map->parser());
 
+    // convert the plain cells separately; in the background, if built with CALLIGRA_SHEETS_MT
+    CellContentsLoader cellContents(map);
+    tableContext.cellContents = &cellContents;
+
     // load the sheet
     sheetNode = body.firstChild();
     while (!sheetNode.isNull()) {
@@ -225,6 +232,8 @@ bool Odf::loadMap(Map *map, const KoXmlElement& body, KoOdfLoadingContext& odfCo
         KoXml::unload(sheetElement);
         sheetNode = sheetNode.nextSibling();
     }
+    cellContents.finish();
+    tableContext.cellContents = 0;
 
     // make sure always at least one sheet exists
     if (map->count() == 0) {
@@ -295,10 +304,15 @@ bool Odf::saveMap(Map *map, KoXmlWriter & xmlWriter, KoShapeSavingContext & savi
     }
 
     OdfSavingContext tableContext(savingContext);
+    SheetContents contents(map->sheetList(), savingContext);
+    RowHashes rowHashes(contents.remainingSheets());
+    tableContext.rowHashes = &rowHashes;
 
     foreach(Sheet* sheet, map->sheetList()) {
-        saveSheet(sheet, tableContext);
+        if (!contents.write(sheet, tableContext))
+            saveSheet(sheet, tableContext);
     }
+    tableContext.rowHashes = 0;
 
     tableContext.valStyle.writeStyle(xmlWriter);
 
@@ -352,7 +366,10 @@ void Odf::saveTableShape(Sheet *sheet, KoShapeSavingContext &context)
     context.mainStyles().insert(defaultRowStyle, "Default", KoGenStyles::DontAddNumberToName);
 
     OdfSavingContext tableContext(context);
+    RowHashes rowHashes(QList<Sheet*>() << sheet);
+    tableContext.rowHashes = &rowHashes;
     saveSheet(sheet, tableContext);
+    tableContext.rowHashes = 0;
     tableContext.valStyle.writeStyle(context.xmlWriter());
 }
 
@@ -44,6 +44,10 @@
 #include "OdfLoadingContext.h"
 #include "OdfSavingContext.h"
 
+class KLocale;
+class QDate;
+class QTime;
+
 namespace Calligra {
 namespace Sheets {
 
@@ -76,6 +80,12 @@ namespace Odf {
             const Styles& autoStyles, const QString& cellStyleName,
             QList<ShapeLoadingData>& shapeData);
     bool saveCell(Cell *cell, int &repeated, OdfSavingContext& tableContext);
+    // Decodes a table:formula attribute regardless of its namespace prefix.
+    QString loadCellFormula(const QString& oasisFormula, const KLocale* locale);
+    // Parses an office:date-value; hasTime tells, whether it has a time part.
+    bool loadDateValue(const QString& value, QDate* date, QTime* time, bool* hasTime);
+    // Parses an office:time-value.
+    bool loadTimeValue(const QString& value, QTime* time);
 
     // SheetsOdfStyle
 
@@ -33,6 +33,8 @@
 
 #include "SheetsOdf.h"
 #include "SheetsOdfPrivate.h"
+#include "CellContentsLoader.h"
+#include "RowHashes.h"
 
 #include <kcodecs.h>
 
@@ -56,6 +58,8 @@
 #include "LoadingInfo.h"
 #include "Map.h"
 #include "PrintSettings.h"
+#include "RectStorage.h"
+#include "Region.h"
 #include "RowColumnFormat.h"
 #include "RowFormatStorage.h"
 #include "Sheet.h"
@@ -966,6 +970,13 @@ int Odf::loadRowFormat(Sheet *sheet, const KoXmlElement& row, int &rowIndex,
         if (!styleName.isEmpty())
             cellStyleRegions[styleName] += QRect(columnIndex, rowIndex, numberColumns, number);
 
+        // plain cells get converted by the cell contents loader
+        if (tableContext.cellContents && tableContext.cellContents->read(sheet, cellElement, columnIndex, rowIndex,
+                                                                          numberColumns, endRow - rowIndex + 1)) {
+            columnIndex += numberColumns;
+            continue;
+        }
+
         // figure out exact cell style for loading of cell content
         QString cellStyleName = styleName;
         if (cellStyleName.isEmpty())
@@ -1013,6 +1024,11 @@ int Odf::loadRowFormat(Sheet *sheet, const KoXmlElement& row, int &rowIndex,
 
 bool Odf::saveSheet(Sheet *sheet, OdfSavingContext& tableContext)
 {
+    // The row hashes are created in the background; the sheet must not be
+    // accessed before they are done.
+    if (tableContext.rowHashes)
+        tableContext.rowHashes->wait(sheet);
+
     KoXmlWriter & xmlWriter = tableContext.shapeContext.xmlWriter();
     KoGenStyles & mainStyles = tableContext.shapeContext.mainStyles();
     xmlWriter.startElement("table:table");
@@ -1683,6 +1699,52 @@ inline bool compareCellsInRows(CellStorage *cellStorage, int row1, int row2, int
     return true;
 }
 
+// Compares the styles of the rows span by span, so rows formatted
+// differently are told apart without composing the style of each cell.
+static bool compareRowStyles(const StyleStorage *styleStorage, int row1, int row2, int maxCols)
+{
+    StyleStorage::RowIterator it1(styleStorage, row1, 1, maxCols);
+    StyleStorage::RowIterator it2(styleStorage, row2, 1, maxCols);
+    while (!it1.atEnd() && !it2.atEnd()) {
+        if (it1.style() != it2.style())
+            return false;
+        // the spans of both rows may end in different columns
+        const int right = qMin(it1.right(), it2.right());
+        if (it1.right() == right)
+            it1.next();
+        if (it2.right() == right)
+            it2.next();
+    }
+    return it1.atEnd() && it2.atEnd();
+}
+
+// Like compareCellsInRows, but rich text and merged cells, which
+// Cell::compareData() does not fully take into account, are never
+// considered equal.
+static bool compareHashedRows(CellStorage *cellStorage, int row1, int row2, int maxCols)
+{
+    if (!compareRowStyles(cellStorage->styleStorage(), row1, row2, maxCols))
+        return false;
+    if (!cellStorage->fusionStorage()->intersectingPairs(Region(QRect(1, row1, KS_colMax, 1))).isEmpty())
+        return false;
+    if (!cellStorage->fusionStorage()->intersectingPairs(Region(QRect(1, row2, KS_colMax, 1))).isEmpty())
+        return false;
+    Cell cell1 = cellStorage->firstInRow(row1);
+    Cell cell2 = cellStorage->firstInRow(row2);
+    while (true) {
+        int r = compareCellInRow(cell1, cell2, maxCols);
+        if (r == 0)
+            return false;
+        if (r != 1)
+            break;
+        if (cellStorage->richText(cell1.column(), row1) || cellStorage->richText(cell2.column(), row2))
+            return false;
+        cell1 = cellStorage->nextInRow(cell1.column(), cell1.row());
+        cell2 = cellStorage->nextInRow(cell2.column(), cell2.row());
+    }
+    return true;
+}
+
 bool Odf::compareRows(Sheet *sheet, int row1, int row2, int maxCols, OdfSavingContext& tableContext)
 {
 #if 0
@@ -1694,14 +1756,23 @@ bool Odf::compareRows(Sheet *sheet, int row1, int row2, int maxCols, OdfSavingCo
     }
     return compareCellsInRows(sheet->cellStorage(), row1, row2, maxCols);
 #else
-    Q_UNUSED(maxCols);
-
     // Optimized comparison by using the RowRepeatStorage to compare the content
     // rather then an expensive loop like compareCellsInRows.
     int row1repeated = sheet->cellStorage()->rowRepeat(row1);
     Q_ASSERT( row2 > row1 );
     if (row2 - row1 >= row1repeated) {
-        return false;
+        // The RowRepeatStorage only knows the rows repeated while loading. Rows,
+        // that became equal later on, are found by their content hashes, so
+        // the cells only get compared, if the rows are very likely equal.
+        if (!tableContext.rowHashes || !tableContext.rowHashes->mayBeEqual(sheet, row1, row2))
+            return false;
+        if (tableContext.rowHasCellAnchoredShapes(sheet, row1) || tableContext.rowHasCellAnchoredShapes(sheet, row2))
+            return false;
+        if (!sheet->rowFormats()->rowsAreEqual(row1, row2))
+            return false;
+        if (tableContext.rowDefaultStyles.value(row1) != tableContext.rowDefaultStyles.value(row2))
+            return false;
+        return compareHashedRows(sheet->cellStorage(), row1, row2, maxCols);
     }
 
     // The RowRepeatStorage does not take to-cell anchored shapes into account
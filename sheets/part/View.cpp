@@ -895,7 +895,11 @@ SheetView* View::sheetView(const Sheet* sheet) const
     SheetView *sheetView = d->sheetViews.value(sheet);
     if (!sheetView) {
         debugSheetsRender << "View: Creating SheetView for" << sheet->sheetName();
-        sheetView = new SheetView(sheet);
+        const KConfigGroup parameterGroup = Factory::global().config()->group("Parameters");
+        if (parameterGroup.readEntry("Pixmap Caching", false))
+            sheetView = new PixmapCachingSheetView(sheet);
+        else
+            sheetView = new SheetView(sheet);
         d->sheetViews.insert(sheet, sheetView);
         sheetView->setViewConverter(zoomHandler());
         connect(sheetView, SIGNAL(visibleSizeChanged(QSizeF)),
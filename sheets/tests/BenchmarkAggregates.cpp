@@ -0,0 +1,115 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "BenchmarkAggregates.h"
+
+#include "Function.h"
+#include "FunctionModuleRegistry.h"
+#include "FunctionRepository.h"
+#include "Map.h"
+#include "ValueCalc.h"
+#include "ValueStorage.h"
+
+#include <QTest>
+
+using namespace Calligra::Sheets;
+
+// 10 columns of 1M rows, i.e. 10M cells
+static const int s_columns = 10;
+static const int s_rows = 1000000;
+
+void AggregateBenchmark::initTestCase()
+{
+    FunctionModuleRegistry::instance()->loadFunctionModules();
+    m_map = new Map(0 /* no Doc */);
+
+    ValueStorage storage;
+    for (int row = 1; row <= s_rows; ++row) {
+        for (int col = 1; col <= s_columns; ++col) {
+            // integers and fractions, like in a typical data sheet
+            if (col % 2)
+                storage.insert(col, row, Value(row % 1000));
+            else
+                storage.insert(col, row, Value((row % 1000) / 8.0));
+        }
+    }
+    m_range = Value(storage, QSize(s_columns, s_rows));
+}
+
+void AggregateBenchmark::cleanupTestCase()
+{
+    m_range = Value();
+    delete m_map;
+}
+
+void AggregateBenchmark::testFunctions_data()
+{
+    QTest::addColumn<QString>("function");
+
+    QTest::newRow("SUM") << "SUM";
+    QTest::newRow("COUNT") << "COUNT";
+    QTest::newRow("AVERAGE") << "AVERAGE";
+    QTest::newRow("MIN") << "MIN";
+    QTest::newRow("MAX") << "MAX";
+    QTest::newRow("SUMPRODUCT") << "SUMPRODUCT";
+}
+
+void AggregateBenchmark::testFunctions()
+{
+    QFETCH(QString, function);
+
+    QSharedPointer<Function> f = FunctionRepository::self()->function(function);
+    QVERIFY(f);
+    valVector args;
+    args.append(m_range);
+    if (function == "SUMPRODUCT")
+        args.append(m_range);
+
+    Value result;
+    QBENCHMARK {
+        result = f->exec(args, m_map->calc());
+    }
+    QVERIFY(!result.isError());
+}
+
+void AggregateBenchmark::testElementWiseWalk_data()
+{
+    QTest::addColumn<QString>("function");
+
+    QTest::newRow("sum") << "sum";
+    QTest::newRow("count") << "count";
+    QTest::newRow("min") << "min";
+    QTest::newRow("max") << "max";
+}
+
+void AggregateBenchmark::testElementWiseWalk()
+{
+    QFETCH(QString, function);
+
+    // one function call per element; the baseline of the bulk aggregates
+    ValueCalc* calc = m_map->calc();
+    Value result;
+    QBENCHMARK {
+        result = Value(0);
+        calc->arrayWalk(m_range, result, calc->awFunc(function), Value(0));
+    }
+    QVERIFY(!result.isError());
+}
+
+QTEST_MAIN(AggregateBenchmark)
@@ -0,0 +1,111 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "BenchmarkFormula.h"
+
+#include "CellStorage.h"
+#include "Formula.h"
+#include "FunctionModuleRegistry.h"
+#include "Map.h"
+#include "Sheet.h"
+#include "Value.h"
+
+#include <QTest>
+
+using namespace Calligra::Sheets;
+
+static void addFormulaRows()
+{
+    QTest::addColumn<QString>("expression");
+
+    QTest::newRow("constant") << "=1+2*3-4/5";
+    QTest::newRow("cell arithmetic") << "=A1+B1*C1-A2";
+    QTest::newRow("mixed") << "=(A1+10)*2-B2/4";
+    QTest::newRow("function call") << "=ABS(A1-B1)+MAX(A1;B1;C1)";
+    QTest::newRow("range function") << "=SUM(A1:C10)";
+    QTest::newRow("nested functions") << "=IF(A1>B1;ROUND(A1/3;2);SQRT(ABS(B1)))";
+    QTest::newRow("comparison") << "=A1<>B1";
+}
+
+void FormulaBenchmark::initTestCase()
+{
+    FunctionModuleRegistry::instance()->loadFunctionModules();
+
+    m_map = new Map(0 /* no Doc */);
+    m_sheet = m_map->addNewSheet();
+    m_sheet->setSheetName("Sheet1");
+    CellStorage* storage = m_sheet->cellStorage();
+    for (int row = 1; row <= 10; ++row) {
+        for (int col = 1; col <= 3; ++col) {
+            storage->setValue(col, row, Value(row * col));
+        }
+    }
+}
+
+void FormulaBenchmark::cleanupTestCase()
+{
+    delete m_map;
+}
+
+void FormulaBenchmark::testEvaluationPerformance_data()
+{
+    addFormulaRows();
+}
+
+void FormulaBenchmark::testEvaluationPerformance()
+{
+    QFETCH(QString, expression);
+
+    // compiled once, evaluated many times; the recalculation use case
+    Formula formula(m_sheet, Cell(m_sheet, 5, 5));
+    formula.setExpression(expression);
+    QVERIFY(formula.isValid());
+
+    Value result;
+    QBENCHMARK {
+        for (int i = 0; i < 10000; ++i) {
+            result = formula.eval();
+        }
+    }
+    QVERIFY(!result.isError());
+}
+
+void FormulaBenchmark::testCompilationPerformance_data()
+{
+    addFormulaRows();
+}
+
+void FormulaBenchmark::testCompilationPerformance()
+{
+    QFETCH(QString, expression);
+
+    // scanned, compiled and evaluated each time; the baseline the
+    // evaluation benchmark is compared against
+    Value result;
+    QBENCHMARK {
+        for (int i = 0; i < 10000; ++i) {
+            Formula formula(m_sheet, Cell(m_sheet, 5, 5));
+            formula.setExpression(expression);
+            result = formula.eval();
+        }
+    }
+    QVERIFY(!result.isError());
+}
+
+QTEST_MAIN(FormulaBenchmark)
@@ -0,0 +1,106 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "BenchmarkImport.h"
+
+#include "Cell.h"
+#include "CellStorage.h"
+#include "Map.h"
+#include "Sheet.h"
+#include "StringPool.h"
+
+#include <QFile>
+#include <QStringList>
+#include <QTest>
+
+#include <unistd.h>
+
+using namespace Calligra::Sheets;
+
+// the resident memory in bytes
+static qint64 residentMemory()
+{
+#ifdef Q_OS_LINUX
+    QFile file("/proc/self/statm");
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+    const QList<QByteArray> fields = file.readAll().split(' ');
+    if (fields.count() < 2)
+        return -1;
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+void ImportBenchmark::testRepeatedLabels_data()
+{
+    QTest::addColumn<bool>("interned");
+
+    QTest::newRow("copied") << false;
+    QTest::newRow("interned") << true;
+}
+
+void ImportBenchmark::testRepeatedLabels()
+{
+    QFETCH(bool, interned);
+    if (residentMemory() < 0)
+        QSKIP("The resident memory is unknown on this platform.");
+
+    // 1000 distinct labels, as typical for category columns
+    QStringList labels;
+    for (int i = 0; i < 1000; ++i)
+        labels.append(QString("Category %1").arg(i));
+
+    const int columns = 10;
+    const int rows = 100000;
+    Map map;
+    Sheet* sheet = new Sheet(&map, "Sheet1");
+    map.addSheet(sheet);
+    map.setLoading(true);
+
+    StringPool pool;
+    const qint64 before = residentMemory();
+    QBENCHMARK_ONCE {
+        for (int row = 1; row <= rows; ++row) {
+            for (int column = 1; column <= columns; ++column) {
+                // a fresh copy of the characters, like parsed from a file
+                const QString& label = labels[(row * columns + column) % labels.count()];
+                const QString text(label.constData(), label.length());
+                Cell cell(sheet, column, row);
+                if (interned) {
+                    const Value value = pool.value(text);
+                    cell.setRawUserInput(value.asString());
+                    cell.setValue(value);
+                } else {
+                    cell.setRawUserInput(text);
+                    cell.setValue(Value(text));
+                }
+            }
+        }
+    }
+    const qint64 growth = residentMemory() - before;
+    map.setLoading(false);
+    QTest::setBenchmarkResult(growth, QTest::BytesAllocated);
+
+    QCOMPARE(sheet->cellStorage()->value(1, 1).asString(), labels[(columns + 1) % labels.count()]);
+    QCOMPARE(sheet->cellStorage()->userInput(columns, rows), labels[(rows * columns + columns) % labels.count()]);
+}
+
+QTEST_MAIN(ImportBenchmark)
@@ -23,12 +23,384 @@
 
 #include "PointStorage.h"
 
+#include <QStringList>
 #include <QTest>
 #include <QUuid>
 
 
 using namespace Calligra::Sheets;
 
+namespace
+{
+/**
+ * The structural edits of PointStorage before they were done in one pass,
+ * taking each entry out of the vectors on its own, as a reference for
+ * the benchmark. The data is laid out as in PointStorage.
+ */
+template<typename T>
+struct PreviousPointStorage
+{
+    int count() const {
+        return m_data.count();
+    }
+
+    /**
+     * Insert \p number columns at \p position .
+     * \return the data, that became out of range (shifted over the end)
+     */
+    QVector< QPair<QPoint, T> > insertColumns(int position, int number) {
+        Q_ASSERT(1 <= position && position <= KS_colMax);
+        QVector< QPair<QPoint, T> > oldData;
+        for (int row = m_rows.count(); row >= 1; --row) {
+            const int rowStart = m_rows.value(row - 1);
+            const int rowLength = (row < m_rows.count()) ? m_rows.value(row) - rowStart : -1;
+            const QVector<int> cols = m_cols.mid(rowStart, rowLength);
+            for (int col = cols.count(); col >= 0; --col) {
+                if (cols.value(col) + number > KS_colMax) {
+                    oldData.append(qMakePair(QPoint(cols.value(col), row), m_data.value(rowStart + col)));
+                    m_cols.remove(rowStart + col);
+                    m_data.remove(rowStart + col);
+                    // adjust the offsets of the following rows
+                    for (int r = row; r < m_rows.count(); ++r)
+                        --m_rows[r];
+                } else if (cols.value(col) >= position)
+                    m_cols[rowStart + col] += number;
+            }
+        }
+        squeezeRows();
+        return oldData;
+    }
+
+    /**
+     * Removes \p number columns at \p position .
+     * \return the removed data
+     */
+    QVector< QPair<QPoint, T> > removeColumns(int position, int number) {
+        Q_ASSERT(1 <= position && position <= KS_colMax);
+        QVector< QPair<QPoint, T> > oldData;
+        for (int row = m_rows.count(); row >= 1; --row) {
+            const int rowStart = m_rows.value(row - 1);
+            const int rowLength = (row < m_rows.count()) ? m_rows.value(row) - rowStart : -1;
+            const QVector<int> cols = m_cols.mid(rowStart, rowLength);
+            for (int col = cols.count() - 1; col >= 0; --col) {
+                if (cols.value(col) >= position) {
+                    if (cols.value(col) < position + number) {
+                        oldData.append(qMakePair(QPoint(cols.value(col), row), m_data.value(rowStart + col)));
+                        m_cols.remove(rowStart + col);
+                        m_data.remove(rowStart + col);
+                        for (int r = row; r < m_rows.count(); ++r)
+                            --m_rows[r];
+                    } else
+                        m_cols[rowStart + col] -= number;
+                }
+            }
+        }
+        squeezeRows();
+        return oldData;
+    }
+
+    /**
+     * Insert \p number rows at \p position .
+     * \return the data, that became out of range (shifted over the end)
+     */
+    QVector< QPair<QPoint, T> > insertRows(int position, int number) {
+        Q_ASSERT(1 <= position && position <= KS_rowMax);
+        // row's missing?
+        if (position > m_rows.count())
+            return QVector< QPair<QPoint, T> >();
+        QVector< QPair<QPoint, T> > oldData;
+        int dataCount = 0;
+        int rowCount = 0;
+        // save the old data
+        for (int row = KS_rowMax - number + 1; row <= m_rows.count() && row <= KS_rowMax; ++row) {
+            const QVector<int>::const_iterator cstart(m_cols.begin() + m_rows.value(row - 1));
+            const QVector<int>::const_iterator cend((row < m_rows.count()) ? (m_cols.begin() + m_rows.value(row)) : m_cols.end());
+            for (QVector<int>::const_iterator cit = cstart; cit != cend; ++cit)
+                oldData.append(qMakePair(QPoint(*cit, row), m_data.value(cit - m_cols.constBegin())));
+            dataCount += (cend - cstart);
+            ++rowCount;
+        }
+        // remove the out of range data
+        while (dataCount-- > 0) {
+            m_data.remove(m_data.count() - 1);
+            m_cols.remove(m_cols.count() - 1);
+        }
+        while (rowCount-- > 0)
+            m_rows.remove(m_rows.count() - 1);
+        // insert the new rows
+        const int index = m_rows.value(position - 1);
+        for (int r = 0; r < number; ++r)
+            m_rows.insert(position, index);
+        squeezeRows();
+        return oldData;
+    }
+
+    /**
+     * Removes \p number rows at \p position .
+     * \return the removed data
+     */
+    QVector< QPair<QPoint, T> > removeRows(int position, int number) {
+        Q_ASSERT(1 <= position && position <= KS_rowMax);
+        // row's missing?
+        if (position > m_rows.count())
+            return QVector< QPair<QPoint, T> >();
+        QVector< QPair<QPoint, T> > oldData;
+        int dataCount = 0;
+        int rowCount = 0;
+        // save the old data
+        for (int row = position; row <= m_rows.count() && row <= position + number - 1; ++row) {
+            const int rowStart = m_rows.value(row - 1);
+            const int rowLength = (row < m_rows.count()) ? m_rows.value(row) - rowStart : -1;
+            const QVector<int> cols = m_cols.mid(rowStart, rowLength);
+            const QVector<T> data = m_data.mid(rowStart, rowLength);
+            for (int col = 0; col < cols.count(); ++col)
+                oldData.append(qMakePair(QPoint(cols.value(col), row), data.value(col)));
+            dataCount += data.count();
+            ++rowCount;
+        }
+        // adjust the offsets of the following rows
+        for (int r = position + number - 1; r < m_rows.count(); ++r)
+            m_rows[r] -= dataCount;
+        // remove the out of range data
+        while (dataCount-- > 0) {
+            m_data.remove(m_rows.value(position - 1));
+            m_cols.remove(m_rows.value(position - 1));
+        }
+        while (rowCount-- > 0)
+            m_rows.remove(position - 1);
+        squeezeRows();
+        return oldData;
+    }
+
+    /**
+     * Shifts the data right of \p rect to the left by the width of \p rect .
+     * The data formerly contained in \p rect becomes overridden.
+     * \return the removed data
+     */
+    QVector< QPair<QPoint, T> > removeShiftLeft(const QRect& rect) {
+        Q_ASSERT(1 <= rect.left() && rect.left() <= KS_colMax);
+        QVector< QPair<QPoint, T> > oldData;
+        for (int row = qMin(rect.bottom(), m_rows.count()); row >= rect.top(); --row) {
+            const int rowStart = m_rows.value(row - 1);
+            const int rowLength = (row < m_rows.count()) ? m_rows.value(row) - rowStart : -1;
+            const QVector<int> cols = m_cols.mid(rowStart, rowLength);
+            for (int col = cols.count() - 1; col >= 0; --col) {
+                if (cols.value(col) >= rect.left()) {
+                    if (cols.value(col) <= rect.right()) {
+                        oldData.append(qMakePair(QPoint(cols.value(col), row), m_data.value(rowStart + col)));
+                        m_cols.remove(rowStart + col);
+                        m_data.remove(rowStart + col);
+                        for (int r = row; r < m_rows.count(); ++r)
+                            --m_rows[r];
+                    } else
+                        m_cols[rowStart + col] -= rect.width();
+                }
+            }
+        }
+        squeezeRows();
+        return oldData;
+    }
+
+    /**
+     * Shifts the data in and right of \p rect to the right by the width of \p rect .
+     * \return the data, that became out of range (shifted over the end)
+     */
+    QVector< QPair<QPoint, T> > insertShiftRight(const QRect& rect) {
+        Q_ASSERT(1 <= rect.left() && rect.left() <= KS_colMax);
+        QVector< QPair<QPoint, T> > oldData;
+        for (int row = rect.top(); row <= rect.bottom() && row <= m_rows.count(); ++row) {
+            const int rowStart = m_rows.value(row - 1);
+            const int rowLength = (row < m_rows.count()) ? m_rows.value(row) - rowStart : -1;
+            const QVector<int> cols = m_cols.mid(rowStart, rowLength);
+            for (int col = cols.count(); col >= 0; --col) {
+                if (cols.value(col) + rect.width() > KS_colMax) {
+                    oldData.append(qMakePair(QPoint(cols.value(col), row), m_data.value(rowStart + col)));
+                    m_cols.remove(rowStart + col);
+                    m_data.remove(rowStart + col);
+                    // adjust the offsets of the following rows
+                    for (int r = row; r < m_rows.count(); ++r)
+                        --m_rows[r];
+                } else if (cols.value(col) >= rect.left())
+                    m_cols[rowStart + col] += rect.width();
+            }
+        }
+        squeezeRows();
+        return oldData;
+    }
+
+    /**
+     * Shifts the data below \p rect to the top by the height of \p rect .
+     * The data formerly contained in \p rect becomes overridden.
+     * \return the removed data
+     */
+    QVector< QPair<QPoint, T> > removeShiftUp(const QRect& rect) {
+        Q_ASSERT(1 <= rect.top() && rect.top() <= KS_rowMax);
+        // row's missing?
+        if (rect.top() > m_rows.count())
+            return QVector< QPair<QPoint, T> >();
+        QVector< QPair<QPoint, T> > oldData;
+        for (int row = rect.top(); row <= m_rows.count() && row <= KS_rowMax - rect.height(); ++row) {
+            const int rowStart = m_rows.value(row - 1);
+            const int rowLength = (row < m_rows.count()) ? m_rows.value(row) - rowStart : -1;
+            const QVector<int> cols = m_cols.mid(rowStart, rowLength);
+            const QVector<T> data = m_data.mid(rowStart, rowLength);
+            // first, iterate over the destination row
+            for (int col = cols.count() - 1; col >= 0; --col) {
+                const int column = cols.value(col); // real column value (1...KS_colMax)
+                if (column >= rect.left() && column <= rect.right()) {
+                    // save the old data
+                    if (row <= rect.bottom())
+                        oldData.append(qMakePair(QPoint(column, row), data.value(col)));
+                    // search
+                    const int srcRow = row + rect.height();
+                    const QVector<int>::const_iterator cstart2((srcRow - 1 < m_rows.count()) ? m_cols.begin() + m_rows.value(srcRow - 1) : m_cols.end());
+                    const QVector<int>::const_iterator cend2((srcRow < m_rows.count()) ? (m_cols.begin() + m_rows.value(srcRow)) : m_cols.end());
+                    const QVector<int>::const_iterator cit2 = qBinaryFind(cstart2, cend2, column);
+                    // column's missing?
+                    if (cit2 == cend2) {
+                        m_cols.remove(rowStart + col);
+                        m_data.remove(rowStart + col);
+                        // adjust the offsets of the following rows
+                        for (int r = row; r < m_rows.count(); ++r)
+                            --m_rows[r];
+                    }
+                    // column exists
+                    else {
+                        // copy
+                        m_data[rowStart + col] = m_data.value(cit2 - m_cols.constBegin());
+                        // remove
+                        m_cols.remove(cit2 - m_cols.constBegin());
+                        m_data.remove(cit2 - m_cols.constBegin());
+                        // adjust the offsets of the following rows
+                        for (int r = row + rect.height(); r < m_rows.count(); ++r)
+                            --m_rows[r];
+                    }
+                }
+            }
+            // last, iterate over the source row
+            const int srcRow = row + rect.height();
+            const int rowStart2 = (srcRow - 1 < m_rows.count()) ? m_rows.value(srcRow - 1) : m_data.count();
+            const int rowLength2 = (srcRow < m_rows.count()) ? m_rows.value(srcRow) - rowStart2 : -1;
+            const QVector<int> cols2 = m_cols.mid(rowStart2, rowLength2);
+            const QVector<T> data2 = m_data.mid(rowStart2, rowLength2);
+            int offset = 0;
+            for (int col = cols2.count() - 1; col >= 0; --col) {
+                const int column = cols2.value(col); // real column value (1...KS_colMax)
+                if (column >= rect.left() && column <= rect.right()) {
+                    // find the insertion position
+                    const QVector<int>::const_iterator cstart((row - 1 < m_rows.count()) ? m_cols.begin() + m_rows.value(row - 1) : m_cols.end());
+                    const QVector<int>::const_iterator cend(((row < m_rows.count())) ? (m_cols.begin() + m_rows.value(row)) : m_cols.end());
+                    const QVector<int>::const_iterator cit = qUpperBound(cstart, cend, cols2.value(col));
+                    // Destination column:
+                    const QVector<int>::const_iterator dstcit = qBinaryFind(cols.begin(), cols.end(), column);
+                    if (dstcit != cols.end()) { // destination column exists
+                        // replace the existing destination value
+                        const int dstCol = (dstcit - cols.constBegin());
+                        m_data[rowStart + dstCol] = m_data.value(rowStart2 + col);
+                        // remove it from its old position
+                        m_data.remove(rowStart2 + col + 1);
+                        m_cols.remove(rowStart2 + col + 1);
+                        // The amount of values in the range from the
+                        // destination row to the source row have not changed.
+                        // adjust the offsets of the following rows
+                        for (int r = srcRow; r < m_rows.count(); ++r) {
+                            ++m_rows[r];
+                        }
+                    } else { // destination column does not exist yet
+                        // copy it to its new position
+                        const int dstCol = cit - m_cols.constBegin();
+                        m_data.insert(dstCol, data2.value(col));
+                        m_cols.insert(dstCol, cols2.value(col));
+                        // remove it from its old position
+                        m_data.remove(rowStart2 + col + 1 + offset);
+                        m_cols.remove(rowStart2 + col + 1 + offset);
+                        ++offset;
+                        // adjust the offsets of the following rows
+                        for (int r = row; r < srcRow; ++r) {
+                            ++m_rows[r];
+                        }
+                    }
+                }
+            }
+        }
+        squeezeRows();
+        return oldData;
+    }
+
+    /**
+     * Shifts the data in and below \p rect to the bottom by the height of \p rect .
+     * \return the data, that became out of range (shifted over the end)
+     */
+    QVector< QPair<QPoint, T> > insertShiftDown(const QRect& rect) {
+        Q_ASSERT(1 <= rect.top() && rect.top() <= KS_rowMax);
+        // row's missing?
+        if (rect.top() > m_rows.count())
+            return QVector< QPair<QPoint, T> >();
+        QVector< QPair<QPoint, T> > oldData;
+        for (int row = m_rows.count(); row >= rect.top(); --row) {
+            const int rowStart = m_rows.value(row - 1);
+            const int rowLength = (row < m_rows.count()) ? m_rows.value(row) - rowStart : -1;
+            const QVector<int> cols = m_cols.mid(rowStart, rowLength);
+            const QVector<T> data = m_data.mid(rowStart, rowLength);
+            for (int col = cols.count() - 1; col >= 0; --col) {
+                if (cols.value(col) >= rect.left() && cols.value(col) <= rect.right()) {
+                    if (row + rect.height() > KS_rowMax) {
+                        // save old data
+                        oldData.append(qMakePair(QPoint(cols.value(col), row), data.value(col)));
+                    } else {
+                        // insert missing rows
+                        if (row + rect.height() > m_rows.count())
+                            m_rows.insert(m_rows.count(), row + rect.height() - m_rows.count(), m_data.count());
+
+                        // copy the data down
+                        const int row2 = row + rect.height();
+                        const QVector<int>::const_iterator cstart2(m_cols.begin() + m_rows.value(row2 - 1));
+                        const QVector<int>::const_iterator cend2((row2 < m_rows.count()) ? (m_cols.begin() + m_rows.value(row2)) : m_cols.end());
+                        const QVector<int>::const_iterator cit2 = qLowerBound(cstart2, cend2, cols.value(col));
+                        // column's missing?
+                        if (cit2 == cend2 || *cit2 != cols.value(col)) {
+                            // determine the index where the data and column has to be inserted
+                            const int index = m_rows.value(row2 - 1) + (cit2 - cstart2);
+                            // insert the actual data
+                            m_data.insert(index, data.value(col));
+                            // insert the column index
+                            m_cols.insert(index, cols.value(col));
+                            // adjust the offsets of the following rows
+                            for (int r = row2; r < m_rows.count(); ++r)
+                                ++m_rows[r];
+                        }
+                        // column exists
+                        else {
+                            const int index = m_rows.value(row2 - 1) + (cit2 - cstart2);
+                            m_data[ index ] = data.value(col);
+                        }
+                    }
+
+                    // remove the data
+                    m_cols.remove(rowStart + col);
+                    m_data.remove(rowStart + col);
+                    // adjust the offsets of the following rows
+                    for (int r = row; r < m_rows.count(); ++r)
+                        --m_rows[r];
+                }
+            }
+        }
+        squeezeRows();
+        return oldData;
+    }
+
+    void squeezeRows() {
+        int row = m_rows.count() - 1;
+        while (m_rows.value(row) == m_data.count() && row >= 0)
+            m_rows.remove(row--);
+    }
+
+    QVector<int> m_cols;    // stores the column indices (beginning with one)
+    QVector<int> m_rows;    // stores the row offsets in m_data
+    QVector<T>   m_data;    // stores the actual non-default data
+};
+} // namespace
+
 void PointStorageBenchmark::testInsertionPerformance_loadingLike()
 {
     PointStorage<int> storage;
@@ -265,4 +637,87 @@ void PointStorageBenchmark::testIterationPerformance()
     Q_UNUSED(v); //Not fully unused, but GCC thinks so
 }
 
+template<typename Storage>
+static void benchmarkStructuralEdit(Storage& storage, const QString& edit)
+{
+    // Each edit is followed by its reverse, like an undo, to keep the storage's size.
+    const QRect rect(2, 2, 3, 3);
+    if (edit == "rows") {
+        QBENCHMARK {
+            storage.insertRows(2, 3);
+            storage.removeRows(2, 3);
+        }
+    } else if (edit == "columns") {
+        QBENCHMARK {
+            storage.insertColumns(2, 3);
+            storage.removeColumns(2, 3);
+        }
+    } else if (edit == "shift down/up") {
+        QBENCHMARK {
+            storage.insertShiftDown(rect);
+            storage.removeShiftUp(rect);
+        }
+    } else {
+        QBENCHMARK {
+            storage.insertShiftRight(rect);
+            storage.removeShiftLeft(rect);
+        }
+    }
+}
+
+void PointStorageBenchmark::testStructuralEditPerformance_data()
+{
+    QTest::addColumn<int>("maxrow");
+    QTest::addColumn<int>("maxcol");
+    QTest::addColumn<QString>("edit");
+    QTest::addColumn<bool>("previous");
+
+    // The previous implementation is quadratic in the amount of data, hence,
+    // it is compared on the smaller sizes only.
+    const QStringList edits = QStringList() << "rows" << "columns" << "shift down/up" << "shift right/left";
+    foreach (const QString& edit, edits) {
+        QTest::newRow(qPrintable("medium; " + edit)) << 100 << 100 << edit << false;
+        QTest::newRow(qPrintable("medium; " + edit + "; previous")) << 100 << 100 << edit << true;
+        QTest::newRow(qPrintable("more rows; " + edit)) << 1000 << 100 << edit << false;
+        QTest::newRow(qPrintable("more rows; " + edit + "; previous")) << 1000 << 100 << edit << true;
+        QTest::newRow(qPrintable("typical data: more rows; " + edit)) << 10000 << 100 << edit << false;
+        QTest::newRow(qPrintable("large; " + edit)) << 1000 << 1000 << edit << false;
+    }
+}
+
+void PointStorageBenchmark::testStructuralEditPerformance()
+{
+    QFETCH(int, maxrow);
+    QFETCH(int, maxcol);
+    QFETCH(QString, edit);
+    QFETCH(bool, previous);
+
+    QVector<int> data;
+    QVector<int> cols;
+    QVector<int> rows;
+    for (int r = 0; r < maxrow; ++r) {
+        for (int c = 0; c < maxcol; ++c) {
+            data << c;
+            cols << (c + 1);
+        }
+        rows << r*maxcol;
+    }
+
+    if (previous) {
+        PreviousPointStorage<int> storage;
+        storage.m_data = data;
+        storage.m_cols = cols;
+        storage.m_rows = rows;
+        benchmarkStructuralEdit(storage, edit);
+        QCOMPARE(storage.count(), maxrow * maxcol);
+    } else {
+        PointStorage<int> storage;
+        storage.m_data = data;
+        storage.m_cols = cols;
+        storage.m_rows = rows;
+        benchmarkStructuralEdit(storage, edit);
+        QCOMPARE(storage.count(), maxrow * maxcol);
+    }
+}
+
 QTEST_MAIN(PointStorageBenchmark)
@@ -45,6 +45,8 @@ private Q_SLOTS:
     void testShiftDownPerformance();
     void testIterationPerformance_data();
     void testIterationPerformance();
+    void testStructuralEditPerformance_data();
+    void testStructuralEditPerformance();
 };
 
 } // namespace Sheets
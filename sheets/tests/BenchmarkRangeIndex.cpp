@@ -0,0 +1,131 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "BenchmarkRangeIndex.h"
+
+#include <QTest>
+
+using namespace Calligra::Sheets;
+
+static const int s_rangeCount = 1000000;
+static const int s_columns = 100;
+static const int s_rows = 10000;
+
+void RangeIndexBenchmark::initTestCase()
+{
+    // One million formulas referencing the cell left of them, a small
+    // block above them or, every hundredth one, a complete column,
+    // like SUM(A:A) does.
+    m_ranges.reserve(s_rangeCount);
+    qsrand(1);
+    for (int i = 0; i < s_rangeCount; ++i) {
+        const int col = 1 + qrand() % s_columns;
+        const int row = 1 + qrand() % s_rows;
+        if (i % 100 == 0)
+            m_ranges.append(QRect(col, 1, 1, KS_rowMax));
+        else if (i % 10 == 0)
+            m_ranges.append(QRect(col, row, 1 + qrand() % 5, 1 + qrand() % 50));
+        else
+            m_ranges.append(QRect(col, row, 1, 1));
+    }
+    for (int i = 0; i < m_ranges.count(); ++i) {
+        m_index.insert(m_ranges[i], i);
+        m_tree.insert(m_ranges[i], i);
+    }
+}
+
+void RangeIndexBenchmark::testRangeIndexInsertion()
+{
+    QBENCHMARK {
+        RangeIndex<int> index;
+        for (int i = 0; i < m_ranges.count(); ++i)
+            index.insert(m_ranges[i], i);
+    }
+}
+
+void RangeIndexBenchmark::testRTreeInsertion()
+{
+    QBENCHMARK {
+        RTree<int> tree;
+        for (int i = 0; i < m_ranges.count(); ++i)
+            tree.insert(m_ranges[i], i);
+    }
+}
+
+void RangeIndexBenchmark::testRangeIndexLookup()
+{
+    int counter = 0;
+    QBENCHMARK {
+        for (int row = 1; row <= s_rows; row += 10) {
+            for (int col = 1; col <= s_columns; ++col)
+                counter += m_index.contains(QPoint(col, row)).count();
+        }
+    }
+    QVERIFY(counter > 0);
+}
+
+void RangeIndexBenchmark::testRTreeLookup()
+{
+    int counter = 0;
+    QBENCHMARK {
+        for (int row = 1; row <= s_rows; row += 10) {
+            for (int col = 1; col <= s_columns; ++col)
+                counter += m_tree.contains(QPoint(col, row)).count();
+        }
+    }
+    QVERIFY(counter > 0);
+}
+
+void RangeIndexBenchmark::testRangeIndexIntersection()
+{
+    int counter = 0;
+    QBENCHMARK {
+        for (int row = 1; row <= s_rows; row += 100)
+            counter += m_index.intersects(QRect(1, row, 10, 10)).count();
+    }
+    QVERIFY(counter > 0);
+}
+
+void RangeIndexBenchmark::testRTreeIntersection()
+{
+    int counter = 0;
+    QBENCHMARK {
+        for (int row = 1; row <= s_rows; row += 100)
+            counter += m_tree.intersects(QRect(1, row, 10, 10)).count();
+    }
+    QVERIFY(counter > 0);
+}
+
+void RangeIndexBenchmark::testRangeIndexRemoval()
+{
+    QBENCHMARK_ONCE {
+        for (int i = 0; i < m_ranges.count(); i += 10)
+            m_index.remove(m_ranges[i], i);
+    }
+}
+
+void RangeIndexBenchmark::testRTreeRemoval()
+{
+    QBENCHMARK_ONCE {
+        for (int i = 0; i < m_ranges.count(); i += 10)
+            m_tree.remove(m_ranges[i], i);
+    }
+}
+
+QTEST_MAIN(RangeIndexBenchmark)
@@ -0,0 +1,63 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_RANGE_INDEX_BENCHMARK_H
+#define CALLIGRA_SHEETS_RANGE_INDEX_BENCHMARK_H
+
+#include <QObject>
+#include <QRect>
+#include <QVector>
+
+#include "RangeIndex.h"
+#include "RTree.h"
+
+namespace Calligra
+{
+namespace Sheets
+{
+
+/**
+ * Compares RangeIndex and RTree as dependency index for a sheet with
+ * one million range references, some of them complete columns.
+ */
+class RangeIndexBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+
+    void testRangeIndexInsertion();
+    void testRTreeInsertion();
+    void testRangeIndexLookup();
+    void testRTreeLookup();
+    void testRangeIndexIntersection();
+    void testRTreeIntersection();
+    void testRangeIndexRemoval();
+    void testRTreeRemoval();
+
+private:
+    QVector<QRect> m_ranges;
+    RangeIndex<int> m_index;
+    RTree<int> m_tree;
+};
+
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_RANGE_INDEX_BENCHMARK_H
@@ -0,0 +1,89 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+
+#include "BenchmarkSort.h"
+
+#include "CellStorage.h"
+#include "Map.h"
+#include "Sheet.h"
+#include "../commands/SortManipulator.h"
+
+#include <QTest>
+
+using namespace Calligra::Sheets;
+
+void SortBenchmark::testSortRows_data()
+{
+    QTest::addColumn<int>("rows");
+
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("1M") << 1000000;
+}
+
+void SortBenchmark::testSortRows()
+{
+    QFETCH(int, rows);
+
+    Map map;
+    Sheet* sheet = new Sheet(&map, "Sheet1");
+    map.addSheet(sheet);
+    CellStorage* storage = sheet->cellStorage();
+
+    // two keys with many duplicates and the original position
+    quint32 random = 1;
+    for (int row = 1; row <= rows; ++row) {
+        random = random * 1103515245 + 12345;
+        storage->setValue(1, row, Value(int((random >> 16) % 1000)));
+        storage->setValue(2, row, Value(int((random >> 8) % 10)));
+        storage->setValue(3, row, Value(row));
+    }
+
+    SortManipulator* command = new SortManipulator();
+    command->setRegisterUndo(false);
+    command->setSheet(sheet);
+    command->setSortRows(true);
+    command->setSkipFirst(false);
+    command->setCopyFormat(false);
+    command->addCriterion(0, Qt::AscendingOrder, Qt::CaseInsensitive);
+    command->addCriterion(1, Qt::DescendingOrder, Qt::CaseInsensitive);
+    command->add(QRect(1, 1, 3, rows), sheet);
+
+    QBENCHMARK_ONCE {
+        command->execute();
+    }
+    delete command;
+
+    // sorted and stable
+    for (int row = 2; row <= rows; ++row) {
+        const qint64 previous = storage->value(1, row - 1).asInteger();
+        const qint64 current = storage->value(1, row).asInteger();
+        QVERIFY(previous <= current);
+        if (previous == current) {
+            const qint64 previousSecond = storage->value(2, row - 1).asInteger();
+            const qint64 currentSecond = storage->value(2, row).asInteger();
+            QVERIFY(previousSecond >= currentSecond);
+            if (previousSecond == currentSecond)
+                QVERIFY(storage->value(3, row - 1).asInteger() < storage->value(3, row).asInteger());
+        }
+    }
+}
+
+QTEST_MAIN(SortBenchmark)
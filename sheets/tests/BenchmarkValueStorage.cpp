@@ -0,0 +1,136 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "BenchmarkValueStorage.h"
+
+#include "ColumnarValueStorage.h"
+#include "PointStorage.h"
+
+#include <QFile>
+#include <QTest>
+
+#include <unistd.h>
+
+using namespace Calligra::Sheets;
+
+// 10 columns of 100000 rows, i.e. 1M cells
+static const int s_columns = 10;
+static const int s_rows = 100000;
+
+// the resident memory in bytes
+static qint64 residentMemory()
+{
+#ifdef Q_OS_LINUX
+    QFile file("/proc/self/statm");
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+    const QList<QByteArray> fields = file.readAll().split(' ');
+    if (fields.count() < 2)
+        return -1;
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+// integers and fractions, like in a typical data sheet
+template<typename T>
+static void fill(T& storage)
+{
+    for (int row = 1; row <= s_rows; ++row) {
+        for (int col = 1; col <= s_columns; ++col) {
+            if (col % 2)
+                storage.insert(col, row, Value(row % 1000));
+            else
+                storage.insert(col, row, Value((row % 1000) / 8.0));
+        }
+    }
+}
+
+// the element-wise walk over the values, which the aggregates do for PointStorage
+static Number sum(const PointStorage<Value>& storage)
+{
+    Number sum = 0.0;
+    for (int i = 0; i < storage.count(); ++i) {
+        const Value value = storage.data(i);
+        if (value.isNumber())
+            sum += value.asFloat();
+    }
+    return sum;
+}
+
+void ValueStorageBenchmark::testMemory_data()
+{
+    QTest::addColumn<bool>("columnar");
+
+    QTest::newRow("PointStorage") << false;
+    QTest::newRow("ColumnarValueStorage") << true;
+}
+
+void ValueStorageBenchmark::testMemory()
+{
+    QFETCH(bool, columnar);
+    if (residentMemory() < 0)
+        QSKIP("The resident memory is unknown on this platform.");
+
+    PointStorage<Value> points;
+    ColumnarValueStorage columns;
+    const qint64 before = residentMemory();
+    QBENCHMARK_ONCE {
+        if (columnar)
+            fill(columns);
+        else
+            fill(points);
+    }
+    const qint64 growth = residentMemory() - before;
+    QTest::setBenchmarkResult(growth, QTest::BytesAllocated);
+
+    QCOMPARE(columnar ? columns.count() : points.count(), s_columns * s_rows);
+}
+
+void ValueStorageBenchmark::testSum_data()
+{
+    testMemory_data();
+}
+
+void ValueStorageBenchmark::testSum()
+{
+    QFETCH(bool, columnar);
+
+    PointStorage<Value> points;
+    ColumnarValueStorage columns;
+    if (columnar)
+        fill(columns);
+    else
+        fill(points);
+
+    Number result = 0.0;
+    QBENCHMARK {
+        if (columnar) {
+            int count = 0;
+            result = 0.0;
+            QVERIFY(columns.sumNumbers(QRect(1, 1, s_columns, s_rows), &result, &count));
+        } else
+            result = sum(points);
+    }
+    // 100 times 0 to 999 and an eighth of it in 5 columns each
+    QCOMPARE(double(result), 5 * 100 * 499500 * (1.0 + 1.0 / 8.0));
+}
+
+QTEST_MAIN(ValueStorageBenchmark)
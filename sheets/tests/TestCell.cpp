@@ -31,6 +31,7 @@
 #include <sheets/Map.h>
 #include <sheets/Sheet.h>
 #include <sheets/Style.h>
+#include <sheets/odf/CellContentsLoader.h>
 #include <sheets/odf/OdfLoadingContext.h>
 #include <sheets/Value.h>
 #include <sheets/odf/SheetsOdf.h>
@@ -39,10 +40,10 @@
 
 using namespace Calligra::Sheets;
 
-KoXmlDocument CellTest::xmlDocument(const QString &content)
+KoXmlDocument CellTest::xmlDocument(const QString &content, const QString &attributes)
 {
     KoXmlDocument document;
-    QString xml = "<table:table-cell xmlns:text=\"urn:oasis:names:tc:opendocument:xmlns:text:1.0\" xmlns:table=\"urn:oasis:names:tc:opendocument:xmlns:table:1.0\" xmlns:draw=\"urn:oasis:names:tc:opendocument:xmlns:drawing:1.0\" xmlns:style=\"urn:oasis:names:tc:opendocument:xmlns:style:1.0\" xmlns:number=\"urn:oasis:names:tc:opendocument:xmlns:datastyle:1.0\" >" + content + "</table:table-cell>";
+    QString xml = "<table:table-cell xmlns:text=\"urn:oasis:names:tc:opendocument:xmlns:text:1.0\" xmlns:table=\"urn:oasis:names:tc:opendocument:xmlns:table:1.0\" xmlns:draw=\"urn:oasis:names:tc:opendocument:xmlns:drawing:1.0\" xmlns:style=\"urn:oasis:names:tc:opendocument:xmlns:style:1.0\" xmlns:number=\"urn:oasis:names:tc:opendocument:xmlns:datastyle:1.0\" xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\" " + attributes + " >" + content + "</table:table-cell>";
     bool ok = document.setContent(xml, true);
     return ok ? document : KoXmlDocument();
 }
@@ -114,4 +115,82 @@ void CellTest::testRichText()
     }
 }
 
+void CellTest::testCellContentsLoader_data()
+{
+    QTest::addColumn<QString>("attributes");
+    QTest::addColumn<QString>("content");
+    QTest::addColumn<bool>("plain");
+    QTest::addColumn<Value>("value");
+    QTest::addColumn<int>("format");
+    QTest::addColumn<QString>("userInput");
+
+    QTest::newRow("float") << "office:value-type=\"float\" office:value=\"1.5\"" << "<text:p>1,50</text:p>"
+                           << true << Value(1.5) << int(Value::fmt_Number) << "1.5";
+    QTest::newRow("percentage") << "office:value-type=\"percentage\" office:value=\"0.5\"" << "<text:p>50%</text:p>"
+                                << true << Value(0.5) << int(Value::fmt_Percent) << "50%";
+    QTest::newRow("string") << "office:value-type=\"string\"" << "<text:p>  Some  text </text:p>"
+                            << true << Value("Some text ") << int(Value::fmt_String) << "Some text ";
+    QTest::newRow("string value") << "office:value-type=\"string\" office:string-value=\"Value\"" << "<text:p>Text</text:p>"
+                                  << true << Value("Value") << int(Value::fmt_String) << "Text";
+    QTest::newRow("boolean") << "office:value-type=\"boolean\" office:boolean-value=\"TRUE\"" << "<text:p>TRUE</text:p>"
+                             << true << Value(true) << int(Value::fmt_Boolean) << "TRUE";
+    QTest::newRow("date") << "office:value-type=\"date\" office:date-value=\"2016-02-29\"" << "<text:p>02/29/16</text:p>"
+                          << true << Value(42429.0) << int(Value::fmt_Date) << "02/29/16";
+    QTest::newRow("time") << "office:value-type=\"time\" office:time-value=\"PT15H10M12S\"" << "<text:p>15:10:12</text:p>"
+                          << true << Value(QTime(15, 10, 12)) << int(Value::fmt_Time) << "15:10:12";
+    QTest::newRow("formula") << "table:formula=\"of:=[.A1]+1\" office:value-type=\"float\" office:value=\"2\"" << "<text:p>2</text:p>"
+                             << true << Value(2.0) << int(Value::fmt_Number) << "=A1+1";
+    QTest::newRow("no paragraph") << "office:value-type=\"float\" office:value=\"3\"" << ""
+                                  << true << Value(3.0) << int(Value::fmt_Number) << "3";
+
+    // loaded by Odf::loadCell()
+    QTest::newRow("no value type") << "" << "<text:p>1.5</text:p>"
+                                   << false << Value() << int(Value::fmt_None) << "";
+    QTest::newRow("span") << "office:value-type=\"string\"" << "<text:p>Some<text:span>text</text:span></text:p>"
+                          << false << Value() << int(Value::fmt_None) << "";
+    QTest::newRow("paragraphs") << "office:value-type=\"string\"" << "<text:p>Some</text:p><text:p>text</text:p>"
+                                << false << Value() << int(Value::fmt_None) << "";
+    QTest::newRow("merged") << "office:value-type=\"string\" table:number-columns-spanned=\"2\"" << "<text:p>text</text:p>"
+                            << false << Value() << int(Value::fmt_None) << "";
+    QTest::newRow("annotation") << "office:value-type=\"string\"" << "<office:annotation><text:p>Note</text:p></office:annotation><text:p>text</text:p>"
+                                << false << Value() << int(Value::fmt_None) << "";
+}
+
+void CellTest::testCellContentsLoader()
+{
+    QFETCH(QString, attributes);
+    QFETCH(QString, content);
+    QFETCH(bool, plain);
+    QFETCH(Value, value);
+    QFETCH(int, format);
+    QFETCH(QString, userInput);
+
+    Map map;
+    Sheet* sheet = map.addNewSheet();
+    KoXmlDocument doc = xmlDocument(content, attributes);
+    KoXmlElement e = doc.documentElement();
+    QVERIFY(!e.isNull());
+
+    map.setLoading(true);
+    {
+        // a cell repeated in two columns
+        Odf::CellContentsLoader loader(&map);
+        QCOMPARE(loader.read(sheet, e, 2, 3, 2, 1), plain);
+        loader.finish();
+    }
+    map.setLoading(false);
+
+    for (int column = 1; column <= 4; ++column) {
+        const Cell cell(sheet, column, 3);
+        if (!plain || column == 1 || column == 4) {
+            QVERIFY(cell.value().isEmpty());
+            QVERIFY(cell.userInput().isEmpty());
+            continue;
+        }
+        QCOMPARE(cell.value(), value);
+        QCOMPARE(int(cell.value().format()), format);
+        QCOMPARE(cell.userInput(), userInput);
+    }
+}
+
 QTEST_MAIN(CellTest)
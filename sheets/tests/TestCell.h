@@ -36,8 +36,10 @@ class CellTest : public QObject
     Q_OBJECT
 private Q_SLOTS:
     void testRichText();
+    void testCellContentsLoader_data();
+    void testCellContentsLoader();
 private:
-    KoXmlDocument xmlDocument(const QString &content);
+    KoXmlDocument xmlDocument(const QString &content, const QString &attributes = QString());
 };
 
 } // namespace Sheets
@@ -23,11 +23,30 @@
 #include <sheets/Map.h>
 #include <sheets/Sheet.h>
 #include <sheets/Value.h>
+#include <sheets/ValueStorage.h>
 
 #include <QTest>
 
+#include <kundo2command.h>
+#include <kundo2qstack.h>
+
 using namespace Calligra::Sheets;
 
+// A command keeping a given amount of undo data.
+class SizedCommand : public KUndo2Command
+{
+public:
+    explicit SizedCommand(qint64 size, KUndo2Command *parent = 0)
+            : KUndo2Command(parent)
+            , m_size(size) {
+    }
+    virtual qint64 size() const {
+        return m_size;
+    }
+private:
+    const qint64 m_size;
+};
+
 void CellStorageTest::testMergedCellsInsertRowBug()
 {
     Map map;
@@ -72,4 +91,75 @@ void CellStorageTest::testMergedCellsInsertRowBug()
     QCOMPARE(storage->mergedYCells(1, 3), 2);
 }
 
+void CellStorageTest::testUndoRecording()
+{
+    Map map;
+    Sheet* sheet = map.addNewSheet();
+    CellStorage* storage = sheet->cellStorage();
+
+    storage->setValue(2, 2, Value(1));
+    storage->setValue(5, 7, Value("a"));
+    storage->setUserInput(5, 7, "a");
+
+    // fill mostly empty cells row by row, then column by column
+    storage->startUndoRecording();
+    for (int row = 1; row <= 10; ++row) {
+        for (int column = 1; column <= 10; ++column)
+            storage->setValue(column, row, Value(column * row));
+    }
+    for (int column = 1; column <= 10; ++column) {
+        for (int row = 1; row <= 10; ++row) {
+            storage->setValue(column, row, Value(-column * row));
+            storage->setUserInput(column, row, QString::number(-column * row));
+        }
+    }
+    storage->setValue(5, 7, Value());
+    KUndo2Command command;
+    storage->stopUndoRecording(&command);
+    QCOMPARE(storage->value(3, 4), Value(-12));
+
+    // the overwritten values are kept one by one, the defaults by rectangles
+    QVERIFY(command.size() >= qint64(100 * sizeof(QPair<QPoint, Value>)));
+    QVERIFY(command.size() < qint64(200 * sizeof(QPair<QPoint, Value>)));
+
+    // validate result
+    command.undo();
+    QCOMPARE(storage->value(2, 2), Value(1));
+    QCOMPARE(storage->value(5, 7), Value("a"));
+    QCOMPARE(storage->userInput(5, 7), QString("a"));
+    QCOMPARE(storage->userInput(2, 2), QString());
+    QCOMPARE(storage->valueStorage()->count(), 2);
+    QCOMPARE(storage->userInputStorage()->count(), 1);
+}
+
+void CellStorageTest::testUndoMemoryLimit()
+{
+    KUndo2QStack stack;
+    stack.setUndoMemoryLimit(250);
+
+    stack.push(new SizedCommand(100));
+    stack.push(new SizedCommand(100));
+    QCOMPARE(stack.count(), 2);
+
+    // the oldest command gets dropped
+    stack.push(new SizedCommand(100));
+    QCOMPARE(stack.count(), 2);
+    QCOMPARE(stack.index(), 2);
+
+    // the most recent command stays, even if it exceeds the limit on its own
+    stack.push(new SizedCommand(1000));
+    QCOMPARE(stack.count(), 1);
+    QCOMPARE(stack.index(), 1);
+    QVERIFY(stack.canUndo());
+
+    // the undo data of child commands is counted
+    KUndo2Command *const command = new KUndo2Command;
+    new SizedCommand(100, command);
+    new SizedCommand(100, command);
+    QCOMPARE(command->size(), qint64(200));
+    stack.push(command);
+    QCOMPARE(stack.count(), 1);
+    QCOMPARE(stack.command(0), static_cast<const KUndo2Command*>(command));
+}
+
 QTEST_MAIN(CellStorageTest)
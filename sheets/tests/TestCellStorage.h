@@ -32,6 +32,8 @@ class CellStorageTest : public QObject
     Q_OBJECT
 private Q_SLOTS:
     void testMergedCellsInsertRowBug();
+    void testUndoRecording();
+    void testUndoMemoryLimit();
 };
 
 } // namespace Sheets
@@ -0,0 +1,240 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "TestColumnarValueStorage.h"
+
+#include <QTest>
+
+#include "ColumnarValueStorage.h"
+#include "PointStorage.h"
+#include "Region.h"
+
+using namespace Calligra::Sheets;
+
+static Value formatted(const Value& value, Value::Format format)
+{
+    Value result(value);
+    result.setFormat(format);
+    return result;
+}
+
+void TestColumnarValueStorage::testValueTypes()
+{
+    QList<Value> values;
+    values << Value(true) << Value(false)
+           << Value(42) << Value(Q_INT64_C(-9007199254740992)) << Value(Q_INT64_C(9007199254740993))
+           << Value(0.5) << Value(1.0 / 3.0) << Value(Number(1) / Number(3))
+           << Value("text") << Value(QString()) << Value::errorDIV0() << Value()
+           << formatted(Value(0.25), Value::fmt_Percent) << formatted(Value(42000), Value::fmt_Date)
+           << formatted(Value(true), Value::fmt_Number) << formatted(Value(12), Value::fmt_Money);
+
+    ColumnarValueStorage storage;
+    for (int i = 0; i < values.count(); ++i)
+        storage.insert(1 + i % 3, 1 + i, values[i]);
+    QCOMPARE(storage.count(), values.count());
+    for (int i = 0; i < values.count(); ++i) {
+        const Value value = storage.lookup(1 + i % 3, 1 + i);
+        QCOMPARE(value.type(), values[i].type());
+        QCOMPARE(value.format(), values[i].format());
+        QCOMPARE(value, values[i]);
+    }
+    // the exact value of integers beyond 2^53
+    QCOMPARE(storage.lookup(2, 5).asInteger(), Q_INT64_C(9007199254740993));
+    QVERIFY(storage.lookup(3, 12).isEmpty());
+
+    // overwriting changes the kind of storage
+    QCOMPARE(storage.insert(1, 1, Value("string")), Value(true));
+    QCOMPARE(storage.insert(1, 1, Value(7)), Value("string"));
+    QCOMPARE(storage.take(1, 1), Value(7));
+    QCOMPARE(storage.count(), values.count() - 1);
+}
+
+void TestColumnarValueStorage::testNavigation()
+{
+    ColumnarValueStorage storage;
+    storage.insert(2, 2, Value(1));
+    storage.insert(5, 2, Value(2));
+    storage.insert(2, 7, Value(3));
+    storage.insert(9, 7, Value("four"));
+
+    int newCol = -1;
+    int newRow = -1;
+    QCOMPARE(storage.firstInRow(2, &newCol), Value(1));
+    QCOMPARE(newCol, 2);
+    QCOMPARE(storage.nextInRow(2, 2, &newCol), Value(2));
+    QCOMPARE(newCol, 5);
+    QCOMPARE(storage.nextInRow(5, 2, &newCol), Value());
+    QCOMPARE(newCol, 0);
+    QCOMPARE(storage.lastInRow(7, &newCol), Value("four"));
+    QCOMPARE(newCol, 9);
+    QCOMPARE(storage.prevInRow(9, 7, &newCol), Value(3));
+    QCOMPARE(newCol, 2);
+    QCOMPARE(storage.prevInRow(2, 7, &newCol), Value());
+    QCOMPARE(newCol, 0);
+    QCOMPARE(storage.firstInRow(3, &newCol), Value());
+    QCOMPARE(newCol, 0);
+
+    QCOMPARE(storage.firstInColumn(2, &newRow), Value(1));
+    QCOMPARE(newRow, 2);
+    QCOMPARE(storage.nextInColumn(2, 2, &newRow), Value(3));
+    QCOMPARE(newRow, 7);
+    QCOMPARE(storage.nextInColumn(2, 7, &newRow), Value());
+    QCOMPARE(newRow, 0);
+    QCOMPARE(storage.lastInColumn(5, &newRow), Value(2));
+    QCOMPARE(newRow, 2);
+    QCOMPARE(storage.prevInColumn(2, 7, &newRow), Value(1));
+    QCOMPARE(newRow, 2);
+    QCOMPARE(storage.firstInColumn(10, &newRow), Value());
+    QCOMPARE(newRow, 0);
+
+    QCOMPARE(storage.columns(), 9);
+    QCOMPARE(storage.rows(), 7);
+
+    // the index based access is row-major
+    QCOMPARE(storage.count(), 4);
+    QCOMPARE(storage.col(1), 5);
+    QCOMPARE(storage.row(1), 2);
+    QCOMPARE(storage.data(2), Value(3));
+    QCOMPARE(storage.col(3), 9);
+    QCOMPARE(storage.row(3), 7);
+}
+
+void TestColumnarValueStorage::testSubStorage()
+{
+    ColumnarValueStorage storage;
+    for (int col = 1; col <= 5; ++col) {
+        for (int row = 1; row <= 5; ++row)
+            storage.insert(col, row, Value(col * 10 + row));
+    }
+    ColumnarValueStorage subStorage = storage.subStorage(Region(QRect(2, 3, 2, 2)));
+    QCOMPARE(subStorage.count(), 4);
+    QCOMPARE(subStorage.lookup(2, 3), Value(23));
+    QCOMPARE(subStorage.lookup(3, 4), Value(34));
+    QCOMPARE(subStorage.lookup(1, 1), Value());
+
+    subStorage = storage.subStorage(Region(QRect(2, 3, 2, 2)), false);
+    QCOMPARE(subStorage.count(), 4);
+    QCOMPARE(subStorage.lookup(1, 1), Value(23));
+    QCOMPARE(subStorage.lookup(2, 2), Value(34));
+    QCOMPARE(subStorage.columns(), 2);
+    QCOMPARE(subStorage.rows(), 2);
+}
+
+template<typename Storage>
+static QVector< QPair<QPoint, Value> > randomOperation(Storage& storage, int operation, int col, int row, int number)
+{
+    const QRect rect(col, row, number, number + 1);
+    switch (operation) {
+    case 0: return storage.insertColumns(col, number);
+    case 1: return storage.removeColumns(col, number);
+    case 2: return storage.insertRows(row, number);
+    case 3: return storage.removeRows(row, number);
+    case 4: return storage.removeShiftLeft(rect);
+    case 5: return storage.insertShiftRight(rect);
+    case 6: return storage.removeShiftUp(rect);
+    default: return storage.insertShiftDown(rect);
+    }
+}
+
+static QMap<QPair<int, int>, Value> toMap(const QVector< QPair<QPoint, Value> >& data)
+{
+    QMap<QPair<int, int>, Value> map;
+    for (int i = 0; i < data.count(); ++i)
+        map.insert(qMakePair(data[i].first.x(), data[i].first.y()), data[i].second);
+    return map;
+}
+
+void TestColumnarValueStorage::testSumNumbers()
+{
+    ColumnarValueStorage storage;
+    storage.insert(1, 1, Value(1));
+    storage.insert(1, 2, Value(0.5));
+    storage.insert(1, 3, Value(true));
+    storage.insert(1, 4, Value("text"));
+    storage.insert(2, 1, Value(Q_INT64_C(9007199254740993)));
+    storage.insert(2, 3, formatted(Value(2), Value::fmt_Date));
+    storage.insert(3, 2, Value::errorDIV0());
+
+    Number sum = 1.0;
+    int count = 1;
+    QVERIFY(storage.sumNumbers(QRect(1, 1, 1, 4), &sum, &count));
+    QCOMPARE(double(sum), 2.5);
+    QCOMPARE(count, 3);
+
+    // errors
+    sum = 0.0;
+    count = 0;
+    QVERIFY(storage.sumNumbers(QRect(2, 1, 5, 3), &sum, &count) == false);
+    QCOMPARE(double(sum), 0.0);
+    QCOMPARE(count, 0);
+    // numbers kept as Value objects, beyond the occupied rows
+    QVERIFY(storage.sumNumbers(QRect(2, 1, 1, 10), &sum, &count));
+    QVERIFY(sum == Number(Q_INT64_C(9007199254740993)) + 2);
+    QCOMPARE(count, 2);
+}
+
+void TestColumnarValueStorage::testCompareWithPointStorage()
+{
+    PointStorage<Value> expected;
+    ColumnarValueStorage storage;
+    qsrand(1);
+    for (int i = 0; i < 3000; ++i) {
+        const int col = 1 + qrand() % 12;
+        const int row = 1 + qrand() % 40;
+        const int operation = qrand() % 16;
+        if (operation < 5) {
+            Value value;
+            switch (qrand() % 4) {
+            case 0: value = Value(qrand() % 100); break;
+            case 1: value = Value(double(qrand() % 100) / 8); break;
+            case 2: value = Value(QString::number(qrand() % 100)); break;
+            default: value = formatted(Value(qrand() % 100), Value::fmt_Percent); break;
+            }
+            QCOMPARE(storage.insert(col, row, value), expected.insert(col, row, value));
+        } else if (operation < 8) {
+            QCOMPARE(storage.take(col, row), expected.take(col, row));
+        } else {
+            const int number = 1 + qrand() % 3;
+            QCOMPARE(toMap(randomOperation(storage, operation - 8, col, row, number)),
+                     toMap(randomOperation(expected, operation - 8, col, row, number)));
+        }
+
+        QCOMPARE(storage.count(), expected.count());
+        for (int j = 0; j < expected.count(); ++j) {
+            QCOMPARE(storage.col(j), expected.col(j));
+            QCOMPARE(storage.row(j), expected.row(j));
+            QCOMPARE(storage.data(j), expected.data(j));
+            QCOMPARE(storage.data(j).format(), expected.data(j).format());
+        }
+        QCOMPARE(storage.columns(), expected.columns());
+        QCOMPARE(storage.rows(), expected.rows());
+        for (int r = 1; r <= expected.rows(); ++r) {
+            int col1 = 0;
+            int col2 = 0;
+            QCOMPARE(storage.firstInRow(r, &col1), expected.firstInRow(r, &col2));
+            QCOMPARE(col1, col2);
+            while (col2) {
+                QCOMPARE(storage.nextInRow(col1, r, &col1), expected.nextInRow(col2, r, &col2));
+                QCOMPARE(col1, col2);
+            }
+        }
+    }
+}
+
+QTEST_MAIN(TestColumnarValueStorage)
@@ -19,6 +19,12 @@
 
 #include "TestDatabaseFilter.h"
 
+#include <sheets/CellStorage.h>
+#include <sheets/Map.h>
+#include <sheets/Region.h>
+#include <sheets/Sheet.h>
+#include <sheets/Value.h>
+#include <sheets/database/Database.h>
 #include <sheets/database/Filter.h>
 
 #include <QTest>
@@ -87,4 +93,35 @@ void DatabaseFilterTest::testOrEquals()
     QVERIFY(a == b);
 }
 
+void DatabaseFilterTest::testEvaluate()
+{
+    Map map;
+    Sheet* sheet = map.addNewSheet();
+    CellStorage* storage = sheet->cellStorage();
+    const char* strings[] = { "a", "B", "A", "", "b", "a", "c" };
+    for (int row = 2; row <= 8; ++row) {
+        if (*strings[row - 2])
+            storage->setValue(1, row, Value(strings[row - 2]));
+        storage->setValue(2, row, Value(row % 4 + 1));
+    }
+
+    Filter filter;
+    filter.addCondition(Filter::OrComposition, 0, Filter::Match, "a");
+    filter.addCondition(Filter::OrComposition, 0, Filter::Match, "b", Qt::CaseSensitive);
+    Filter subFilter;
+    subFilter.addCondition(Filter::AndComposition, 1, Filter::NotMatch, "2");
+    filter.addSubFilter(Filter::AndComposition, subFilter);
+    Database database;
+    database.setRange(Region(QRect(1, 1, 2, 8), sheet));
+    database.setFilter(filter);
+
+    const QBitArray results = database.filter().evaluate(database, 2, 8);
+    QCOMPARE(results.count(), 7);
+    const bool expected[] = { true, false, true, false, true, true, false };
+    for (int row = 2; row <= 8; ++row) {
+        QCOMPARE(results.testBit(row - 2), expected[row - 2]);
+        QCOMPARE(results.testBit(row - 2), database.filter().evaluate(database, row));
+    }
+}
+
 QTEST_MAIN(DatabaseFilterTest)
@@ -108,6 +108,38 @@ void TestDependencies::testDepths()
     QCOMPARE(depths[a4], 2);
 }
 
+void TestDependencies::testCellsToCalculate()
+{
+    Cell b1(m_sheet, 2, 1); b1.setUserInput("5");
+    Cell b2(m_sheet, 2, 2); b2.setUserInput("=B1");
+    Cell b3(m_sheet, 2, 3); b3.setUserInput("=B2*2");
+    Cell b4(m_sheet, 2, 4); b4.setUserInput("=SUM(B1:B3)");
+    Cell c1(m_sheet, 3, 1); c1.setUserInput("=B3+B4");
+    Cell c2(m_sheet, 3, 2); c2.setUserInput("=7");
+
+    QApplication::processEvents(); // handle Damages
+
+    DependencyManager* manager = m_map->dependencyManager();
+
+    // all consumers of B1, ordered by depth, each one once
+    QMap<int, Cell> cells = manager->cellsToCalculate(Region(QPoint(2, 1), m_sheet));
+    QCOMPARE(cells.count(), 4);
+    QCOMPARE(cells.values(1), QList<Cell>() << b2);
+    QCOMPARE(cells.values(2), QList<Cell>() << b3);
+    QCOMPARE(cells.values(3), QList<Cell>() << b4);
+    QCOMPARE(cells.values(4), QList<Cell>() << c1);
+
+    // the formulas in the region itself are included
+    cells = manager->cellsToCalculate(Region(QRect(3, 1, 1, 2), m_sheet));
+    QCOMPARE(cells.count(), 2);
+    QVERIFY(cells.values().contains(c1));
+    QVERIFY(cells.values().contains(c2));
+
+    // a region without formulas and consumers
+    cells = manager->cellsToCalculate(Region(QRect(10, 10, 5, 5), m_sheet));
+    QVERIFY(cells.isEmpty());
+}
+
 void TestDependencies::cleanupTestCase()
 {
     delete m_map;
@@ -39,6 +39,7 @@ private Q_SLOTS:
     void testCircleRemoval();
     void testCircles();
     void testDepths();
+    void testCellsToCalculate();
     void cleanupTestCase();
 
 private:
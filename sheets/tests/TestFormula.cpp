@@ -20,6 +20,13 @@
 
 #include "TestKspreadCommon.h"
 
+#include "CellStorage.h"
+#include "Function.h"
+#include "FunctionRepository.h"
+#include "Map.h"
+#include "Sheet.h"
+#include "ValueCalc.h"
+
 using namespace Calligra::Sheets;
 
 static char encodeTokenType(const Token& token)
@@ -369,4 +376,73 @@ void TestFormula::testInlineArrays()
 #endif
 }
 
+void TestFormula::testSheetFormula()
+{
+    // formulas owned by a sheet get their constants folded and
+    // their sheet-local references parsed on compilation
+    Map map(0 /* no Doc */);
+    Sheet* sheet = map.addNewSheet();
+    sheet->setSheetName("Sheet1");
+    sheet->cellStorage()->setValue(1, 1, Value(3));
+    sheet->cellStorage()->setValue(1, 2, Value(4));
+
+    Formula formula(sheet, Cell(sheet, 2, 1));
+    formula.setExpression("=2*3+A1");
+    QCOMPARE(formula.eval(), Value(9.0));
+    formula.setExpression("=-(2+3)*A2");
+    QCOMPARE(formula.eval(), Value(-20.0));
+    formula.setExpression("=SUM(A1:A2;2^3)-ABS(-1)");
+    QCOMPARE(formula.eval(), Value(14.0));
+    formula.setExpression("=Sheet1!A1+PI()*0");
+    QCOMPARE(formula.eval(), Value(3.0));
+    formula.setExpression("=1/0");
+    QCOMPARE(formula.eval(), Value::errorDIV0());
+    formula.setExpression("=NOSUCHFUNCTION(A1)");
+    QCOMPARE(formula.eval(), Value::errorNAME());
+
+    // the evaluation does not change the result of repeated calls
+    formula.setExpression("=IF(A1<A2;A2-A1;0)");
+    QCOMPARE(formula.eval(), Value(1.0));
+    QCOMPARE(formula.eval(), Value(1.0));
+}
+
+// Sums up its second argument, which is passed as a cell range.
+static Value func_cellRangeTest(valVector args, ValueCalc *calc, FuncExtra *e)
+{
+    if (args[0].type() == Value::CellRange)
+        return Value::errorVALUE();
+    if (args[1].type() != Value::CellRange)
+        return Value("values");
+    return calc->sum(argumentValue(args, e, 1), false);
+}
+
+void TestFormula::testCellRangeArguments()
+{
+    Function* function = new Function("CELLRANGETEST", func_cellRangeTest);
+    function->setParamCount(2);
+    function->setAcceptArray();
+    function->setNeedsExtra(true);
+    function->setAcceptCellRange(1);
+    FunctionRepository::self()->add(QSharedPointer<Function>(function));
+
+    Map map(0 /* no Doc */);
+    Sheet* sheet = map.addNewSheet();
+    sheet->setSheetName("Sheet1");
+    sheet->cellStorage()->setValue(1, 1, Value(3));
+    sheet->cellStorage()->setValue(1, 2, Value(4));
+
+    Formula formula(sheet, Cell(sheet, 2, 1));
+    formula.setExpression("=CELLRANGETEST(A1:A2;A1:A2)");
+    QCOMPARE(formula.eval(), Value(7.0));
+    formula.setExpression("=CELLRANGETEST(2*3;Sheet1!A1:A2)");
+    QCOMPARE(formula.eval(), Value(7.0));
+    formula.setExpression("=SUM(1;CELLRANGETEST(SUM(A1:A2);A1:A2);A1:A2)");
+    QCOMPARE(formula.eval(), Value(15.0));
+    // the values of ranges used otherwise get fetched
+    formula.setExpression("=CELLRANGETEST(A1:A2;-A1:A2)");
+    QCOMPARE(formula.eval(), Value("values"));
+    formula.setExpression("=CELLRANGETEST(A1:A2;CELLRANGETEST(A1;A1:A2))");
+    QCOMPARE(formula.eval(), Value("values"));
+}
+
 QTEST_MAIN(TestFormula)
@@ -45,6 +45,8 @@ private Q_SLOTS:
     void testString();
     void testFunction();
     void testInlineArrays();
+    void testSheetFormula();
+    void testCellRangeArguments();
 
 private:
     Value evaluate(const QString&, Value&);
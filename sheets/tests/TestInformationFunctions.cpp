@@ -108,6 +108,12 @@ void TestInformationFunctions::initTestCase()
 //     storage->setValue(3, 6, Value( 7 ) );
     storage->setValue(3, 7, Value("2005-01-31"));
 
+     // AA1:AB40
+     for (int row = 1; row <= 40; ++row) {
+         storage->setValue(27, row, Value(row * 10));
+         storage->setValue(28, row, Value(QString("row %1").arg(row)));
+     }
+
      // C11:C17
      storage->setValue(3,11, Value( 5 ) );
      storage->setValue(3,12, Value( 6 ) );
@@ -328,6 +334,28 @@ void TestInformationFunctions::testFORMULA()
     CHECK_EVAL( "LEN(FORMULA(B1))>0", Value( true ) ); // B7 is a formula, so this is fine and will produce a text value
 }
 
+void TestInformationFunctions::testHLOOKUP()
+{
+    CellStorage* storage = m_map->sheet(0)->cellStorage();
+    // A2000:AN2001, long enough to get indexed
+    for (int col = 1; col <= 40; ++col) {
+        storage->setValue(col, 2000, Value(QString("k%1").arg(col, 2, 10, QChar('0'))));
+        storage->setValue(col, 2001, Value(col));
+    }
+
+    CHECK_EVAL("HLOOKUP(\"k10\";A2000:AN2001;2;0)", Value(10));
+    CHECK_EVAL("HLOOKUP(\"K10\";A2000:AN2001;2;0)", Value::errorNA()); // case sensitive
+    CHECK_EVAL("HLOOKUP(\"k10x\";A2000:AN2001;2;0)", Value::errorNA());
+    CHECK_EVAL("HLOOKUP(\"k10x\";A2000:AN2001;2)", Value(10));
+    CHECK_EVAL("HLOOKUP(\"zzz\";A2000:AN2001;2)", Value(40));
+    CHECK_EVAL("HLOOKUP(\"a\";A2000:AN2001;2)", Value::errorNA());
+    CHECK_EVAL("HLOOKUP(\"k10\";A2000:AN2001;3;0)", Value::errorVALUE());
+
+    // too short to get indexed
+    CHECK_EVAL("HLOOKUP(\"k02\";A2000:C2001;2;0)", Value(2));
+    CHECK_EVAL("HLOOKUP(\"k02x\";A2000:C2001;2)", Value(2));
+}
+
 void TestInformationFunctions::testINFO()
 {
     CHECK_EVAL("INFO(\"recalc\")",             Value("Automatic"));     //
@@ -584,6 +612,8 @@ void TestInformationFunctions::testMATCH()
     CHECK_EVAL("MATCH(\"Hello\";B3:B10;0)", Value(5));
     CHECK_EVAL("MATCH(\"hello\";B3:B10;0)", Value(5)); // match is always case insensitive
     CHECK_EVAL("MATCH(\"kde\";A1000:G1000;0)", Value(5));
+    CHECK_EVAL("MATCH(\"ROW 20\";AB1:AB40;0)", Value(20)); // indexed
+    CHECK_EVAL("MATCH(400;AA1:AA40;0)", Value(40));
 
     // matchType == 1 or omitted, largest value less than or equal to search value in sorted range
     CHECK_EVAL("MATCH(0;A19:A31;1)", Value::errorNA());
@@ -611,6 +641,33 @@ void TestInformationFunctions::testMATCH()
     CHECK_EVAL("MATCH(13;C11:D13;-1)", Value::errorNA()); // not sure if this is the best error
 }
 
+void TestInformationFunctions::testVLOOKUP()
+{
+    // AA1:AB40 is long enough to get indexed
+    CHECK_EVAL("VLOOKUP(200;AA1:AB40;2;0)", Value("row 20"));
+    CHECK_EVAL("VLOOKUP(200;AA1:AB40;2;FALSE())", Value("row 20"));
+    CHECK_EVAL("VLOOKUP(205;AA1:AB40;2;0)", Value::errorNA());
+    CHECK_EVAL("VLOOKUP(\"200\";AA1:AB40;2;0)", Value::errorNA());
+    CHECK_EVAL("VLOOKUP(205;AA1:AB40;2)", Value("row 20"));
+    CHECK_EVAL("VLOOKUP(1000;AA1:AB40;2)", Value("row 40"));
+    CHECK_EVAL("VLOOKUP(5;AA1:AB40;2)", Value::errorNA());
+    CHECK_EVAL("VLOOKUP(200;AA1:AB40;3)", Value::errorVALUE());
+
+    // a changed value drops the index
+    CellStorage* storage = m_map->sheet(0)->cellStorage();
+    storage->setValue(27, 20, Value(201));
+    CHECK_EVAL("VLOOKUP(200;AA1:AB40;2;0)", Value::errorNA());
+    CHECK_EVAL("VLOOKUP(201;AA1:AB40;2;0)", Value("row 20"));
+    CHECK_EVAL("VLOOKUP(200;AA1:AB40;2)", Value("row 19"));
+    storage->setValue(27, 20, Value(200));
+    CHECK_EVAL("VLOOKUP(200;AA1:AB40;2;0)", Value("row 20"));
+
+    // too short to get indexed
+    CHECK_EVAL("VLOOKUP(20;AA1:AB3;2;0)", Value("row 2"));
+    CHECK_EVAL("VLOOKUP(25;AA1:AB3;2)", Value("row 2"));
+    CHECK_EVAL("VLOOKUP(5;AA1:AB3;2)", Value::errorNA());
+}
+
 //
 // cleanup test
 //
@@ -51,6 +51,7 @@ private Q_SLOTS:
     void testCOUNTIF();
     void testERRORTYPE();
     void testFORMULA();
+    void testHLOOKUP();
     void testINFO();
     void testISBLANK();
     void testISERR();
@@ -73,6 +74,7 @@ private Q_SLOTS:
     void testSHEETS();
     void testTYPE();
     void testVALUE();
+    void testVLOOKUP();
 
     void cleanupTestCase();
 
@@ -934,6 +934,36 @@ void TestMathFunctions::testSUMIF_REGULAREXPRESSIONS()
     CHECK_EVAL("=SUMIF(B1:B32767;\".+\";B1:B32767)", Value(5));
 }
 
+void TestMathFunctions::testSUMIF_CHANGES()
+{
+    m_map->calculationSettings()->setUseWildcards(false);
+    m_map->calculationSettings()->setUseRegularExpressions(false);
+    CellStorage* storage2 = m_map->sheet(1)->cellStorage();
+
+    // large ranges get grouped by their values
+    CHECK_EVAL("=SUMIF(Sheet2!A1:A32767;\"test\";Sheet2!B1:B32767)", Value(7));
+    CHECK_EVAL("=SUMIF(Sheet2!B1:B32767;\">10\")", Value(36));
+    CHECK_EVAL("=COUNTIF(Sheet2!A1:A32767;\"test\")", Value(2));
+    CHECK_EVAL("=SUMIFS(Sheet2!B1:B32767;Sheet2!A1:A32767;\"test1\";Sheet2!B1:B32767;\">5\")", Value(7));
+    CHECK_EVAL("=COUNTIFS(Sheet2!A1:A32767;\"test1\";Sheet2!B1:B32767;\"<5\")", Value(1));
+
+    // changed criteria and sum ranges are grouped again
+    storage2->setValue(1, 14, Value("test"));
+    storage2->setValue(2, 14, Value(14));
+    CHECK_EVAL("=SUMIF(Sheet2!A1:A32767;\"test\";Sheet2!B1:B32767)", Value(21));
+    CHECK_EVAL("=COUNTIF(Sheet2!A1:A32767;\"test\")", Value(3));
+    storage2->setValue(2, 6, Value(16));
+    CHECK_EVAL("=SUMIF(Sheet2!A1:A32767;\"test\";Sheet2!B1:B32767)", Value(31));
+    CHECK_EVAL("=SUMIF(Sheet2!B1:B32767;\">10\")", Value(66));
+    CHECK_EVAL("=SUMIFS(Sheet2!B1:B32767;Sheet2!A1:A32767;\"test\";Sheet2!B1:B32767;\">10\")", Value(30));
+
+    storage2->setValue(2, 6, Value(6));
+    storage2->setValue(1, 14, Value());
+    storage2->setValue(2, 14, Value());
+    CHECK_EVAL("=SUMIF(Sheet2!A1:A32767;\"test\";Sheet2!B1:B32767)", Value(7));
+    CHECK_EVAL("=COUNTIF(Sheet2!A1:A32767;\"test\")", Value(2));
+}
+
 void TestMathFunctions::testSUMSQ()
 {
     CHECK_EVAL("SUMSQ(1;2;3)",      Value(14));     // Simple sum.
@@ -108,6 +108,7 @@ private Q_SLOTS:
     void testSUMIF_STRING();
     void testSUMIF_WILDCARDS();
     void testSUMIF_REGULAREXPRESSIONS();
+    void testSUMIF_CHANGES();
     void testSUMSQ();
     void testTRUNC();
 
@@ -0,0 +1,230 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+
+#include "TestPixmapCachingSheetView.h"
+
+#include <QTest>
+
+#include <KoViewConverter.h>
+
+#include "Map.h"
+#include "Region.h"
+#include "RowColumnFormat.h"
+#include "RowFormatStorage.h"
+#include "Sheet.h"
+#include "ui/PixmapCachingSheetView.h"
+
+using namespace Calligra::Sheets;
+
+// The tiles are 256 pixels wide and high.
+static int tileColumn(const Sheet* sheet, int column, qreal scale = 1.0)
+{
+    return int(sheet->columnPosition(column) * scale / 256);
+}
+
+static int tileRow(const Sheet* sheet, int row, qreal scale = 1.0)
+{
+    return int(sheet->rowPosition(row) * scale / 256);
+}
+
+void PixmapCachingSheetViewTest::testPaintTile()
+{
+    Map map;
+    Sheet* sheet = map.addNewSheet();
+    KoViewConverter converter;
+    PixmapCachingSheetView view(sheet);
+    view.setViewConverter(&converter);
+    const QPointF scale(1.0, 1.0);
+
+    QCOMPARE(view.tileState(scale, 0, 0), PixmapCachingSheetView::NoTile);
+    view.paintTile(scale, 0, 0);
+    QCOMPARE(view.tileState(scale, 0, 0), PixmapCachingSheetView::CleanTile);
+    QCOMPARE(view.tileState(scale, 1, 0), PixmapCachingSheetView::NoTile);
+    QCOMPARE(view.tileState(QPointF(2.0, 2.0), 0, 0), PixmapCachingSheetView::NoTile);
+}
+
+void PixmapCachingSheetViewTest::testInvalidateCell()
+{
+    Map map;
+    Sheet* sheet = map.addNewSheet();
+    KoViewConverter converter;
+    PixmapCachingSheetView view(sheet);
+    view.setViewConverter(&converter);
+    const QPointF scale(1.0, 1.0);
+
+    const int farRow = tileRow(sheet, 1000);
+    const int farColumn = tileColumn(sheet, 100);
+    QVERIFY(farRow > 0);
+    QVERIFY(farColumn > 0);
+    view.paintTile(scale, 0, 0);
+    view.paintTile(scale, farColumn, 0);
+    view.paintTile(scale, 0, farRow);
+
+    view.invalidateRegion(Region(QPoint(1, 1)));
+    QCOMPARE(view.tileState(scale, 0, 0), PixmapCachingSheetView::DirtyTile);
+    // the text may overflow into the cells to the right
+    QCOMPARE(view.tileState(scale, farColumn, 0), PixmapCachingSheetView::DirtyTile);
+    QCOMPARE(view.tileState(scale, 0, farRow), PixmapCachingSheetView::CleanTile);
+
+    view.paintTile(scale, 0, 0);
+    QCOMPARE(view.tileState(scale, 0, 0), PixmapCachingSheetView::CleanTile);
+    QCOMPARE(view.tileState(scale, farColumn, 0), PixmapCachingSheetView::DirtyTile);
+}
+
+void PixmapCachingSheetViewTest::testInvalidateUncachedCell()
+{
+    Map map;
+    Sheet* sheet = map.addNewSheet();
+    KoViewConverter converter;
+    PixmapCachingSheetView view(sheet);
+    view.setViewConverter(&converter);
+    const QPointF scale(1.0, 1.0);
+
+    // The tile is painted, but its cells are not in the paint range of the
+    // view and thus are not cached by the SheetView.
+    const int farRow = tileRow(sheet, 1000);
+    view.paintTile(scale, 0, farRow);
+    view.setPaintCellRange(QRect(1, 1, 10, 10));
+
+    view.invalidateRegion(Region(QPoint(1, 1000)));
+    QCOMPARE(view.tileState(scale, 0, farRow), PixmapCachingSheetView::DirtyTile);
+}
+
+void PixmapCachingSheetViewTest::testInvalidateOtherZoomLevels()
+{
+    Map map;
+    Sheet* sheet = map.addNewSheet();
+    KoViewConverter converter;
+    PixmapCachingSheetView view(sheet);
+    view.setViewConverter(&converter);
+    const QPointF scale(1.0, 1.0);
+    const QPointF zoomed(2.0, 2.0);
+
+    view.paintTile(scale, 0, 0);
+    view.paintTile(zoomed, 0, 0);
+    const int farRow = tileRow(sheet, 1000, 2.0);
+    view.paintTile(zoomed, 0, farRow);
+
+    view.invalidateRegion(Region(QPoint(1, 1)));
+    QCOMPARE(view.tileState(scale, 0, 0), PixmapCachingSheetView::DirtyTile);
+    QCOMPARE(view.tileState(zoomed, 0, 0), PixmapCachingSheetView::DirtyTile);
+    QCOMPARE(view.tileState(zoomed, 0, farRow), PixmapCachingSheetView::CleanTile);
+}
+
+void PixmapCachingSheetViewTest::testInvalidateAll()
+{
+    Map map;
+    Sheet* sheet = map.addNewSheet();
+    KoViewConverter converter;
+    PixmapCachingSheetView view(sheet);
+    view.setViewConverter(&converter);
+    const QPointF scale(1.0, 1.0);
+
+    const int farRow = tileRow(sheet, 1000);
+    view.paintTile(scale, 0, 0);
+    view.paintTile(scale, 0, farRow);
+
+    view.invalidate();
+    QCOMPARE(view.tileState(scale, 0, 0), PixmapCachingSheetView::DirtyTile);
+    QCOMPARE(view.tileState(scale, 0, farRow), PixmapCachingSheetView::DirtyTile);
+}
+
+void PixmapCachingSheetViewTest::testRowHeight()
+{
+    Map map;
+    Sheet* sheet = map.addNewSheet();
+    KoViewConverter converter;
+    PixmapCachingSheetView view(sheet);
+    view.setViewConverter(&converter);
+    const QPointF scale(1.0, 1.0);
+
+    const int farRow = tileRow(sheet, 1000);
+    const int farColumn = tileColumn(sheet, 100);
+    view.paintTile(scale, 0, 0);
+    view.paintTile(scale, farColumn, 0);
+    view.paintTile(scale, 0, farRow);
+
+    // The rows below move down; no cell gets damaged.
+    sheet->rowFormats()->setRowHeight(500, 500, 3 * sheet->rowFormats()->rowHeight(500));
+    QCOMPARE(view.tileState(scale, 0, 0), PixmapCachingSheetView::CleanTile);
+    QCOMPARE(view.tileState(scale, farColumn, 0), PixmapCachingSheetView::CleanTile);
+    QCOMPARE(view.tileState(scale, 0, farRow), PixmapCachingSheetView::DirtyTile);
+
+    // A row within the tiles changes its height.
+    sheet->rowFormats()->setRowHeight(2, 2, 3 * sheet->rowFormats()->rowHeight(2));
+    QCOMPARE(view.tileState(scale, 0, 0), PixmapCachingSheetView::DirtyTile);
+    QCOMPARE(view.tileState(scale, farColumn, 0), PixmapCachingSheetView::DirtyTile);
+}
+
+void PixmapCachingSheetViewTest::testColumnWidth()
+{
+    Map map;
+    Sheet* sheet = map.addNewSheet();
+    KoViewConverter converter;
+    PixmapCachingSheetView view(sheet);
+    view.setViewConverter(&converter);
+    const QPointF scale(1.0, 1.0);
+
+    const int farRow = tileRow(sheet, 1000);
+    const int farColumn = tileColumn(sheet, 100);
+    view.paintTile(scale, 0, 0);
+    view.paintTile(scale, farColumn, 0);
+    view.paintTile(scale, 0, farRow);
+
+    // The columns to the right move; no cell gets damaged.
+    ColumnFormat* format = sheet->nonDefaultColumnFormat(50);
+    format->setWidth(3 * format->width());
+    QCOMPARE(view.tileState(scale, 0, 0), PixmapCachingSheetView::CleanTile);
+    QCOMPARE(view.tileState(scale, 0, farRow), PixmapCachingSheetView::CleanTile);
+    QCOMPARE(view.tileState(scale, farColumn, 0), PixmapCachingSheetView::DirtyTile);
+
+    format = sheet->nonDefaultColumnFormat(1);
+    format->setWidth(3 * format->width());
+    QCOMPARE(view.tileState(scale, 0, 0), PixmapCachingSheetView::DirtyTile);
+    QCOMPARE(view.tileState(scale, 0, farRow), PixmapCachingSheetView::DirtyTile);
+}
+
+void PixmapCachingSheetViewTest::testLeastRecentlyUsed()
+{
+    Map map;
+    Sheet* sheet = map.addNewSheet();
+    KoViewConverter converter;
+    PixmapCachingSheetView view(sheet);
+    view.setViewConverter(&converter);
+    const QPointF scale(1.0, 1.0);
+
+    // The budget holds 256 tiles.
+    for (int y = 0; y < 256; ++y)
+        view.paintTile(scale, 0, y);
+    QCOMPARE(view.tileState(scale, 0, 0), PixmapCachingSheetView::CleanTile);
+    QCOMPARE(view.tileState(scale, 0, 255), PixmapCachingSheetView::CleanTile);
+
+    // Painting the first tile again makes it the most recently used one.
+    view.paintTile(scale, 0, 0);
+    view.paintTile(scale, 0, 256);
+    QCOMPARE(view.tileState(scale, 0, 0), PixmapCachingSheetView::CleanTile);
+    QCOMPARE(view.tileState(scale, 0, 1), PixmapCachingSheetView::NoTile);
+    QCOMPARE(view.tileState(scale, 0, 2), PixmapCachingSheetView::CleanTile);
+    QCOMPARE(view.tileState(scale, 0, 256), PixmapCachingSheetView::CleanTile);
+
+    view.paintTile(scale, 0, 257);
+    QCOMPARE(view.tileState(scale, 0, 0), PixmapCachingSheetView::CleanTile);
+    QCOMPARE(view.tileState(scale, 0, 2), PixmapCachingSheetView::NoTile);
+}
+
+QTEST_MAIN(PixmapCachingSheetViewTest)
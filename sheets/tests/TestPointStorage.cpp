@@ -274,6 +274,25 @@ void PointStorageTest::testInsertColumns()
     QCOMPARE(storage.m_data, data);
     QCOMPARE(storage.m_rows, rows);
     QCOMPARE(storage.m_cols, cols);
+
+
+    // the data left of the inserted columns stays
+    storage.clear();
+    storage.insert(8, 1, 1);
+    storage.insert(9, 1, 2);
+    // (  ,  ,  ,  ,  ,  ,  , 1, 2,  )
+
+    old = storage.insertColumns(9, 4);
+    QVERIFY(old.count() == 1);
+    QVERIFY(old.contains(qMakePair(QPoint(9, 1), 2)));
+    // (  ,  ,  ,  ,  ,  ,  , 1,  ,  )
+
+    data = QVector<int>() << 1;
+    rows = QVector<int>() << 0;
+    cols = QVector<int>() << 8;
+    QCOMPARE(storage.m_data, data);
+    QCOMPARE(storage.m_rows, rows);
+    QCOMPARE(storage.m_cols, cols);
 }
 
 void PointStorageTest::testDeleteColumns()
@@ -0,0 +1,165 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "TestRangeIndex.h"
+
+#include <QTest>
+
+#include <algorithm>
+
+#include "RangeIndex.h"
+
+using namespace Calligra::Sheets;
+
+static QList<int> sorted(QList<int> list)
+{
+    std::sort(list.begin(), list.end());
+    return list;
+}
+
+void TestRangeIndex::testContainsPoint()
+{
+    RangeIndex<int> index;
+    index.insert(QRect(1, 1, 1, 1), 1);
+    index.insert(QRect(1, 1, 3, 3), 2);
+    index.insert(QRect(2, 2, 100, 1000), 3);
+    index.insert(QRect(5, 5, 1, 1), 4);
+    QCOMPARE(index.count(), 4);
+
+    QCOMPARE(sorted(index.contains(QPoint(1, 1))), QList<int>() << 1 << 2);
+    QCOMPARE(sorted(index.contains(QPoint(3, 3))), QList<int>() << 2 << 3);
+    QCOMPARE(sorted(index.contains(QPoint(5, 5))), QList<int>() << 3 << 4);
+    QCOMPARE(sorted(index.contains(QPoint(101, 1001))), QList<int>() << 3);
+    QCOMPARE(index.contains(QPoint(102, 2)), QList<int>());
+    QCOMPARE(index.contains(QPoint(4, 1)), QList<int>());
+}
+
+void TestRangeIndex::testContainsRect()
+{
+    RangeIndex<int> index;
+    index.insert(QRect(1, 1, 10, 10), 1);
+    index.insert(QRect(2, 2, 2, 2), 2);
+    index.insert(QRect(5, 5, 10, 10), 3);
+
+    QCOMPARE(sorted(index.contains(QRect(2, 2, 2, 2))), QList<int>() << 1 << 2);
+    QCOMPARE(sorted(index.contains(QRect(5, 5, 6, 6))), QList<int>() << 1 << 3);
+    QCOMPARE(index.contains(QRect(1, 1, 11, 1)), QList<int>());
+}
+
+void TestRangeIndex::testIntersects()
+{
+    RangeIndex<int> index;
+    index.insert(QRect(1, 1, 1, 1), 1);
+    index.insert(QRect(3, 1, 2, 5), 2);
+    index.insert(QRect(1, 10, KS_colMax, 1), 3);
+
+    // cell ranges touching each other do not intersect
+    QCOMPARE(index.intersects(QRect(2, 1, 1, 1)), QList<int>());
+    QCOMPARE(sorted(index.intersects(QRect(1, 1, 3, 1))), QList<int>() << 1 << 2);
+    QCOMPARE(sorted(index.intersects(QRect(1, 1, KS_colMax, KS_rowMax))), QList<int>() << 1 << 2 << 3);
+    QCOMPARE(sorted(index.intersects(QRect(1000, 5, 1, 10))), QList<int>() << 3);
+}
+
+void TestRangeIndex::testIntersectingPairs()
+{
+    RangeIndex<int> index;
+    index.insert(QRect(2, 2, 3, 3), 42);
+    const QList< QPair<QRect, int> > pairs = index.intersectingPairs(QRect(1, 1, 10, 10)).values();
+    QCOMPARE(pairs.count(), 1);
+    QCOMPARE(pairs[0].first, QRect(2, 2, 3, 3));
+    QCOMPARE(pairs[0].second, 42);
+}
+
+void TestRangeIndex::testRemove()
+{
+    RangeIndex<int> index;
+    index.insert(QRect(1, 1, 5, 5), 1);
+    index.insert(QRect(1, 1, 5, 5), 1);
+    index.insert(QRect(1, 1, 5, 5), 2);
+    // stored in several buckets
+    index.insert(QRect(3, 3, 3, 3), 3);
+    QCOMPARE(index.count(), 4);
+
+    index.remove(QRect(1, 1, 5, 5), 1);
+    QCOMPARE(index.count(), 3);
+    QCOMPARE(sorted(index.contains(QPoint(1, 1))), QList<int>() << 1 << 2);
+
+    index.remove(QRect(3, 3, 3, 3), 3);
+    QCOMPARE(index.count(), 2);
+    QCOMPARE(sorted(index.intersects(QRect(1, 1, 10, 10))), QList<int>() << 1 << 2);
+
+    // not existing
+    index.remove(QRect(1, 1, 5, 5), 3);
+    index.remove(QRect(1, 1, 4, 4), 2);
+    QCOMPARE(index.count(), 2);
+
+    index.remove(QRect(1, 1, 5, 5), 1);
+    index.remove(QRect(1, 1, 5, 5), 2);
+    QCOMPARE(index.count(), 0);
+    QCOMPARE(index.contains(QPoint(1, 1)), QList<int>());
+}
+
+void TestRangeIndex::testWholeColumns()
+{
+    // like SUM(A:A), SUM(B:B), ... in many cells
+    RangeIndex<int> index;
+    for (int i = 0; i < 1000; ++i)
+        index.insert(QRect(1 + i % 10, 1, 1, KS_rowMax), i);
+
+    QCOMPARE(index.contains(QPoint(1, 5000)).count(), 100);
+    QCOMPARE(index.contains(QPoint(10, KS_rowMax)).count(), 100);
+    QCOMPARE(index.contains(QPoint(11, 1)).count(), 0);
+    QCOMPARE(index.intersects(QRect(2, 100, 2, 1)).count(), 200);
+}
+
+void TestRangeIndex::testCompareWithBruteForce()
+{
+    QList< QPair<QRect, int> > ranges;
+    RangeIndex<int> index;
+    qsrand(1);
+    for (int i = 0; i < 2000; ++i) {
+        const int col = 1 + qrand() % 200;
+        const int row = 1 + qrand() % 2000;
+        const int width = 1 + ((i % 7 == 0) ? qrand() % 100 : qrand() % 4);
+        const int height = 1 + ((i % 5 == 0) ? qrand() % 5000 : qrand() % 10);
+        const QRect rect(col, row, width, height);
+        ranges.append(qMakePair(rect, i));
+        index.insert(rect, i);
+    }
+
+    for (int i = 0; i < 500; ++i) {
+        const QPoint point(1 + qrand() % 300, 1 + qrand() % 7000);
+        QList<int> expected;
+        for (int j = 0; j < ranges.count(); ++j) {
+            if (ranges[j].first.contains(point))
+                expected.append(ranges[j].second);
+        }
+        QCOMPARE(sorted(index.contains(point)), expected);
+
+        const QRect rect(point, QSize(1 + qrand() % 50, 1 + qrand() % 500));
+        expected.clear();
+        for (int j = 0; j < ranges.count(); ++j) {
+            if (ranges[j].first.intersects(rect))
+                expected.append(ranges[j].second);
+        }
+        QCOMPARE(sorted(index.intersects(rect)), expected);
+    }
+}
+
+QTEST_MAIN(TestRangeIndex)
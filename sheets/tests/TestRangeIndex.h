@@ -0,0 +1,47 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CALLIGRA_SHEETS_TEST_RANGE_INDEX
+#define CALLIGRA_SHEETS_TEST_RANGE_INDEX
+
+#include <QObject>
+
+namespace Calligra
+{
+namespace Sheets
+{
+
+class TestRangeIndex : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testContainsPoint();
+    void testContainsRect();
+    void testIntersects();
+    void testIntersectingPairs();
+    void testRemove();
+    void testWholeColumns();
+    void testCompareWithBruteForce();
+};
+
+} // namespace Sheets
+} // namespace Calligra
+
+#endif // CALLIGRA_SHEETS_TEST_RANGE_INDEX
@@ -0,0 +1,107 @@
+/* This file is part of the KDE project
+   Copyright 2016 The Calligra Sheets developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "TestRecalcManager.h"
+
+#include <QTest>
+#ifdef CALLIGRA_SHEETS_MT
+#include <QThreadPool>
+#endif
+
+#include "CellStorage.h"
+#include "DependencyManager.h"
+#include "Map.h"
+#include "RecalcManager.h"
+#include "Sheet.h"
+#include "Value.h"
+
+using namespace Calligra::Sheets;
+
+// More rows than cells needed for a reference depth to get evaluated in parallel.
+static const int s_rows = 300;
+
+void TestRecalcManager::fill(Map* map)
+{
+    Sheet* sheet = map->addNewSheet();
+    map->setLoading(true);
+    for (int row = 1; row <= s_rows; ++row) {
+        const int mirrored = s_rows + 1 - row;
+        Cell(sheet, 1, row).setValue(Value(row));
+        // depth 1
+        Cell(sheet, 2, row).setUserInput(QString("=A%1*2+1").arg(row));
+        // depth 2
+        Cell(sheet, 3, row).setUserInput(QString("=B%1*B%1-A%1").arg(row));
+        // depth 3, referring to other rows of the previous depths
+        Cell(sheet, 4, row).setUserInput(QString("=C%1+B%2").arg(row).arg(mirrored));
+        // depth 4
+        Cell(sheet, 5, row).setUserInput(QString("=D%1/B%1+C%2").arg(row).arg(mirrored));
+        // depth 5
+        Cell(sheet, 6, row).setUserInput(QString("=E%1-E%2").arg(row).arg(mirrored));
+    }
+    map->setLoading(false);
+}
+
+void TestRecalcManager::recalc(Map* map, int threadCount)
+{
+#ifdef CALLIGRA_SHEETS_MT
+    map->recalcManager()->threadPool()->setMaxThreadCount(threadCount);
+#else
+    Q_UNUSED(threadCount);
+#endif
+    map->dependencyManager()->updateAllDependencies(map);
+    map->recalcManager()->recalcMap();
+}
+
+void TestRecalcManager::testDependencyChain()
+{
+    // evaluated level by level in this thread
+    Map sequential(0 /* no Doc */);
+    fill(&sequential);
+    recalc(&sequential, 1);
+
+    // evaluated level by level in the thread pool, if built with CALLIGRA_SHEETS_MT
+    Map parallel(0 /* no Doc */);
+    fill(&parallel);
+    recalc(&parallel, 4);
+
+    const CellStorage* expected = sequential.sheet(0)->cellStorage();
+    const CellStorage* actual = parallel.sheet(0)->cellStorage();
+    for (int row = 1; row <= s_rows; ++row) {
+        for (int col = 2; col <= 6; ++col) {
+            QVERIFY(!actual->value(col, row).isError());
+            QCOMPARE(actual->value(col, row), expected->value(col, row));
+        }
+    }
+
+    // the chain got calculated in the order of the depths
+    for (int row = 1; row <= s_rows; ++row) {
+        const int mirrored = s_rows + 1 - row;
+        const double b = 2.0 * row + 1;
+        const double c = b * b - row;
+        const double bMirrored = 2.0 * mirrored + 1;
+        const double cMirrored = bMirrored * bMirrored - mirrored;
+        const double d = c + bMirrored;
+        QCOMPARE(double(actual->value(2, row).asFloat()), b);
+        QCOMPARE(double(actual->value(3, row).asFloat()), c);
+        QCOMPARE(double(actual->value(4, row).asFloat()), d);
+        QCOMPARE(double(actual->value(5, row).asFloat()), d / b + cMirrored);
+    }
+}
+
+QTEST_MAIN(TestRecalcManager)
@@ -30,8 +30,13 @@
 #include <part/Doc.h> // FIXME detach from part
 #include <Map.h>
 #include <Sheet.h>
+#include <Style.h>
 #include <CellStorage.h>
+#include <odf/OdfSavingContext.h>
+#include <odf/RowHashes.h>
+#include <odf/SheetContents.h>
 
+#include <QBuffer>
 #include <QPainter>
 #include <QTest>
 
@@ -173,6 +178,75 @@ void SheetTest::testDocumentToCellCoordinates()
     QCOMPARE(m_sheet->documentToCellCoordinates(area), result);
 }
 
+void SheetTest::testRowHashes()
+{
+    for (int row = 1; row <= 3; ++row) {
+        Cell(m_sheet, 1, row).setValue(Value(42.0));
+        Cell(m_sheet, 2, row).setUserInput("=A1*2");
+    }
+    // same value, other column
+    Cell(m_sheet, 2, 4).setValue(Value(42.0));
+    Cell(m_sheet, 3, 4).setUserInput("=A1*2");
+    // same value, other formula
+    Cell(m_sheet, 1, 5).setValue(Value(42.0));
+    Cell(m_sheet, 2, 5).setUserInput("=A1*3");
+
+    Odf::RowHashes hashes(QList<Sheet*>() << m_sheet);
+    hashes.wait(m_sheet);
+    QVERIFY(hashes.mayBeEqual(m_sheet, 1, 2));
+    QVERIFY(hashes.mayBeEqual(m_sheet, 1, 3));
+    QVERIFY(!hashes.mayBeEqual(m_sheet, 1, 4));
+    QVERIFY(!hashes.mayBeEqual(m_sheet, 1, 5));
+    QVERIFY(!hashes.mayBeEqual(m_sheet, 1, 6));
+    // empty rows
+    QVERIFY(hashes.mayBeEqual(m_sheet, 6, 7));
+}
+
+void SheetTest::testSheetContents()
+{
+    m_doc->map()->addNewSheet();
+    Sheet* const sheet2 = m_doc->map()->sheet(1);
+    Style bold;
+    bold.setFontBold(true);
+    Style italic;
+    italic.setFontItalic(true);
+    Cell(m_sheet, 1, 1).setValue(Value(1.0));
+    Cell(m_sheet, 1, 1).setStyle(bold);
+    Cell(sheet2, 1, 1).setValue(Value(2.0));
+    Cell(sheet2, 1, 1).setStyle(italic);
+    Cell(sheet2, 2, 1).setValue(Value(3.0));
+    Cell(sheet2, 2, 1).setStyle(bold);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    KoXmlWriter xmlWriter(&buffer);
+    KoGenStyles mainStyles;
+    KoEmbeddedDocumentSaver embeddedSaver;
+    KoShapeSavingContext shapeContext(xmlWriter, mainStyles, embeddedSaver);
+    Odf::OdfSavingContext tableContext(shapeContext);
+    xmlWriter.startElement("office:spreadsheet");
+    {
+        Odf::SheetContents contents(m_doc->map()->sheetList(), shapeContext);
+        QVERIFY(contents.remainingSheets().isEmpty());
+        QVERIFY(contents.write(m_sheet, tableContext));
+        QVERIFY(contents.write(sheet2, tableContext));
+        QVERIFY(!contents.write(sheet2, tableContext));
+    }
+    xmlWriter.endElement();
+
+    // the styles are named as if the sheets had been saved one after another,
+    // i.e. the bold cell of the second sheet refers to the style of the first one
+    QCOMPARE(mainStyles.styles(KoGenStyle::TableCellAutoStyle).count(), 2);
+    const QString xml = QString::fromUtf8(buffer.data());
+    const int secondTable = xml.indexOf("<table:table ", xml.indexOf("<table:table ") + 1);
+    QVERIFY(secondTable != -1);
+    QCOMPARE(xml.count("table:style-name=\"ce1\""), 2);
+    QCOMPARE(xml.count("table:style-name=\"ce2\""), 1);
+    QVERIFY(xml.indexOf("table:style-name=\"ce1\"") < secondTable);
+    QVERIFY(xml.indexOf("table:style-name=\"ce2\"") > secondTable);
+    QVERIFY(xml.indexOf("table:style-name=\"ce2\"") < xml.lastIndexOf("table:style-name=\"ce1\""));
+}
+
 #if 0
 // test if embedded objects are propare taken into account (tests for bug 287997)
 void SheetTest::testCompareRows()
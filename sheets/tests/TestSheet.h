@@ -44,6 +44,9 @@ private Q_SLOTS:
     void testDocumentToCellCoordinates_data();
     void testDocumentToCellCoordinates();
 
+    void testRowHashes();
+    void testSheetContents();
+
 //    void testCompareRows();
 
 private:
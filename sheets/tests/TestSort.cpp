@@ -138,4 +138,58 @@ void TestSort::DescendingOrder()
     QCOMPARE(storage->value(2,3),Value());
 }
 
+void TestSort::StableOrder()
+{
+    Map map;
+    Sheet* sheet = new Sheet(&map, "Sheet1");
+    map.addSheet(sheet);
+
+    CellStorage* storage = sheet->cellStorage();
+    // Data to sort...
+    // Header, case insensitive keys and the original order
+    // A1 Key    B1 Index
+    // A2 b      B2 1
+    // A3 A      B3 2
+    // A4 B      B4 3
+    // A5 a      B5 4
+    storage->setValue(1,1, Value("Key"));
+    storage->setValue(2,1, Value("Index"));
+    storage->setValue(1,2, Value("b"));
+    storage->setValue(2,2, Value(1));
+    storage->setValue(1,3, Value("A"));
+    storage->setValue(2,3, Value(2));
+    storage->setValue(1,4, Value("B"));
+    storage->setValue(2,4, Value(3));
+    storage->setValue(1,5, Value("a"));
+    storage->setValue(2,5, Value(4));
+
+    // Sort Manipulator
+    SortManipulator *const command = new SortManipulator();
+    command->setRegisterUndo(0);
+    command->setSheet(sheet);
+
+    // Parameters.
+    command->setSortRows(Qt::Vertical);
+    command->setSkipFirst(true);
+    command->setCopyFormat(false);
+
+    command->addCriterion(0, Qt::AscendingOrder, Qt::CaseInsensitive);
+
+    command->add(QRect(1,1,2,5), sheet);
+
+    // Execute sort
+    command->execute();
+
+    // equal keys keep their order
+    QCOMPARE(storage->value(1,1),Value("Key"));
+    QCOMPARE(storage->value(1,2),Value("A"));
+    QCOMPARE(storage->value(2,2),Value(2));
+    QCOMPARE(storage->value(1,3),Value("a"));
+    QCOMPARE(storage->value(2,3),Value(4));
+    QCOMPARE(storage->value(1,4),Value("b"));
+    QCOMPARE(storage->value(2,4),Value(1));
+    QCOMPARE(storage->value(1,5),Value("B"));
+    QCOMPARE(storage->value(2,5),Value(3));
+}
+
 QTEST_MAIN(TestSort)
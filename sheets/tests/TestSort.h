@@ -33,6 +33,7 @@ class TestSort : public QObject
 private Q_SLOTS:
     void AscendingOrder();
     void DescendingOrder();
+    void StableOrder();
 
 };
 
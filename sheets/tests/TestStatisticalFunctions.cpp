@@ -769,6 +769,7 @@ void TestStatisticalFunctions::testMAX()
 //     CHECK_EVAL("ISNA(MAXA(NA())", Value(true)); // nline errors are propagated.
     CHECK_EVAL("MAX(B3:B5)",    Value(3));             // Strings are not converted to numbers and are ignored.
     CHECK_EVAL("MAX(-1;B7)",    Value(-1));            // Strings are not converted to numbers and are ignored.
+    CHECK_EVAL("MAX(B4:B8)",    Value(3));             // Logicals, strings and empty cells in ranges are ignored.
     CHECK_EVAL("MAX(B3:B9)",    Value::errorVALUE());  // TODO check function - Errors inside ranges are NOT ignored.
 }
 
@@ -809,6 +810,7 @@ void TestStatisticalFunctions::testMIN()
     CHECK_EVAL("MIN(B3)",       Value(0));           // If no numbers are provided in all ranges, MIN returns 0
     CHECK_EVAL("MIN(\"a\")",    Value::errorNUM());  // Non-numbers inline are NOT ignored.
     CHECK_EVAL("MIN(B3:B5)",    Value(2));           // Cell text is not converted to numbers and is ignored.
+    CHECK_EVAL("MIN(B4:B8)",    Value(2));           // Logicals, strings and empty cells in ranges are ignored.
 }
 
 void TestStatisticalFunctions::testMINA()
@@ -1099,6 +1101,8 @@ void TestStatisticalFunctions::testSUMPRODUCT()
 {
     CHECK_EVAL("SUMPRODUCT(C19:C23;A19:A23)", Value(106));
     CHECK_EVAL("SUMPRODUCT(C19:C23^2;2*A19:A23)", Value(820));
+    CHECK_EVAL("SUMPRODUCT(A19:A23;A19:A23)", Value(341));
+    CHECK_EVAL("SUMPRODUCT(A19:A23;C19:C22)", Value::errorVALUE()); // different dimensions
 }
 
 void TestStatisticalFunctions::testTDIST()
@@ -20,6 +20,7 @@
 #include "TestStyleStorage.h"
 
 #include <StyleStorage.h>
+#include <StyleManager.h>
 #include <Map.h>
 
 #include <QTest>
@@ -63,4 +64,102 @@ void TestStyleStorage::testGarbageCollection()
     }
 }
 
+void TestStyleStorage::testRowIterator()
+{
+    Map map;
+    StyleStorage storage(&map);
+    const Style defaultStyle = *map.styleManager()->defaultStyle();
+
+    QColor c1(Qt::red);
+    QColor c2(Qt::blue);
+    SharedSubStyle style1(new SubStyleOne<Style::BackgroundColor, QColor>(c1));
+    SharedSubStyle style2(new SubStyleOne<Style::BackgroundColor, QColor>(c2));
+    storage.insert(QRect(3, 2, 4, 3), style1);
+    storage.insert(QRect(5, 3, 4, 1), style2);
+    // cache some of the styles first
+    QCOMPARE(storage.contains(QPoint(4, 3)).backgroundColor(), c1);
+    QCOMPARE(storage.contains(QPoint(7, 3)).backgroundColor(), c2);
+
+    StyleStorage::RowIterator it(&storage, 3, 1, 10);
+    QVERIFY(!it.atEnd());
+    QCOMPARE(it.left(), 1);
+    QCOMPARE(it.right(), 2);
+    QVERIFY(it.style() == defaultStyle);
+    it.next();
+    QVERIFY(!it.atEnd());
+    QCOMPARE(it.left(), 3);
+    QCOMPARE(it.right(), 4);
+    QCOMPARE(it.style().backgroundColor(), c1);
+    it.next();
+    QVERIFY(!it.atEnd());
+    QCOMPARE(it.left(), 5);
+    QCOMPARE(it.right(), 8);
+    QCOMPARE(it.style().backgroundColor(), c2);
+    it.next();
+    QVERIFY(!it.atEnd());
+    QCOMPARE(it.left(), 9);
+    QCOMPARE(it.right(), 10);
+    QVERIFY(it.style() == defaultStyle);
+    it.next();
+    QVERIFY(it.atEnd());
+
+    // the cached spans get updated
+    storage.insert(QRect(4, 3, 1, 1), style2);
+    QCOMPARE(storage.contains(QPoint(3, 3)).backgroundColor(), c1);
+    QCOMPARE(storage.contains(QPoint(4, 3)).backgroundColor(), c2);
+    StyleStorage::RowIterator it2(&storage, 3, 4, 6);
+    QVERIFY(!it2.atEnd());
+    QCOMPARE(it2.left(), 4);
+    QCOMPARE(it2.right(), 6);
+    QCOMPARE(it2.style().backgroundColor(), c2);
+    it2.next();
+    QVERIFY(it2.atEnd());
+}
+
+void TestStyleStorage::testRowIteratorWideRows()
+{
+    Map map;
+    StyleStorage storage(&map);
+
+    // more than twice as wide as the window looked at around a cell
+    const int columns = 1000;
+    QColor c1(Qt::red);
+    QColor c2(Qt::blue);
+    SharedSubStyle style1(new SubStyleOne<Style::BackgroundColor, QColor>(c1));
+    SharedSubStyle style2(new SubStyleOne<Style::BackgroundColor, QColor>(c2));
+    // uniform rows
+    storage.insert(QRect(1, 1, columns, 2), style1);
+    // a mixed row
+    for (int left = 1; left <= columns; left += 100)
+        storage.insert(QRect(left, 3, 100, 1), (left / 100) % 2 ? style2 : style1);
+
+    // the spans looked up in different windows get merged
+    StyleStorage::RowIterator it(&storage, 1, 1, columns);
+    QVERIFY(!it.atEnd());
+    QCOMPARE(it.left(), 1);
+    QCOMPARE(it.right(), columns);
+    QCOMPARE(it.style().backgroundColor(), c1);
+    it.next();
+    QVERIFY(it.atEnd());
+
+    // ... also, if a span in the middle got cached before
+    QCOMPARE(storage.contains(QPoint(600, 2)).backgroundColor(), c1);
+    StyleStorage::RowIterator it2(&storage, 2, 1, columns);
+    QVERIFY(!it2.atEnd());
+    QCOMPARE(it2.left(), 1);
+    QCOMPARE(it2.right(), columns);
+    it2.next();
+    QVERIFY(it2.atEnd());
+
+    StyleStorage::RowIterator it3(&storage, 3, 1, columns);
+    for (int left = 1; left <= columns; left += 100) {
+        QVERIFY(!it3.atEnd());
+        QCOMPARE(it3.left(), left);
+        QCOMPARE(it3.right(), left + 99);
+        QCOMPARE(it3.style().backgroundColor(), (left / 100) % 2 ? c2 : c1);
+        it3.next();
+    }
+    QVERIFY(it3.atEnd());
+}
+
 QTEST_MAIN(TestStyleStorage)
@@ -22,6 +22,7 @@
 #include "TestKspreadCommon.h"
 
 #include "CalculationSettings.h"
+#include "StringPool.h"
 
 
 void TestValue::testEmpty()
@@ -357,4 +358,29 @@ void TestValue::testAssignment()
     delete v2;
 }
 
+void TestValue::testStringPool()
+{
+    StringPool pool;
+    const Value v1 = pool.value(QString("Hello"));
+    const Value v2 = pool.value(QString("Hel") + QString("lo"));
+    QCOMPARE(v1.type(), Value::String);
+    QCOMPARE(v1.asString(), QString("Hello"));
+    QCOMPARE(v2, v1);
+    // equal strings share their characters
+    QCOMPARE(v2.asString().constData(), v1.asString().constData());
+    QCOMPARE(pool.string(QString("Hell") + QString("o")).constData(), v1.asString().constData());
+    QCOMPARE(pool.count(), 1);
+
+    const Value v3 = pool.value(QString("World"));
+    QCOMPARE(v3.asString(), QString("World"));
+    QVERIFY(v3.asString().constData() != v1.asString().constData());
+    QCOMPARE(pool.count(), 2);
+
+    // the values keep their data
+    pool.clear();
+    QCOMPARE(pool.count(), 0);
+    QCOMPARE(v1.asString(), QString("Hello"));
+    QVERIFY(pool.value(QString("Hello")).asString().constData() != v1.asString().constData());
+}
+
 QTEST_MAIN(TestValue)
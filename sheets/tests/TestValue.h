@@ -42,6 +42,7 @@ private Q_SLOTS:
     void testArray();
     void testCopy();
     void testAssignment();
+    void testStringPool();
 };
 
 } // namespace Sheets
@@ -22,11 +22,18 @@
 #include "CellView.h"
 #include "SheetsDebug.h"
 
+#include "../Region.h"
+#include "../RowColumnFormat.h"
+#include "../RowFormatStorage.h"
 #include "../Sheet.h"
 #include "../part/CanvasBase.h"
 
-#include <QCache>
+#include <QHash>
+#include <QLinkedList>
 #include <QPainter>
+#include <QPixmap>
+#include <QTimer>
+#include <QVector>
 
 
 #ifdef CALLIGRA_SHEETS_MT
@@ -38,16 +45,60 @@ using namespace Calligra::Sheets;
 
 #define TILESIZE 256
 
-class PixmapCachingSheetView::Private
+// The memory used by the cached tiles in kilobytes, i.e. 256 tiles.
+static const int s_tileCacheBudget = 64 * 1024;
+// The memory used by a tile in kilobytes.
+static const int s_tileCost = TILESIZE * TILESIZE * 4 / 1024;
+
+namespace
 {
-public:
-    Private(PixmapCachingSheetView* q) : q(q) {}
-    PixmapCachingSheetView* q;
-    QCache<int, QPixmap> tileCache;
-    QPointF lastScale;
+// The tile x, y at a zoom level covers the pixels from x * TILESIZE, y * TILESIZE
+// to (x + 1) * TILESIZE, (y + 1) * TILESIZE at this zoom level.
+struct TileKey {
+    TileKey(const QPointF& scale, int x, int y) : scale(scale), x(x), y(y) {}
+
+    bool operator==(const TileKey& other) const {
+        return x == other.x && y == other.y && scale == other.scale;
+    }
+
+    QPointF scale;
+    int x;
+    int y;
+};
+
+uint qHash(const TileKey& key, uint seed = 0)
+{
+    return ::qHash((quint64(quint32(key.x)) << 32) | quint32(key.y), seed)
+           ^ ::qHash(key.scale.x(), seed) ^ ::qHash(key.scale.y(), seed);
+}
+
+// The positions and sizes of the cells' columns and rows, which change
+// without any damage of the cells.
+QVector<double> cellGeometry(const Sheet* sheet, const QRect& cells)
+{
+    QVector<double> geometry;
+    geometry.reserve(cells.width() + cells.height() + 2);
+    geometry.append(sheet->columnPosition(cells.left()));
+    for (int col = cells.left(); col <= cells.right(); ++col)
+        geometry.append(sheet->columnFormat(col)->visibleWidth());
+    geometry.append(sheet->rowPosition(cells.top()));
+    for (int row = cells.top(); row <= cells.bottom(); ++row)
+        geometry.append(sheet->rowFormats()->visibleHeight(row));
+    return geometry;
+}
 
-    QPixmap* getTile(const Sheet* sheet, int x, int y, CanvasBase* canvas);
+struct Tile {
+    QPixmap pixmap;
+    // the cells painted into the tile
+    QRect cells;
+    // the geometry of the cells, when the tile got painted
+    QVector<double> geometry;
+    // whether the cells changed since the tile got painted
+    bool dirty;
+    // the position of the tile in the usage order
+    QLinkedList<TileKey>::Iterator use;
 };
+}
 
 #ifdef CALLIGRA_SHEETS_MT
 class TileDrawingJob : public ThreadWeaver::Job
@@ -56,81 +107,262 @@ class TileDrawingJob
 #endif
 {
 public:
-    TileDrawingJob(const Sheet* sheet, SheetView* sheetView, CanvasBase* canvas, const QPointF& scale, int x, int y);
+    TileDrawingJob(const Sheet* sheet, SheetView* sheetView, CanvasBase* canvas, const TileKey& key);
     ~TileDrawingJob();
     void run();
 private:
     const Sheet* m_sheet;
     SheetView* m_sheetView;
+    QPointF m_offset;
 public:
     CanvasBase* m_canvas;
-    QPointF m_scale;
-    int m_x;
-    int m_y;
+    TileKey m_key;
+    // the area of the tile in document coordinates
+    QRectF m_docRect;
+    // the cells painted into the tile
+    QRect m_cells;
+    QVector<double> m_geometry;
+    // whether the cells changed while the tile got painted
+    bool m_stale;
     QImage m_image;
 };
 
-TileDrawingJob::TileDrawingJob(const Sheet *sheet, SheetView* sheetView, CanvasBase* canvas, const QPointF& scale, int x, int y)
-    : m_sheet(sheet), m_sheetView(sheetView), m_canvas(canvas), m_scale(scale), m_x(x), m_y(y)
+TileDrawingJob::TileDrawingJob(const Sheet *sheet, SheetView* sheetView, CanvasBase* canvas, const TileKey& key)
+    : m_sheet(sheet), m_sheetView(sheetView), m_canvas(canvas), m_key(key), m_stale(false)
     , m_image(TILESIZE, TILESIZE, QImage::Format_ARGB32)
 {
-    debugSheets << "new job for " << x << "," << y << " " << m_scale;
+    debugSheets << "new job for " << key.x << "," << key.y << " " << key.scale;
+
+    // the cells get looked up here, so that changes of them can be tracked
+    // while the tile gets painted
+    const QRect globalPixelRect(QPoint(key.x * TILESIZE, key.y * TILESIZE), QSize(TILESIZE, TILESIZE));
+    m_docRect = QRectF(
+            globalPixelRect.x() / key.scale.x(),
+            globalPixelRect.y() / key.scale.y(),
+            globalPixelRect.width() / key.scale.x(),
+            globalPixelRect.height() / key.scale.y()
+    );
+
+    qreal loffset, toffset;
+    const int left = m_sheet->leftColumn(m_docRect.left(), loffset);
+    const int right = m_sheet->rightColumn(m_docRect.right());
+    const int top = m_sheet->topRow(m_docRect.top(), toffset);
+    const int bottom = m_sheet->bottomRow(m_docRect.bottom());
+    m_cells = QRect(left, top, right - left + 1, bottom - top + 1);
+    m_offset = QPointF(loffset, toffset);
+    m_geometry = cellGeometry(m_sheet, m_cells);
+
+    debugSheets << globalPixelRect << m_docRect;
+    debugSheets << m_cells;
 }
 
 TileDrawingJob::~TileDrawingJob()
 {
-    debugSheets << "end job for " << m_x << "," << m_y << " " << m_scale;
+    debugSheets << "end job for " << m_key.x << "," << m_key.y << " " << m_key.scale;
 }
 
 void TileDrawingJob::run()
 {
-    debugSheets << "start draw for " << m_x << "," << m_y << " " << m_scale;
+    debugSheets << "start draw for " << m_key.x << "," << m_key.y << " " << m_key.scale;
     const bool rtl = m_sheet->layoutDirection() == Qt::RightToLeft;
 
     m_image.fill(QColor(255, 255, 255, 0).rgba());
     QPainter pixmapPainter(&m_image);
     pixmapPainter.setClipRect(m_image.rect());
-    pixmapPainter.scale(m_scale.x(), m_scale.y());
-
-    QRect globalPixelRect(QPoint(m_x * TILESIZE, m_y * TILESIZE), QSize(TILESIZE, TILESIZE));
-    QRectF docRect(
-            globalPixelRect.x() / m_scale.x(),
-            globalPixelRect.y() / m_scale.y(),
-            globalPixelRect.width() / m_scale.x(),
-            globalPixelRect.height() / m_scale.y()
-    );
+    pixmapPainter.scale(m_key.scale.x(), m_key.scale.y());
 
     if (rtl) {
-        pixmapPainter.translate(docRect.x(), -docRect.y());
+        pixmapPainter.translate(m_docRect.x(), -m_docRect.y());
     } else {
-        pixmapPainter.translate(-docRect.x(), -docRect.y());
+        pixmapPainter.translate(-m_docRect.x(), -m_docRect.y());
     }
 
-    qreal loffset, toffset;
-    const int left = m_sheet->leftColumn(docRect.left(), loffset);
-    const int right = m_sheet->rightColumn(docRect.right());
-    const int top = m_sheet->topRow(docRect.top(), toffset);
-    const int bottom = m_sheet->bottomRow(docRect.bottom());
-    QRect cellRect(left, top, right - left + 1, bottom - top + 1);
+    m_sheetView->SheetView::paintCells(pixmapPainter, m_docRect, m_offset, 0, m_cells);
+
+    //m_image.save(QString("/tmp/tile%1_%2.png").arg(m_key.x).arg(m_key.y));
+    debugSheets << "end draw for " << m_key.x << "," << m_key.y << " " << m_key.scale;
+}
+
+
+class PixmapCachingSheetView::Private
+{
+public:
+    Private(PixmapCachingSheetView* q) : q(q), cost(0) {}
+    PixmapCachingSheetView* q;
+    QHash<TileKey, Tile> tiles;
+    // the keys of the tiles from the least to the most recently used one;
+    // the tiles used least recently get dropped first
+    QLinkedList<TileKey> usage;
+    // the memory used by the tiles in kilobytes
+    int cost;
+    QPointF lastScale;
+    // the tiles painted last time at lastScale
+    QRect visibleTiles;
+#ifdef CALLIGRA_SHEETS_MT
+    // the tiles being painted in the background
+    QHash<TileKey, TileDrawingJob*> jobs;
+#else
+    // the tiles painted one after another, while the GUI thread is idle
+    QList<TileKey> pendingTiles;
+    QTimer prefetchTimer;
+#endif
+
+    // Returns the tile, if there is something to show. A missing or dirty tile gets painted.
+    const Tile* getTile(const Sheet* sheet, const TileKey& key, CanvasBase* canvas);
+    void requestTile(const Sheet* sheet, const TileKey& key, CanvasBase* canvas);
+    void insertTile(const TileKey& key, const QImage& image, const QRect& cells, const QVector<double>& geometry);
+    // Makes the tile the most recently used one.
+    void touch(const TileKey& key, Tile& tile);
+    // Returns whether the tile is missing or has to be painted again.
+    bool needsPainting(const Sheet* sheet, const TileKey& key);
+    // Marks the tile dirty, if the columns or rows got moved or resized since it got painted.
+    void checkGeometry(const Sheet* sheet, Tile& tile) const;
+    // Marks the tiles showing the cells in \p range dirty.
+    void invalidateTiles(const QRect& range);
+    // Paints the tiles around the visible ones in the background or, if
+    // built without CALLIGRA_SHEETS_MT, while the GUI thread is idle.
+    void prefetch(const Sheet* sheet, CanvasBase* canvas);
+};
+
+const Tile* PixmapCachingSheetView::Private::getTile(const Sheet* sheet, const TileKey& key, CanvasBase* canvas)
+{
+    if (needsPainting(sheet, key)) {
+        // a dirty tile is shown until it got painted again
+        requestTile(sheet, key, canvas);
+    }
+    QHash<TileKey, Tile>::Iterator it = tiles.find(key);
+    if (it == tiles.end())
+        return 0;
+    touch(key, it.value());
+    return &it.value();
+}
+
+void PixmapCachingSheetView::Private::requestTile(const Sheet* sheet, const TileKey& key, CanvasBase* canvas)
+{
+#ifdef CALLIGRA_SHEETS_MT
+    if (jobs.contains(key))
+        return;
+    TileDrawingJob* job = new TileDrawingJob(sheet, q, canvas, key);
+    jobs.insert(key, job);
+    QObject::connect(job, SIGNAL(done(ThreadWeaver::Job*)), q, SLOT(jobDone(ThreadWeaver::Job*)), Qt::QueuedConnection);
+    ThreadWeaver::Weaver::instance()->enqueue(job);
+#else
+    TileDrawingJob job(sheet, q, canvas, key);
+    job.run();
+    insertTile(key, job.m_image, job.m_cells, job.m_geometry);
+#endif
+}
+
+void PixmapCachingSheetView::Private::insertTile(const TileKey& key, const QImage& image, const QRect& cells, const QVector<double>& geometry)
+{
+    QHash<TileKey, Tile>::Iterator it = tiles.find(key);
+    if (it == tiles.end()) {
+        it = tiles.insert(key, Tile());
+        it.value().use = usage.insert(usage.end(), key);
+        cost += s_tileCost;
+    } else {
+        touch(key, it.value());
+    }
+    it.value().pixmap = QPixmap::fromImage(image);
+    it.value().cells = cells;
+    it.value().geometry = geometry;
+    it.value().dirty = false;
+
+    // drop the least recently used tiles exceeding the budget
+    while (cost > s_tileCacheBudget && tiles.count() > 1) {
+        tiles.remove(usage.takeFirst());
+        cost -= s_tileCost;
+    }
+}
 
-    debugSheets << globalPixelRect << docRect;
-    debugSheets << cellRect;
+void PixmapCachingSheetView::Private::touch(const TileKey& key, Tile& tile)
+{
+    usage.erase(tile.use);
+    tile.use = usage.insert(usage.end(), key);
+}
+
+bool PixmapCachingSheetView::Private::needsPainting(const Sheet* sheet, const TileKey& key)
+{
+    QHash<TileKey, Tile>::Iterator it = tiles.find(key);
+    if (it == tiles.end())
+        return true;
+    checkGeometry(sheet, it.value());
+    return it.value().dirty;
+}
+
+void PixmapCachingSheetView::Private::invalidateTiles(const QRect& range)
+{
+    // The text of a cell overflows into the cells next to it, so the tiles
+    // of the whole rows get painted again, when they are needed.
+    const QRect rows(1, range.top(), KS_colMax, range.height());
+    for (QHash<TileKey, Tile>::Iterator it = tiles.begin(); it != tiles.end(); ++it) {
+        if (it.value().cells.intersects(rows))
+            it.value().dirty = true;
+    }
+#ifdef CALLIGRA_SHEETS_MT
+    foreach (TileDrawingJob* job, jobs) {
+        if (job->m_cells.intersects(rows))
+            job->m_stale = true;
+    }
+#endif
+}
 
-    m_sheetView->SheetView::paintCells(pixmapPainter, docRect, QPointF(loffset, toffset), 0, cellRect);
+void PixmapCachingSheetView::Private::checkGeometry(const Sheet* sheet, Tile& tile) const
+{
+    if (!tile.dirty && cellGeometry(sheet, tile.cells) != tile.geometry)
+        tile.dirty = true;
+}
 
-    //m_image.save(QString("/tmp/tile%1_%2.png").arg(m_x).arg(m_y));
-    debugSheets << "end draw for " << m_x << "," << m_y << " " << m_scale;
+void PixmapCachingSheetView::Private::prefetch(const Sheet* sheet, CanvasBase* canvas)
+{
+#ifndef CALLIGRA_SHEETS_MT
+    // the tiles of the previous position are not needed anymore
+    pendingTiles.clear();
+#endif
+    // the neighbouring tiles get shown next when scrolling
+    const QRect neighbours = visibleTiles.adjusted(-1, -1, 1, 1);
+    for (int x = qMax(0, neighbours.left()); x <= neighbours.right(); ++x) {
+        for (int y = qMax(0, neighbours.top()); y <= neighbours.bottom(); ++y) {
+            if (visibleTiles.contains(x, y))
+                continue;
+            const TileKey key(lastScale, x, y);
+            if (!needsPainting(sheet, key))
+                continue;
+#ifdef CALLIGRA_SHEETS_MT
+            requestTile(sheet, key, canvas);
+#else
+            pendingTiles.append(key);
+#endif
+        }
+    }
+#ifndef CALLIGRA_SHEETS_MT
+    Q_UNUSED(canvas);
+    if (!pendingTiles.isEmpty())
+        prefetchTimer.start();
+#endif
 }
 
 
 PixmapCachingSheetView::PixmapCachingSheetView(const Sheet* sheet)
     : SheetView(sheet), d(new Private(this))
 {
-    d->tileCache.setMaxCost(128); // number of tiles to cache
+#ifndef CALLIGRA_SHEETS_MT
+    d->prefetchTimer.setSingleShot(true);
+    d->prefetchTimer.setInterval(0);
+    connect(&d->prefetchTimer, SIGNAL(timeout()), this, SLOT(prefetchTile()));
+#endif
 }
 
 PixmapCachingSheetView::~PixmapCachingSheetView()
 {
+#ifdef CALLIGRA_SHEETS_MT
+    // the jobs paint using this view
+    foreach (TileDrawingJob* job, d->jobs) {
+        ThreadWeaver::Weaver::instance()->dequeue(job);
+    }
+    ThreadWeaver::Weaver::instance()->finish();
+    qDeleteAll(d->jobs);
+#endif
     delete d;
 }
 
@@ -138,11 +370,18 @@ void PixmapCachingSheetView::jobDone(ThreadWeaver::Job *tjob)
 {
 #ifdef CALLIGRA_SHEETS_MT
     TileDrawingJob* job = static_cast<TileDrawingJob*>(tjob);
-    if (job->m_scale == d->lastScale) {
-        int idx = job->m_x << 16 | job->m_y;
-        d->tileCache.insert(idx, new QPixmap(QPixmap::fromImage(job->m_image)));
-        // TODO: figure out what area to repaint
-        job->m_canvas->update();
+    d->jobs.remove(job->m_key);
+    // a tile, whose cells changed meanwhile, gets painted again, when it is needed
+    if (!job->m_stale) {
+        d->insertTile(job->m_key, job->m_image, job->m_cells, job->m_geometry);
+    }
+    if (job->m_key.scale == d->lastScale && d->visibleTiles.contains(job->m_key.x, job->m_key.y)) {
+        if (sheet()->layoutDirection() == Qt::RightToLeft) {
+            // the tiles get mirrored within the painted area, whose width is not known here
+            job->m_canvas->update();
+        } else {
+            job->m_canvas->updateCanvas(job->m_docRect);
+        }
     }
     job->deleteLater();
 #else
@@ -150,30 +389,18 @@ void PixmapCachingSheetView::jobDone(ThreadWeaver::Job *tjob)
 #endif
 }
 
-QPixmap* PixmapCachingSheetView::Private::getTile(const Sheet* sheet, int x, int y, CanvasBase* canvas)
+void PixmapCachingSheetView::prefetchTile()
 {
-    int idx = x << 16 | y;
-    if (tileCache.contains(idx)) return tileCache.object(idx);
-
-#ifdef CALLIGRA_SHEETS_MT
-    TileDrawingJob* job = new TileDrawingJob(sheet, q, canvas, lastScale, x, y);
-    QObject::connect(job, SIGNAL(done(ThreadWeaver::Job*)), q, SLOT(jobDone(ThreadWeaver::Job*)), Qt::QueuedConnection);
-    ThreadWeaver::Weaver::instance()->enqueue(job);
-    QPixmap* pm = new QPixmap(TILESIZE, TILESIZE);
-    pm->fill(QColor(255, 255, 255, 0));
-    if (tileCache.insert(idx, pm)) {
-        return pm;
-    }
-#else
-    TileDrawingJob job(sheet, q, canvas, lastScale, x, y);
-    job.run();
-    QPixmap *pm = new QPixmap(QPixmap::fromImage(job.m_image));
-    if (tileCache.insert(idx, pm)) {
-        tileCache.insert(idx, pm);
-        return pm;
-    }
+#ifndef CALLIGRA_SHEETS_MT
+    if (d->pendingTiles.isEmpty())
+        return;
+    // one tile at a time to keep the GUI responsive
+    const TileKey key = d->pendingTiles.takeFirst();
+    if (d->needsPainting(sheet(), key))
+        paintTile(key.scale, key.x, key.y);
+    if (!d->pendingTiles.isEmpty())
+        d->prefetchTimer.start();
 #endif
-    return 0;
 }
 
 void PixmapCachingSheetView::paintCells(QPainter& painter, const QRectF& paintRect, const QPointF& topLeft, CanvasBase* canvas, const QRect& visibleRect)
@@ -202,10 +429,8 @@ void PixmapCachingSheetView::paintCells(QPainter& painter, const QRectF& paintRe
     //const qreal cost = (sx > 1e-10 ? cos_sx / sx : cos_sy / sy);
     //const qreal ang = acos(cost);
 
+    // the tiles of other zoom levels are kept until they exceed the budget
     QPointF scale = QPointF(sx, sy);
-    if (scale != d->lastScale) {
-        d->tileCache.clear();
-    }
     d->lastScale = scale;
 
     QRect tiles;
@@ -216,45 +441,83 @@ void PixmapCachingSheetView::paintCells(QPainter& painter, const QRectF& paintRe
     tiles.setTop(topLeft.y() * sy / TILESIZE);
     tiles.setRight((bottomRight.x() * sx + TILESIZE-1) / TILESIZE);
     tiles.setBottom((bottomRight.y() * sy + TILESIZE-1) / TILESIZE);
+    d->visibleTiles = QRect(QPoint(qMax(0, tiles.left()), qMax(0, tiles.top())),
+                            QPoint(tiles.right() - 1, tiles.bottom() - 1));
 
     bool rtl = s->layoutDirection() == Qt::RightToLeft;
 
     if (rtl) {
         for (int x = qMax(0, tiles.left()); x < tiles.right(); x++) {
             for (int y = qMax(0, tiles.top()); y < tiles.bottom(); y++) {
-                QPixmap *p = d->getTile(s, x, y, canvas);
-                if (p) {
+                const Tile *tile = d->getTile(s, TileKey(scale, x, y), canvas);
+                if (tile) {
                     QPointF pt(paintRect.width() - (x+1) * TILESIZE / scale.x(), y * TILESIZE / scale.y());
                     QRectF r(pt, QSizeF(TILESIZE / sx, TILESIZE / sy));
-                    painter.drawPixmap(r, *p, p->rect());
+                    painter.drawPixmap(r, tile->pixmap, tile->pixmap.rect());
                 }
             }
         }
     } else {
         for (int x = qMax(0, tiles.left()); x < tiles.right(); x++) {
             for (int y = qMax(0, tiles.top()); y < tiles.bottom(); y++) {
-                QPixmap *p = d->getTile(s, x, y, canvas);
-                if (p) {
+                const Tile *tile = d->getTile(s, TileKey(scale, x, y), canvas);
+                if (tile) {
                     QPointF pt(x * TILESIZE / scale.x(), y * TILESIZE / scale.y());
                     QRectF r(pt, QSizeF(TILESIZE / sx, TILESIZE / sy));
-                    painter.drawPixmap(r, *p, p->rect());
+                    painter.drawPixmap(r, tile->pixmap, tile->pixmap.rect());
                 }
             }
         }
     }
+
+    d->prefetch(s, canvas);
+}
+
+void PixmapCachingSheetView::invalidateRegion(const Region& region)
+{
+    // SheetView only invalidates the cells it has cached, but the tiles
+    // also show cells, that are not cached anymore or are not visible.
+    Region::ConstIterator end(region.constEnd());
+    for (Region::ConstIterator it(region.constBegin()); it != end; ++it) {
+        d->invalidateTiles((*it)->rect());
+    }
+
+    SheetView::invalidateRegion(region);
 }
 
 void PixmapCachingSheetView::invalidateRange(const QRect &rect)
 {
-    // TODO: figure out which tiles to invalidate
-    d->tileCache.clear();
+    d->invalidateTiles(rect);
 
     SheetView::invalidateRange(rect);
 }
 
 void PixmapCachingSheetView::invalidate()
 {
-    d->tileCache.clear();
+    for (QHash<TileKey, Tile>::Iterator it = d->tiles.begin(); it != d->tiles.end(); ++it) {
+        it.value().dirty = true;
+    }
+#ifdef CALLIGRA_SHEETS_MT
+    foreach (TileDrawingJob* job, d->jobs) {
+        job->m_stale = true;
+    }
+#endif
 
     SheetView::invalidate();
 }
+
+PixmapCachingSheetView::TileState PixmapCachingSheetView::tileState(const QPointF& scale, int x, int y) const
+{
+    QHash<TileKey, Tile>::Iterator it = d->tiles.find(TileKey(scale, x, y));
+    if (it == d->tiles.end())
+        return NoTile;
+    d->checkGeometry(sheet(), it.value());
+    return it.value().dirty ? DirtyTile : CleanTile;
+}
+
+void PixmapCachingSheetView::paintTile(const QPointF& scale, int x, int y)
+{
+    TileDrawingJob job(sheet(), this, 0, TileKey(scale, x, y));
+    job.run();
+    d->insertTile(job.m_key, job.m_image, job.m_cells, job.m_geometry);
+}
@@ -29,7 +29,18 @@ namespace ThreadWeaver {
 namespace Calligra {
 namespace Sheets {
 
-class PixmapCachingSheetView : public SheetView
+/**
+ * A SheetView keeping the painted cells as pixmap tiles.
+ *
+ * The tiles used least recently get dropped first, when the cached tiles
+ * exceed their memory budget. The tiles around the visible ones get painted
+ * in advance, in the background, if built with CALLIGRA_SHEETS_MT, or
+ * otherwise one by one, while the GUI thread is idle.
+ *
+ * It is not used by default; the View uses it, if the entry
+ * "Pixmap Caching" of the group "Parameters" in the configuration is set.
+ */
+class CALLIGRA_SHEETS_COMMON_TEST_EXPORT PixmapCachingSheetView : public SheetView
 {
     Q_OBJECT
 public:
@@ -44,12 +55,31 @@ public:
     ~PixmapCachingSheetView();
 
     virtual void invalidate();
+    virtual void invalidateRegion(const Region& region);
     virtual void paintCells(QPainter& painter, const QRectF& paintRect, const QPointF& topLeft, CanvasBase* canvas, const QRect& visibleRect);
 protected:
     virtual void invalidateRange(const QRect &range);
 private Q_SLOTS:
     void jobDone(ThreadWeaver::Job* job);
+    // Paints the next tile to prefetch, if built without CALLIGRA_SHEETS_MT.
+    void prefetchTile();
 private:
+    friend class PixmapCachingSheetViewTest;
+
+    enum TileState { NoTile, CleanTile, DirtyTile };
+    /**
+     * \return whether the tile \p x , \p y at \p scale is cached and
+     * whether it has to be painted again
+     * \internal Used by the tests.
+     */
+    TileState tileState(const QPointF& scale, int x, int y) const;
+
+    /**
+     * Paints the tile \p x , \p y at \p scale into the cache.
+     * \internal Used by the tests.
+     */
+    void paintTile(const QPointF& scale, int x, int y);
+
     class Private;
     Private * const d;
 };
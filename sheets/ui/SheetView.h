@@ -105,7 +105,7 @@ public:
     /**
      * Invalidates all cached CellViews in \p region .
      */
-    void invalidateRegion(const Region& region);
+    virtual void invalidateRegion(const Region& region);
 
     /**
      * Invalidates all CellViews, the cached and the default.